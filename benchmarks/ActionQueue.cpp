@@ -0,0 +1,56 @@
+#include "Logger.h"
+LOG_INIT(ActionQueue_benchmarks);
+
+#include "ActionQueue.h"
+
+#include "benchmark/benchmark.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace {
+
+/**
+ * The benchmark threads push into one queue executed by a single consumer, as the downloader threads push their
+ * finished downloads into the action queue of the crawler.
+ */
+struct ContendedActionQueue {
+  ContendedActionQueue() : queue{}, executed{0}, stop{false}, consumer{} {
+    consumer = std::thread{[this]() {
+      while(!stop) {
+        queue.executeOrWaitAndExecute();
+      }
+    }};
+  }
+
+  ~ContendedActionQueue() {
+    queue.push([this]() { stop = true; });
+    consumer.join();
+  }
+
+  ActionQueue         queue;
+  std::atomic<size_t> executed;
+  bool                stop; // only used by the consumer thread
+  std::thread         consumer;
+};
+
+std::unique_ptr<ContendedActionQueue> contendedQueue;
+
+void
+actionQueuePush(benchmark::State& state) {
+  if(0 == state.thread_index()) {
+    contendedQueue = std::make_unique<ContendedActionQueue>();
+  }
+  for(auto _: state) {
+    std::atomic<size_t>& executed = contendedQueue->executed;
+    contendedQueue->queue.push([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); });
+  }
+  state.SetItemsProcessed(state.iterations());
+  if(0 == state.thread_index()) {
+    contendedQueue.reset();
+  }
+}
+BENCHMARK(actionQueuePush)->ThreadRange(1, 16)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,41 @@
+#include "DownloadQueues.h"
+#include "benchmarkUrls.h"
+
+#include "benchmark/benchmark.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t URLS_PER_HOST = 8;
+
+/**
+ * Queues URLS_PER_HOST urls for each host and pops all of them, as the crawler does for one batch.
+ */
+void
+downloadQueuesAddPop(benchmark::State& state) {
+  const auto               nrHosts = static_cast<size_t>(state.range(0));
+  std::vector<std::string> hosts;
+  for(size_t hostId = 0; hostId < nrHosts; ++hostId) {
+    hosts.push_back(benchmarkHost(hostId));
+  }
+  for(auto _: state) {
+    DownloadQueues queues;
+    for(size_t url = 0; url < nrHosts * URLS_PER_HOST; ++url) {
+      const size_t hostId = url % nrHosts;
+      const auto   queue  = queues.getQueue(hosts[hostId]);
+      queues.addDownload(queue, UrlHandle{0, 0, 0, static_cast<uint32_t>(hostId), static_cast<int32_t>(url)});
+    }
+    for(auto queue = queues.begin(); queue != queues.end(); queue = queues.begin()) {
+      while(!queues.empty(queue)) {
+        benchmark::DoNotOptimize(queues.popDownload(queue));
+      }
+      queues.erase(queue);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nrHosts * URLS_PER_HOST);
+}
+BENCHMARK(downloadQueuesAddPop)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,47 @@
+#include "HeaderHandler.h"
+
+#include "benchmark/benchmark.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// curl calls the header callback once per header line
+const std::vector<std::string> HTML_RESPONSE_HEADER{
+    "HTTP/1.1 200 OK\r\n",
+    "Date: Sat, 01 Jun 2019 10:12:43 GMT\r\n",
+    "Server: Apache/2.4.29 (Ubuntu)\r\n",
+    "Cache-Control: private, max-age=0, must-revalidate\r\n",
+    "Set-Cookie: session=4f2a9c1e7b3d5a60; Path=/; HttpOnly; SameSite=Lax\r\n",
+    "Vary: Accept-Encoding,Cookie\r\n",
+    "Last-Modified: Fri, 31 May 2019 22:01:15 GMT\r\n",
+    "ETag: \"1e3f-58a3b2c4d9e00\"\r\n",
+    "X-Frame-Options: SAMEORIGIN\r\n",
+    "Content-Length: 7743\r\n",
+    "Content-Type: text/html; charset=\"UTF-8\"\r\n",
+    "Connection: keep-alive\r\n",
+    "\r\n",
+};
+
+void
+headerHandler(benchmark::State& state) {
+  std::ostringstream errors;
+  HeaderHandler      handler{[](const MediaType& mediaType) { return "text" == mediaType.type; }, &errors};
+  // the handler gets a writable buffer from curl
+  std::vector<std::string> lines = HTML_RESPONSE_HEADER;
+  size_t                   bytes = 0;
+  for(auto _: state) {
+    handler.reuse();
+    for(std::string& line: lines) {
+      benchmark::DoNotOptimize(handler(line.data(), line.size()));
+      bytes += line.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(headerHandler);
+
+} // namespace
@@ -0,0 +1,160 @@
+#include "HtmlTokenizer.h"
+#include "benchmarkUrls.h"
+#include "extractLinks.h"
+
+#include "benchmark/benchmark.h"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t GENERATED_CORPUS_SIZE = 16 * 1024 * 1024;
+
+/**
+ * Markup like the one of a news or shop page: mostly nested blocks, text and links.
+ */
+std::string
+generatePage(std::mt19937& random) {
+  static const std::vector<std::string> PIECES{
+      "<div class=\"article-body col-md-8\">\n",
+      "</div>\n",
+      "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore.</p>\n",
+      "<span class=\"price\">19.99</span>",
+      "<a href=\"/articles/2019/06/01/some-long-title-of-an-article.html\" class=\"teaser-link\">Read more</a>\n",
+      "<li class=\"menu-item\"><a href=\"https://www.example.com/category/news?page=2&amp;sort=date\">News</a></li>\n",
+      "<img src=\"/static/img/thumbnail-320x240.jpg\" alt=\"thumbnail\" width=\"320\" height=\"240\">\n",
+      "<script>window.dataLayer = window.dataLayer || []; function gtag(){dataLayer.push(arguments);}</script>\n",
+      "<!-- generated by the content management system -->\n",
+      "<table><tr><td>1</td><td>2</td></tr></table>\n",
+      "<meta property=\"og:title\" content=\"Some title\">\n",
+      "<section id=\"comments\"><h2>Comments</h2><button type=\"button\">Load</button></section>\n",
+  };
+  std::string result{"<!DOCTYPE html><html><head><title>Page</title>"
+                     "<link rel=\"stylesheet\" href=\"/static/css/main.css\"></head><body>\n"};
+  while(result.size() < 256 * 1024) {
+    result += PIECES[random() % PIECES.size()];
+  }
+  return result + "</body></html>\n";
+}
+
+/**
+ * The pages of the directory given by CHEAP_CRAWLER_HTML_CORPUS, e.g. the pages written by the crawlerDriver,
+ * otherwise generated pages.
+ */
+const std::vector<std::string>&
+corpus() {
+  static const std::vector<std::string> pages = []() {
+    std::vector<std::string> result;
+    const char* const        directory = std::getenv("CHEAP_CRAWLER_HTML_CORPUS");
+    if(nullptr != directory) {
+      if(DIR* const dir = opendir(directory)) {
+        while(const dirent* const entry = readdir(dir)) {
+          std::ifstream      file{std::string{directory} + '/' + entry->d_name, std::ios::binary};
+          std::ostringstream content;
+          if(file && content << file.rdbuf()) {
+            result.push_back(content.str());
+          }
+        }
+        closedir(dir);
+      }
+      return result;
+    }
+    std::mt19937 random{BENCHMARK_SEED};
+    for(size_t size = 0; size < GENERATED_CORPUS_SIZE; size += result.back().size()) {
+      result.push_back(generatePage(random));
+    }
+    return result;
+  }();
+  return pages;
+}
+
+size_t
+corpusBytes() {
+  size_t result = 0;
+  for(const std::string& page: corpus()) {
+    result += page.size();
+  }
+  return result;
+}
+
+void
+htmlTokenizer(benchmark::State& state) {
+  const auto simdLevel = static_cast<SimdLevel>(state.range(0));
+  if(simdLevel > bestSimdLevel()) {
+    state.SkipWithError("instruction set not supported");
+    return;
+  }
+  HtmlTokenizer tokenizer{simdLevel};
+  size_t        nrTags = 0;
+  for(auto _: state) {
+    for(const std::string& page: corpus()) {
+      tokenizer.reset();
+      tokenizer.feed(page, [&nrTags](const HtmlTag& tag) { nrTags += tag.attributes.size(); });
+    }
+  }
+  benchmark::DoNotOptimize(nrTags);
+  state.SetBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(htmlTokenizer)
+    ->Arg(static_cast<int>(SimdLevel::SCALAR))
+    ->Arg(static_cast<int>(SimdLevel::SSE2))
+    ->Arg(static_cast<int>(SimdLevel::AVX2));
+
+// the tokenizer fed with the 16KiB chunks of a download
+void
+htmlTokenizerIncremental(benchmark::State& state) {
+  constexpr size_t CHUNK_SIZE = 16 * 1024;
+  HtmlTokenizer    tokenizer;
+  size_t           nrTags = 0;
+  for(auto _: state) {
+    for(const std::string& page: corpus()) {
+      tokenizer.reset();
+      for(size_t size = std::min(CHUNK_SIZE, page.size());; size = std::min(size + CHUNK_SIZE, page.size())) {
+        tokenizer.feed(std::string_view{page}.substr(0, size), [&nrTags](const HtmlTag&) { ++nrTags; });
+        if(size == page.size()) {
+          break;
+        }
+      }
+    }
+  }
+  benchmark::DoNotOptimize(nrTags);
+  state.SetBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(htmlTokenizerIncremental);
+
+void
+extractLinks(benchmark::State& state) {
+  HtmlLinks links;
+  for(auto _: state) {
+    for(const std::string& page: corpus()) {
+      links.links.clear();
+      extractLinks(page, links);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(extractLinks);
+
+// reference: searching the attributes with std::string::find
+void
+findHref(benchmark::State& state) {
+  size_t nrLinks = 0;
+  for(auto _: state) {
+    for(const std::string& page: corpus()) {
+      for(size_t pos = page.find("href="); std::string::npos != pos; pos = page.find("href=", pos + 1)) {
+        ++nrLinks;
+      }
+    }
+  }
+  benchmark::DoNotOptimize(nrLinks);
+  state.SetBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(findHref);
+
+} // namespace
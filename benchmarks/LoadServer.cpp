@@ -0,0 +1,268 @@
+#include "Logger.h"
+LOG_INIT(LoadServer);
+
+#include "LoadServer.h"
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+using boost::asio::ip::tcp;
+using BErrorCode = boost::system::error_code;
+
+namespace {
+
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+std::chrono::nanoseconds
+threadCpuTime() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
+}
+
+std::string
+makeBody(const size_t size) {
+  static const std::string HEAD{"<html><head><title>LoadServer</title></head><body>\n"};
+  static const std::string PARAGRAPH{"<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit.</p>\n"};
+  static const std::string TAIL{"</body></html>\n"};
+  std::string              result{HEAD};
+  while(result.size() + TAIL.size() < size) {
+    result.append(PARAGRAPH, 0, std::min(PARAGRAPH.size(), size - TAIL.size() - result.size()));
+  }
+  return result + TAIL;
+}
+
+std::string
+chunkedBody(const std::string& body, const size_t chunkSize) {
+  std::ostringstream result;
+  for(size_t pos = 0; pos < body.size(); pos += chunkSize) {
+    const size_t size = std::min(chunkSize, body.size() - pos);
+    result << std::hex << size << "\r\n";
+    result.write(body.data() + pos, size);
+    result << "\r\n";
+  }
+  result << "0\r\n\r\n";
+  return result.str();
+}
+
+/**
+ * All the responses are prepared when the server is started.
+ */
+struct LoadResponses {
+  explicit LoadResponses(const LoadServerOptions& options)
+      : ok{"HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\n"}
+      , notFound{"HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 0\r\n\r\n"}
+      , error{"HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/plain\r\nContent-Length: 0\r\n\r\n"} {
+    const std::string body = makeBody(options.responseSize);
+    if(0 == options.chunkSize) {
+      ok += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+    else {
+      ok += "Transfer-Encoding: chunked\r\n\r\n" + chunkedBody(body, options.chunkSize);
+    }
+  }
+
+  std::string ok;
+  std::string notFound;
+  std::string error;
+};
+
+} // namespace
+
+struct LoadServer::Pimpl {
+  Pimpl(const LoadServerOptions& options, const unsigned short port)
+      : m_options{options}
+      , m_responses{options}
+      , m_ioContext{}
+      , m_acceptor{m_ioContext, tcp::endpoint{boost::asio::ip::address_v4::loopback(), port}}
+      , m_nrResponses{0}
+      , m_cpuTime{0}
+      , m_threads{} {
+    accept();
+    for(size_t thread = 0; thread < std::max<size_t>(options.nrThreads, 1); ++thread) {
+      m_threads.emplace_back([this]() {
+        m_ioContext.run();
+        m_cpuTime += threadCpuTime().count();
+      });
+    }
+    LOG_INFO("serving on 127.0.0.1:" << m_acceptor.local_endpoint().port() << " with " << m_threads.size()
+                                     << " threads");
+  }
+
+  void accept();
+
+  void stop() {
+    m_ioContext.stop();
+    for(std::thread& thread: m_threads) {
+      if(thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  LoadServerOptions        m_options;
+  LoadResponses            m_responses;
+  boost::asio::io_context  m_ioContext;
+  tcp::acceptor            m_acceptor;
+  std::atomic<size_t>      m_nrResponses;
+  std::atomic<int64_t>     m_cpuTime; // nanoseconds
+  std::vector<std::thread> m_threads;
+};
+
+namespace {
+
+/**
+ * One keep alive connection, kept alive by the pending asio handlers.
+ */
+class LoadConnection : public std::enable_shared_from_this<LoadConnection> {
+public:
+  LoadConnection(tcp::socket&& socket, LoadServer::Pimpl& server)
+      : m_socket{std::move(socket)}, m_request{MAX_REQUEST_SIZE}, m_timer{server.m_ioContext}, m_server{server} {}
+
+  void readRequest() {
+    boost::asio::async_read_until(
+        m_socket, m_request, "\r\n\r\n", [self = shared_from_this()](const BErrorCode& error, const size_t size) {
+          if(error) {
+            LOG_DEBUG("connection closed: " << error.message());
+            return;
+          }
+          self->respond(size);
+        });
+  }
+
+private:
+  void respond(const size_t requestSize) {
+    const std::string_view request{static_cast<const char*>(m_request.data().data()), requestSize};
+    const std::string_view requestLine = request.substr(0, request.find("\r\n"));
+    const bool isRobotsTxt = std::string_view::npos != requestLine.find("/robots.txt ");
+    m_request.consume(requestSize);
+
+    thread_local std::mt19937              random{std::hash<std::thread::id>{}(std::this_thread::get_id())};
+    std::uniform_real_distribution<double> uniform{0., 1.};
+    const double                           draw = uniform(random);
+    if(draw < m_server.m_options.resetRate) {
+      BErrorCode ignored;
+      m_socket.close(ignored);
+      return;
+    }
+    const LoadResponses& responses = m_server.m_responses;
+    const std::string*   response  = &responses.ok;
+    if(isRobotsTxt) {
+      response = &responses.notFound;
+    }
+    else if(draw < m_server.m_options.resetRate + m_server.m_options.errorRate) {
+      response = &responses.error;
+    }
+    after(m_server.m_options.latency, [this, response]() { write(response, 0); });
+  }
+
+  template<typename Func> void after(const std::chrono::milliseconds delay, Func func) {
+    if(0 == delay.count()) {
+      func();
+      return;
+    }
+    m_timer.expires_after(delay);
+    m_timer.async_wait([self = shared_from_this(), func](const BErrorCode& error) {
+      if(!error) {
+        func();
+      }
+    });
+  }
+
+  void write(const std::string* const response, const size_t offset) {
+    const size_t dripSize = m_server.m_options.dripSize;
+    const size_t size     = 0 == dripSize ? response->size() - offset : std::min(dripSize, response->size() - offset);
+    boost::asio::async_write(
+        m_socket,
+        boost::asio::buffer(response->data() + offset, size),
+        [self = shared_from_this(), response, next = offset + size](const BErrorCode& error, size_t) {
+          if(error) {
+            LOG_DEBUG("failed to write response: " << error.message());
+            return;
+          }
+          if(next < response->size()) {
+            self->after(self->m_server.m_options.dripInterval,
+                        [self, response, next]() { self->write(response, next); });
+            return;
+          }
+          ++self->m_server.m_nrResponses;
+          self->readRequest();
+        });
+  }
+
+  tcp::socket               m_socket;
+  boost::asio::streambuf    m_request;
+  boost::asio::steady_timer m_timer;
+  LoadServer::Pimpl&        m_server;
+};
+
+} // namespace
+
+void
+LoadServer::Pimpl::accept() {
+  m_acceptor.async_accept([this](const BErrorCode& error, tcp::socket socket) {
+    if(error == boost::asio::error::operation_aborted) {
+      return;
+    }
+    if(error) {
+      LOG_ERROR("failed to accept connection: " << error.message());
+    }
+    else {
+      socket.set_option(tcp::no_delay{true});
+      std::make_shared<LoadConnection>(std::move(socket), *this)->readRequest();
+    }
+    accept();
+  });
+}
+
+// class LoadServer
+LoadServer::LoadServer(const LoadServerOptions& options, const unsigned short port)
+    : m_pimpl{std::make_unique<Pimpl>(options, port)} {}
+
+LoadServer::~LoadServer() { m_pimpl->stop(); }
+
+unsigned short
+LoadServer::port() const {
+  return m_pimpl->m_acceptor.local_endpoint().port();
+}
+
+size_t
+LoadServer::nrResponses() const {
+  return m_pimpl->m_nrResponses;
+}
+
+void
+LoadServer::stop() {
+  m_pimpl->stop();
+}
+
+std::chrono::nanoseconds
+LoadServer::cpuTime() const {
+  return std::chrono::nanoseconds{m_pimpl->m_cpuTime.load()};
+}
+
+void
+addLoadServerOptions(boost::program_options::options_description& optionsDescription, LoadServerOptions& options) {
+  namespace po = boost::program_options;
+  // clang-format off
+  optionsDescription.add_options()
+    ("responseSize", po::value<size_t>(&options.responseSize)->default_value(16 * 1024), "Bytes of the html body of the responses.")
+    ("latencyMs", po::value<size_t>()->default_value(0)->notifier([&options](size_t ms) { options.latency = std::chrono::milliseconds{ms}; }), "Delay before each response.")
+    ("chunkSize", po::value<size_t>(&options.chunkSize)->default_value(0), "Send the body with chunked transfer encoding in chunks of this size. Disabled when 0.")
+    ("dripSize", po::value<size_t>(&options.dripSize)->default_value(0), "Write the responses in pieces of this size. Disabled when 0.")
+    ("dripIntervalMs", po::value<size_t>()->default_value(10)->notifier([&options](size_t ms) { options.dripInterval = std::chrono::milliseconds{ms}; }), "Delay between the pieces of a dripped response.")
+    ("errorRate", po::value<double>(&options.errorRate)->default_value(0.), "Rate of the 500 Internal Server Error responses.")
+    ("resetRate", po::value<double>(&options.resetRate)->default_value(0.), "Rate of the connections closed instead of responding.")
+    ("serverThreads", po::value<size_t>(&options.nrThreads)->default_value(1), "Number of threads of the server.")
+    ;
+  // clang-format on
+}
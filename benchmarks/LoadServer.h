@@ -0,0 +1,66 @@
+#ifndef BENCHMARKS_LOADSERVER_H_H4XK9QTC
+#define BENCHMARKS_LOADSERVER_H_H4XK9QTC
+
+#include <boost/program_options/options_description.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Behaviour of the responses of the LoadServer.
+ */
+struct LoadServerOptions {
+  size_t                    responseSize{16 * 1024}; // bytes of the html body
+  std::chrono::milliseconds latency{0};              // delay before the response is sent
+  size_t                    chunkSize{0};            // 0 for a Content-Length body, else chunked transfer encoding
+  size_t                    dripSize{0};             // 0 writes the body at once, else in pieces of dripSize bytes
+  std::chrono::milliseconds dripInterval{10};        // delay between the pieces of a dripped body
+  double                    errorRate{0.};           // rate of the 500 Internal Server Error responses
+  double                    resetRate{0.};           // rate of the connections closed instead of responding
+  size_t                    nrThreads{1};
+};
+
+/**
+ * Local HTTP/1.1 server faking any number of virtual hosts for offline throughput tests.
+ * It listens on the loopback interface and answers every host and path, except robots.txt which is not found.
+ * Point a downloader to it with CURLOPT_CONNECT_TO "::127.0.0.1:<port>" and use any host names in the urls.
+ * Connections are kept alive and the requests of a connection are answered in order.
+ */
+class LoadServer {
+public:
+  /**
+   * Starts serving on nrThreads threads.
+   * @param port 0 selects a free port, see port()
+   */
+  explicit LoadServer(const LoadServerOptions& options, unsigned short port = 0);
+  ~LoadServer();
+
+  LoadServer(const LoadServer&) = delete;
+  LoadServer& operator=(const LoadServer&) = delete;
+
+  unsigned short port() const;
+
+  size_t nrResponses() const;
+
+  /**
+   * Stops serving and waits for the threads of the server.
+   */
+  void stop();
+
+  /**
+   * @returns the CPU time used by the threads of the server, only complete after stop()
+   */
+  std::chrono::nanoseconds cpuTime() const;
+
+  struct Pimpl;
+
+private:
+  const std::unique_ptr<Pimpl> m_pimpl;
+};
+
+/**
+ * Adds the command line options of the responses, they are written into options.
+ */
+void addLoadServerOptions(boost::program_options::options_description& optionsDescription, LoadServerOptions& options);
+
+#endif /* end of include guard: BENCHMARKS_LOADSERVER_H_H4XK9QTC */
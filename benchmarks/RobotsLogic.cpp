@@ -0,0 +1,35 @@
+#include "RobotsLogic.h"
+#include "DownloadResult.h"
+#include "benchmarkUrls.h"
+
+#include "benchmark/benchmark.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Populates the download queues with one batch, including the creation of the batch from the dispatched urls
+ * and the release of the queues.
+ */
+void
+populateDownloadQueues(benchmark::State& state) {
+  const auto                     nrUrls = static_cast<size_t>(state.range(0));
+  const std::vector<std::string> urls   = generateBenchmarkUrls(nrUrls, nrUrls / 100);
+  for(auto _: state) {
+    UrlBatch batch{[](DownloadResult&&) {}};
+    for(size_t url = 0; url < nrUrls; ++url) {
+      batch.add(urls[url], static_cast<int>(url));
+    }
+    DownloadQueues queues;
+    RobotsLogic    robotsLogic{&queues};
+    robotsLogic.populateDownloadQueues(std::move(batch),
+                                       [](DownloadQueues::DownloadQueueIt, const TransferOutcome&) {});
+    benchmark::DoNotOptimize(robotsLogic.nrQueuedUrls());
+  }
+  state.SetItemsProcessed(state.iterations() * nrUrls);
+}
+BENCHMARK(populateDownloadQueues)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,49 @@
+#include "TimeHeap.h"
+#include "benchmarkUrls.h"
+
+#include "benchmark/benchmark.h"
+
+#include <chrono>
+#include <random>
+
+namespace {
+
+/**
+ * The crawler steady state: the queue of the popped download goes back into the heap with the politeness delay.
+ */
+void
+timeHeapPopPush(benchmark::State& state) {
+  const auto                    nrQueues = static_cast<size_t>(state.range(0));
+  std::mt19937                  random{BENCHMARK_SEED};
+  TimeHeap                      heap;
+  std::function<DownloadElem()> popper = []() { return DownloadElem{}; };
+  for(size_t queue = 0; queue < nrQueues; ++queue) {
+    heap.push(popper, std::chrono::seconds{random() % 4});
+  }
+  for(auto _: state) {
+    DownloadElem download = heap.pop();
+    benchmark::DoNotOptimize(download);
+    heap.push(popper, std::chrono::seconds{2});
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(timeHeapPopPush)->RangeMultiplier(10)->Range(100, 1000000);
+
+void
+timeHeapFill(benchmark::State& state) {
+  const auto                    nrQueues = static_cast<size_t>(state.range(0));
+  std::function<DownloadElem()> popper   = []() { return DownloadElem{}; };
+  for(auto _: state) {
+    TimeHeap heap;
+    for(size_t queue = 0; queue < nrQueues; ++queue) {
+      heap.push(popper, std::chrono::seconds{queue % 4});
+    }
+    while(!heap.empty()) {
+      benchmark::DoNotOptimize(heap.pop());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nrQueues);
+}
+BENCHMARK(timeHeapFill)->RangeMultiplier(10)->Range(100, 100000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
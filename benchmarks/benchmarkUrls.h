@@ -0,0 +1,36 @@
+#ifndef BENCHMARKS_BENCHMARKURLS_H_R6WQ2ZJD
+#define BENCHMARKS_BENCHMARKURLS_H_R6WQ2ZJD
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// The inputs of the benchmarks are generated with a fixed seed, thus they are the same for every run and commit.
+constexpr uint32_t BENCHMARK_SEED = 20190601;
+
+inline std::string
+benchmarkHost(const size_t hostId) {
+  return "host" + std::to_string(hostId) + ".example.com";
+}
+
+/**
+ * Generates nrUrls urls spread over nrHosts hosts.
+ * The hosts are picked with a geometric like distribution, as in a real crawl few hosts have most of the urls.
+ */
+inline std::vector<std::string>
+generateBenchmarkUrls(const size_t nrUrls, const size_t nrHosts) {
+  std::mt19937                           random{BENCHMARK_SEED};
+  std::uniform_real_distribution<double> uniform{0., 1.};
+  std::vector<std::string>               result;
+  result.reserve(nrUrls);
+  for(size_t url = 0; url < nrUrls; ++url) {
+    const double draw   = uniform(random);
+    const size_t hostId = static_cast<size_t>(draw * draw * draw * nrHosts) % nrHosts;
+    result.push_back((0 == url % 4 ? "https://" : "http://") + benchmarkHost(hostId) + "/articles/"
+                     + std::to_string(random() % 100000) + "/page.html?ref=" + std::to_string(url));
+  }
+  return result;
+}
+
+#endif /* end of include guard: BENCHMARKS_BENCHMARKURLS_H_R6WQ2ZJD */
@@ -0,0 +1,57 @@
+#include "DownloadResult.h"
+#include "benchmarkUrls.h"
+#include "crawler/SimulatedDownloader.h"
+
+#include "benchmark/benchmark.h"
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+constexpr std::chrono::seconds POLITENESS_DELAY{2};
+
+/**
+ * Crawls one batch of state.range(0) hosts with state.range(1) urls each on virtual time with state.range(2) slots.
+ * Reports the slot utilisation, the politeness violations and the crawler CPU per download of the scheduler.
+ */
+void
+crawlSimulation(benchmark::State& state) {
+  const auto nrHosts         = static_cast<size_t>(state.range(0));
+  const auto urlsPerHost     = static_cast<size_t>(state.range(1));
+  const auto maxActiveQueues = static_cast<size_t>(state.range(2));
+  for(auto _: state) {
+    SimulationProfile profile;
+    profile.seed = BENCHMARK_SEED;
+    SimulatedDownloader simulator{profile, POLITENESS_DELAY};
+    bool                dispatched = false;
+    const auto          dispatcher = [&dispatched, nrHosts, urlsPerHost]() {
+      dispatched = true;
+      UrlBatch batch{[](DownloadResult&&) {}};
+      for(size_t url = 0; url < urlsPerHost; ++url) {
+        for(size_t hostId = 0; hostId < nrHosts; ++hostId) {
+          batch.add("http://" + benchmarkHost(hostId) + "/page" + std::to_string(url), static_cast<int>(url));
+        }
+      }
+      return batch;
+    };
+    Crawler crawler{
+        [&dispatched]() { return !dispatched; }, dispatcher, &simulator, maxActiveQueues, POLITENESS_DELAY, &simulator};
+    crawler.crawl();
+
+    const SimulationStats stats                   = simulator.stats();
+    state.counters["slot_utilisation"]            = stats.slotUtilisation(maxActiveQueues);
+    state.counters["politeness_violations"]       = stats.nrPolitenessViolations;
+    state.counters["crawler_cpu_per_download_ns"] = stats.crawlerCpuPerDownload().count();
+    state.counters["virtual_hours"]               = stats.virtualDuration.count() / 3600e6;
+    state.counters["downloads"]                   = stats.nrDownloads;
+  }
+}
+BENCHMARK(crawlSimulation)
+    ->Args({10000, 10, 1000})
+    ->Args({100000, 10, 10000})
+    ->Args({1000000, 3, 10000})
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,172 @@
+#include "Logger.h"
+LOG_INIT(crawlThroughput);
+
+#include "DownloadResult.h"
+#include "LoadServer.h"
+#include "Metrics.h"
+#include "ProgramLogic.h"
+#include "crawler/CurlAsioDownloader.h"
+#include "crawler/crawler.h"
+#include "handleExceptions.h"
+
+#include <boost/program_options.hpp>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+namespace {
+
+struct ThroughputOptions {
+  bool              shouldContinue;
+  size_t            nrHosts;
+  size_t            urlsPerHost;
+  size_t            parallelDownloads;
+  size_t            perHostDelay;
+  size_t            hostSlots;
+  size_t            prewarmWindow;
+  BandwidthLimits   bandwidth;
+  LoadServerOptions server;
+};
+
+ThroughputOptions
+readCommandLineArgs(const int argc, const char** argv) {
+  namespace po = boost::program_options;
+
+  ThroughputOptions result{};
+
+  po::options_description optionsDescription(
+      "Crawls the virtual hosts of a LoadServer started in this process, the crawler pipeline is the same as\n"
+      "in the crawlerDriver without writing the results. No network access is needed.\n"
+      "Reports pages/s, the transfers per opened socket, the p50 and p99 transfer latency, the CPU per page and\n"
+      "the peak RSS.\n\n"
+      "Supported options");
+  // clang-format off
+  optionsDescription.add_options()
+    ("nrHosts", po::value<size_t>(&result.nrHosts)->default_value(1000), "Number of virtual hosts.")
+    ("urlsPerHost", po::value<size_t>(&result.urlsPerHost)->default_value(10), "Number of pages crawled from each host.")
+    ("parallelDownloads", po::value<size_t>(&result.parallelDownloads)->default_value(500), "Number of simultaneous downloads.")
+    ("perHostDelay", po::value<size_t>(&result.perHostDelay)->default_value(0), "Seconds between the downloads of a host.")
+    ("hostSlots", po::value<size_t>(&result.hostSlots)->default_value(1), "Simultaneous downloads of each host.")
+    ("prewarmWindow", po::value<size_t>(&result.prewarmWindow)->default_value(0), "Milliseconds before the end of the perHostDelay the connection of a host is opened. Disabled when 0.")
+    ("maxBytesPerSecond", po::value<uint64_t>(&result.bandwidth.bytesPerSecond)->default_value(0), "Aggregate receive rate of the downloader. Unlimited when 0.")
+    ("help,h", "produce help message")
+    ;
+  // clang-format on
+  addLoadServerOptions(optionsDescription, result.server);
+  configureLogging(optionsDescription);
+
+  po::variables_map variablesMap;
+  po::store(po::parse_command_line(argc, argv, optionsDescription), variablesMap);
+  po::notify(variablesMap);
+
+  if(variablesMap.count("help")) {
+    std::cout << optionsDescription << std::endl;
+    return ThroughputOptions{false};
+  }
+  result.shouldContinue = processLogging(variablesMap);
+  return result;
+}
+
+std::chrono::nanoseconds
+processCpuTime() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  const auto toNanoseconds = [](const timeval& time) {
+    return std::chrono::seconds{time.tv_sec} + std::chrono::microseconds{time.tv_usec};
+  };
+  return toNanoseconds(usage.ru_utime) + toNanoseconds(usage.ru_stime);
+}
+
+size_t
+peakRssKiB() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+void
+throughputLogic(const ThroughputOptions& options) {
+  LoadServer server{options.server};
+
+  std::atomic<size_t> nrPages{0};
+  std::atomic<size_t> nrFailedPages{0};
+  bool                dispatched = false;
+  const auto          dispatcher = [&]() {
+    dispatched = true;
+    UrlBatch batch{[&nrPages, &nrFailedPages](DownloadResult&& result) {
+      ++nrPages;
+      nrFailedPages += result.success ? 0 : 1;
+    }};
+    for(size_t url = 0; url < options.urlsPerHost; ++url) {
+      for(size_t host = 0; host < options.nrHosts; ++host) {
+        batch.add("http://host" + std::to_string(host) + ".loadtest/page" + std::to_string(url) + ".html",
+                  static_cast<int>(url));
+      }
+    }
+    return batch;
+  };
+
+  const auto cpuStart  = processCpuTime();
+  const auto wallStart = std::chrono::steady_clock::now();
+  {
+    CurlAsioDownloaderOptions downloaderOptions;
+    downloaderOptions.connectTo       = {"::127.0.0.1:" + std::to_string(server.port())};
+    downloaderOptions.bandwidthLimits = options.bandwidth;
+    CurlAsioDownloader downloader{options.server.responseSize + 1024,
+                                  [](const MediaType& mediaType) { return "html" == mediaType.subtype; },
+                                  std::move(downloaderOptions)};
+    Crawler            crawler{[&dispatched]() { return !dispatched; },
+                    dispatcher,
+                    &downloader,
+                    options.parallelDownloads,
+                    std::chrono::seconds{options.perHostDelay}};
+    HostConcurrency    hostConcurrency;
+    hostConcurrency.defaultSlots = options.hostSlots;
+    crawler.setHostConcurrency(hostConcurrency);
+    crawler.setPrewarmWindow(std::chrono::milliseconds{options.prewarmWindow});
+    crawler.crawl();
+  }
+  const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+  server.stop();
+  const auto crawlerCpu = processCpuTime() - cpuStart - server.cpuTime();
+
+  // the transfer durations are recorded by the downloader, including the robots.txt transfers
+  const Histogram& transferDuration = getHistogram("crawler_transfer_duration_seconds", "", 1e-6);
+  const Counter&   downloadedBytes  = getCounter("crawler_downloaded_bytes_total", "");
+  const Counter&   openedSockets    = getCounter("crawler_opened_sockets_total", "");
+  const size_t     pages            = nrPages;
+  const size_t     transfers        = transferDuration.count();
+  const Histogram& connectTime      = getHistogram("crawler_connect_seconds", "", 1e-6);
+  const Counter&   prewarms         = getCounter("crawler_prewarmed_connections_total", "");
+  const Histogram& prewarmSaved     = getHistogram("crawler_prewarm_saved_seconds", "", 1e-6);
+  std::cout << "pages: " << pages << " failed: " << nrFailedPages << " seconds: " << wall.count() << '\n'
+            << "pages/s: " << pages / wall.count() << '\n'
+            << "MiB/s: " << downloadedBytes.value() / wall.count() / (1024 * 1024) << '\n'
+            << "sockets: " << openedSockets.value() << " transfers per socket: "
+            << (0 == openedSockets.value() ? 0. : static_cast<double>(transfers) / openedSockets.value()) << '\n'
+            << "connect p50 (ms): " << connectTime.quantile(.5) / 1e3 << " p99 (ms): " << connectTime.quantile(.99) / 1e3
+            << '\n'
+            << "prewarmed connections: " << prewarms.value() << " used: " << prewarmSaved.count()
+            << " saved connect time per used (ms): "
+            << (0 == prewarmSaved.count() ? 0. : prewarmSaved.sum() / 1e3 / prewarmSaved.count()) << '\n'
+            << "transfer latency p50 (ms): " << transferDuration.quantile(.5) / 1e3
+            << " p99 (ms): " << transferDuration.quantile(.99) / 1e3 << '\n'
+            << "crawler CPU per page (us): " << (0 == pages ? 0. : crawlerCpu.count() / 1e3 / pages) << '\n'
+            << "peak RSS (MiB): " << peakRssKiB() / 1024. << std::endl;
+  if(pages != options.nrHosts * options.urlsPerHost) {
+    throw std::runtime_error("missing download results: " + std::to_string(pages));
+  }
+}
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+  return handleExceptions(ProgramLogic<ThroughputOptions>(argc, argv, readCommandLineArgs, throughputLogic));
+}
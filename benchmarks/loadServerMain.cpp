@@ -0,0 +1,70 @@
+#include "Logger.h"
+LOG_INIT(LoadServerMain);
+
+#include "LoadServer.h"
+#include "ProgramLogic.h"
+#include "handleExceptions.h"
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <csignal>
+#include <iostream>
+
+namespace {
+
+struct LoadServerMainOptions {
+  bool              shouldContinue;
+  unsigned short    port;
+  LoadServerOptions server;
+};
+
+LoadServerMainOptions
+readCommandLineArgs(const int argc, const char** argv) {
+  namespace po = boost::program_options;
+
+  LoadServerMainOptions result{};
+
+  po::options_description optionsDescription(
+      "Serves any host name with html pages on the loopback interface, for offline crawling benchmarks.\n"
+      "Use CURLOPT_CONNECT_TO \"::127.0.0.1:<port>\" to send the downloads of all hosts to it.\n\n"
+      "Supported options");
+  // clang-format off
+  optionsDescription.add_options()
+    ("port,p", po::value<unsigned short>(&result.port)->default_value(8080), "Listening port on 127.0.0.1.")
+    ("help,h", "produce help message")
+    ;
+  // clang-format on
+  addLoadServerOptions(optionsDescription, result.server);
+  configureLogging(optionsDescription);
+
+  po::variables_map variablesMap;
+  po::store(po::parse_command_line(argc, argv, optionsDescription), variablesMap);
+  po::notify(variablesMap);
+
+  if(variablesMap.count("help")) {
+    std::cout << optionsDescription << std::endl;
+    return LoadServerMainOptions{false};
+  }
+  result.shouldContinue = processLogging(variablesMap);
+  return result;
+}
+
+void
+loadServerLogic(const LoadServerMainOptions& options) {
+  LoadServer server{options.server, options.port};
+
+  boost::asio::io_context signalsContext;
+  boost::asio::signal_set signals{signalsContext, SIGINT, SIGTERM};
+  signals.async_wait([](const boost::system::error_code&, int) {});
+  signalsContext.run();
+
+  server.stop();
+  LOG_INFO("responses: " << server.nrResponses());
+}
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+  return handleExceptions(ProgramLogic<LoadServerMainOptions>(argc, argv, readCommandLineArgs, loadServerLogic));
+}
@@ -0,0 +1,75 @@
+#include "UrlFileReader.h"
+#include "benchmarkUrls.h"
+#include "readUrlsFromFile.h"
+
+#include "benchmark/benchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr size_t NR_FILE_URLS = 1000000;
+
+/**
+ * The url file is generated once and removed at exit.
+ */
+class BenchmarkUrlFile {
+public:
+  static const BenchmarkUrlFile& getInstance() {
+    static BenchmarkUrlFile instance;
+    return instance;
+  }
+
+  ~BenchmarkUrlFile() { std::remove(m_filename.c_str()); }
+
+  const std::string& filename() const { return m_filename; }
+  size_t             size() const { return m_size; }
+
+private:
+  BenchmarkUrlFile() : m_filename{"CheapCrawlerBenchmarkUrls.txt"}, m_size{0} {
+    std::ofstream output{m_filename, std::ios::binary};
+    for(const std::string& url: generateBenchmarkUrls(NR_FILE_URLS, NR_FILE_URLS / 100)) {
+      output << url << '\n';
+      m_size += url.size() + 1;
+    }
+  }
+
+  std::string m_filename;
+  size_t      m_size;
+};
+
+void
+readUrlsFromFileAtOnce(benchmark::State& state) {
+  const BenchmarkUrlFile& urlFile = BenchmarkUrlFile::getInstance();
+  for(auto _: state) {
+    benchmark::DoNotOptimize(readUrlsFromFile(urlFile.filename(), NR_FILE_URLS));
+  }
+  state.SetBytesProcessed(state.iterations() * urlFile.size());
+}
+BENCHMARK(readUrlsFromFileAtOnce)->Unit(benchmark::kMillisecond);
+
+/**
+ * Reads the file in batches without copying the urls, as the UrlFileDispatcher does.
+ */
+void
+urlFileReaderNext(benchmark::State& state) {
+  const BenchmarkUrlFile&       urlFile   = BenchmarkUrlFile::getInstance();
+  const auto                    batchSize = static_cast<size_t>(state.range(0));
+  std::vector<std::string_view> urls;
+  for(auto _: state) {
+    UrlFileReader reader{urlFile.filename(), NR_FILE_URLS};
+    while(!reader.finished()) {
+      urls.clear();
+      reader.next(batchSize, urls);
+      benchmark::DoNotOptimize(urls.data());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * urlFile.size());
+}
+BENCHMARK(urlFileReaderNext)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+} // namespace
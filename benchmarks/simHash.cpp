@@ -0,0 +1,77 @@
+#include "benchmarkUrls.h"
+#include "simHash.h"
+
+#include "benchmark/benchmark.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Pages of 64KiB with paragraphs of random words.
+ */
+std::vector<std::string>
+generateTextPages(const size_t nrPages) {
+  static const std::vector<std::string> WORDS{"the",     "of",     "and",      "crawler", "download", "page",   "news",
+                                              "article", "market", "price",    "weather", "today",    "server", "2019",
+                                              "search",  "result", "business", "sport",   "city",     "people"};
+  std::mt19937             random{BENCHMARK_SEED};
+  std::vector<std::string> result(nrPages);
+  for(std::string& page: result) {
+    page = "<html><body><div class=\"content\">";
+    while(page.size() < 64 * 1024) {
+      page += "<p>";
+      for(size_t word = 0; word < 20; ++word) {
+        page += WORDS[random() % WORDS.size()] + ' ';
+      }
+      page += "</p>\n";
+    }
+    page += "</div></body></html>";
+  }
+  return result;
+}
+
+void
+simHashPages(benchmark::State& state) {
+  static const std::vector<std::string> pages = generateTextPages(64);
+  size_t                                bytes = 0;
+  uint64_t                              hash  = 0;
+  for(auto _: state) {
+    for(const std::string& page: pages) {
+      hash ^= simHash(page, 4);
+      bytes += page.size();
+    }
+  }
+  benchmark::DoNotOptimize(hash);
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(simHashPages);
+
+// lookups into an index of state.range(0) random hashes, half of the looked up hashes are near duplicates
+void
+simHashIndexLookup(benchmark::State& state) {
+  std::mt19937_64 random{BENCHMARK_SEED};
+  SimHashIndex    index;
+  for(uint32_t id = 0; id < static_cast<uint32_t>(state.range(0)); ++id) {
+    index.insert(random(), id);
+  }
+  std::vector<uint64_t> queries;
+  std::mt19937_64       inserted{BENCHMARK_SEED};
+  for(size_t query = 0; query < 4096; ++query) {
+    queries.push_back(0 == query % 2 ? random() : inserted() ^ (uint64_t{1} << (query % 64)));
+  }
+  size_t   nrFound = 0;
+  uint32_t id      = 0;
+  for(auto _: state) {
+    for(const uint64_t query: queries) {
+      nrFound += index.findNear(query, id);
+    }
+  }
+  benchmark::DoNotOptimize(nrFound);
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(simHashIndexLookup)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,123 @@
+#include "Logger.h"
+LOG_INIT(crawlerConcurrencyController);
+
+#include "ConcurrencyController.h"
+#include "DownloadResult.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// fewer finished downloads do not give a meaningful error rate
+constexpr uint64_t MIN_FINISHED_FOR_ERROR_RATE = 10;
+
+Gauge& concurrencyLimit = getGauge("crawler_concurrency_limit", "Maximum number of simultaneous downloads.");
+
+Counter&
+decisionCounter(const char* const decision, const char* const reason) {
+  return getCounter("crawler_concurrency_decisions_total",
+                    "Changes of the maximum number of simultaneous downloads.",
+                    {{"decision", decision}, {"reason", reason}});
+}
+
+bool
+isCongestionError(const TransferError error) {
+  return TransferError::TIMEOUT == error || TransferError::CONNECT == error;
+}
+
+} // namespace
+
+ConcurrencyController::ConcurrencyController(const AdaptiveConcurrencyOptions& options,
+                                             const size_t                      initialLimit,
+                                             const SteadyTime                  now)
+    : m_options{options}
+    , m_limit{0}
+    , m_intervalStart{now}
+    , m_limitReached{false}
+    , m_increased{false}
+    , m_lastThroughput{0.}
+    , m_nrFinished{0}
+    , m_nrSucceeded{0}
+    , m_nrCongestionErrors{0} {
+  if(0 == options.minActiveDownloads || options.minActiveDownloads > options.maxActiveDownloads) {
+    throw std::invalid_argument("invalid adaptive concurrency limits: " + std::to_string(options.minActiveDownloads)
+                                + " - " + std::to_string(options.maxActiveDownloads));
+  }
+  if(!(options.decreaseFactor > 0. && options.decreaseFactor < 1.)) {
+    throw std::invalid_argument("adaptive concurrency decreaseFactor not in (0, 1): "
+                                + std::to_string(options.decreaseFactor));
+  }
+  if(options.interval <= std::chrono::milliseconds{0}) {
+    throw std::invalid_argument("adaptive concurrency interval not positive");
+  }
+  m_limit = std::clamp(initialLimit, options.minActiveDownloads, options.maxActiveDownloads);
+  concurrencyLimit.set(m_limit);
+}
+
+void
+ConcurrencyController::onFinished(const DownloadResult& result) {
+  m_nrFinished.fetch_add(1, std::memory_order_relaxed);
+  if(result.success) {
+    m_nrSucceeded.fetch_add(1, std::memory_order_relaxed);
+  }
+  else if(isCongestionError(result.transferError)) {
+    m_nrCongestionErrors.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+size_t
+ConcurrencyController::update(const SteadyTime now, const std::chrono::microseconds eventLoopLag) {
+  static Counter& increasedCounter           = decisionCounter("increase", "limit_reached");
+  static Counter& decreasedErrorsCounter     = decisionCounter("decrease", "errors");
+  static Counter& decreasedLagCounter        = decisionCounter("decrease", "event_loop_lag");
+  static Counter& decreasedThroughputCounter = decisionCounter("decrease", "throughput");
+
+  const double   elapsed     = std::max(std::chrono::duration<double>(now - m_intervalStart).count(), 1e-6);
+  const uint64_t nrFinished  = m_nrFinished.exchange(0, std::memory_order_relaxed);
+  const uint64_t nrSucceeded = m_nrSucceeded.exchange(0, std::memory_order_relaxed);
+  const uint64_t nrErrors    = m_nrCongestionErrors.exchange(0, std::memory_order_relaxed);
+  const double   throughput  = nrSucceeded / elapsed;
+  const double   errorRate   = 0 == nrFinished ? 0. : static_cast<double>(nrErrors) / nrFinished;
+
+  const char* reason   = nullptr;
+  Counter*    counter  = nullptr;
+  size_t      newLimit = m_limit;
+  if(nrFinished >= MIN_FINISHED_FOR_ERROR_RATE && errorRate > m_options.maxErrorRate) {
+    reason  = "errors";
+    counter = &decreasedErrorsCounter;
+  }
+  else if(eventLoopLag > m_options.maxEventLoopLag) {
+    reason  = "event loop lag";
+    counter = &decreasedLagCounter;
+  }
+  else if(m_increased && throughput < (1. - m_options.maxThroughputDrop) * m_lastThroughput) {
+    reason  = "throughput drop";
+    counter = &decreasedThroughputCounter;
+  }
+  if(nullptr != reason) {
+    newLimit = static_cast<size_t>(std::floor(m_limit * m_options.decreaseFactor));
+  }
+  else if(m_limitReached) {
+    reason   = "limit reached";
+    counter  = &increasedCounter;
+    newLimit = m_limit + m_options.increaseStep;
+  }
+  newLimit = std::clamp(newLimit, m_options.minActiveDownloads, m_options.maxActiveDownloads);
+
+  if(newLimit != m_limit) {
+    counter->add();
+    LOG_INFO("concurrency limit " << m_limit << " -> " << newLimit << " reason: " << reason
+                                  << " throughput: " << throughput << "/s error rate: " << errorRate
+                                  << " event loop lag: " << eventLoopLag.count() << "us");
+  }
+  m_increased      = newLimit > m_limit;
+  m_limit          = newLimit;
+  m_lastThroughput = throughput;
+  m_limitReached   = false;
+  m_intervalStart  = now;
+  concurrencyLimit.set(m_limit);
+  return m_limit;
+}
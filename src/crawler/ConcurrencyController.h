@@ -0,0 +1,59 @@
+#ifndef CRAWLER_CONCURRENCYCONTROLLER_H_B6JX3QWN
+#define CRAWLER_CONCURRENCYCONTROLLER_H_B6JX3QWN
+
+#include "Url.h"
+#include "crawler/crawler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * AIMD controller of the maximum number of simultaneous downloads, see AdaptiveConcurrencyOptions.
+ * The downloads are counted from the threads of the downloader, the limit is updated from the crawling thread.
+ */
+class ConcurrencyController {
+public:
+  /**
+   * @param initialLimit moved into the limits of the options
+   * @throws std::invalid_argument for invalid options
+   */
+  ConcurrencyController(const AdaptiveConcurrencyOptions& options, size_t initialLimit, SteadyTime now);
+
+  /**
+   * Counts a finished download, thread safe.
+   */
+  void onFinished(const DownloadResult& result);
+
+  /**
+   * A download was due but the limit was reached.
+   */
+  void onLimitReached() { m_limitReached = true; }
+
+  /**
+   * @returns true if the current interval passed and update() should be called
+   */
+  bool due(const SteadyTime now) const { return now >= m_intervalStart + m_options.interval; }
+
+  /**
+   * Evaluates the interval ending at now and starts the next one.
+   * @param eventLoopLag the longest delay of the event loop of the downloader during the interval
+   * @returns the new limit
+   */
+  size_t update(SteadyTime now, std::chrono::microseconds eventLoopLag);
+
+  size_t limit() const { return m_limit; }
+
+private:
+  AdaptiveConcurrencyOptions m_options;
+  size_t                     m_limit;
+  SteadyTime                 m_intervalStart;
+  bool                       m_limitReached;
+  bool                       m_increased;      // by the previous update
+  double                     m_lastThroughput; // successful downloads per second of the previous interval
+  std::atomic<uint64_t>      m_nrFinished;
+  std::atomic<uint64_t>      m_nrSucceeded;
+  std::atomic<uint64_t>      m_nrCongestionErrors; // timeouts and connection errors
+};
+
+#endif /* end of include guard: CRAWLER_CONCURRENCYCONTROLLER_H_B6JX3QWN */
@@ -3,18 +3,35 @@ LOG_INIT(crawlerCurlAsioDownloader);
 
 #include "crawler/CurlAsioDownloader.h"
 
+#include "BandwidthLimiter.h"
 #include "CurlGlobalManager.h"
 #include "CurlMultiManager.h"
 #include "DownloadManager.h"
+#include "DownloadResult.h"
+#include "HostResolver.h"
+#include "TransferTimeouts.h"
 #include "throwOnError.h"
 
+#include "Metrics.h"
+#include "MetricsEndpoint.h"
 #include "handleExceptions.h"
 #include "throwOnError.h"
 #include "unique_resource.h"
+#include "uriUtils/uriUtils.h"
 
+#include <atomic>
+#include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <sys/socket.h>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 using boost::asio::io_context;
 using BErrorCode = boost::system::error_code;
@@ -26,6 +43,37 @@ using SocketIt   = SocketsMap::iterator;
 
 namespace {
 
+Gauge&     openSockets     = getGauge("crawler_open_sockets", "Sockets opened by curl and not yet closed.");
+Counter&   openedSockets   = getCounter("crawler_opened_sockets_total", "Sockets opened by curl.");
+Gauge&     activeTransfers = getGauge("crawler_curl_transfers", "Transfers added to curl and not yet finished.");
+Counter&   socketActions   = getCounter("crawler_socket_actions_total", "Socket events passed to curl.");
+Histogram& dispatchTime    = getHistogram("crawler_dispatch_latency_seconds",
+                                          "Time from popping a download until its transfer is added to curl.",
+                                          1e-6);
+Histogram& loopLag         = getHistogram("crawler_event_loop_lag_seconds",
+                                          "Delay of a periodic timer of the downloader event loop.",
+                                          1e-6);
+Counter&   prewarmedConnections = getCounter("crawler_prewarmed_connections_total",
+                                           "Connections opened ahead of their download by a prewarm.");
+Counter&   unusedPrewarms       = getCounter("crawler_prewarmed_connections_unused_total",
+                                     "Prewarmed connections closed without being taken by a download.");
+Counter&   closedPrewarms       = getCounter("crawler_prewarmed_connections_closed_total",
+                                     "Prewarmed connections found closed by the server when a download took them.");
+Histogram& prewarmSavedTime     = getHistogram("crawler_prewarm_saved_seconds",
+                                           "Connect time of the prewarmed connections taken by a download.",
+                                           1e-6);
+
+// getaddrinfo blocks a resolver thread during each resolution
+constexpr size_t RESOLVER_THREADS = 16;
+
+#if LIBCURL_VERSION_NUM >= 0x074300
+// streams of a multiplexed connection, the servers usually allow 100 or more
+constexpr long MAX_CONCURRENT_STREAMS = 100;
+#endif
+
+// the event loop lag is measured with a timer of this period
+constexpr std::chrono::milliseconds LAG_PROBE_PERIOD{100};
+
 struct ThreadReleaser {
   void operator()(std::thread& t) const {
     handleExceptions([&] { t.join(); });
@@ -36,6 +84,81 @@ struct StopIoService {
   void operator()(io_context* ioService) { ioService->stop(); }
 };
 
+CurlSlist
+makeCurlSlist(const std::vector<std::string>& strings) {
+  CurlSlist result;
+  for(const std::string& string: strings) {
+    curl_slist* const list = curl_slist_append(result.get(), string.c_str());
+    if(nullptr == list) {
+      throw std::runtime_error("curl_slist_append failed for: " + string);
+    }
+    result.release();
+    result.reset(list);
+  }
+  return result;
+}
+
+/**
+ * Splits the host and the port of url with splitOrigin, the brackets of an IPv6 host are removed and the port defaults
+ * to the one of the scheme.
+ * @returns false if url has no http or https origin or an invalid port
+ */
+bool
+hostAndPortOf(const std::string_view url, std::string& o_host, std::string& o_port) {
+  std::string buffer;
+  UrlParts    parts;
+  if(!splitOrigin(url, buffer, parts) || ("http" != parts.scheme && "https" != parts.scheme)) {
+    return false;
+  }
+  std::string_view host = parts.host;
+  if(host.size() > 1 && '[' == host.front()) {
+    host = host.substr(1, host.size() - 2);
+  }
+  o_host = std::string{host};
+  o_port = parts.port.empty() ? ("https" == parts.scheme ? "443" : "80") : std::string{parts.port};
+  return o_port.size() <= 5 && std::stoul(o_port) <= std::numeric_limits<unsigned short>::max();
+}
+
+/**
+ * A connection idle since its prewarm may have been closed by the server meanwhile, curl would then report the
+ * download as a failed connect. The server sends nothing before the request, thus pending bytes are unexpected too.
+ * @returns true if the connection is still open without pending bytes
+ */
+bool
+isIdleAndOpen(tcp::socket& socket) {
+  char          byte;
+  const ssize_t received = ::recv(socket.native_handle(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return received < 0 && (EAGAIN == errno || EWOULDBLOCK == errno);
+}
+
+/**
+ * Redirects host and port as curl does with the first matching CURLOPT_CONNECT_TO entry
+ * HOST:PORT:CONNECT-TO-HOST:CONNECT-TO-PORT, empty fields match any host or port, respectively keep it.
+ * Entries with IPv6 addresses are skipped.
+ */
+void
+applyConnectTo(const std::vector<std::string>& connectTo, std::string& host, std::string& port) {
+  for(const std::string& entry: connectTo) {
+    std::vector<std::string> fields;
+    boost::split(fields, entry, [](const char c) { return ':' == c; });
+    if(4 != fields.size()) {
+      continue;
+    }
+    if((fields[0].empty() || boost::iequals(fields[0], host)) && (fields[1].empty() || fields[1] == port)) {
+      host = fields[2].empty() ? host : fields[2];
+      port = fields[3].empty() ? port : fields[3];
+      return;
+    }
+  }
+}
+
+bool
+isIpAddress(const std::string& host) {
+  BErrorCode error;
+  boost::asio::ip::make_address(host, error);
+  return !error;
+}
+
 [[maybe_unused]] std::string
 to_stringAction(const int action) {
   switch(action) {
@@ -69,13 +192,96 @@ getPrevAction(SocketIt socketIt) {
 
 struct CurlAsioDownloader::Pimpl {
 public:
-  Pimpl(size_t maxContentLength, std::function<bool(const MediaType&)>&& mediaTypeValidator);
+  Pimpl(size_t                                  maxContentLength,
+        std::function<bool(const MediaType&)>&& mediaTypeValidator,
+        CurlAsioDownloaderOptions&&             options);
 
   void download(DownloadElem&& downloadElem);
 
+  void prewarm(std::string_view url) {
+    boost::asio::post(m_io_context, [this, url = std::string{url}]() { connectAhead(url); });
+  }
+
+  void prefetchHost(std::string_view url) {
+    boost::asio::post(m_io_context, [this, url = std::string{url}]() {
+      std::string host;
+      std::string port;
+      if(connectOrigin(url, host, port) && !isIpAddress(host)) {
+        m_hostResolver.prefetch(host);
+      }
+    });
+  }
+
+  /**
+   * @returns the longest lag measured since the previous call, thread safe
+   */
+  std::chrono::microseconds takeEventLoopLag() {
+    return std::chrono::microseconds{m_maxEventLoopLagUs.exchange(0, std::memory_order_relaxed)};
+  }
+
 private:
+  /**
+   * A connection opened by a prewarm, handed to curl by openSocket() for its address.
+   */
+  struct PrewarmedSocket {
+    tcp::socket               socket;
+    SteadyTime                connected;
+    std::chrono::microseconds connectTime;
+  };
+
   void newDownload(DownloadElem&& downloadElem);
 
+  /**
+   * Adds the transfer to curl.
+   * @param resolve CURLOPT_RESOLVE entries of the host, empty if curl resolves it
+   */
+  void addTransfer(DownloadElem&& downloadElem, const std::vector<std::string>& resolve);
+
+  /**
+   * Splits url into the host and the port curl connects to, after the connectTo redirections.
+   * @returns false if url has no http or https origin
+   */
+  bool connectOrigin(std::string_view url, std::string& o_host, std::string& o_port) const {
+    if(!hostAndPortOf(url, o_host, o_port)) {
+      return false;
+    }
+    applyConnectTo(m_connectToEntries, o_host, o_port);
+    return true;
+  }
+
+  /**
+   * Calls callback with the addresses of host, resolved by the HostResolver unless host is an IP address.
+   */
+  void resolveHost(const std::string& host, HostResolver::Callback&& callback) {
+    if(isIpAddress(host)) {
+      callback(DnsAnswer{{host}, SteadyTime::max()});
+      return;
+    }
+    m_hostResolver.resolve(host, std::move(callback));
+  }
+
+  /**
+   * Resolves the host of url and connects to it, the connection waits for a download in m_prewarmed.
+   */
+  void connectAhead(const std::string& url);
+
+  /**
+   * @returns the prewarmed socket connected to address or an invalid socket
+   */
+  curl_socket_t takePrewarmed(const curl_sockaddr* address);
+
+  void closeIdlePrewarms();
+
+  /**
+   * Measures how late the lag timer expired, expected is when it should have expired.
+   */
+  void probeEventLoopLag(SteadyTime expected);
+
+  /**
+   * Resumes the transfers paused by the bandwidth limiter at time.
+   */
+  void resumeTransfersAt(SteadyTime time);
+
   static curl_socket_t openSocketCb(void* clientp, curlsocktype purpose, curl_sockaddr* address) {
     return static_cast<Pimpl*>(clientp)->openSocket(purpose, address);
   }
@@ -86,6 +292,12 @@ private:
   }
   int closeSocket(curl_socket_t item);
 
+  static int sockoptCb(void* clientp, curl_socket_t curlSocket, curlsocktype) {
+    // curl skips the connect of the prewarmed sockets
+    return 1 == static_cast<Pimpl*>(clientp)->m_connectedSockets.erase(curlSocket) ? CURL_SOCKOPT_ALREADY_CONNECTED
+                                                                                     : CURL_SOCKOPT_OK;
+  }
+
   static int socketActionCb(CURL* e, curl_socket_t curlSocket, int what, void* userp, void* sockp) {
     static_cast<Pimpl*>(userp)->addSocketActions(e, curlSocket, what, sockp);
     // must return 0 nothing to control from this return value
@@ -127,24 +339,70 @@ private:
   CurlMultiManager                                               m_multi;
   size_t                                                         m_maxContentLength;
   std::function<bool(const MediaType&)>                          m_mediaTypeValidator;
+  CurlSlist                                                      m_connectTo;
+  std::unique_ptr<BandwidthLimiter>                              m_bandwidthLimiter; // nullptr without limits
+  boost::asio::steady_timer                                      m_bandwidthTimer;
+  std::vector<std::string>                                       m_connectToEntries;
+  HostResolver                                                   m_hostResolver;
+  std::multimap<tcp::endpoint, PrewarmedSocket>                  m_prewarmed;
+  std::unordered_set<std::string>                                m_prewarming;       // origins being connected
+  std::unordered_set<curl_socket_t>                              m_connectedSockets; // prewarmed, handed to curl
+  TransferTimeouts                                               m_timeouts;
+  std::unique_ptr<SegmentFiles>                                  m_segmentFiles; // nullptr without streaming
+  TransferOptions                                                m_transferOptions;
   std::list<DownloadManager>                                     m_downloads;
   boost::asio::executor_work_guard<io_context::executor_type>    m_workGuard;
   boost::asio::deadline_timer                                    m_timer;
+  boost::asio::steady_timer                                      m_lagTimer;
+  std::atomic<int64_t>                                           m_maxEventLoopLagUs;
+  std::unique_ptr<MetricsEndpoint>                               m_metricsEndpoint;
   std_experimental::unique_resource<std::thread, ThreadReleaser> m_thread;
   std::unique_ptr<io_context, StopIoService>                     m_ioServiceStopper;
 };
 
 // class CurlAsioDownloader::Pimpl
-CurlAsioDownloader::Pimpl::Pimpl(size_t maxContentLength, std::function<bool(const MediaType&)>&& mediaTypeValidator)
+CurlAsioDownloader::Pimpl::Pimpl(size_t                                  maxContentLength,
+                                 std::function<bool(const MediaType&)>&& mediaTypeValidator,
+                                 CurlAsioDownloaderOptions&&             options)
     : m_io_context{}
     , m_sockets{}
     , m_global{}
     , m_multi{}
     , m_maxContentLength{maxContentLength}
     , m_mediaTypeValidator{std::move(mediaTypeValidator)}
+    , m_connectTo{makeCurlSlist(options.connectTo)}
+    , m_bandwidthLimiter{0 == options.bandwidthLimits.bytesPerSecond && 0 == options.bandwidthLimits.hostBudgetBytes
+                                 && 0 == options.bandwidthLimits.memoryBudgetBytes
+                             ? nullptr
+                             : std::make_unique<BandwidthLimiter>(
+                                 options.bandwidthLimits,
+                                 [this](const SteadyTime time) { resumeTransfersAt(time); },
+                                 [this]() {
+                                   boost::asio::post(m_io_context, [this]() { m_bandwidthLimiter->resume(); });
+                                 })}
+    , m_bandwidthTimer{m_io_context}
+    , m_connectToEntries{std::move(options.connectTo)}
+    , m_hostResolver{m_io_context, options.dnsCacheLimits, RESOLVER_THREADS}
+    , m_prewarmed{}
+    , m_prewarming{}
+    , m_connectedSockets{}
+    , m_timeouts{options.timeoutOptions}
+    , m_segmentFiles{options.streamingOptions.directory.empty()
+                         ? nullptr
+                         : std::make_unique<SegmentFiles>(options.streamingOptions)}
+    , m_transferOptions{m_connectTo.get(),
+                        m_bandwidthLimiter.get(),
+                        &m_timeouts,
+                        m_segmentFiles.get(),
+                        std::move(options.scannerFactory)}
     , m_downloads{}
     , m_workGuard{boost::asio::make_work_guard(m_io_context)}
     , m_timer{m_io_context}
+    , m_lagTimer{m_io_context}
+    , m_maxEventLoopLagUs{0}
+    , m_metricsEndpoint{0 == options.metricsPort
+                            ? nullptr
+                            : std::make_unique<MetricsEndpoint>(m_io_context, options.metricsPort)}
     , m_thread{std::thread{[this]() { m_io_context.run(); }}, ThreadReleaser{}}
     , m_ioServiceStopper{&m_io_context} {
   throwOnError(curl_multi_setopt(m_multi.get(), CURLMOPT_SOCKETFUNCTION, socketActionCb),
@@ -153,6 +411,44 @@ CurlAsioDownloader::Pimpl::Pimpl(size_t maxContentLength, std::function<bool(con
   throwOnError(curl_multi_setopt(m_multi.get(), CURLMOPT_TIMERFUNCTION, timerCurlCb),
                "curl_multi_setopt CURLMOPT_TIMERFUNCTION");
   throwOnError(curl_multi_setopt(m_multi.get(), CURLMOPT_TIMERDATA, this), "curl_multi_setopt CURLMOPT_TIMERDATA");
+  throwOnError(curl_multi_setopt(m_multi.get(), CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX),
+               "curl_multi_setopt CURLMOPT_PIPELINING");
+#if LIBCURL_VERSION_NUM >= 0x074300
+  // older curl versions open as many streams as the server allows
+  throwOnError(curl_multi_setopt(m_multi.get(), CURLMOPT_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS),
+               "curl_multi_setopt CURLMOPT_MAX_CONCURRENT_STREAMS");
+#endif
+  boost::asio::post(m_io_context, [this]() { probeEventLoopLag(std::chrono::steady_clock::now()); });
+}
+
+void
+CurlAsioDownloader::Pimpl::probeEventLoopLag(const SteadyTime expected) {
+  const SteadyTime now = std::chrono::steady_clock::now();
+  const auto       lag
+      = std::chrono::duration_cast<std::chrono::microseconds>(std::max(now - expected, SteadyTime::duration::zero()));
+  loopLag.recordDuration(lag);
+  int64_t maxLag = m_maxEventLoopLagUs.load(std::memory_order_relaxed);
+  while(maxLag < lag.count()
+        && !m_maxEventLoopLagUs.compare_exchange_weak(maxLag, lag.count(), std::memory_order_relaxed)) {
+    // maxLag was reloaded by the failed exchange
+  }
+  const SteadyTime next = now + LAG_PROBE_PERIOD;
+  m_lagTimer.expires_at(next);
+  m_lagTimer.async_wait([this, next](const BErrorCode& error) {
+    if(!error) {
+      probeEventLoopLag(next);
+    }
+  });
+}
+
+void
+CurlAsioDownloader::Pimpl::resumeTransfersAt(const SteadyTime time) {
+  m_bandwidthTimer.expires_at(time);
+  m_bandwidthTimer.async_wait([this](const BErrorCode& error) {
+    if(!error) {
+      m_bandwidthLimiter->resume();
+    }
+  });
 }
 
 void
@@ -165,18 +461,158 @@ CurlAsioDownloader::Pimpl::download(DownloadElem&& downloadElem) {
 void
 CurlAsioDownloader::Pimpl::newDownload(DownloadElem&& downloadElem) {
   LOG_DEBUG("newDownload: " << downloadElem);
-  OpenCloseSocketConfig openCloseSocketConfig{&openSocketCb, this, &closeSocketCb, this};
-  m_downloads.emplace_back(
-      m_multi.get(), std::move(downloadElem), m_maxContentLength, m_mediaTypeValidator, &openCloseSocketConfig);
+  if(SteadyTime{} != downloadElem.times.popped) {
+    dispatchTime.recordDuration(std::chrono::steady_clock::now() - downloadElem.times.popped);
+  }
+  if(m_bandwidthLimiter && !m_bandwidthLimiter->admit(std::get<0>(downloadElem.url))) {
+    downloadElem.callback(DownloadResult{std::move(downloadElem.url),
+                                         std::string{},
+                                         MediaType{},
+                                         false,
+                                         "host byte budget exceeded",
+                                         0.,
+                                         TransferError::CONTENT_REJECTED});
+    return;
+  }
+  std::string host;
+  std::string port;
+  if(!connectOrigin(std::get<0>(downloadElem.url), host, port)) {
+    // curl reports the error of the url
+    addTransfer(std::move(downloadElem), {});
+    return;
+  }
+  if(isIpAddress(host)) {
+    // curl connects to an IP address without a CURLOPT_RESOLVE entry
+    addTransfer(std::move(downloadElem), {});
+    return;
+  }
+  resolveHost(host,
+              [this, downloadElem = std::move(downloadElem), host, port](const DnsAnswer& answer) mutable {
+                if(answer.addresses.empty()) {
+                  downloadElem.callback(DownloadResult{std::move(downloadElem.url),
+                                                       std::string{},
+                                                       MediaType{},
+                                                       false,
+                                                       "could not resolve host: " + host,
+                                                       0.,
+                                                       TransferError::DNS});
+                  return;
+                }
+                addTransfer(std::move(downloadElem), curlResolveEntries(host, port, answer));
+              });
+}
+
+void
+CurlAsioDownloader::Pimpl::addTransfer(DownloadElem&& downloadElem, const std::vector<std::string>& resolve) {
+  OpenCloseSocketConfig openCloseSocketConfig{&openSocketCb, this, &closeSocketCb, this, &sockoptCb, this};
+  m_downloads.emplace_back(m_multi.get(),
+                           std::move(downloadElem),
+                           m_maxContentLength,
+                           m_mediaTypeValidator,
+                           &openCloseSocketConfig,
+                           &m_transferOptions,
+                           resolve);
   LOG_DEBUG("newDownload emplaced back");
+  activeTransfers.add(1);
   auto addedElemIt = --end(m_downloads);
   m_downloads.back().setFinishedCallback([this, addedElemIt]() {
     LOG_DEBUG("newDownload finished callback, erasing ...");
     m_downloads.erase(addedElemIt);
+    activeTransfers.add(-1);
   });
   LOG_DEBUG("newDownload set finished callback");
 }
 
+void
+CurlAsioDownloader::Pimpl::connectAhead(const std::string& url) {
+  closeIdlePrewarms();
+  std::string host;
+  std::string port;
+  if(!connectOrigin(url, host, port)) {
+    return;
+  }
+  std::string origin = host + ':' + port;
+  if(!m_prewarming.insert(origin).second) {
+    return;
+  }
+  resolveHost(host, [this, origin, port](const DnsAnswer& answer) {
+    std::vector<tcp::endpoint> endpoints;
+    for(const std::string& address: answer.addresses) {
+      BErrorCode error;
+      const auto ipAddress = boost::asio::ip::make_address(address, error);
+      if(!error) {
+        endpoints.emplace_back(ipAddress, static_cast<unsigned short>(std::stoul(port)));
+      }
+    }
+    if(endpoints.empty()) {
+      LOG_DEBUG("prewarm resolve failed: " << origin);
+      m_prewarming.erase(origin);
+      return;
+    }
+    const SteadyTime start  = std::chrono::steady_clock::now();
+    auto             socket = std::make_shared<tcp::socket>(m_io_context);
+    boost::asio::async_connect(
+        *socket, endpoints, [this, origin, socket, start](const BErrorCode& error, const tcp::endpoint& endpoint) {
+          m_prewarming.erase(origin);
+          if(error) {
+            LOG_DEBUG("prewarm connect failed: " << origin << ' ' << error.message());
+            return;
+          }
+          const SteadyTime now = std::chrono::steady_clock::now();
+          m_prewarmed.emplace(
+              endpoint,
+              PrewarmedSocket{
+                  std::move(*socket), now, std::chrono::duration_cast<std::chrono::microseconds>(now - start)});
+          prewarmedConnections.add();
+          openedSockets.add();
+        });
+  });
+}
+
+curl_socket_t
+CurlAsioDownloader::Pimpl::takePrewarmed(const curl_sockaddr* const address) {
+  closeIdlePrewarms();
+  tcp::endpoint endpoint;
+  if(address->addrlen > endpoint.capacity()) {
+    return CURL_SOCKET_BAD;
+  }
+  std::memcpy(endpoint.data(), &address->addr, address->addrlen);
+  endpoint.resize(address->addrlen);
+  auto prewarmedIt = m_prewarmed.find(endpoint);
+  while(end(m_prewarmed) != prewarmedIt && prewarmedIt->first == endpoint
+        && !isIdleAndOpen(prewarmedIt->second.socket)) {
+    LOG_DEBUG("prewarmed connection closed by the server: " << endpoint);
+    closedPrewarms.add();
+    prewarmedIt = m_prewarmed.erase(prewarmedIt);
+  }
+  if(end(m_prewarmed) == prewarmedIt || prewarmedIt->first != endpoint) {
+    return CURL_SOCKET_BAD;
+  }
+  prewarmSavedTime.recordDuration(prewarmedIt->second.connectTime);
+  tcp::socket tcpSocket = std::move(prewarmedIt->second.socket);
+  m_prewarmed.erase(prewarmedIt);
+  const curl_socket_t sockfd = tcpSocket.native_handle();
+  m_sockets.emplace(sockfd, std::make_tuple(std::move(tcpSocket), CURL_POLL_NONE));
+  m_connectedSockets.insert(sockfd);
+  openSockets.add(1);
+  LOG_DEBUG("openSocket prewarmed:" << sockfd);
+  return sockfd;
+}
+
+void
+CurlAsioDownloader::Pimpl::closeIdlePrewarms() {
+  const SteadyTime oldest = std::chrono::steady_clock::now() - m_timeouts.options().prewarmIdle;
+  for(auto prewarmedIt = begin(m_prewarmed); prewarmedIt != end(m_prewarmed);) {
+    if(prewarmedIt->second.connected < oldest) {
+      unusedPrewarms.add();
+      prewarmedIt = m_prewarmed.erase(prewarmedIt);
+    }
+    else {
+      ++prewarmedIt;
+    }
+  }
+}
+
 curl_socket_t
 CurlAsioDownloader::Pimpl::openSocket(curlsocktype purpose, curl_sockaddr* address) {
   if(m_io_context.stopped()) {
@@ -186,6 +622,12 @@ CurlAsioDownloader::Pimpl::openSocket(curlsocktype purpose, curl_sockaddr* addre
   if(purpose != CURLSOCKTYPE_IPCXN) {
     throw std::runtime_error("openSocketCb received unexpected purpose: " + std::to_string(purpose));
   }
+  if(!m_prewarmed.empty()) {
+    const curl_socket_t prewarmed = takePrewarmed(address);
+    if(CURL_SOCKET_BAD != prewarmed) {
+      return prewarmed;
+    }
+  }
   tcp::socket tcpSocket{m_io_context};
   switch(address->family) {
     case AF_INET:
@@ -199,6 +641,8 @@ CurlAsioDownloader::Pimpl::openSocket(curlsocktype purpose, curl_sockaddr* addre
   }
   const curl_socket_t sockfd = tcpSocket.native_handle();
   m_sockets.emplace(sockfd, std::make_tuple(std::move(tcpSocket), CURL_POLL_NONE));
+  openSockets.add(1);
+  openedSockets.add();
   LOG_DEBUG("openSocket:" << sockfd);
   return sockfd;
 }
@@ -214,6 +658,7 @@ CurlAsioDownloader::Pimpl::closeSocket(curl_socket_t item) {
   if(1 != erasedItems) {
     throw std::runtime_error("closeSocket unexpected number of sockets closed: " + std::to_string(erasedItems));
   }
+  openSockets.add(-1);
   return 0;
 }
 
@@ -233,6 +678,7 @@ CurlAsioDownloader::Pimpl::doSocketAction(curl_socket_t curlSocket, int action,
       action = CURL_CSELECT_ERR;
     }
     int activeDownloads;
+    socketActions.add();
     throwOnError(curl_multi_socket_action(m_multi.get(), curlSocket, action, &activeDownloads),
                  "curl_multi_socket_action");
     processFinishedDownloads();
@@ -275,7 +721,8 @@ CurlAsioDownloader::Pimpl::addSocketActions(CURL* const         easyHandle,
   }
   const auto socketIt = m_sockets.find(curlSocket);
   if(socketIt == m_sockets.end()) {
-    LOG_INFO("Socket " << curlSocket << " is a c-ares socket, ignoring - C library for asynchronous DNS requests");
+    // the hosts are resolved by the HostResolver, curl resolves only the urls it rejects
+    LOG_INFO("Socket " << curlSocket << " was not opened by openSocket, ignoring");
     return;
   }
   LOG_DEBUG("addSocketActions: "
@@ -339,8 +786,9 @@ CurlAsioDownloader::Pimpl::processFinishedDownloads() {
 
 // class CurlAsioDownloader
 CurlAsioDownloader::CurlAsioDownloader(const size_t                          maxContentLength,
-                                       std::function<bool(const MediaType&)> mediaTypeValidator)
-    : m_pimpl{std::make_unique<Pimpl>(maxContentLength, std::move(mediaTypeValidator))} {}
+                                       std::function<bool(const MediaType&)> mediaTypeValidator,
+                                       CurlAsioDownloaderOptions             options)
+    : m_pimpl{std::make_unique<Pimpl>(maxContentLength, std::move(mediaTypeValidator), std::move(options))} {}
 
 CurlAsioDownloader::~CurlAsioDownloader() {}
 
@@ -348,3 +796,18 @@ void
 CurlAsioDownloader::doDownload(DownloadElem&& downloadElem) {
   m_pimpl->download(std::move(downloadElem));
 }
+
+std::chrono::microseconds
+CurlAsioDownloader::doEventLoopLag() {
+  return m_pimpl->takeEventLoopLag();
+}
+
+void
+CurlAsioDownloader::doPrewarm(const std::string_view url) {
+  m_pimpl->prewarm(url);
+}
+
+void
+CurlAsioDownloader::doPrefetchHost(const std::string_view url) {
+  m_pimpl->prefetchHost(url);
+}
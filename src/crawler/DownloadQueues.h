@@ -1,67 +1,207 @@
 #ifndef CRAWLER_DOWNLOADQUEUES_H_3VTDLUMK
 #define CRAWLER_DOWNLOADQUEUES_H_3VTDLUMK
 
-#include "Url.h"
-#include <iterator>
+#include "DownloadResult.h"
+#include "UrlArena.h"
+
+#include <algorithm>
 #include <map>
 #include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * An url waiting in a download queue.
+ * The urls are stored in the UrlArena of the crawled batch.
+ */
+struct QueuedUrl {
+  UrlHandle url;
+  bool      isRobotsTxt;
+};
+
+/**
+ * What the crawler learns about the host of a download queue from a finished download.
+ */
+struct TransferOutcome {
+  TransferError transferError{TransferError::NONE};
+  bool          multiplexed{false}; // see DownloadResult::multiplexed
+};
+
+/**
+ * The simultaneous downloads of a download queue, see HostConcurrency.
+ * A queue is at most once in the TimeHeap, it is pushed again after a pop while it has free slots.
+ */
+struct HostSlots {
+  uint16_t limit{1};
+  uint16_t maxLimit{1};         // the limit grows up to maxLimit, 1 and limit for a fixed limit
+  uint16_t inFlight{0};         // downloads popped and not finished
+  uint16_t nrSucceeded{0};      // successful downloads since the last change of the limit
+  uint16_t multiplexedLimit{0}; // limit once the host answered over a multiplexed connection, 0 keeps the limit
+  bool     scheduled{false};
+
+  bool hasFreeSlot() const { return inFlight < limit; }
+
+  void adapt(const TransferOutcome& outcome) {
+    if(outcome.multiplexed && multiplexedLimit > maxLimit) {
+      maxLimit = multiplexedLimit;
+      limit    = multiplexedLimit;
+    }
+    adapt(outcome.transferError);
+  }
+
+  /**
+   * Grows the limit by one after limit successful downloads and halves it on timeouts and connection errors.
+   */
+  void adapt(const TransferError error) {
+    if(TransferError::TIMEOUT == error || TransferError::CONNECT == error || TransferError::NETWORK == error) {
+      limit       = std::max<uint16_t>(1, limit / 2);
+      nrSucceeded = 0;
+    }
+    else if(TransferError::NONE == error && ++nrSucceeded >= limit && limit < maxLimit) {
+      ++limit;
+      nrSucceeded = 0;
+    }
+  }
+};
+
+enum class CircuitState : uint8_t {
+  CLOSED,  // the downloads run, the consecutive host failures are counted
+  OPEN,    // the queue waits for the cooldown, its next download probes the host
+  PROBING, // the probe is in flight, nothing else is popped from the queue
+  TRIPPED  // the probe failed, the urls of the queue are failed without a download
+};
+
+/**
+ * The health of the host of a download queue, see CircuitBreakerOptions.
+ */
+struct HostCircuit {
+  CircuitState state{CircuitState::CLOSED};
+  uint16_t     nrFailures{0}; // consecutive host failures while CLOSED
+  uint16_t     nrStale{0};    // downloads in flight when the circuit opened, their outcome is ignored
+  SteadyTime   probeTime{};   // end of the cooldown while OPEN
+
+  bool admitsDownloads() const { return CircuitState::CLOSED == state; }
+
+  /**
+   * @returns true for the errors telling that the host is down or unreachable, not that one url failed
+   */
+  static bool isHostFailure(const TransferError error) {
+    return TransferError::TIMEOUT == error || TransferError::CONNECT == error || TransferError::DNS == error;
+  }
+};
+
+/**
+ * The downloads of one host, or of the hosts sharing a politeness key.
+ * The robots.txt downloads are always popped before the other urls.
+ */
+struct DownloadQueue {
+  std::vector<UrlHandle> robotsTxts;
+  std::vector<UrlHandle> urls;
+  HostSlots              slots;
+  HostCircuit            circuit;
+};
 
 class DownloadQueues {
 public:
-  using DownloadQueueIt = std::map<std::string, DownloadQueue>::iterator;
+  using DownloadQueueIt = std::map<std::string, DownloadQueue, std::less<>>::iterator;
 
-  DownloadQueueIt getQueueByHost(const std::string& host) {
-    auto dwListMapIt = m_downloads.find(host);
+  /**
+   * @param politenessKey the host of the urls or the key grouping their hosts, see PolitenessKey
+   */
+  DownloadQueueIt getQueue(std::string_view politenessKey) {
+    auto dwListMapIt = m_downloads.find(politenessKey);
     if(end() == dwListMapIt) {
-      dwListMapIt = m_downloads.insert(std::make_pair(host, DownloadQueue{})).first;
+      dwListMapIt = m_downloads.insert(std::make_pair(std::string{politenessKey}, DownloadQueue{})).first;
     }
     return dwListMapIt;
   }
 
-  void addDownload(DownloadQueueIt dwQueue, DownloadElem download) {
-    dwQueue->second.emplace_back(std::move(download));
+  void addDownload(DownloadQueueIt dwQueue, const UrlHandle& download) { dwQueue->second.urls.push_back(download); }
+
+  void addDownloads(DownloadQueueIt dwQueue, std::vector<UrlHandle>&& downloads) {
+    std::vector<UrlHandle>& urls = dwQueue->second.urls;
+    if(urls.empty()) {
+      urls = std::move(downloads);
+    }
+    else {
+      urls.insert(urls.end(), downloads.begin(), downloads.end());
+    }
+    downloads = std::vector<UrlHandle>{};
+  }
+
+  void addRobotsTxtDownload(DownloadQueueIt dwQueue, const UrlHandle& download) {
+    dwQueue->second.robotsTxts.push_back(download);
   }
 
-  DownloadElem popDownload(DownloadQueueIt dwQueue) {
-    if(dwQueue->second.empty()) {
+  QueuedUrl popDownload(DownloadQueueIt dwQueue) {
+    std::vector<UrlHandle>& robotsTxts = dwQueue->second.robotsTxts;
+    std::vector<UrlHandle>& urls       = dwQueue->second.urls;
+    if(!robotsTxts.empty()) {
+      const QueuedUrl result{robotsTxts.back(), true};
+      robotsTxts.pop_back();
+      return result;
+    }
+    if(urls.empty()) {
       throw std::runtime_error("DownloadQueues ERROR: poping from empty queue");
     }
-    DownloadElem result = dwQueue->second.back();
-    dwQueue->second.pop_back();
+    const QueuedUrl result{urls.back(), false};
+    urls.pop_back();
     return result;
   }
 
+  /**
+   * @returns the url popDownload() would return, dwQueue must not be empty
+   */
+  const UrlHandle& peekDownload(DownloadQueueIt dwQueue) const {
+    const DownloadQueue& queue = dwQueue->second;
+    return queue.robotsTxts.empty() ? queue.urls.back() : queue.robotsTxts.back();
+  }
+
   DownloadQueueIt begin() { return m_downloads.begin(); }
 
   DownloadQueueIt end() { return m_downloads.end(); }
 
   void erase(DownloadQueueIt dwQueue) { m_downloads.erase(dwQueue); }
 
-  size_t size(DownloadQueueIt dwQueue) const { return dwQueue->second.size(); }
+  size_t size(DownloadQueueIt dwQueue) const {
+    return dwQueue->second.robotsTxts.size() + dwQueue->second.urls.size();
+  }
 
   size_t size() const { return m_downloads.size(); }
 
-  bool empty(DownloadQueueIt dwQueue) const { return dwQueue->second.empty(); }
+  bool empty(DownloadQueueIt dwQueue) const { return 0 == size(dwQueue); }
 
   bool empty() const { return m_downloads.empty(); }
 
+  /**
+   * @returns approximately the number of bytes allocated by the queues, without the urls stored in the arena
+   */
+  size_t memoryUsage() const {
+    size_t result = 0;
+    for(const auto& hostQueue: m_downloads) {
+      result += sizeof(hostQueue) + hostQueue.first.capacity();
+      result += (hostQueue.second.robotsTxts.capacity() + hostQueue.second.urls.capacity()) * sizeof(UrlHandle);
+    }
+    return result;
+  }
+
 private:
-  std::map<std::string, DownloadQueue> m_downloads;
+  std::map<std::string, DownloadQueue, std::less<>> m_downloads;
 };
 
 inline std::ostream&
 operator<<(std::ostream& out, DownloadQueues::DownloadQueueIt dwQueue) {
-  out << "Host: " << dwQueue->first << std::endl;
-  std::copy(begin(dwQueue->second), end(dwQueue->second), std::ostream_iterator<DownloadElem>(out, "\n"));
+  out << "Politeness key: " << dwQueue->first << " robots.txt downloads: " << dwQueue->second.robotsTxts.size()
+      << " downloads: " << dwQueue->second.urls.size() << " in flight: " << dwQueue->second.slots.inFlight;
   return out;
 }
 
 inline std::ostream&
 operator<<(std::ostream& out, DownloadQueues& dwQueues) {
-  std::for_each(std::begin(dwQueues), std::end(dwQueues), [&](const auto& dwQueue) {
-    out << "Host: " << dwQueue.first << std::endl;
-    std::copy(begin(dwQueue.second), end(dwQueue.second), std::ostream_iterator<DownloadElem>(out, "\n"));
-  });
+  for(auto dwQueue = std::begin(dwQueues); dwQueue != std::end(dwQueues); ++dwQueue) {
+    out << dwQueue << std::endl;
+  }
   return out;
 }
 
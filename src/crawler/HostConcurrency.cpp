@@ -0,0 +1,23 @@
+#include "crawler/HostConcurrency.h"
+
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+void
+readHostSlots(std::istream& in, HostConcurrency& o_concurrency) {
+  std::string line;
+  for(size_t lineNr = 1; std::getline(in, line); ++lineNr) {
+    std::istringstream fields{line};
+    std::string        politenessKey;
+    if(!(fields >> politenessKey) || '#' == politenessKey.front()) {
+      continue;
+    }
+    long long   slots = 0;
+    std::string rest;
+    if(!(fields >> slots) || slots <= 0 || fields >> rest) {
+      throw std::runtime_error("invalid host slots in line " + std::to_string(lineNr) + ": " + line);
+    }
+    o_concurrency.slots[politenessKey] = static_cast<size_t>(slots);
+  }
+}
@@ -0,0 +1,168 @@
+#include "Logger.h"
+LOG_INIT(crawlerHostResolver);
+
+#include "HostResolver.h"
+
+#include "Metrics.h"
+#include "handleExceptions.h"
+
+#include <algorithm>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+Counter&   cacheHits      = getCounter("crawler_dns_cache_hits_total", "Host names answered from the DNS cache.");
+Counter&   resolutions    = getCounter("crawler_dns_resolutions_total", "Host names resolved by the resolver threads.");
+Counter&   failures       = getCounter("crawler_dns_failures_total", "Host names which could not be resolved.");
+Histogram& resolutionTime = getHistogram("crawler_dns_resolution_seconds", "Time of the getaddrinfo calls.", 1e-6);
+
+} // namespace
+
+HostResolver::HostResolver(boost::asio::io_context& ioContext, const DnsCacheLimits& limits, const size_t nrThreads)
+    : m_ioContext{ioContext}
+    , m_cache{limits}
+    , m_waiting{}
+    , m_mutex{}
+    , m_ready{}
+    , m_urgent{}
+    , m_prefetches{}
+    , m_queued{}
+    , m_stop{false}
+    , m_threads{} {
+  for(size_t threadNr = 0; threadNr < nrThreads; ++threadNr) {
+    m_threads.emplace_back([this]() { runResolutions(); });
+  }
+}
+
+HostResolver::~HostResolver() {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stop = true;
+  }
+  m_ready.notify_all();
+  for(std::thread& thread: m_threads) {
+    handleExceptions([&] { thread.join(); });
+  }
+}
+
+void
+HostResolver::resolve(const std::string& host, Callback&& callback) {
+  const DnsAnswer* const answer = m_cache.find(host, std::chrono::steady_clock::now());
+  if(nullptr != answer) {
+    cacheHits.add();
+    callback(*answer);
+    return;
+  }
+  const auto waitingIt = m_waiting.find(host);
+  if(end(m_waiting) == waitingIt) {
+    m_waiting[host].push_back(std::move(callback));
+    enqueue(host, true);
+    return;
+  }
+  // a prefetch still in the queue is moved ahead
+  const bool prefetched = waitingIt->second.empty();
+  waitingIt->second.push_back(std::move(callback));
+  if(prefetched) {
+    promote(host);
+  }
+}
+
+void
+HostResolver::prefetch(const std::string& host) {
+  if(end(m_waiting) != m_waiting.find(host) || nullptr != m_cache.find(host, std::chrono::steady_clock::now())) {
+    return;
+  }
+  m_waiting.emplace(host, std::vector<Callback>{});
+  enqueue(host, false);
+}
+
+void
+HostResolver::enqueue(const std::string& host, const bool urgent) {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_queued.insert(host);
+    (urgent ? m_urgent : m_prefetches).push_back(host);
+  }
+  m_ready.notify_one();
+}
+
+void
+HostResolver::promote(const std::string& host) {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if(0 == m_queued.count(host)) {
+      // the resolution was started
+      return;
+    }
+    m_urgent.push_back(host);
+  }
+  m_ready.notify_one();
+}
+
+void
+HostResolver::runResolutions() {
+  boost::asio::io_context resolverContext;
+  tcp::resolver           resolver{resolverContext};
+  while(true) {
+    std::string host;
+    {
+      std::unique_lock<std::mutex> lock{m_mutex};
+      while(!m_stop && host.empty()) {
+        std::deque<std::string>& queue = m_urgent.empty() ? m_prefetches : m_urgent;
+        if(queue.empty()) {
+          m_ready.wait(lock);
+          continue;
+        }
+        // a host queued twice is resolved once
+        if(1 == m_queued.erase(queue.front())) {
+          host = std::move(queue.front());
+        }
+        queue.pop_front();
+      }
+      if(m_stop) {
+        return;
+      }
+    }
+    const SteadyTime          start = std::chrono::steady_clock::now();
+    boost::system::error_code error;
+    const auto                endpoints = resolver.resolve(host, std::string{}, error);
+    resolutionTime.recordDuration(std::chrono::steady_clock::now() - start);
+    std::vector<std::string> addresses;
+    if(error) {
+      LOG_DEBUG("resolving " << host << " failed: " << error.message());
+    }
+    else {
+      for(const auto& endpoint: endpoints) {
+        std::string address = endpoint.endpoint().address().to_string();
+        if(end(addresses) == std::find(begin(addresses), end(addresses), address)) {
+          addresses.push_back(std::move(address));
+        }
+      }
+    }
+    boost::asio::post(m_ioContext, [this, host = std::move(host), addresses = std::move(addresses)]() mutable {
+      resolved(host, std::move(addresses));
+    });
+  }
+}
+
+void
+HostResolver::resolved(const std::string& host, std::vector<std::string>&& addresses) {
+  resolutions.add();
+  if(addresses.empty()) {
+    failures.add();
+  }
+  // copied, the callbacks may evict it
+  const DnsAnswer answer    = m_cache.insert(host, std::move(addresses), std::chrono::steady_clock::now());
+  const auto      waitingIt = m_waiting.find(host);
+  if(end(m_waiting) == waitingIt) {
+    return;
+  }
+  std::vector<Callback> callbacks = std::move(waitingIt->second);
+  m_waiting.erase(waitingIt);
+  for(Callback& callback: callbacks) {
+    callback(answer);
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef CRAWLER_HOSTRESOLVER_H_N4CZ7TLE
+#define CRAWLER_HOSTRESOLVER_H_N4CZ7TLE
+
+#include "DnsCache.h"
+
+#include <boost/asio/io_context.hpp>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Resolves the host names of the downloader ahead of curl, the answers are cached in a DnsCache.
+ * getaddrinfo blocks, thus the names are resolved by a pool of threads and the answers are delivered on the event loop
+ * of ioContext. Callbacks waiting for the same host share its resolution. The resolutions requested with resolve()
+ * are started before the prefetches. Except the destructor, the methods must be called from the event loop thread.
+ */
+class HostResolver {
+public:
+  using Callback = std::function<void(const DnsAnswer&)>;
+
+  HostResolver(boost::asio::io_context& ioContext, const DnsCacheLimits& limits, size_t nrThreads);
+
+  /**
+   * Stops the threads, the callbacks of the pending resolutions are not called.
+   */
+  ~HostResolver();
+
+  HostResolver(const HostResolver&) = delete;
+  HostResolver& operator=(const HostResolver&) = delete;
+
+  /**
+   * Calls callback with the answer for host, immediately if it is cached.
+   */
+  void resolve(const std::string& host, Callback&& callback);
+
+  /**
+   * Resolves host into the cache, unless it is cached or being resolved.
+   */
+  void prefetch(const std::string& host);
+
+private:
+  /**
+   * Queues the resolution of host.
+   * @param urgent the resolution is started before the queued prefetches
+   */
+  void enqueue(const std::string& host, bool urgent);
+
+  /**
+   * Moves the queued prefetch of host ahead of the other prefetches.
+   */
+  void promote(const std::string& host);
+
+  void runResolutions();
+
+  void resolved(const std::string& host, std::vector<std::string>&& addresses);
+
+  boost::asio::io_context&                               m_ioContext;
+  DnsCache                                               m_cache;
+  std::unordered_map<std::string, std::vector<Callback>> m_waiting; // hosts being resolved
+  // shared with the threads
+  std::mutex                      m_mutex;
+  std::condition_variable         m_ready;
+  std::deque<std::string>         m_urgent;
+  std::deque<std::string>         m_prefetches;
+  std::unordered_set<std::string> m_queued; // the resolutions not started, a host can be in both deques
+  bool                            m_stop;
+  std::vector<std::thread>        m_threads;
+};
+
+#endif /* end of include guard: CRAWLER_HOSTRESOLVER_H_N4CZ7TLE */
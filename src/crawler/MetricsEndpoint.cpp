@@ -0,0 +1,95 @@
+#include "Logger.h"
+LOG_INIT(crawlerMetricsEndpoint);
+
+#include "Metrics.h"
+#include "MetricsEndpoint.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using boost::asio::ip::tcp;
+using BErrorCode = boost::system::error_code;
+
+namespace {
+
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+/**
+ * One accepted connection, kept alive by the pending asio handlers.
+ */
+class MetricsConnection : public std::enable_shared_from_this<MetricsConnection> {
+public:
+  explicit MetricsConnection(tcp::socket&& socket)
+      : m_socket{std::move(socket)}, m_request{MAX_REQUEST_SIZE}, m_response{} {}
+
+  void start() {
+    boost::asio::async_read_until(
+        m_socket, m_request, "\r\n\r\n", [self = shared_from_this()](const BErrorCode& error, size_t) {
+          if(error) {
+            LOG_DEBUG("failed to read request: " << error.message());
+            return;
+          }
+          self->respond();
+        });
+  }
+
+private:
+  void respond() {
+    std::istream requestStream{&m_request};
+    std::string  method;
+    std::string  target;
+    requestStream >> method >> target;
+
+    std::ostringstream body;
+    std::string        status{"200 OK"};
+    if("GET" != method) {
+      status = "405 Method Not Allowed";
+    }
+    else if("/metrics" != target) {
+      status = "404 Not Found";
+    }
+    else {
+      writeMetrics(body);
+    }
+    const std::string content = body.str();
+    m_response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                 + std::to_string(content.size()) + "\r\nConnection: close\r\n\r\n" + content;
+    boost::asio::async_write(
+        m_socket, boost::asio::buffer(m_response), [self = shared_from_this()](const BErrorCode& error, size_t) {
+          if(error) {
+            LOG_DEBUG("failed to write response: " << error.message());
+          }
+          BErrorCode ignored;
+          self->m_socket.shutdown(tcp::socket::shutdown_both, ignored);
+        });
+  }
+
+  tcp::socket            m_socket;
+  boost::asio::streambuf m_request;
+  std::string            m_response;
+};
+
+} // namespace
+
+MetricsEndpoint::MetricsEndpoint(boost::asio::io_context& ioContext, const unsigned short port)
+    : m_acceptor{ioContext, tcp::endpoint{boost::asio::ip::address_v4::loopback(), port}} {
+  LOG_INFO("serving metrics on http://127.0.0.1:" << this->port() << "/metrics");
+  accept();
+}
+
+void
+MetricsEndpoint::accept() {
+  m_acceptor.async_accept([this](const BErrorCode& error, tcp::socket socket) {
+    if(error == boost::asio::error::operation_aborted) {
+      return;
+    }
+    if(error) {
+      LOG_ERROR("failed to accept metrics connection: " << error.message());
+    }
+    else {
+      std::make_shared<MetricsConnection>(std::move(socket))->start();
+    }
+    accept();
+  });
+}
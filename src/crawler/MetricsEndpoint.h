@@ -0,0 +1,29 @@
+#ifndef CRAWLER_METRICSENDPOINT_H_N6TQ3XHL
+#define CRAWLER_METRICSENDPOINT_H_N6TQ3XHL
+
+#include <boost/asio.hpp>
+
+/**
+ * Minimal HTTP/1.x server answering "GET /metrics" with all registered metrics in the Prometheus text format.
+ * It runs on the io_context of the caller and listens only on the loopback interface.
+ * Each connection serves one request and is closed afterwards.
+ */
+class MetricsEndpoint {
+public:
+  /**
+   * @param port 0 selects a free port, see port()
+   */
+  MetricsEndpoint(boost::asio::io_context& ioContext, unsigned short port);
+
+  MetricsEndpoint(const MetricsEndpoint&) = delete;
+  MetricsEndpoint& operator=(const MetricsEndpoint&) = delete;
+
+  unsigned short port() const { return m_acceptor.local_endpoint().port(); }
+
+private:
+  void accept();
+
+  boost::asio::ip::tcp::acceptor m_acceptor;
+};
+
+#endif /* end of include guard: CRAWLER_METRICSENDPOINT_H_N6TQ3XHL */
@@ -0,0 +1,314 @@
+#include "Logger.h"
+LOG_INIT(crawlerRecordReplay);
+
+#include "DownloadResult.h"
+#include "crawler/RecordReplay.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr char RECORDING_MAGIC[] = "CCREC002";
+
+/**
+ * A recorded download, the url is the key of the records.
+ */
+struct DownloadRecord {
+  std::chrono::microseconds duration;
+  bool                      success;
+  TransferError             transferError;
+  double                    downloadSpeedByteSec;
+  MediaType                 mediaType;
+  std::string               errorMessage;
+  std::string               content;
+};
+
+template<typename T>
+void
+writeValue(std::ostream& out, const T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void
+writeString(std::ostream& out, const std::string& value) {
+  writeValue(out, static_cast<uint32_t>(value.size()));
+  out.write(value.data(), value.size());
+}
+
+template<typename T>
+T
+readValue(std::istream& in) {
+  T result{};
+  in.read(reinterpret_cast<char*>(&result), sizeof(result));
+  return result;
+}
+
+std::string
+readString(std::istream& in) {
+  std::string result(readValue<uint32_t>(in), '\0');
+  in.read(&result[0], result.size());
+  return result;
+}
+
+void
+writeRecord(std::ostream& out, const DownloadResult& result, const std::chrono::microseconds duration) {
+  writeValue(out, static_cast<int64_t>(duration.count()));
+  writeValue(out, static_cast<uint8_t>(result.success));
+  writeValue(out, static_cast<uint8_t>(result.transferError));
+  writeValue(out, result.downloadSpeedByteSec);
+  writeString(out, std::get<0>(result.url));
+  writeString(out, result.mediaType.type);
+  writeString(out, result.mediaType.subtype);
+  writeString(out, result.mediaType.charset);
+  writeString(out, result.errorMessage);
+  writeString(out, result.content);
+}
+
+/**
+ * @returns false at the end of the file, after the last complete record
+ * @throws std::runtime_error for a truncated record
+ */
+bool
+readRecord(std::istream& in, std::string& url, DownloadRecord& record) {
+  const auto duration = readValue<int64_t>(in);
+  if(in.eof() && 0 == in.gcount()) {
+    return false;
+  }
+  if(!in) {
+    throw std::runtime_error("truncated download record at the end of the file");
+  }
+  record.duration             = std::chrono::microseconds{duration};
+  record.success              = 0 != readValue<uint8_t>(in);
+  record.transferError        = static_cast<TransferError>(readValue<uint8_t>(in));
+  record.downloadSpeedByteSec = readValue<double>(in);
+  url                         = readString(in);
+  record.mediaType.type       = readString(in);
+  record.mediaType.subtype    = readString(in);
+  record.mediaType.charset    = readString(in);
+  record.errorMessage         = readString(in);
+  record.content              = readString(in);
+  if(!in) {
+    throw std::runtime_error("truncated download record of: " + url);
+  }
+  return true;
+}
+
+/**
+ * The recording file is shared with the callbacks of the pending downloads.
+ */
+struct RecordingFile {
+  std::mutex    mutex;
+  std::ofstream out;
+  size_t        nrRecords;
+};
+
+struct Delivery {
+  SteadyTime     due;
+  uint64_t       sequence; // deliveries due at the same time keep the order of the downloads
+  DownloadElem   download;
+  DownloadResult result;
+};
+
+struct DeliveryCmp {
+  bool operator()(const Delivery& d1, const Delivery& d2) const {
+    return std::tie(d2.due, d2.sequence) < std::tie(d1.due, d1.sequence);
+  }
+};
+
+} // namespace
+
+struct RecordingDownloader::Pimpl {
+  Pimpl(Downloader* downloader, const std::string& filename)
+      : m_downloader{downloader}, m_file{std::make_shared<RecordingFile>()} {
+    m_file->out.open(filename, std::ios::binary | std::ios::trunc);
+    if(!m_file->out) {
+      throw std::runtime_error("failed to create the recording file: " + filename);
+    }
+    m_file->out.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC) - 1);
+    m_file->nrRecords = 0;
+  }
+
+  ~Pimpl() {
+    std::lock_guard<std::mutex> lock{m_file->mutex};
+    m_file->out.flush();
+    LOG_INFO("recorded downloads: " << m_file->nrRecords);
+  }
+
+  Downloader*                    m_downloader;
+  std::shared_ptr<RecordingFile> m_file;
+};
+
+// class RecordingDownloader
+RecordingDownloader::RecordingDownloader(Downloader* downloader, const std::string& filename)
+    : m_pimpl{std::make_unique<Pimpl>(downloader, filename)} {}
+
+RecordingDownloader::~RecordingDownloader() = default;
+
+void
+RecordingDownloader::doDownload(DownloadElem&& elem) {
+  const SteadyTime requested = std::chrono::steady_clock::now();
+  elem.callback = [file = m_pimpl->m_file, callback = std::move(elem.callback), requested](DownloadResult&& result) {
+    const auto duration
+        = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - requested);
+    {
+      std::lock_guard<std::mutex> lock{file->mutex};
+      writeRecord(file->out, result, duration);
+      ++file->nrRecords;
+    }
+    callback(std::move(result));
+  };
+  m_pimpl->m_downloader->download(std::move(elem));
+}
+
+std::chrono::microseconds
+RecordingDownloader::doEventLoopLag() {
+  return m_pimpl->m_downloader->eventLoopLag();
+}
+
+void
+RecordingDownloader::doPrewarm(const std::string_view url) {
+  m_pimpl->m_downloader->prewarm(url);
+}
+
+void
+RecordingDownloader::doPrefetchHost(const std::string_view url) {
+  m_pimpl->m_downloader->prefetchHost(url);
+}
+
+struct ReplayDownloader::Pimpl {
+  Pimpl(const std::string& filename, const ReplaySpeed speed)
+      : m_speed{speed}
+      , m_records{}
+      , m_nrRemainingRecords{0}
+      , m_mutex{}
+      , m_condition{}
+      , m_deliveries{}
+      , m_nextSequence{0}
+      , m_stop{false}
+      , m_thread{} {
+    readRecords(filename);
+    m_thread = std::thread{[this]() { deliver(); }};
+  }
+
+  ~Pimpl() {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_stop = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+  }
+
+  void readRecords(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    if(!in) {
+      throw std::runtime_error("failed to open the recording file: " + filename);
+    }
+    char magic[sizeof(RECORDING_MAGIC) - 1];
+    in.read(magic, sizeof(magic));
+    if(!in || !std::equal(std::begin(magic), std::end(magic), RECORDING_MAGIC)) {
+      throw std::runtime_error("not a recording file: " + filename);
+    }
+    std::string    url;
+    DownloadRecord record;
+    while(readRecord(in, url, record)) {
+      m_records[url].push_back(std::move(record));
+      ++m_nrRemainingRecords;
+    }
+    LOG_INFO("read " << m_nrRemainingRecords << " records of " << m_records.size() << " urls from " << filename);
+  }
+
+  DownloadResult replay(const Url& url, std::chrono::microseconds& duration) {
+    DownloadResult result;
+    result.url = url;
+    auto recordsIt = m_records.find(std::get<0>(url));
+    if(end(m_records) == recordsIt || recordsIt->second.empty()) {
+      result.success              = false;
+      result.errorMessage         = "no recorded download";
+      result.transferError        = TransferError::OTHER;
+      result.downloadSpeedByteSec = 0;
+      duration                    = std::chrono::microseconds{0};
+      return result;
+    }
+    DownloadRecord& record = recordsIt->second.front();
+    result.content              = std::move(record.content);
+    result.mediaType            = std::move(record.mediaType);
+    result.success              = record.success;
+    result.transferError        = record.transferError;
+    result.errorMessage         = std::move(record.errorMessage);
+    result.downloadSpeedByteSec = record.downloadSpeedByteSec;
+    duration                    = record.duration;
+    recordsIt->second.pop_front();
+    --m_nrRemainingRecords;
+    return result;
+  }
+
+  void deliver() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while(!m_stop) {
+      if(m_deliveries.empty()) {
+        m_condition.wait(lock);
+        continue;
+      }
+      if(std::chrono::steady_clock::now() < m_deliveries.front().due) {
+        m_condition.wait_until(lock, m_deliveries.front().due);
+        continue;
+      }
+      std::pop_heap(begin(m_deliveries), end(m_deliveries), DeliveryCmp{});
+      Delivery delivery = std::move(m_deliveries.back());
+      m_deliveries.pop_back();
+      lock.unlock();
+      delivery.download.callback(std::move(delivery.result));
+      lock.lock();
+    }
+    if(!m_deliveries.empty()) {
+      LOG_DEBUG("dropped undelivered results: " << m_deliveries.size());
+    }
+  }
+
+  ReplaySpeed                                                  m_speed;
+  std::unordered_map<std::string, std::deque<DownloadRecord>> m_records;
+  size_t                                                       m_nrRemainingRecords;
+  mutable std::mutex                                           m_mutex;
+  std::condition_variable                                      m_condition;
+  std::vector<Delivery>                                        m_deliveries; // heap of the earliest due delivery
+  uint64_t                                                     m_nextSequence;
+  bool                                                         m_stop;
+  std::thread                                                  m_thread;
+};
+
+// class ReplayDownloader
+ReplayDownloader::ReplayDownloader(const std::string& filename, const ReplaySpeed speed)
+    : m_pimpl{std::make_unique<Pimpl>(filename, speed)} {}
+
+ReplayDownloader::~ReplayDownloader() = default;
+
+size_t
+ReplayDownloader::nrRemainingRecords() const {
+  std::lock_guard<std::mutex> lock{m_pimpl->m_mutex};
+  return m_pimpl->m_nrRemainingRecords;
+}
+
+void
+ReplayDownloader::doDownload(DownloadElem&& elem) {
+  const SteadyTime requested = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock{m_pimpl->m_mutex};
+    std::chrono::microseconds   duration;
+    DownloadResult              result = m_pimpl->replay(elem.url, duration);
+    const SteadyTime            due    = ReplaySpeed::RECORDED == m_pimpl->m_speed ? requested + duration : requested;
+    m_pimpl->m_deliveries.push_back(Delivery{due, m_pimpl->m_nextSequence++, std::move(elem), std::move(result)});
+    std::push_heap(begin(m_pimpl->m_deliveries), end(m_pimpl->m_deliveries), DeliveryCmp{});
+  }
+  m_pimpl->m_condition.notify_one();
+}
@@ -4,23 +4,38 @@ LOG_INIT(crawlerRobotsLogic);
 #include "DownloadQueues.h"
 #include "DownloadResult.h"
 #include "Hashable.h"
+#include "Metrics.h"
 #include "RobotsLogic.h"
 #include "uriUtils/uriUtils.h"
 
 #include <memory>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <uriparser/Uri.h>
 
 using std::begin;
 using std::end;
-using std::string;
 using std::vector;
 
 namespace {
 
+constexpr std::string_view HTTP{"http"};
+constexpr std::string_view HTTPS{"https"};
+constexpr std::string_view URI_PROTOCOL_HOST_DELIMITER{"://"};
+
+Counter& robotsTxtFound  = getCounter("crawler_robots_txt_total", "Robots.txt downloads.", {{"result", "ok"}});
+Counter& robotsTxtFailed = getCounter("crawler_robots_txt_total", "Robots.txt downloads.", {{"result", "failed"}});
+Counter& rejectedUrls    = getCounter("crawler_rejected_urls_total", "Urls which can not be crawled, e.g. invalid.");
+Counter& duplicateUrls   = getCounter("crawler_duplicate_urls_total", "Urls dropped as duplicates in their batch.");
+
+/**
+ * The views of the robots stored in the robots map point to static strings
+ * and to the robots.txt urls stored in the arena.
+ */
 struct Robot {
-  string scheme;
-  string hostText;
+  std::string_view scheme;
+  std::string_view hostText;
 };
 
 bool
@@ -30,83 +45,246 @@ operator==(const Robot& r1, const Robot& r2) {
 
 std::string
 getRobotsTxtUrl(const Robot& robotId) {
-  static const char* URI_PROTOCOL_HOST_DELIMITER = "://";
-  static const char* URI_DELIMITER               = "/";
-  static const char* ROBOTS_TXT                  = "robots.txt";
-  return robotId.scheme + URI_PROTOCOL_HOST_DELIMITER + robotId.hostText + URI_DELIMITER + ROBOTS_TXT;
+  static const char* URI_DELIMITER = "/";
+  static const char* ROBOTS_TXT    = "robots.txt";
+  std::string        result{robotId.scheme};
+  result.append(URI_PROTOCOL_HOST_DELIMITER).append(robotId.hostText).append(URI_DELIMITER).append(ROBOTS_TXT);
+  return result;
+}
+
+/**
+ * Checks if urls can be crawled and finds their canonical form.
+ * Clean urls are recognized by a fast path, only the others are parsed with uriparser.
+ */
+class UrlAdmission {
+public:
+  UrlAdmission() : m_state{}, m_uri{}, m_canonicalUrl{} { m_state.uri = &m_uri; }
+
+  /**
+   * @param o_urlParts receives the components of the canonical url
+   * @returns the canonical url, valid until the next call, or an empty view if url can not be crawled
+   */
+  std::string_view operator()(const std::string_view url, UrlParts& o_urlParts) {
+    if(splitCleanHttpUrl(url, o_urlParts)) {
+      return url;
+    }
+
+    const auto                                      uriReleaser = [](UriUriA* uri) { uriFreeUriMembersA(uri); };
+    std::unique_ptr<UriUriA, decltype(uriReleaser)> uriRaii(&m_uri, uriReleaser);
+    int                                             callResult;
+    if(URI_SUCCESS != (callResult = uriParseUriExA(&m_state, url.data(), url.data() + url.size()))) {
+      LOG_ERROR("failed to parse error:" << callResult << " url: " << url);
+      return {};
+    }
+    if(!isValid(m_uri)) {
+      LOG_ERROR("invalid uri received: " << url);
+      return {};
+    }
+
+    m_canonicalUrl.resize(url.size() + 1);
+    const size_t canonicalUrlLength = canonicalizeUrl(url, &m_canonicalUrl[0], m_canonicalUrl.size(), &o_urlParts);
+    if(0 == canonicalUrlLength) {
+      LOG_ERROR("failed to canonicalize url: " << url);
+      return {};
+    }
+    return {m_canonicalUrl.data(), canonicalUrlLength};
+  }
+
+private:
+  UriParserStateA m_state;
+  UriUriA         m_uri;
+  std::string     m_canonicalUrl;
+};
+
+/**
+ * @returns the position of the path of a valid url
+ */
+uint16_t
+pathOffset(const std::string_view url) {
+  const size_t pathStart = url.find('/', url.find(URI_PROTOCOL_HOST_DELIMITER) + URI_PROTOCOL_HOST_DELIMITER.size());
+  return static_cast<uint16_t>(std::string_view::npos == pathStart ? url.size() : pathStart);
 }
 
 } // namespace
 
 MAKE_HASHABLE(Robot, t.scheme, t.hostText);
 
-void
-populateDownloadQueuesWithRobots(DownloadQueues*                                      dwQueues,
-                                 std::vector<DownloadElem>&&                          urlsToCrawl,
-                                 std::function<void(DownloadQueues::DownloadQueueIt)> onFinishedDownload) {
-  LOG_DEBUG("building downloadQueues, urlsToCrawl size: " << urlsToCrawl.size());
-  const auto uriReleaser = [](UriUriA* uri) { uriFreeUriMembersA(uri); };
+RobotsLogic::RobotsLogic(DownloadQueues* dwQueues, PolitenessKey politenessKey)
+    : m_dwQueues{dwQueues}
+    , m_politenessKey{std::move(politenessKey)}
+    , m_arena{}
+    , m_onFinished{}
+    , m_downloads{}
+    , m_onFinishedDownload{}
+    , m_robotsTxts{}
+    , m_queuedTime{}
+    , m_nrQueuedUrls{0}
+    , m_populated{false} {}
 
-  UriParserStateA state;
-  UriUriA         uri;
-  state.uri = &uri;
+void
+RobotsLogic::populateDownloadQueues(UrlBatch&& urlsToCrawl, OnFinishedDownload onFinishedDownload) {
+  if(m_populated) {
+    throw std::logic_error("RobotsLogic::populateDownloadQueues called more than once");
+  }
+  m_populated          = true;
+  m_arena              = std::move(urlsToCrawl.arena);
+  m_onFinished         = std::move(urlsToCrawl.onFinished);
+  m_downloads          = std::move(urlsToCrawl.downloads);
+  m_onFinishedDownload = std::move(onFinishedDownload);
+  m_queuedTime         = std::chrono::steady_clock::now();
 
-  std::unordered_map<Robot, vector<DownloadElem>*> robots;
+  const vector<UrlHandle> urls = std::move(urlsToCrawl.urls);
+  LOG_DEBUG("building downloadQueues, urlsToCrawl size: " << urls.size());
+  std::unordered_map<Robot, uint32_t> robots;
+  // A clean url is its own canonical url and is viewed in m_arena,
+  // the other canonical urls are kept in canonicalArena while the batch is queued.
+  UrlArena                             canonicalArena;
+  std::unordered_set<std::string_view> canonicalUrls;
+  canonicalUrls.reserve(urls.size());
+  UrlAdmission urlAdmission;
 
-  for(auto& urlElem: urlsToCrawl) {
-    std::unique_ptr<UriUriA, decltype(uriReleaser)> uriRaii(&uri, uriReleaser);
-    int                                             callResult;
-    std::string&                                    url = std::get<0>(urlElem.url);
-    if(URI_SUCCESS != (callResult = uriParseUriA(&state, url.c_str()))) {
-      LOG_ERROR("failed to parse error:" << callResult << " url: " << url);
+  for(const UrlHandle& urlHandle: urls) {
+    const std::string_view url = m_arena.url(urlHandle);
+    UrlParts               urlParts;
+    const std::string_view canonicalUrl = urlAdmission(url, urlParts);
+    if(canonicalUrl.empty()) {
+      rejectedUrls.add();
+      failDownload(urlHandle, TransferError::OTHER, "invalid url");
       continue;
     }
-    if(!isValid(uri)) {
-      LOG_ERROR("invalid uri received: " << url);
+    if(0 != canonicalUrls.count(canonicalUrl)) {
+      LOG_DEBUG("skipping duplicate url: " << url);
+      duplicateUrls.add();
+      failDownload(urlHandle, TransferError::OTHER, "duplicate url");
       continue;
     }
+    canonicalUrls.insert(canonicalUrl.data() == url.data()
+                             ? canonicalUrl
+                             : canonicalArena.url(canonicalArena.add(canonicalUrl, 0)));
 
-    const string          scheme{uri.scheme.first, uri.scheme.afterLast};
-    const string          host{uri.hostText.first, uri.hostText.afterLast};
-    const Robot           robot{scheme, host};
-    auto                  robotIt = robots.find(robot);
-    vector<DownloadElem>* urlList = nullptr;
+    const Robot robot{urlParts.scheme, urlParts.host};
+    auto        robotIt = robots.find(robot);
     if(end(robots) == robotIt) {
-      auto urlListOwner = std::make_shared<vector<DownloadElem>>();
-      urlList           = urlListOwner.get();
-      robots[robot]     = urlList;
-
-      DownloadQueues::DownloadQueueIt dwQueue = dwQueues->getQueueByHost(host);
-      dwQueues->addDownload(
-          dwQueue,
-          DownloadElem{Url{getRobotsTxtUrl(robot), 0},
-                       [urls = std::move(urlListOwner), dwQueues, dwQueue, onFinishedDownload](DownloadResult&&) {
-                         // TODO filter urllist by robots.txt
-                         // RobotsFilter robotsFilter;
-                         // bool parseRobotsResult { };
-                         // std::tie(robotsFilter, parseRobotsResult) = parse(robotsResult);
-                         // if(parseRobotsResult) {
-                         //   robotsFilter(urls);
-                         // }
-                         for(auto& url: *urls) {
-                           dwQueues->addDownload(
-                               dwQueue,
-                               DownloadElem{std::move(url.url),
-                                            [dwQueue, onFinishedDownload, dwFinishedCb = std::move(url.callback)](
-                                                DownloadResult&& dwResult) {
-                                              LOG_DEBUG("Finished downloading: " << dwResult.url);
-                                              dwFinishedCb(std::move(dwResult));
-                                              onFinishedDownload(dwQueue);
-                                            }});
-                         }
-                         onFinishedDownload(dwQueue);
-                       }});
-    }
-    else {
-      urlList = robotIt->second;
+      const auto robotsTxtId = static_cast<uint32_t>(m_robotsTxts.size());
+
+      DownloadQueues::DownloadQueueIt dwQueue = m_politenessKey
+                                                    ? m_dwQueues->getQueue(m_politenessKey(urlParts.host))
+                                                    : m_dwQueues->getQueue(urlParts.host);
+      const std::string_view scheme       = HTTPS == urlParts.scheme ? HTTPS : HTTP;
+      const std::string      robotsTxtUrl = getRobotsTxtUrl(Robot{scheme, urlParts.host});
+      const UrlHandle robotsTxt = m_arena.add(robotsTxtUrl, 0, robotsTxtId, pathOffset(robotsTxtUrl));
+      const Robot     storedRobot{
+          scheme,
+          m_arena.url(robotsTxt).substr(scheme.size() + URI_PROTOCOL_HOST_DELIMITER.size(), urlParts.host.size())};
+      robotIt = robots.emplace(storedRobot, robotsTxtId).first;
+      m_robotsTxts.push_back(RobotsTxt{dwQueue, {}});
+      m_dwQueues->addRobotsTxtDownload(dwQueue, robotsTxt);
     }
-    urlList->emplace_back(std::move(urlElem));
+    m_robotsTxts[robotIt->second].urls.push_back(
+        UrlHandle{urlHandle.offset, urlHandle.length, pathOffset(url), robotIt->second, urlHandle.urlIndex});
+    ++m_nrQueuedUrls;
   }
   LOG_DEBUG("Total robot download: " << robots.size());
-  LOG_DEBUG("Total number of download queues: " << dwQueues->size());
+  LOG_DEBUG("Total number of download queues: " << m_dwQueues->size());
+  if(0 != m_nrQueuedUrls) {
+    LOG_DEBUG("queued urls: " << m_nrQueuedUrls << " bytes per queued url: " << memoryUsage() / m_nrQueuedUrls);
+  }
+}
+
+DownloadElem
+RobotsLogic::popDownload(DownloadQueues::DownloadQueueIt dwQueue) {
+  const QueuedUrl     queuedUrl = m_dwQueues->popDownload(dwQueue);
+  const TransferTimes queuedTimes{m_queuedTime};
+  if(queuedUrl.isRobotsTxt) {
+    return DownloadElem{Url{std::string{m_arena.url(queuedUrl.url)}, 0},
+                        [this, robotsTxtId = queuedUrl.url.hostId](DownloadResult&& dwResult) {
+                          (dwResult.success ? robotsTxtFound : robotsTxtFailed).add();
+                          robotsTxtDownloaded(robotsTxtId,
+                                              TransferOutcome{dwResult.transferError, dwResult.multiplexed});
+                        },
+                        queuedTimes};
+  }
+  if(!m_downloads.empty()) {
+    DownloadElem& download = m_downloads[queuedUrl.url.urlIndex];
+    return DownloadElem{std::move(download.url),
+                        [this, dwQueue, dwFinishedCb = std::move(download.callback)](DownloadResult&& dwResult) {
+                          LOG_DEBUG("Finished downloading: " << dwResult.url);
+                          const TransferOutcome outcome{dwResult.transferError, dwResult.multiplexed};
+                          dwFinishedCb(std::move(dwResult));
+                          m_onFinishedDownload(dwQueue, outcome);
+                        },
+                        queuedTimes};
+  }
+  Url url{std::string{m_arena.url(queuedUrl.url)}, queuedUrl.url.urlIndex};
+  return DownloadElem{std::move(url),
+                      [this, dwQueue](DownloadResult&& dwResult) {
+                        LOG_DEBUG("Finished downloading: " << dwResult.url);
+                        const TransferOutcome outcome{dwResult.transferError, dwResult.multiplexed};
+                        m_onFinished(std::move(dwResult));
+                        m_onFinishedDownload(dwQueue, outcome);
+                      },
+                      queuedTimes};
+}
+
+size_t
+RobotsLogic::failDownloads(DownloadQueues::DownloadQueueIt dwQueue,
+                           const TransferError             error,
+                           const std::string&              errorMessage) {
+  DownloadQueue& queue  = dwQueue->second;
+  size_t         result = queue.urls.size();
+  for(const UrlHandle& robotsTxt: queue.robotsTxts) {
+    std::vector<UrlHandle>& waitingUrls = m_robotsTxts[robotsTxt.hostId].urls;
+    for(const UrlHandle& url: waitingUrls) {
+      failDownload(url, error, errorMessage);
+    }
+    result += waitingUrls.size();
+    waitingUrls = std::vector<UrlHandle>{};
+  }
+  for(const UrlHandle& url: queue.urls) {
+    failDownload(url, error, errorMessage);
+  }
+  queue.robotsTxts = std::vector<UrlHandle>{};
+  queue.urls       = std::vector<UrlHandle>{};
+  return result;
+}
+
+void
+RobotsLogic::failDownload(const UrlHandle& url, const TransferError error, const std::string& errorMessage) {
+  DownloadResult result;
+  result.success              = false;
+  result.errorMessage         = errorMessage;
+  result.downloadSpeedByteSec = 0;
+  result.transferError        = error;
+  if(!m_downloads.empty()) {
+    DownloadElem& download = m_downloads[url.urlIndex];
+    result.url             = std::move(download.url);
+    download.callback(std::move(result));
+    return;
+  }
+  result.url = Url{std::string{m_arena.url(url)}, url.urlIndex};
+  m_onFinished(std::move(result));
+}
+
+void
+RobotsLogic::robotsTxtDownloaded(const uint32_t robotsTxtId, const TransferOutcome& outcome) {
+  RobotsTxt& robotsTxt = m_robotsTxts[robotsTxtId];
+  // TODO filter urllist by robots.txt
+  // RobotsFilter robotsFilter;
+  // bool parseRobotsResult { };
+  // std::tie(robotsFilter, parseRobotsResult) = parse(robotsResult);
+  // if(parseRobotsResult) {
+  //   robotsFilter(urls);
+  // }
+  m_dwQueues->addDownloads(robotsTxt.dwQueue, std::move(robotsTxt.urls));
+  m_onFinishedDownload(robotsTxt.dwQueue, outcome);
+}
+
+size_t
+RobotsLogic::memoryUsage() const {
+  size_t result = m_arena.memoryUsage() + m_dwQueues->memoryUsage() + m_robotsTxts.capacity() * sizeof(RobotsTxt)
+                  + m_downloads.capacity() * sizeof(DownloadElem);
+  for(const RobotsTxt& robotsTxt: m_robotsTxts) {
+    result += robotsTxt.urls.capacity() * sizeof(UrlHandle);
+  }
+  return result;
 }
@@ -2,25 +2,97 @@
 #define CRAWLER_ROBOTSLOGIC_H_YAHWAKIP
 
 #include "DownloadQueues.h"
+#include "UrlBatch.h"
+#include "crawler/crawler.h"
+
+#include <functional>
+#include <string>
+#include <vector>
 
 /**
  * TODO UPDATE THIS AND IMPLEMENT ROBOTS.TXT FILTERING
- *  Will populate the dwQueues with downloads of the robots generated from the download list.
- *  @param urlsToCrawl list of urls to be crawled with robots.txt rules
- *  @param onFinishedDownload Will be added to each DownloadElem as callback
- *                            additionally to the initial action of the DownloadElem
- *                            Note that this also applies to the downloads automatically added by this
- *                            function, i.e. robots.txt downloads, which does not have other associated finished
- *                            actions.
- *  @returns DownloadQueues with appropriate robots.txt downloads:
- *                          - one robots.txt download per host and schema (http and https).
- *                          - downloads are split in download queue according to the hosts
- *                          Each download finish callback will populate the appropriate downloadQueue:
- *                          - after the url filtering is applied
- *                          - before the call to onFinishedDownload.
+ *  Populates the download queues with one batch and creates the downloads popped from them.
+ *  The queued urls are kept in the arena of the batch, a DownloadElem is only created by popDownload().
+ *  DownloadQueues contain the appropriate robots.txt downloads:
+ *    - one robots.txt download per host and schema (http and https).
+ *    - downloads are split in download queue according to the hosts, or to their politeness keys
+ *  Each robots.txt download finish callback will populate the appropriate downloadQueue:
+ *    - after the url filtering is applied
+ *    - before the call to onFinishedDownload.
+ *  The RobotsLogic must outlive all the downloads popped from it.
  */
-void populateDownloadQueuesWithRobots(DownloadQueues*                                      dwQueues,
-                                      std::vector<DownloadElem>&&                          urlsToCrawl,
-                                      std::function<void(DownloadQueues::DownloadQueueIt)> onFinishedDownload);
+class RobotsLogic {
+public:
+  using OnFinishedDownload = std::function<void(DownloadQueues::DownloadQueueIt, const TransferOutcome&)>;
+
+  /**
+   * @param politenessKey if empty the urls are queued by host
+   */
+  explicit RobotsLogic(DownloadQueues* dwQueues, PolitenessKey politenessKey = {});
+
+  /**
+   * Can be called only once per RobotsLogic.
+   * The invalid urls and the urls with the canonical url of an earlier url of the batch are not queued, they are
+   * finished with a failed DownloadResult from the calling thread.
+   * @param urlsToCrawl list of urls to be crawled with robots.txt rules
+   * @param onFinishedDownload Will be called after each finished download,
+   *                           additionally to the sink of the batch.
+   *                           Note that this also applies to the robots.txt downloads,
+   *                           which do not call the sink of the batch.
+   *                           It receives the queue and the TransferOutcome of the download.
+   */
+  void populateDownloadQueues(UrlBatch&& urlsToCrawl, OnFinishedDownload onFinishedDownload);
+
+  /**
+   * Pops the next download of dwQueue.
+   */
+  DownloadElem popDownload(DownloadQueues::DownloadQueueIt dwQueue);
+
+  /**
+   * Empties dwQueue without downloading its urls: each url is finished with a failed DownloadResult carrying error,
+   * from the calling thread. The urls waiting for the queued robots.txt downloads are failed too. onFinishedDownload
+   * is not called, nothing was downloaded.
+   * @returns the number of failed urls, without the robots.txt downloads
+   */
+  size_t failDownloads(DownloadQueues::DownloadQueueIt dwQueue, TransferError error, const std::string& errorMessage);
+
+  /**
+   * @returns the url of the next download of dwQueue, valid during the lifetime of the RobotsLogic
+   */
+  std::string_view nextUrl(DownloadQueues::DownloadQueueIt dwQueue) const {
+    return m_arena.url(m_dwQueues->peekDownload(dwQueue));
+  }
+
+  /**
+   * @returns the number of urls queued for download, without the robots.txt downloads
+   */
+  size_t nrQueuedUrls() const { return m_nrQueuedUrls; }
+
+  /**
+   * @returns approximately the number of bytes allocated for the queued urls, including the download queues
+   */
+  size_t memoryUsage() const;
+
+private:
+  struct RobotsTxt {
+    DownloadQueues::DownloadQueueIt dwQueue;
+    std::vector<UrlHandle>          urls; // waiting for the robots.txt download
+  };
+
+  void robotsTxtDownloaded(uint32_t robotsTxtId, const TransferOutcome& outcome);
+
+  void failDownload(const UrlHandle& url, TransferError error, const std::string& errorMessage);
+
+  DownloadQueues*                       m_dwQueues;
+  PolitenessKey                         m_politenessKey;
+  UrlArena                              m_arena;
+  std::function<void(DownloadResult&&)> m_onFinished;
+  std::vector<DownloadElem>             m_downloads;
+  OnFinishedDownload                    m_onFinishedDownload;
+  std::vector<RobotsTxt>                m_robotsTxts;
+  SteadyTime                            m_queuedTime;
+  size_t                                m_nrQueuedUrls;
+  bool                                  m_populated;
+};
 
 #endif /* end of include guard: CRAWLER_ROBOTSLOGIC_H_YAHWAKIP */
@@ -0,0 +1,251 @@
+#include "Logger.h"
+LOG_INIT(crawlerSimulatedDownloader);
+
+#include "DownloadResult.h"
+#include "crawler/SimulatedDownloader.h"
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <time.h>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+std::chrono::nanoseconds
+threadCpuTime() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
+}
+
+struct SimulatedHost {
+  double     medianLatencyUs;
+  bool       dead;
+  bool       multiplexed;
+  size_t     active; // active downloads
+  bool       prewarmed;
+  SteadyTime lastFinished;
+};
+
+struct FinishEvent {
+  SteadyTime     time;
+  uint64_t       sequence; // downloads finishing at the same time are delivered in the order they were started
+  DownloadElem   download;
+  SimulatedHost* host;
+  TransferError  transferError;
+};
+
+struct FinishEventCmp {
+  bool operator()(const FinishEvent& e1, const FinishEvent& e2) const {
+    return std::tie(e2.time, e2.sequence) < std::tie(e1.time, e1.sequence);
+  }
+};
+
+} // namespace
+
+struct SimulatedDownloader::Pimpl {
+  Pimpl(const SimulationProfile& profile, const std::chrono::seconds politenessDelay)
+      : m_profile{profile}
+      , m_politenessDelay{politenessDelay}
+      , m_random{profile.seed}
+      , m_uniform{0., 1.}
+      , m_normal{0., 1.}
+      , m_hosts{}
+      , m_events{}
+      , m_start{}
+      , m_now{m_start}
+      , m_nextSequence{0}
+      , m_activeDownloadsTime{0.}
+      , m_stats{}
+      , m_crawlerCpuStart{threadCpuTime()}
+      , m_crawlerCpuEnd{m_crawlerCpuStart}
+      , m_simulatorCpu{0} {}
+
+  /**
+   * Keeps the CPU time spent in the simulator apart from the crawler CPU time.
+   */
+  class SimulatorCpu {
+  public:
+    explicit SimulatorCpu(Pimpl* pimpl) : m_pimpl{pimpl}, m_enter{threadCpuTime()} {}
+    ~SimulatorCpu() { leave(); }
+
+    void leave() {
+      const auto now = threadCpuTime();
+      m_pimpl->m_simulatorCpu += now - m_enter;
+      m_pimpl->m_crawlerCpuEnd = now;
+      m_enter                  = now;
+    }
+    void enter() { m_enter = threadCpuTime(); }
+
+  private:
+    Pimpl*                   m_pimpl;
+    std::chrono::nanoseconds m_enter;
+  };
+
+  SimulatedHost& host(const std::string_view url) {
+    std::string hostName = hostOf(url);
+    auto        hostIt   = m_hosts.find(hostName);
+    if(end(m_hosts) == hostIt) {
+      const double  spread   = std::exp(m_profile.hostLatencySpread * m_normal(m_random));
+      const double  medianUs = m_profile.medianLatency.count() * spread;
+      const bool    dead     = m_uniform(m_random) < m_profile.deadHostRate;
+      SimulatedHost simulatedHost{medianUs, dead, false, 0, false, SteadyTime::min()};
+      // no draw without multiplexed hosts, the random sequence of the other profiles stays the same
+      if(m_profile.multiplexedHostRate > 0) {
+        simulatedHost.multiplexed = m_uniform(m_random) < m_profile.multiplexedHostRate;
+      }
+      hostIt = m_hosts.emplace(std::move(hostName), simulatedHost).first;
+    }
+    return hostIt->second;
+  }
+
+  void download(DownloadElem&& download) {
+    SimulatorCpu   cpu{this};
+    SimulatedHost& simulatedHost = host(std::get<0>(download.url));
+    const bool delayed = 1 == m_profile.hostSlots && SteadyTime::min() != simulatedHost.lastFinished
+                         && m_now < simulatedHost.lastFinished + m_politenessDelay;
+    if(simulatedHost.active >= m_profile.hostSlots || delayed) {
+      LOG_DEBUG("politeness violation: " << download);
+      ++m_stats.nrPolitenessViolations;
+    }
+    ++simulatedHost.active;
+    if(simulatedHost.prewarmed) {
+      ++m_stats.nrPrewarmedDownloads;
+      simulatedHost.prewarmed = false;
+    }
+    const double latency = simulatedHost.medianLatencyUs * std::exp(m_profile.latencySpread * m_normal(m_random));
+    auto          duration = std::chrono::microseconds{static_cast<int64_t>(latency)};
+    TransferError error    = TransferError::NONE;
+    if(simulatedHost.dead) {
+      error = TransferError::DNS;
+    }
+    else if(m_uniform(m_random) < m_profile.errorRate) {
+      error = TransferError::OTHER;
+    }
+    if(0 != m_profile.capacity && m_events.size() >= m_profile.capacity) {
+      error    = TransferError::TIMEOUT;
+      duration = m_profile.timeout;
+    }
+    m_events.push_back(FinishEvent{m_now + duration, m_nextSequence++, std::move(download), &simulatedHost, error});
+    std::push_heap(begin(m_events), end(m_events), FinishEventCmp{});
+    m_stats.maxActiveDownloads = std::max(m_stats.maxActiveDownloads, m_events.size());
+  }
+
+  void prewarm(const std::string_view url) {
+    SimulatorCpu cpu{this};
+    host(url).prewarmed = true;
+    ++m_stats.nrPrewarms;
+  }
+
+  void advance(const SteadyTime time) {
+    SimulatorCpu cpu{this};
+    if(m_events.empty()) {
+      if(SteadyTime::max() == time) {
+        throw std::logic_error("SimulatedDownloader: waiting for a finished download, but no download is active");
+      }
+      moveTo(time);
+      return;
+    }
+    const SteadyTime next = m_events.front().time;
+    if(time < next) {
+      moveTo(time);
+      return;
+    }
+    moveTo(next);
+    while(!m_events.empty() && next == m_events.front().time) {
+      std::pop_heap(begin(m_events), end(m_events), FinishEventCmp{});
+      FinishEvent event = std::move(m_events.back());
+      m_events.pop_back();
+      --event.host->active;
+      event.host->lastFinished = m_now;
+      ++m_stats.nrDownloads;
+
+      DownloadResult result;
+      result.url           = event.download.url;
+      result.success       = TransferError::NONE == event.transferError;
+      result.transferError = event.transferError;
+      result.multiplexed   = event.host->multiplexed;
+      if(!result.success) {
+        ++m_stats.nrFailedDownloads;
+        result.errorMessage = event.host->dead ? "simulated host failure" : "simulated download failure";
+        if(TransferError::TIMEOUT == event.transferError) {
+          result.errorMessage = "simulated timeout";
+        }
+      }
+      cpu.leave();
+      event.download.callback(std::move(result));
+      cpu.enter();
+    }
+  }
+
+  void moveTo(const SteadyTime time) {
+    if(time <= m_now) {
+      return;
+    }
+    m_activeDownloadsTime += std::chrono::duration<double>(time - m_now).count() * m_events.size();
+    m_now = time;
+  }
+
+  SimulationStats stats() const {
+    SimulationStats result     = m_stats;
+    result.virtualDuration     = std::chrono::duration_cast<std::chrono::microseconds>(m_now - m_start);
+    const double elapsed       = std::chrono::duration<double>(m_now - m_start).count();
+    result.meanActiveDownloads = elapsed > 0 ? m_activeDownloadsTime / elapsed : 0.;
+    result.crawlerCpu          = m_crawlerCpuEnd - m_crawlerCpuStart - m_simulatorCpu;
+    return result;
+  }
+
+  SimulationProfile                              m_profile;
+  std::chrono::seconds                           m_politenessDelay;
+  std::mt19937_64                                m_random;
+  std::uniform_real_distribution<double>         m_uniform;
+  std::normal_distribution<double>               m_normal;
+  std::unordered_map<std::string, SimulatedHost> m_hosts; // the nodes are never moved
+  std::vector<FinishEvent>                       m_events;
+  const SteadyTime                               m_start;
+  SteadyTime                                     m_now;
+  uint64_t                                       m_nextSequence;
+  double                                         m_activeDownloadsTime; // integral of the active downloads
+  SimulationStats                                m_stats;
+  std::chrono::nanoseconds                       m_crawlerCpuStart;
+  std::chrono::nanoseconds                       m_crawlerCpuEnd;
+  std::chrono::nanoseconds                       m_simulatorCpu;
+};
+
+// class SimulatedDownloader
+SimulatedDownloader::SimulatedDownloader(const SimulationProfile& profile, const std::chrono::seconds politenessDelay)
+    : m_pimpl{new Pimpl{profile, politenessDelay}} {}
+
+SimulatedDownloader::~SimulatedDownloader() {}
+
+SteadyTime
+SimulatedDownloader::now() {
+  return m_pimpl->m_now;
+}
+
+void
+SimulatedDownloader::advance(const SteadyTime time) {
+  m_pimpl->advance(time);
+}
+
+SimulationStats
+SimulatedDownloader::stats() const {
+  return m_pimpl->stats();
+}
+
+void
+SimulatedDownloader::doDownload(DownloadElem&& download) {
+  m_pimpl->download(std::move(download));
+}
+
+void
+SimulatedDownloader::doPrewarm(const std::string_view url) {
+  m_pimpl->prewarm(url);
+}
@@ -2,9 +2,11 @@
 #define CRAWLER_TIMEHEAP_H_D3FKCNVI
 
 #include "DownloadQueues.h"
+#include "Url.h"
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
 #include <list>
 #include <vector>
 
@@ -14,29 +16,38 @@ public:
 
   TimeHeap() {}
 
-  template<typename Func> TimeHeap(DownloadQueues& dwQueues, const size_t sizeHint, Func functor) {
-    SteadyTime now = std::chrono::steady_clock::now();
+  template<typename Func>
+  TimeHeap(DownloadQueues&  dwQueues,
+           const size_t     sizeHint,
+           Func             functor,
+           const SteadyTime now = std::chrono::steady_clock::now()) {
     m_heap.reserve(sizeHint);
     for(auto queueIt = std::begin(dwQueues); queueIt != std::end(dwQueues); ++queueIt) {
-      m_heap.push_back(make_tuple(now, functor(queueIt)));
+      m_heap.push_back(make_tuple(now, now, functor(queueIt)));
     }
     // No need to call make_heap as all elements are equal and should fulfull the heap requirements.
   }
 
-  bool empty() const { return m_heap.empty(); }
+  bool   empty() const { return m_heap.empty(); }
+  size_t size() const { return m_heap.size(); }
 
-  DownloadElem pop() {
+  DownloadElem pop(const SteadyTime now = std::chrono::steady_clock::now()) {
     if(empty()) {
       throw std::logic_error("error trying to pop from empty TimeHeap");
     }
     std::pop_heap(begin(m_heap), end(m_heap), HeapCmp());
-    auto result = std::get<1>(m_heap.back())();
+    auto result            = std::get<2>(m_heap.back())();
+    result.times.scheduled = std::get<1>(m_heap.back());
+    result.times.ready     = std::get<0>(m_heap.back());
+    result.times.popped    = now;
     m_heap.pop_back();
     return result;
   }
 
-  void push(std::function<DownloadElem()> queueElem, std::chrono::seconds delay = std::chrono::seconds{0}) {
-    m_heap.emplace_back(delay + std::chrono::steady_clock::now(), queueElem);
+  void push(std::function<DownloadElem()> queueElem,
+            std::chrono::seconds          delay = std::chrono::seconds{0},
+            const SteadyTime              now   = std::chrono::steady_clock::now()) {
+    m_heap.emplace_back(now + delay, now, queueElem);
     push_heap(begin(m_heap), end(m_heap), HeapCmp());
   }
 
@@ -48,7 +59,8 @@ public:
   }
 
 private:
-  using HeapT = std::vector<std::tuple<SteadyTime, std::function<DownloadElem()>>>;
+  // ready time, push time and the popper of a download queue
+  using HeapT = std::vector<std::tuple<SteadyTime, SteadyTime, std::function<DownloadElem()>>>;
   HeapT m_heap;
   struct HeapCmp {
     bool operator()(HeapT::const_reference e1, HeapT::const_reference e2) { return std::get<0>(e2) < std::get<0>(e1); }
@@ -2,30 +2,75 @@
 LOG_INIT(crawlerCrawler);
 
 #include "ActionQueue.h"
+#include "ConcurrencyController.h"
 #include "DownloadQueues.h"
+#include "DownloadResult.h"
+#include "Metrics.h"
 #include "RobotsLogic.h"
 #include "TimeHeap.h"
+#include "Tracer.h"
 #include "crawler/crawler.h"
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
 namespace {
+
+Gauge&     activeDownloadsGauge = getGauge("crawler_active_downloads", "Downloads handed to the Downloader.");
+Gauge&     downloadQueuesGauge  = getGauge("crawler_download_queues",
+                                       "Download queues, one per host or politeness key, not yet empty.");
+Gauge&     waitingQueuesGauge   = getGauge("crawler_waiting_queues", "Download queues waiting in the TimeHeap.");
+Counter&   batchesCounter       = getCounter("crawler_batches_total", "Url batches received from the dispatcher.");
+Counter&   queuedUrlsCounter    = getCounter("crawler_queued_urls_total", "Urls queued for download.");
+Counter&   prewarmsCounter      = getCounter("crawler_prewarms_total",
+                                        "Download queues prewarmed before their politeness delay ended.");
+Counter&   openedCircuits       = getCounter("crawler_circuits_opened_total",
+                                       "Download queues paused for the cooldown after consecutive host failures.");
+Counter&   trippedCircuits      = getCounter("crawler_circuits_tripped_total",
+                                        "Download queues whose host failed the probe after the cooldown.");
+Counter&   circuitFailedUrls    = getCounter("crawler_circuit_failed_urls_total",
+                                          "Urls failed without a download because their host was tripped.");
+Histogram& finishLatency        = getHistogram("crawler_finish_action_latency_seconds",
+                                              "Time from a finished download until the crawler handles it.",
+                                              1e-6);
+
+// the politeness keys of the tripped download queues with the end of their cooldown
+using TrippedQueues = std::unordered_map<std::string, SteadyTime>;
+
 bool
 canAddDownload(size_t activeDownloads, size_t maxActiveDownloads) {
   return activeDownloads < maxActiveDownloads;
 }
+
+SteadyTime
+crawlerNow(CrawlerClock* clock) {
+  return nullptr == clock ? std::chrono::steady_clock::now() : clock->now();
+}
 } // namespace
 
 class Crawler::Pimpl {
 public:
-  Pimpl(std::function<bool()>&&                      keepCrawling,
-        std::function<std::vector<DownloadElem>()>&& dispatcher,
-        Downloader*                                  downloader,
-        size_t                                       maxActiveQueues,
-        std::chrono::seconds                         perHostTimeout)
+  Pimpl(std::function<bool()>&&     keepCrawling,
+        std::function<UrlBatch()>&& dispatcher,
+        Downloader*                 downloader,
+        size_t                      maxActiveQueues,
+        std::chrono::seconds        perHostTimeout,
+        CrawlerClock*               clock)
       : m_keepCrawling{std::move(keepCrawling)}
       , m_dispatcher{std::move(dispatcher)}
       , m_downloader{downloader}
       , m_maxActiveDownloads{maxActiveQueues}
-      , m_perHostTimeout{perHostTimeout} {
+      , m_perHostTimeout{perHostTimeout}
+      , m_clock{clock}
+      , m_concurrency{}
+      , m_politenessKey{}
+      , m_hostConcurrency{}
+      , m_prewarmWindow{0}
+      , m_circuitBreaker{}
+      , m_trippedQueues{} {
     if(m_maxActiveDownloads <= 0) {
       throw std::logic_error("Crawler::Crawler received invalid maxActiveQueues: "
                              + std::to_string(m_maxActiveDownloads));
@@ -34,38 +79,306 @@ public:
 
   void crawl();
 
+  void adaptConcurrency(const AdaptiveConcurrencyOptions& options) {
+    m_concurrency        = std::make_unique<ConcurrencyController>(options, m_maxActiveDownloads, crawlerNow(m_clock));
+    m_maxActiveDownloads = m_concurrency->limit();
+  }
+
+  void setPolitenessKey(PolitenessKey&& politenessKey) { m_politenessKey = std::move(politenessKey); }
+
+  void setHostConcurrency(const HostConcurrency& hostConcurrency) {
+    const bool zeroOverride = std::any_of(begin(hostConcurrency.slots), end(hostConcurrency.slots),
+                                          [](const auto& keySlots) { return 0 == keySlots.second; });
+    if(0 == hostConcurrency.defaultSlots || 0 == hostConcurrency.maxAdaptiveSlots || zeroOverride) {
+      throw std::invalid_argument("Crawler::setHostConcurrency received 0 slots");
+    }
+    m_hostConcurrency = hostConcurrency;
+  }
+
+  void setPrewarmWindow(const std::chrono::milliseconds window) {
+    if(window.count() < 0) {
+      throw std::invalid_argument("Crawler::setPrewarmWindow received a negative window");
+    }
+    m_prewarmWindow = window;
+  }
+
+  void setCircuitBreaker(const CircuitBreakerOptions& options) {
+    if(options.cooldown.count() < 0) {
+      throw std::invalid_argument("Crawler::setCircuitBreaker received a negative cooldown");
+    }
+    if(options.maxConsecutiveFailures > std::numeric_limits<uint16_t>::max()) {
+      throw std::invalid_argument("Crawler::setCircuitBreaker received too many failures: "
+                                  + std::to_string(options.maxConsecutiveFailures));
+    }
+    m_circuitBreaker = options;
+  }
+
 private:
-  std::function<bool()>                      m_keepCrawling;
-  std::function<std::vector<DownloadElem>()> m_dispatcher;
-  Downloader*                                m_downloader;
-  size_t                                     m_maxActiveDownloads;
-  std::chrono::seconds                       m_perHostTimeout;
+  /**
+   * Executes the finished download actions, waits for them at most until time.
+   */
+  void waitAndExecute(ActionQueue& finishActions, SteadyTime time);
+
+  /**
+   * Updates the limit of the active downloads once per interval of the ConcurrencyController.
+   */
+  void updateConcurrency(TimeHeap& timeHeap, size_t activeDownloads);
+
+  /**
+   * Sets the slots of the new download queues of a batch, all of them are scheduled in the TimeHeap.
+   */
+  void assignSlots(DownloadQueues& downloadList) const;
+
+  /**
+   * Lets the downloader resolve the host of the first download of each queue before the queues are scheduled.
+   */
+  void prefetchHosts(DownloadQueues& downloadList, const RobotsLogic& robotsLogic) const;
+
+  /**
+   * Hands the download to the downloader, counting its result for the ConcurrencyController.
+   */
+  void startDownload(DownloadElem&& download);
+
+  std::function<bool()>                  m_keepCrawling;
+  std::function<UrlBatch()>              m_dispatcher;
+  Downloader*                            m_downloader;
+  size_t                                 m_maxActiveDownloads;
+  std::chrono::seconds                   m_perHostTimeout;
+  CrawlerClock*                          m_clock;
+  std::unique_ptr<ConcurrencyController> m_concurrency;   // null for a fixed limit
+  PolitenessKey                          m_politenessKey; // empty for one download queue per host
+  HostConcurrency                        m_hostConcurrency;
+  std::chrono::milliseconds              m_prewarmWindow; // 0 disables the prewarming
+  CircuitBreakerOptions                  m_circuitBreaker;
+  TrippedQueues                          m_trippedQueues; // see CircuitBreaker
 };
 
+/**
+ * Pops the downloads of the queues in the TimeHeap. A queue with a free slot left after the pop of a url is collected
+ * in freeSlots, the crawler pushes it back into the TimeHeap without delay.
+ */
 struct QueuePopper {
-  DownloadQueues* downloadQueues;
+  RobotsLogic*                                  robotsLogic;
+  DownloadQueues*                               downloadList;
+  std::vector<DownloadQueues::DownloadQueueIt>* freeSlots;
 
   auto operator()(DownloadQueues::DownloadQueueIt dwQueue) {
-    LOG_DEBUG("QueuePopper operator() downloadQueues: " << downloadQueues);
-    return [downloadQueues = this->downloadQueues, dwQueue]() {
-      LOG_DEBUG("downloadQueues:" << downloadQueues);
-      return downloadQueues->popDownload(dwQueue);
+    LOG_DEBUG("QueuePopper operator() robotsLogic: " << robotsLogic);
+    return [popper = *this, dwQueue]() {
+      LOG_DEBUG("robotsLogic:" << popper.robotsLogic);
+      // the urls of the queue wait for its robots.txt
+      const bool   robotsTxt = !dwQueue->second.robotsTxts.empty();
+      DownloadElem result    = popper.robotsLogic->popDownload(dwQueue);
+      HostSlots&   slots     = dwQueue->second.slots;
+      HostCircuit& circuit   = dwQueue->second.circuit;
+      ++slots.inFlight;
+      if(CircuitState::OPEN == circuit.state) {
+        circuit.state = CircuitState::PROBING;
+      }
+      slots.scheduled = !robotsTxt && circuit.admitsDownloads() && slots.hasFreeSlot()
+                        && !popper.downloadList->empty(dwQueue);
+      if(slots.scheduled) {
+        popper.freeSlots->push_back(dwQueue);
+      }
+      return result;
     };
   }
 };
 
+/**
+ * Prewarms the download queues waiting in the TimeHeap, window before their delay ends.
+ * A queue waiting for its delay is not popped before its prewarm time, thus it is still in the DownloadQueues when
+ * it is prewarmed, as long as prewarm() is called before the TimeHeap is popped.
+ */
+class Prewarmer {
+public:
+  Prewarmer(const RobotsLogic* robotsLogic, Downloader* downloader, const std::chrono::milliseconds window)
+      : m_robotsLogic{robotsLogic}, m_downloader{downloader}, m_window{window}, m_prewarms{} {}
+
+  /**
+   * @param due the time the next download of dwQueue can start
+   */
+  void schedule(DownloadQueues::DownloadQueueIt dwQueue, const SteadyTime due) {
+    if(0 == m_window.count()) {
+      return;
+    }
+    m_prewarms.push_back(Prewarm{due - m_window, dwQueue});
+    std::push_heap(begin(m_prewarms), end(m_prewarms), PrewarmCmp{});
+  }
+
+  bool empty() const { return m_prewarms.empty(); }
+
+  /**
+   * @returns the time of the next prewarm, SteadyTime::max() if none is scheduled
+   */
+  SteadyTime nextTime() const { return m_prewarms.empty() ? SteadyTime::max() : m_prewarms.front().time; }
+
+  /**
+   * Prewarms the queues due until now.
+   */
+  void prewarm(const SteadyTime now) {
+    while(!m_prewarms.empty() && m_prewarms.front().time <= now) {
+      std::pop_heap(begin(m_prewarms), end(m_prewarms), PrewarmCmp{});
+      m_downloader->prewarm(m_robotsLogic->nextUrl(m_prewarms.back().dwQueue));
+      m_prewarms.pop_back();
+      prewarmsCounter.add();
+    }
+  }
+
+private:
+  struct Prewarm {
+    SteadyTime                      time;
+    DownloadQueues::DownloadQueueIt dwQueue;
+  };
+
+  struct PrewarmCmp {
+    bool operator()(const Prewarm& p1, const Prewarm& p2) const { return p2.time < p1.time; }
+  };
+
+  const RobotsLogic*        m_robotsLogic;
+  Downloader*               m_downloader;
+  std::chrono::milliseconds m_window;
+  std::vector<Prewarm>      m_prewarms; // heap of the earliest prewarm
+};
+
+/**
+ * Tracks the HostCircuit of the download queues, see CircuitBreakerOptions.
+ * The tripped queues are kept by politeness key across the batches until their cooldown passed.
+ */
+class CircuitBreaker {
+public:
+  CircuitBreaker(const CircuitBreakerOptions& options, RobotsLogic* robotsLogic, TrippedQueues* trippedQueues)
+      : m_options{options}, m_robotsLogic{robotsLogic}, m_trippedQueues{trippedQueues} {}
+
+  bool enabled() const { return 0 != m_options.maxConsecutiveFailures; }
+
+  /**
+   * Fails and erases the queues of a new batch which are still tripped, the queues whose cooldown passed start with
+   * a probe. Must be called before the queues are scheduled.
+   */
+  void admit(DownloadQueues& downloadList, const SteadyTime now) {
+    for(auto dwQueue = downloadList.begin(); dwQueue != downloadList.end();) {
+      const auto trippedIt = m_trippedQueues->find(dwQueue->first);
+      if(end(*m_trippedQueues) == trippedIt) {
+        ++dwQueue;
+      }
+      else if(now < trippedIt->second) {
+        failDownloads(dwQueue);
+        downloadList.erase(dwQueue++);
+      }
+      else {
+        dwQueue->second.circuit.state     = CircuitState::OPEN;
+        dwQueue->second.circuit.probeTime = now;
+        m_trippedQueues->erase(trippedIt);
+        ++dwQueue;
+      }
+    }
+    // the hosts not crawled again are forgotten once their cooldown passed
+    for(auto trippedIt = begin(*m_trippedQueues); trippedIt != end(*m_trippedQueues);) {
+      trippedIt = trippedIt->second <= now ? m_trippedQueues->erase(trippedIt) : std::next(trippedIt);
+    }
+  }
+
+  /**
+   * Updates the circuit of dwQueue with the outcome of one of its downloads.
+   * @returns the time the next download of dwQueue has to wait at least, 0 if the circuit does not delay it
+   */
+  std::chrono::seconds onFinished(DownloadQueues::DownloadQueueIt dwQueue,
+                                  const TransferOutcome&          outcome,
+                                  const SteadyTime                now) {
+    HostCircuit& circuit     = dwQueue->second.circuit;
+    const bool   hostFailure = HostCircuit::isHostFailure(outcome.transferError);
+    switch(circuit.state) {
+      case CircuitState::CLOSED:
+        circuit.nrFailures = hostFailure ? static_cast<uint16_t>(circuit.nrFailures + 1) : 0;
+        if(circuit.nrFailures < m_options.maxConsecutiveFailures) {
+          break;
+        }
+        LOG_DEBUG("circuit opened: " << dwQueue);
+        openedCircuits.add();
+        circuit.state      = CircuitState::OPEN;
+        circuit.nrFailures = 0;
+        circuit.nrStale    = dwQueue->second.slots.inFlight;
+        circuit.probeTime  = now + m_options.cooldown;
+        return m_options.cooldown;
+      case CircuitState::OPEN:
+        // a download started before the circuit opened
+        circuit.nrStale = circuit.nrStale > 0 ? static_cast<uint16_t>(circuit.nrStale - 1) : 0;
+        return now < circuit.probeTime ? std::chrono::ceil<std::chrono::seconds>(circuit.probeTime - now)
+                                       : std::chrono::seconds{0};
+      case CircuitState::PROBING:
+        if(circuit.nrStale > 0) {
+          --circuit.nrStale;
+        }
+        else if(hostFailure) {
+          trip(dwQueue, now);
+        }
+        else {
+          circuit.state = CircuitState::CLOSED;
+        }
+        break;
+      case CircuitState::TRIPPED:
+        // the urls of a robots.txt finished after the trip
+        failDownloads(dwQueue);
+        break;
+    }
+    return std::chrono::seconds{0};
+  }
+
+private:
+  void trip(DownloadQueues::DownloadQueueIt dwQueue, const SteadyTime now) {
+    LOG_INFO("circuit tripped: " << dwQueue);
+    trippedCircuits.add();
+    dwQueue->second.circuit.state      = CircuitState::TRIPPED;
+    (*m_trippedQueues)[dwQueue->first] = now + m_options.cooldown;
+    failDownloads(dwQueue);
+  }
+
+  void failDownloads(DownloadQueues::DownloadQueueIt dwQueue) {
+    circuitFailedUrls.add(
+        m_robotsLogic->failDownloads(dwQueue, TransferError::CIRCUIT_OPEN, "circuit open for host: " + dwQueue->first));
+  }
+
+  CircuitBreakerOptions m_options;
+  RobotsLogic*          m_robotsLogic;
+  TrippedQueues*        m_trippedQueues;
+};
+
 class DownloadFinishedAction {
 public:
-  void operator()(DownloadQueues::DownloadQueueIt dwQueue) {
-    finishActions->push([dfa = *this, dwQueue]() mutable {
+  void operator()(DownloadQueues::DownloadQueueIt dwQueue, const TransferOutcome& outcome) {
+    const bool       traced = sampleTrace();
+    const SteadyTime pushed = std::chrono::steady_clock::now();
+    finishActions->push([dfa = *this, dwQueue, outcome, traced, pushed]() mutable {
+      const SteadyTime now = std::chrono::steady_clock::now();
+      finishLatency.recordDuration(now - pushed);
+      if(traced) {
+        traceSpan("actionQueue", pushed, now);
+      }
       LOG_DEBUG("Download finished download: " << *dfa.downloadList);
       LOG_DEBUG("Download finished, downloadList: " << *dfa.downloadList);
       LOG_DEBUG("DownloadQueue: " << dwQueue);
-      if(!dfa.downloadList->empty(dwQueue)) {
+      HostSlots& slots = dwQueue->second.slots;
+      --slots.inFlight;
+      slots.adapt(outcome);
+      const SteadyTime     crtTime = crawlerNow(dfa.clock);
+      std::chrono::seconds delay   = dfa.perHostTimeout;
+      if(dfa.circuitBreaker->enabled()) {
+        delay = std::max(delay, dfa.circuitBreaker->onFinished(dwQueue, outcome, crtTime));
+      }
+      if(slots.scheduled) {
+        LOG_DEBUG("DownloadQueue already in the TimeHeap");
+      }
+      else if(!dfa.downloadList->empty(dwQueue)) {
         LOG_DEBUG("DownloadQueue not empty");
-        dfa.timeHeap->push(dfa.queuePopper(dwQueue), dfa.perHostTimeout);
+        // a probing queue waits for its probe
+        if(slots.hasFreeSlot() && CircuitState::PROBING != dwQueue->second.circuit.state) {
+          slots.scheduled = true;
+          dfa.timeHeap->push(dfa.queuePopper(dwQueue), delay, crtTime);
+          dfa.prewarmer->schedule(dwQueue, crtTime + delay);
+        }
       }
-      else {
+      else if(0 == slots.inFlight) {
         LOG_DEBUG("DownloadQueue empty");
         dfa.downloadList->erase(dwQueue);
       }
@@ -77,44 +390,145 @@ public:
   QueuePopper          queuePopper;
   DownloadQueues*      downloadList;
   TimeHeap*            timeHeap;
+  Prewarmer*           prewarmer;
+  CircuitBreaker*      circuitBreaker;
   size_t*              activeDownloads;
   ActionQueue*         finishActions;
   std::chrono::seconds perHostTimeout;
+  CrawlerClock*        clock;
 };
 
+void
+Crawler::Pimpl::waitAndExecute(ActionQueue& finishActions, const SteadyTime time) {
+  if(nullptr != m_clock) {
+    m_clock->advance(time);
+    finishActions.execute();
+  }
+  else if(SteadyTime::max() == time) {
+    finishActions.executeOrWaitAndExecute();
+  }
+  else {
+    finishActions.executeOrWaitAndExecuteOrWaitUntil(time);
+  }
+}
+
+void
+Crawler::Pimpl::updateConcurrency(TimeHeap& timeHeap, const size_t activeDownloads) {
+  const SteadyTime now = crawlerNow(m_clock);
+  if(!canAddDownload(activeDownloads, m_maxActiveDownloads) && !timeHeap.empty() && timeHeap.topTime() <= now) {
+    m_concurrency->onLimitReached();
+  }
+  if(m_concurrency->due(now)) {
+    m_maxActiveDownloads = m_concurrency->update(now, m_downloader->eventLoopLag());
+  }
+}
+
+void
+Crawler::Pimpl::assignSlots(DownloadQueues& downloadList) const {
+  constexpr size_t MAX_SLOTS = std::numeric_limits<uint16_t>::max();
+  for(auto dwQueue = downloadList.begin(); dwQueue != downloadList.end(); ++dwQueue) {
+    const bool   overridden = end(m_hostConcurrency.slots) != m_hostConcurrency.slots.find(dwQueue->first);
+    const size_t limit      = std::min(m_hostConcurrency.slotsOf(dwQueue->first), MAX_SLOTS);
+    size_t       maxLimit   = limit;
+    if(m_hostConcurrency.adaptive && !overridden) {
+      maxLimit = std::clamp(m_hostConcurrency.maxAdaptiveSlots, limit, MAX_SLOTS);
+    }
+    const size_t multiplexedLimit = overridden ? 0 : std::min(m_hostConcurrency.multiplexedSlots, MAX_SLOTS);
+    HostSlots&   slots            = dwQueue->second.slots;
+    slots.limit                   = static_cast<uint16_t>(limit);
+    slots.maxLimit                = static_cast<uint16_t>(maxLimit);
+    slots.multiplexedLimit        = static_cast<uint16_t>(multiplexedLimit);
+    slots.scheduled               = true;
+  }
+}
+
+void
+Crawler::Pimpl::prefetchHosts(DownloadQueues& downloadList, const RobotsLogic& robotsLogic) const {
+  for(auto dwQueue = downloadList.begin(); dwQueue != downloadList.end(); ++dwQueue) {
+    if(!downloadList.empty(dwQueue)) {
+      m_downloader->prefetchHost(robotsLogic.nextUrl(dwQueue));
+    }
+  }
+}
+
+void
+Crawler::Pimpl::startDownload(DownloadElem&& download) {
+  if(m_concurrency) {
+    download.callback = [concurrency = m_concurrency.get(),
+                         callback    = std::move(download.callback)](DownloadResult&& dwResult) {
+      concurrency->onFinished(dwResult);
+      callback(std::move(dwResult));
+    };
+  }
+  m_downloader->download(std::move(download));
+}
+
 void
 Crawler::Pimpl::crawl() {
   LOG_DEBUG("Crawler::Pimpl::crawl start crawling");
   size_t activeDownloads = 0;
   while(m_keepCrawling()) {
-    TimeHeap               timeHeap;
-    DownloadQueues         downloadList;
-    QueuePopper            queuePopper{&downloadList};
-    ActionQueue            finishActions;
-    DownloadFinishedAction dfa{
-        queuePopper, &downloadList, &timeHeap, &activeDownloads, &finishActions, m_perHostTimeout};
-    populateDownloadQueuesWithRobots(&downloadList, m_dispatcher(), dfa);
+    TimeHeap                                     timeHeap;
+    DownloadQueues                               downloadList;
+    RobotsLogic                                  robotsLogic{&downloadList, m_politenessKey};
+    std::vector<DownloadQueues::DownloadQueueIt> freeSlots;
+    QueuePopper                                  queuePopper{&robotsLogic, &downloadList, &freeSlots};
+    Prewarmer                                    prewarmer{&robotsLogic, m_downloader, m_prewarmWindow};
+    CircuitBreaker                               circuitBreaker{m_circuitBreaker, &robotsLogic, &m_trippedQueues};
+    ActionQueue                                  finishActions;
+    DownloadFinishedAction                       dfa{queuePopper,
+                               &downloadList,
+                               &timeHeap,
+                               &prewarmer,
+                               &circuitBreaker,
+                               &activeDownloads,
+                               &finishActions,
+                               m_perHostTimeout,
+                               m_clock};
+    robotsLogic.populateDownloadQueues(m_dispatcher(), dfa);
+    batchesCounter.add();
+    queuedUrlsCounter.add(robotsLogic.nrQueuedUrls());
 
-    timeHeap = TimeHeap{downloadList, downloadList.size(), queuePopper};
+    if(circuitBreaker.enabled()) {
+      circuitBreaker.admit(downloadList, crawlerNow(m_clock));
+    }
+    assignSlots(downloadList);
+    prefetchHosts(downloadList, robotsLogic);
+    timeHeap = TimeHeap{downloadList, downloadList.size(), queuePopper, crawlerNow(m_clock)};
 
     while(!downloadList.empty() || activeDownloads > 0 || !timeHeap.empty()) {
+      activeDownloadsGauge.set(activeDownloads);
+      downloadQueuesGauge.set(downloadList.size());
+      waitingQueuesGauge.set(timeHeap.size());
+      if(m_concurrency) {
+        updateConcurrency(timeHeap, activeDownloads);
+      }
       if(!canAddDownload(activeDownloads, m_maxActiveDownloads) || timeHeap.empty()) {
         LOG_DEBUG("Waiting for downloads to finished. activeDownloads: " << activeDownloads << " m_maxActiveDownloads: "
                                                                          << m_maxActiveDownloads
                                                                          << " empty timeHeap: " << timeHeap.empty());
-        finishActions.executeOrWaitAndExecute();
+        if(!prewarmer.empty()) {
+          prewarmer.prewarm(crawlerNow(m_clock));
+        }
+        waitAndExecute(finishActions, prewarmer.nextTime());
       }
       else {
-        auto crtTime = std::chrono::steady_clock::now();
+        auto crtTime = crawlerNow(m_clock);
+        // before the pops, the prewarmed queues are still queued
+        prewarmer.prewarm(crtTime);
         if(crtTime < timeHeap.topTime()) {
           LOG_DEBUG("Waiting for downloads with timeout");
-          finishActions.executeOrWaitAndExecuteOrWaitUntil(timeHeap.topTime());
+          waitAndExecute(finishActions, std::min(timeHeap.topTime(), prewarmer.nextTime()));
         }
         else {
           do {
             LOG_DEBUG("Adding new download");
-            m_downloader->download(timeHeap.pop());
+            startDownload(timeHeap.pop(crtTime));
             ++activeDownloads;
+            for(const DownloadQueues::DownloadQueueIt dwQueue: freeSlots) {
+              timeHeap.push(queuePopper(dwQueue), std::chrono::seconds{0}, crtTime);
+            }
+            freeSlots.clear();
           } while(::canAddDownload(activeDownloads, m_maxActiveDownloads) && !timeHeap.empty()
                   && crtTime >= timeHeap.topTime());
           finishActions.execute();
@@ -124,20 +538,63 @@ Crawler::Pimpl::crawl() {
     if(!timeHeap.empty()) {
       throw std::logic_error("Internal ERROR: downloadQueue empty but timeHeap not empty");
     }
+    activeDownloadsGauge.set(activeDownloads);
+    downloadQueuesGauge.set(0);
+    waitingQueuesGauge.set(0);
   }
   LOG_DEBUG("Bye bye birdie");
 }
 
 // class Crawler
+Crawler::Crawler(std::function<bool()>&&     keepCrawling,
+                 std::function<UrlBatch()>&& dispatcher,
+                 Downloader*                 downloader,
+                 size_t                      maxActiveQueues,
+                 std::chrono::seconds        perHostTimeout,
+                 CrawlerClock*               clock)
+    : m_pimpl{new Pimpl{
+        std::move(keepCrawling), std::move(dispatcher), downloader, maxActiveQueues, perHostTimeout, clock}} {}
+
 Crawler::Crawler(std::function<bool()>&&                      keepCrawling,
                  std::function<std::vector<DownloadElem>()>&& dispatcher,
                  Downloader*                                  downloader,
                  size_t                                       maxActiveQueues,
-                 std::chrono::seconds                         perHostTimeout)
-    : m_pimpl{new Pimpl{std::move(keepCrawling), std::move(dispatcher), downloader, maxActiveQueues, perHostTimeout}} {}
+                 std::chrono::seconds                         perHostTimeout,
+                 CrawlerClock*                                clock)
+    : Crawler{std::move(keepCrawling),
+              [dispatcher = std::move(dispatcher)]() { return makeUrlBatch(dispatcher()); },
+              downloader,
+              maxActiveQueues,
+              perHostTimeout,
+              clock} {}
 
 Crawler::~Crawler() {}
 
+void
+Crawler::adaptConcurrency(const AdaptiveConcurrencyOptions& options) {
+  m_pimpl->adaptConcurrency(options);
+}
+
+void
+Crawler::setPolitenessKey(PolitenessKey politenessKey) {
+  m_pimpl->setPolitenessKey(std::move(politenessKey));
+}
+
+void
+Crawler::setHostConcurrency(const HostConcurrency& hostConcurrency) {
+  m_pimpl->setHostConcurrency(hostConcurrency);
+}
+
+void
+Crawler::setPrewarmWindow(const std::chrono::milliseconds window) {
+  m_pimpl->setPrewarmWindow(window);
+}
+
+void
+Crawler::setCircuitBreaker(const CircuitBreakerOptions& options) {
+  m_pimpl->setCircuitBreaker(options);
+}
+
 void
 Crawler::crawl() {
   m_pimpl->crawl();
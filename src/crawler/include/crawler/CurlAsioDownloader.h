@@ -1,20 +1,59 @@
 #ifndef CRAWLER_CURLASIODOWNLOADER_H_UKHIGCT4
 #define CRAWLER_CURLASIODOWNLOADER_H_UKHIGCT4
 
+#include "BandwidthLimiter.h"
+#include "ContentScanner.h"
+#include "DnsCache.h"
 #include "MediaType.h"
+#include "SegmentFiles.h"
+#include "TransferTimeouts.h"
 #include "crawler.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
+/**
+ * Options of the CurlAsioDownloader, the defaults download without limits beside the default timeouts.
+ */
+struct CurlAsioDownloaderOptions {
+  unsigned short metricsPort{0}; // if not 0 the metrics are served on this port of the loopback interface
+  // connect to other hosts than the ones of the urls, in the CURLOPT_CONNECT_TO format
+  // HOST:PORT:CONNECT-TO-HOST:CONNECT-TO-PORT, e.g. "::127.0.0.1:8080" for a local test server
+  std::vector<std::string> connectTo{};
+  BandwidthLimits          bandwidthLimits{};  // downloads of a host over its budget fail without a transfer
+  DnsCacheLimits           dnsCacheLimits{};   // size and lifetime of the cached resolutions
+  TimeoutOptions           timeoutOptions{};   // deadlines and low speed limit of the transfers
+  StreamingOptions         streamingOptions{}; // the large bodies of the streamed media types go to segment files
+  // scanners of the content kept in memory, fed while it is received, see DownloadResult::scanner
+  ContentScannerFactory scannerFactory{};
+};
+
+/**
+ * Downloader running libcurl on a Boost.Asio event loop thread.
+ * The hosts are resolved by a pool of resolver threads into a DNS cache before their transfers are added to curl,
+ * curl receives the addresses with CURLOPT_RESOLVE. A download of a host which could not be resolved fails with
+ * TransferError::DNS without a transfer.
+ * A prewarm resolves the host of the url and connects to it. The connection is handed to curl for the first download
+ * to its address, or closed after a few seconds. The TLS handshake is still done by the download.
+ */
 class CurlAsioDownloader : public Downloader {
 public:
-  CurlAsioDownloader(size_t maxContentLength, std::function<bool(const MediaType&)> mediaTypeValidator);
+  /**
+   * @throws std::invalid_argument for invalid timeoutOptions or streamingOptions
+   */
+  CurlAsioDownloader(size_t                                maxContentLength,
+                     std::function<bool(const MediaType&)> mediaTypeValidator,
+                     CurlAsioDownloaderOptions             options = {});
   ~CurlAsioDownloader();
 
   struct Pimpl;
 
 private:
   void                         doDownload(DownloadElem&&) override;
+  std::chrono::microseconds    doEventLoopLag() override;
+  void                         doPrewarm(std::string_view url) override;
+  void                         doPrefetchHost(std::string_view url) override;
   const std::unique_ptr<Pimpl> m_pimpl;
 };
 
@@ -0,0 +1,54 @@
+#ifndef CRAWLER_HOSTCONCURRENCY_H_P5ZCW2HM
+#define CRAWLER_HOSTCONCURRENCY_H_P5ZCW2HM
+
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <string_view>
+
+/**
+ * Maximum number of simultaneous downloads of a download queue, see Crawler::setHostConcurrency.
+ * Each slot of a queue waits the politeness delay after its download finished, thus a queue with N slots is crawled
+ * about N times faster.
+ */
+struct HostConcurrency {
+  size_t defaultSlots{1};
+
+  /**
+   * Slots of the queues of some politeness keys, e.g. partner sites and own origins allowing more.
+   */
+  std::map<std::string, size_t, std::less<>> slots;
+
+  /**
+   * Adapts the slots of each queue starting from its slots: one more after as many successful downloads as slots,
+   * half of them on timeouts and connection errors. The learned slots are kept for the batch of the queue.
+   */
+  bool adaptive{false};
+
+  /**
+   * Upper limit of the adaptive slots of the queues without an entry in slots.
+   */
+  size_t maxAdaptiveSlots{8};
+
+  /**
+   * Slots of the queues without an entry in slots once their host answered over HTTP/2: the downloads are streams
+   * of one connection instead of more connections. 0 keeps the slots of HTTP/2 hosts.
+   */
+  size_t multiplexedSlots{0};
+
+  size_t slotsOf(std::string_view politenessKey) const {
+    const auto slotsIt = slots.find(politenessKey);
+    return end(slots) == slotsIt ? defaultSlots : slotsIt->second;
+  }
+};
+
+/**
+ * Reads the slots of politeness keys into o_concurrency.slots.
+ * Each line holds a politeness key and its number of slots separated by whitespace, empty lines and lines starting
+ * with '#' are skipped.
+ * @throws std::runtime_error for invalid lines
+ */
+void readHostSlots(std::istream& in, HostConcurrency& o_concurrency);
+
+#endif /* end of include guard: CRAWLER_HOSTCONCURRENCY_H_P5ZCW2HM */
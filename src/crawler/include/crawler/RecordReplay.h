@@ -0,0 +1,66 @@
+#ifndef CRAWLER_RECORDREPLAY_H_Q7VMC2KD
+#define CRAWLER_RECORDREPLAY_H_Q7VMC2KD
+
+#include "crawler.h"
+
+#include <memory>
+#include <string>
+
+/**
+ * Decorator recording the results of another downloader into a file, for replaying them with the ReplayDownloader.
+ * Each record keeps the result and the time between the download request and its result.
+ * The file is binary in the byte order of the host, it is written when the results arrive.
+ * The wrapped downloader must stay alive while the RecordingDownloader is used, it may be destroyed after it: the
+ * callbacks of the pending downloads share the file, it is closed with the last of them.
+ */
+class RecordingDownloader : public Downloader {
+public:
+  /**
+   * @throws std::runtime_error if the file cannot be created
+   */
+  RecordingDownloader(Downloader* downloader, const std::string& filename);
+  ~RecordingDownloader();
+
+  struct Pimpl;
+
+private:
+  void                         doDownload(DownloadElem&&) override;
+  std::chrono::microseconds    doEventLoopLag() override;
+  void                         doPrewarm(std::string_view url) override;
+  void                         doPrefetchHost(std::string_view url) override;
+  const std::unique_ptr<Pimpl> m_pimpl;
+};
+
+enum class ReplaySpeed {
+  RECORDED, // each result is delivered after the recorded download time
+  MAXIMUM   // the results are delivered as fast as possible
+};
+
+/**
+ * Downloader delivering the results recorded by a RecordingDownloader, nothing is downloaded.
+ * A url recorded several times is replayed in the order of the recording, urls without a record fail.
+ * The urlIndex of the results is the one of the replayed download.
+ * The results are delivered by a thread of the ReplayDownloader, in the order they are due.
+ */
+class ReplayDownloader : public Downloader {
+public:
+  /**
+   * Reads all the records of the file.
+   * @throws std::runtime_error if the file cannot be read or is not a recording
+   */
+  ReplayDownloader(const std::string& filename, ReplaySpeed speed);
+  ~ReplayDownloader();
+
+  /**
+   * @returns the number of records which were not replayed yet
+   */
+  size_t nrRemainingRecords() const;
+
+  struct Pimpl;
+
+private:
+  void                         doDownload(DownloadElem&&) override;
+  const std::unique_ptr<Pimpl> m_pimpl;
+};
+
+#endif /* end of include guard: CRAWLER_RECORDREPLAY_H_Q7VMC2KD */
@@ -0,0 +1,79 @@
+#ifndef CRAWLER_SIMULATEDDOWNLOADER_H_N8TQ3FXE
+#define CRAWLER_SIMULATEDDOWNLOADER_H_N8TQ3FXE
+
+#include "crawler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Latency and error distributions of the simulated hosts.
+ * Each host draws its median latency once, the downloads of the host are spread around this median.
+ */
+struct SimulationProfile {
+  // median of the host medians
+  std::chrono::microseconds medianLatency{std::chrono::milliseconds{300}};
+  double                    hostLatencySpread{1.};   // sigma of the lognormal distribution of the host medians
+  double                    latencySpread{.5};       // sigma of the lognormal distribution of one host
+  double                    deadHostRate{.01};       // hosts failing all their downloads, e.g. unresolvable
+  double                    errorRate{.02};          // downloads failing on the other hosts
+  double                    multiplexedHostRate{0.}; // hosts answering over HTTP/2, see DownloadResult::multiplexed
+  size_t                    capacity{0}; // simultaneous downloads the network sustains, 0 for unlimited
+  std::chrono::microseconds timeout{std::chrono::seconds{30}}; // the downloads started above capacity time out
+  size_t                    hostSlots{1}; // simultaneous downloads of a host which are not a politeness violation
+  uint32_t                  seed{1};
+};
+
+/**
+ * Summary of a simulated crawl.
+ */
+struct SimulationStats {
+  size_t                    nrDownloads{0};
+  size_t                    nrFailedDownloads{0};
+  size_t                    maxActiveDownloads{0};
+  size_t                    nrPolitenessViolations{0};
+  size_t                    nrPrewarms{0};
+  size_t                    nrPrewarmedDownloads{0}; // downloads of a host prewarmed after its previous download
+  std::chrono::microseconds virtualDuration{0};
+  double                    meanActiveDownloads{0.};
+  std::chrono::nanoseconds  crawlerCpu{0}; // CPU time of the crawling thread spent outside of the simulator
+
+  double slotUtilisation(const size_t maxActiveQueues) const { return meanActiveDownloads / maxActiveQueues; }
+
+  std::chrono::nanoseconds crawlerCpuPerDownload() const {
+    return 0 == nrDownloads ? std::chrono::nanoseconds{0} : crawlerCpu / static_cast<int64_t>(nrDownloads);
+  }
+};
+
+/**
+ * Downloader running on virtual time, for scheduler tests and benchmarks at production scale.
+ * Give it to the Crawler both as downloader and as clock: instead of waiting the crawler moves the virtual time to
+ * the next finished download, which is delivered synchronously from the crawling thread.
+ * Nothing is downloaded, the results have no content.
+ * A politeness violation is a download started while the previous download of its host is still active
+ * or before politenessDelay passed since it finished. With several hostSlots it is a download started while all
+ * the slots of its host are active.
+ * The crawler CPU is measured from the construction of the simulator, thus it includes the dispatcher and the sinks.
+ */
+class SimulatedDownloader
+    : public Downloader
+    , public CrawlerClock {
+public:
+  SimulatedDownloader(const SimulationProfile& profile, std::chrono::seconds politenessDelay);
+  ~SimulatedDownloader();
+
+  SteadyTime now() override;
+  void       advance(SteadyTime time) override;
+
+  SimulationStats stats() const;
+
+  struct Pimpl;
+
+private:
+  void                         doDownload(DownloadElem&&) override;
+  void                         doPrewarm(std::string_view url) override;
+  const std::unique_ptr<Pimpl> m_pimpl;
+};
+
+#endif /* end of include guard: CRAWLER_SIMULATEDDOWNLOADER_H_N8TQ3FXE */
@@ -4,9 +4,13 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "HostConcurrency.h"
 #include "Url.h"
+#include "UrlBatch.h"
 
 class Downloader {
 public:
@@ -19,6 +23,24 @@ public:
    */
   void download(DownloadElem&& elem) { doDownload(std::move(elem)); }
 
+  /**
+   * @returns the longest delay of the event loop of the downloader since the previous call,
+   *          0 for downloaders without an event loop
+   */
+  std::chrono::microseconds eventLoopLag() { return doEventLoopLag(); }
+
+  /**
+   * Hints that url will be downloaded soon: the downloader may resolve its host and connect to it ahead, thus the
+   * download does not wait for the handshake. Nothing is requested from the host. Ignored by default.
+   */
+  void prewarm(std::string_view url) { doPrewarm(url); }
+
+  /**
+   * Hints that the host of url will be downloaded from: the downloader may resolve its name ahead, thus the downloads
+   * do not wait for the DNS. Ignored by default.
+   */
+  void prefetchHost(std::string_view url) { doPrefetchHost(url); }
+
   /**
    * On destruction abort all ongoing downloads ASAP.
    * Do not call any non-started callbacks.
@@ -26,9 +48,71 @@ public:
   virtual ~Downloader() {}
 
 private:
-  virtual void doDownload(DownloadElem&&) = 0;
+  virtual void                      doDownload(DownloadElem&&) = 0;
+  virtual std::chrono::microseconds doEventLoopLag() { return std::chrono::microseconds{0}; }
+  virtual void                      doPrewarm(std::string_view) {}
+  virtual void                      doPrefetchHost(std::string_view) {}
+};
+
+/**
+ * Time source of the crawler, the steady clock is used if none is given.
+ * A virtual clock lets a simulation run days of politeness delays in seconds, see SimulatedDownloader.
+ * The virtual clock is only used from the crawling thread.
+ */
+class CrawlerClock {
+public:
+  virtual ~CrawlerClock() {}
+
+  virtual SteadyTime now() = 0;
+
+  /**
+   * Called by the crawler instead of blocking while it waits for finished downloads.
+   * The clock moves forward to the next event, at most to time, and delivers the downloads finished then.
+   * @param time SteadyTime::max() if the crawler can only continue after a finished download
+   */
+  virtual void advance(SteadyTime time) = 0;
 };
 
+/**
+ * Adaptation of the maximum number of simultaneous downloads of the crawler, see Crawler::adaptConcurrency.
+ * The limit starts at maxActiveQueues and is evaluated once per interval, with additive increase and multiplicative
+ * decrease:
+ *  - decreased by decreaseFactor if more than maxErrorRate of the downloads finished in the interval timed out or
+ *    could not connect, if the event loop of the downloader lagged more than maxEventLoopLag or if the successful
+ *    downloads per second dropped by more than maxThroughputDrop after the previous increase
+ *  - otherwise increased by increaseStep if the limit held back a due download during the interval
+ */
+struct AdaptiveConcurrencyOptions {
+  size_t                    minActiveDownloads{1};
+  size_t                    maxActiveDownloads{1000};
+  size_t                    increaseStep{4};
+  double                    decreaseFactor{.75};
+  double                    maxErrorRate{.1};
+  double                    maxThroughputDrop{.2};
+  std::chrono::milliseconds maxEventLoopLag{100};
+  std::chrono::milliseconds interval{2000};
+};
+
+/**
+ * Stops downloading from the hosts which are down, see Crawler::setCircuitBreaker.
+ * After maxConsecutiveFailures consecutive downloads of a download queue timed out, could not connect or could not
+ * resolve the host, the circuit of the queue opens: its next download waits for the cooldown instead of the politeness
+ * delay and probes the host alone. If the probe succeeds the downloads continue, otherwise the circuit trips: the
+ * remaining urls of the queue are failed at once with TransferError::CIRCUIT_OPEN, as are the urls of the queue in the
+ * following batches until the cooldown passed again. Then the queue starts with a probe.
+ */
+struct CircuitBreakerOptions {
+  size_t               maxConsecutiveFailures{0}; // 0 disables the circuit breaker
+  std::chrono::seconds cooldown{60};
+};
+
+/**
+ * Maps the lowercase host of an url to the key of its download queue. The hosts with the same key share one queue,
+ * thus one download at a time and the politeness delay, e.g. with registeredDomain() the subdomains of a site or with
+ * the resolved IP address the virtual hosts of a server. The robots.txt files are still downloaded per host.
+ */
+using PolitenessKey = std::function<std::string(std::string_view host)>;
+
 /**
  * Flow:
  * While (keepCrawling)
@@ -48,7 +132,8 @@ private:
  *  - Pull URL list from the crawling dispatcher
  *  - Calculate overall robots.txt url list for the dispatched url bunch
  *  - Read robots.txt before each call to dispatcher (no persistent robots.txt)
- *  - One download queue per host with 2 secs timeout between downloads per host
+ *  - One download queue per host with 2 secs timeout between downloads per host,
+ *    or per politeness key, see setPolitenessKey()
  *  - Filter URLs by robots.txt result
  *  - Call download result for each finished download
  */
@@ -58,21 +143,66 @@ public:
    * @param keepCrawling called before getting the list of downloads from the dispatcher
    *                     and stops when false is returned
    * @param dispatcher is called whenever new urls can be added to be downloaded
-   *                   should return the list of url to be downloaded
+   *                   should return the batch of urls to be downloaded,
+   *                   the results of the batch are delivered to its single sink
    * @param downloader the software component responsible for actual downloading
    * @param maxActiveQueues Downloads are split by hosts into download queues.
    *                        This param controls the number of maximum simultaneous downloads.
-   *                        There can only be maximum one download per queue
+   *                        There can only be maximum one download per queue, see setHostConcurrency
    * @param perHostTimeout timeout between subsequent download requests to the same host,
    *                       after a download is finished
+   * @param clock if not null replaces the steady clock, it must outlive the crawler
+   */
+  Crawler(std::function<bool()>&&     keepCrawling,
+          std::function<UrlBatch()>&& dispatcher,
+          Downloader*                 downloader,
+          size_t                      maxActiveQueues,
+          std::chrono::seconds        perHostTimeout,
+          CrawlerClock*               clock = nullptr);
+
+  /**
+   * Same as above, for dispatchers returning downloads with their own callbacks.
+   * The downloads are converted with makeUrlBatch.
    */
   Crawler(std::function<bool()>&&                      keepCrawling,
           std::function<std::vector<DownloadElem>()>&& dispatcher,
           Downloader*                                  downloader,
           size_t                                       maxActiveQueues,
-          std::chrono::seconds                         perHostTimeout);
+          std::chrono::seconds                         perHostTimeout,
+          CrawlerClock*                                clock = nullptr);
   ~Crawler();
 
+  /**
+   * Replaces the fixed maxActiveQueues with a limit adapted to the observed throughput, errors and event loop lag.
+   * The limit starts at maxActiveQueues moved into the limits of the options. Must be called before crawl().
+   * @throws std::invalid_argument for invalid options
+   */
+  void adaptConcurrency(const AdaptiveConcurrencyOptions& options);
+
+  /**
+   * Groups the hosts into download queues by politenessKey instead of one queue per host.
+   * Must be called before crawl().
+   */
+  void setPolitenessKey(PolitenessKey politenessKey);
+
+  /**
+   * Allows more than one simultaneous download per download queue. Must be called before crawl().
+   * @throws std::invalid_argument for 0 slots
+   */
+  void setHostConcurrency(const HostConcurrency& hostConcurrency);
+
+  /**
+   * Calls Downloader::prewarm with the next url of each download queue waiting for its politeness delay,
+   * window before the delay ends. Disabled by default or for a window of 0. Must be called before crawl().
+   */
+  void setPrewarmWindow(std::chrono::milliseconds window);
+
+  /**
+   * Enables the circuit breaker of the download queues, disabled by default. Must be called before crawl().
+   * @throws std::invalid_argument for a negative cooldown or more than 65535 failures
+   */
+  void setCircuitBreaker(const CircuitBreakerOptions& options);
+
   /**
    * Will stop getting urls from the dispatcher
    * when keepCrawling returns false
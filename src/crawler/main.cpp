@@ -3,35 +3,82 @@ LOG_INIT(DriverMain);
 
 #include "DownloadResult.h"
 #include "MediaType.h"
+#include "NearDuplicateFilter.h"
+#include "OutlinkDispatcher.h"
 #include "ProgramLogic.h"
 #include "TaskSystem.h"
+#include "Tracer.h"
+#include "UrlBatch.h"
+#include "UrlFileDispatcher.h"
 #include "crawler/CurlAsioDownloader.h"
+#include "crawler/RecordReplay.h"
 #include "crawler/crawler.h"
 #include "handleExceptions.h"
 #include "readUrlsFromFile.h"
+#include "uriUtils/uriUtils.h"
 
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
+#include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <math.h>
+#include <memory>
 #include <sstream>
 
 namespace {
 
 struct DriverOptions {
-  bool        shouldContinue;
-  std::string urlsFilename;
-  std::string url;
-  std::string prefix;
-  size_t      maxUrls;
-  bool        printUrls;
-  size_t      parallelDownloads;
-  size_t      maxContentLength;
+  bool                       shouldContinue;
+  std::string                urlsFilename;
+  std::string                url;
+  std::string                prefix;
+  size_t                     maxUrls;
+  size_t                     batchSize;
+  bool                       printUrls;
+  size_t                     parallelDownloads;
+  size_t                     maxContentLength;
+  unsigned short             metricsPort;
+  std::string                recordFilename;
+  std::string                replayFilename;
+  ReplaySpeed                replaySpeed;
+  OutlinkOptions             outlinks;
+  bool                       filterNearDuplicates;
+  NearDuplicateOptions       nearDuplicates;
+  bool                       adaptConcurrency;
+  AdaptiveConcurrencyOptions concurrency;
+  BandwidthLimits            bandwidth;
+  bool                       politenessByDomain;
+  HostConcurrency            hostConcurrency;
+  size_t                     prewarmWindow;
+  DnsCacheLimits             dnsCache;
+  CircuitBreakerOptions      circuitBreaker;
+  TimeoutOptions             timeouts;
+  StreamingOptions           streaming;
 };
 
+/**
+ * @returns the matcher of the media types given as type/subtype
+ */
+std::function<bool(const MediaType&)>
+mediaTypeMatcher(const std::vector<std::string>& mediaTypes) {
+  std::vector<MediaType> matched;
+  for(const std::string& mediaType: mediaTypes) {
+    const size_t slash = mediaType.find('/');
+    if(std::string::npos == slash) {
+      throw std::runtime_error("Invalid media type: " + mediaType);
+    }
+    matched.push_back(MediaType{mediaType.substr(0, slash), mediaType.substr(slash + 1), std::string{}});
+  }
+  return [matched](const MediaType& mediaType) {
+    return std::any_of(begin(matched), end(matched), [&mediaType](const MediaType& candidate) {
+      return boost::iequals(mediaType.type, candidate.type) && boost::iequals(mediaType.subtype, candidate.subtype);
+    });
+  };
+}
+
 DriverOptions
 readCommandLineArgs(const int argc, const char** argv) {
   namespace po = boost::program_options;
@@ -58,12 +105,51 @@ readCommandLineArgs(const int argc, const char** argv) {
     ("parallelDownloads", po::value<size_t>(&result.parallelDownloads)->default_value(10), "Number of simultaneous downloads.")
     ("maxContentLength", po::value<size_t>(&result.maxContentLength)->default_value(1024*1024), "Maximum allowed length of a downloaded page. Default 1Mb")
     ("maxUrls", po::value<size_t>(&result.maxUrls)->default_value(100), "The maximum number of URLs to be downloaded. Default is 100")
+    ("batchSize", po::value<size_t>(&result.batchSize)->default_value(100000), "Number of URLs read from the urlListFile and crawled together. The robots.txt files are downloaded for each batch.")
     ("printUrls", po::value<bool>(&result.printUrls)->default_value(false), "print all read urls")
+    ("metricsPort", po::value<unsigned short>(&result.metricsPort)->default_value(0), "Serve the metrics in the Prometheus format on http://127.0.0.1:<metricsPort>/metrics. Disabled when 0.")
+    ("record", po::value<std::string>(&result.recordFilename), "Record the download results into this file.")
+    ("replay", po::value<std::string>(&result.replayFilename), "Replay the download results recorded in this file instead of downloading.")
+    ("replaySpeed", po::value<std::string>()->default_value("recorded"), "recorded: replay each result after its recorded download time, max: replay as fast as possible.")
+    ("maxDepth", po::value<size_t>(&result.outlinks.maxDepth)->default_value(0), "Follow the links of the downloaded pages up to this depth, the given urls have depth 0. Disabled when 0.")
+    ("scope", po::value<std::string>()->default_value("host"), "Links followed with maxDepth, host: the hosts of the given urls, domain: also their subdomains and the domains without www, allow: the allowHosts and their subdomains.")
+    ("allowHosts", po::value<std::vector<std::string>>(&result.outlinks.allowedHosts)->multitoken(), "The hosts of the allow scope.")
+    ("nearDuplicates", po::value<std::string>()->default_value("off"), "Pages differing only slightly from a page downloaded before, e.g. in timestamps or ads, off: are saved, tag: are saved with the nearDup_ prefix, skip: are not saved.")
+    ("nearDuplicateDistance", po::value<unsigned>(&result.nearDuplicates.maxDistance)->default_value(3), "Maximum number of different bits of the 64 bit SimHashes of near duplicate pages.")
+    ("adaptiveConcurrency", po::value<bool>(&result.adaptConcurrency)->default_value(false), "Adapt the number of simultaneous downloads starting from parallelDownloads: increase it while the downloads succeed, decrease it on timeouts, connection errors, event loop lag or a lower throughput.")
+    ("minParallelDownloads", po::value<size_t>(&result.concurrency.minActiveDownloads)->default_value(1), "Lower limit of the adapted number of simultaneous downloads.")
+    ("maxParallelDownloads", po::value<size_t>(&result.concurrency.maxActiveDownloads)->default_value(1000), "Upper limit of the adapted number of simultaneous downloads.")
+    ("maxBytesPerSecond", po::value<uint64_t>(&result.bandwidth.bytesPerSecond)->default_value(0), "Aggregate receive rate of all the downloads, the transfers over it are paused. Unlimited when 0.")
+    ("hostByteBudget", po::value<uint64_t>(&result.bandwidth.hostBudgetBytes)->default_value(0), "Maximum bytes received from each host during the crawl, the downloads over it fail. Unlimited when 0.")
+    ("memoryBudget", po::value<uint64_t>(&result.bandwidth.memoryBudgetBytes)->default_value(0), "Maximum bytes of downloaded content held in memory by the transfers and the unprocessed results, the transfers over it are paused. Unlimited when 0.")
+    ("politeness", po::value<std::string>()->default_value("host"), "Hosts sharing the 2 secs delay between downloads, host: each host, domain: the subdomains of a registered domain, e.g. www.x.com and x.com. The robots.txt files are per host.")
+    ("hostSlots", po::value<size_t>(&result.hostConcurrency.defaultSlots)->default_value(1), "Simultaneous downloads of each host or politeness key, each of them waits the 2 secs delay after it finished.")
+    ("hostSlotsFile", po::value<std::string>(), "File of lines with a host or politeness key and its number of simultaneous downloads overriding hostSlots, e.g. for own origins.")
+    ("adaptiveHostSlots", po::value<bool>(&result.hostConcurrency.adaptive)->default_value(false), "Grow the simultaneous downloads of the hosts not in hostSlotsFile while their downloads succeed up to maxHostSlots, halve them on timeouts and connection errors.")
+    ("maxHostSlots", po::value<size_t>(&result.hostConcurrency.maxAdaptiveSlots)->default_value(8), "Upper limit of the adaptive host slots.")
+    ("multiplexedHostSlots", po::value<size_t>(&result.hostConcurrency.multiplexedSlots)->default_value(0), "Simultaneous downloads of the hosts not in hostSlotsFile once they answered over HTTP/2, as streams of one connection. Disabled when 0.")
+    ("prewarmWindow", po::value<size_t>(&result.prewarmWindow)->default_value(0), "Milliseconds before the end of the 2 secs delay of a host its connection is opened, thus the next download does not wait for the TCP handshake. Disabled when 0.")
+    ("prewarmIdle", po::value<size_t>()->default_value(TimeoutOptions{}.prewarmIdle.count()), "Milliseconds a prewarmed connection waits for its download before it is closed, keep it below the time the servers keep a connection without request open.")
+    ("dnsCacheSize", po::value<size_t>(&result.dnsCache.maxEntries)->default_value(DnsCacheLimits{}.maxEntries), "Maximum number of host names in the DNS cache, the least recently used ones are evicted.")
+    ("dnsCacheTtl", po::value<size_t>()->default_value(DnsCacheLimits{}.ttl.count()), "Seconds the addresses of a host are cached.")
+    ("dnsNegativeTtl", po::value<size_t>()->default_value(DnsCacheLimits{}.negativeTtl.count()), "Seconds a host which could not be resolved is cached, its downloads fail without a resolution meanwhile.")
+    ("circuitBreakerFailures", po::value<size_t>(&result.circuitBreaker.maxConsecutiveFailures)->default_value(0), "Consecutive timeouts, connection or DNS failures after which the downloads of a host pause for circuitBreakerCooldown, then one download probes the host and if it fails too the remaining urls of the host fail without a download. Disabled when 0.")
+    ("circuitBreakerCooldown", po::value<size_t>()->default_value(CircuitBreakerOptions{}.cooldown.count()), "Seconds a host is not downloaded from after the circuit breaker opened or tripped.")
+    ("connectTimeout", po::value<size_t>()->default_value(TimeoutOptions{}.connect.count()), "Milliseconds a transfer waits for its connection.")
+    ("transferTimeout", po::value<size_t>()->default_value(TimeoutOptions{}.transfer.count()), "Milliseconds a transfer may take in total.")
+    ("lowSpeedLimit", po::value<uint32_t>(&result.timeouts.lowSpeedLimit)->default_value(TimeoutOptions{}.lowSpeedLimit), "Bytes per second below which a transfer is aborted as timed out after lowSpeedTime, keep it below maxBytesPerSecond divided by the simultaneous downloads. Disabled when 0.")
+    ("lowSpeedTime", po::value<size_t>()->default_value(TimeoutOptions{}.lowSpeedTime.count()), "Seconds a transfer may stay below lowSpeedLimit.")
+    ("adaptiveTimeouts", po::value<bool>(&result.timeouts.adaptive)->default_value(false), "Shorten the connectTimeout and transferTimeout of each origin to a multiple of the 90th percentile of its previous transfers, thus unusually slow transfers do not hold a download slot for the full timeout.")
+    ("streamMediaTypes", po::value<std::vector<std::string>>()->multitoken(), "Media types downloaded besides text/html, e.g. application/pdf application/rss+xml. Their bodies longer than streamThreshold are written to segment files in streamDirectory instead of memory.")
+    ("streamDirectory", po::value<std::string>(&result.streaming.directory), "Directory of the segment files of the streamMediaTypes, the saved downloads are moved out of it.")
+    ("streamThreshold", po::value<size_t>(&result.streaming.memoryThreshold)->default_value(StreamingOptions{}.memoryThreshold), "Maximum length of a body of the streamMediaTypes kept in memory.")
+    ("maxStreamedLength", po::value<size_t>(&result.streaming.maxStreamedLength)->default_value(StreamingOptions{}.maxStreamedLength), "Maximum allowed length of a download of the streamMediaTypes, replaces maxContentLength.")
     ("help,h", "produce help message")
     ;
   // clang-format on
 
   configureLogging(optionsDescription);
+  configureTracing(optionsDescription);
 
   po::variables_map variablesMap;
   po::store(po::parse_command_line(argc, argv, optionsDescription), variablesMap);
@@ -77,6 +163,80 @@ readCommandLineArgs(const int argc, const char** argv) {
   if(!processLogging(variablesMap)) {
     return DriverOptions{false};
   }
+  processTracing(variablesMap);
+
+  const std::string& replaySpeed = variablesMap["replaySpeed"].as<std::string>();
+  if("recorded" == replaySpeed) {
+    result.replaySpeed = ReplaySpeed::RECORDED;
+  }
+  else if("max" == replaySpeed) {
+    result.replaySpeed = ReplaySpeed::MAXIMUM;
+  }
+  else {
+    throw std::runtime_error("Unknown replaySpeed: " + replaySpeed);
+  }
+
+  const std::string& scope = variablesMap["scope"].as<std::string>();
+  if("host" == scope) {
+    result.outlinks.scope = CrawlScope::SAME_HOST;
+  }
+  else if("domain" == scope) {
+    result.outlinks.scope = CrawlScope::SAME_DOMAIN;
+  }
+  else if("allow" == scope) {
+    result.outlinks.scope = CrawlScope::ALLOW_LIST;
+  }
+  else {
+    throw std::runtime_error("Unknown scope: " + scope);
+  }
+  result.outlinks.maxUrls = result.maxUrls;
+
+  result.dnsCache.ttl         = std::chrono::seconds{variablesMap["dnsCacheTtl"].as<size_t>()};
+  result.dnsCache.negativeTtl = std::chrono::seconds{variablesMap["dnsNegativeTtl"].as<size_t>()};
+
+  result.circuitBreaker.cooldown = std::chrono::seconds{variablesMap["circuitBreakerCooldown"].as<size_t>()};
+
+  result.timeouts.connect      = std::chrono::milliseconds{variablesMap["connectTimeout"].as<size_t>()};
+  result.timeouts.transfer     = std::chrono::milliseconds{variablesMap["transferTimeout"].as<size_t>()};
+  result.timeouts.lowSpeedTime = std::chrono::seconds{variablesMap["lowSpeedTime"].as<size_t>()};
+  result.timeouts.prewarmIdle  = std::chrono::milliseconds{variablesMap["prewarmIdle"].as<size_t>()};
+
+  if(variablesMap.count("streamMediaTypes")) {
+    if(result.streaming.directory.empty()) {
+      throw std::runtime_error("The streamMediaTypes need a streamDirectory");
+    }
+    result.streaming.streamed = mediaTypeMatcher(variablesMap["streamMediaTypes"].as<std::vector<std::string>>());
+  }
+  else if(!result.streaming.directory.empty()) {
+    throw std::runtime_error("The streamDirectory needs streamMediaTypes");
+  }
+
+  const std::string& politeness = variablesMap["politeness"].as<std::string>();
+  if("host" != politeness && "domain" != politeness) {
+    throw std::runtime_error("Unknown politeness: " + politeness);
+  }
+  result.politenessByDomain = "domain" == politeness;
+
+  if(variablesMap.count("hostSlotsFile")) {
+    const std::string& hostSlotsFilename = variablesMap["hostSlotsFile"].as<std::string>();
+    std::ifstream      hostSlotsFile{hostSlotsFilename};
+    if(!hostSlotsFile) {
+      throw std::runtime_error("Failed to open the hostSlotsFile: " + hostSlotsFilename);
+    }
+    readHostSlots(hostSlotsFile, result.hostConcurrency);
+  }
+
+  const std::string& nearDuplicates = variablesMap["nearDuplicates"].as<std::string>();
+  result.filterNearDuplicates       = "off" != nearDuplicates;
+  if("tag" == nearDuplicates) {
+    result.nearDuplicates.action = NearDuplicateAction::TAG;
+  }
+  else if("skip" == nearDuplicates) {
+    result.nearDuplicates.action = NearDuplicateAction::SKIP;
+  }
+  else if(result.filterNearDuplicates) {
+    throw std::runtime_error("Unknown nearDuplicates: " + nearDuplicates);
+  }
 
   if(!variablesMap.count("urlListFile") && !variablesMap.count("url")) {
     throw std::runtime_error("No urlList defined");
@@ -88,33 +248,100 @@ readCommandLineArgs(const int argc, const char** argv) {
   return result;
 }
 
-class CrawlOnce {
+/**
+ * Dispatches the url given on the command line followed by the urls of the urlListFile in batches.
+ * With maxDepth the given urls are the seeds of a recursive crawl, each batch is then one depth.
+ */
+class DriverDispatcher {
 public:
-  bool operator()() {
-    const bool hasCrawled = m_hasCrawled;
-    m_hasCrawled          = true;
-    return !hasCrawled;
+  DriverDispatcher(const DriverOptions& options, std::function<void(DownloadResult&&)> sink)
+      : m_url{options.url}
+      , m_printUrls{options.printUrls}
+      , m_sink{std::move(sink)}
+      , m_fileDispatcher{}
+      , m_outlinkDispatcher{} {
+    if(0 < options.outlinks.maxDepth) {
+      std::vector<std::string> seeds;
+      if(!options.urlsFilename.empty()) {
+        seeds = readUrlsFromFile(options.urlsFilename, options.maxUrls);
+      }
+      if(!m_url.empty()) {
+        seeds.insert(seeds.begin(), m_url);
+        m_url.clear();
+      }
+      m_outlinkDispatcher = std::make_unique<OutlinkDispatcher>(seeds, options.outlinks, m_sink);
+    }
+    else if(!options.urlsFilename.empty()) {
+      m_fileDispatcher = std::make_unique<UrlFileDispatcher>(
+          options.urlsFilename, options.maxUrls, options.batchSize, m_sink, /* firstUrlIndex */ 1);
+    }
+  }
+
+  bool hasUrls() const {
+    if(m_outlinkDispatcher) {
+      return m_outlinkDispatcher->hasUrls();
+    }
+    return !m_url.empty() || (m_fileDispatcher && m_fileDispatcher->hasUrls());
+  }
+
+  /**
+   * @returns the scanners of the links of a recursive crawl, empty otherwise
+   */
+  ContentScannerFactory scannerFactory() const {
+    return m_outlinkDispatcher ? m_outlinkDispatcher->scannerFactory() : ContentScannerFactory{};
+  }
+
+  UrlBatch nextBatch() {
+    UrlBatch result = m_outlinkDispatcher
+                          ? m_outlinkDispatcher->nextBatch()
+                          : m_fileDispatcher && m_fileDispatcher->hasUrls() ? m_fileDispatcher->nextBatch()
+                                                                            : UrlBatch{m_sink};
+    if(!m_url.empty()) {
+      result.add(m_url, /* urlIndex */ 0);
+      m_url.clear();
+    }
+    if(m_printUrls) {
+      for(const UrlHandle& url: result.urls) {
+        std::cout << result.arena.url(url) << '\n';
+      }
+    }
+    return result;
   }
 
 private:
-  bool m_hasCrawled = false;
+  std::string                           m_url;
+  bool                                  m_printUrls;
+  std::function<void(DownloadResult&&)> m_sink;
+  std::unique_ptr<UrlFileDispatcher>    m_fileDispatcher;
+  std::unique_ptr<OutlinkDispatcher>    m_outlinkDispatcher;
 };
 
 std::function<bool(const MediaType&)>
-getMediaTypeValidator() {
-  return [](const MediaType& mediaType) {
-    return boost::iequals(mediaType.type, "text") && boost::iequals(mediaType.subtype, "html");
+getMediaTypeValidator(const StreamingOptions& streaming) {
+  return [streamed = streaming.streamed](const MediaType& mediaType) {
+    return (boost::iequals(mediaType.type, "text") && boost::iequals(mediaType.subtype, "html"))
+           || (streamed && streamed(mediaType));
   };
 }
 
 class WriteDownloadResultToFile {
 public:
-  WriteDownloadResultToFile(int nrDownloads, std::string prefix)
+  WriteDownloadResultToFile(size_t nrDownloads, std::string prefix)
       : m_maxNumberOfDigits{static_cast<int>(log10(nrDownloads)) + 1}, m_prefix{std::move(prefix)}, m_seq{0} {}
-  void operator()(std::shared_ptr<DownloadResult> downloadResult) {
+  void operator()(std::shared_ptr<DownloadResult> downloadResult, const bool nearDuplicate = false) {
     // Process your own downloads sequentially here
     // e.g. write each download result into separate file
-    std::ofstream fout(this->generateFilename(std::get<0>(downloadResult->url)));
+    const std::string filename = this->generateFilename(std::get<0>(downloadResult->url), nearDuplicate);
+    if(!downloadResult->contentFile.empty()) {
+      // the segment file becomes the saved file, it is copied if it is on another file system
+      if(0 != std::rename(downloadResult->contentFile.c_str(), filename.c_str())) {
+        std::ofstream fout(filename, std::ios::binary);
+        fout << std::ifstream{downloadResult->contentFile, std::ios::binary}.rdbuf();
+        std::remove(downloadResult->contentFile.c_str());
+      }
+      return;
+    }
+    std::ofstream fout(filename);
     if(downloadResult->success) {
       fout << downloadResult->content;
     }
@@ -134,9 +361,12 @@ private:
     return result;
   }
 
-  std::string generateFilename(const std::string url) {
+  std::string generateFilename(const std::string url, const bool nearDuplicate) {
     std::ostringstream filenameStream;
     filenameStream << m_prefix;
+    if(nearDuplicate) {
+      filenameStream << "nearDup_";
+    }
     filenameStream << std::setfill('0') << std::setw(m_maxNumberOfDigits);
     filenameStream << m_seq++;
     filenameStream << std::setw(0);
@@ -159,41 +389,68 @@ private:
 
 void
 driverLoadLogic(const DriverOptions& options) {
-  std::vector<std::string> urlList;
-  if(!options.urlsFilename.empty()) {
-    urlList = readUrlsFromFile(options.urlsFilename, options.maxUrls);
-  }
-  if(!options.url.empty()) {
-    urlList.push_back(options.url);
-  }
-  if(options.printUrls) {
-    std::copy(urlList.begin(), urlList.end(), std::ostream_iterator<std::string>(std::cout, "\n"));
-  }
   // Keep the taskSystem dependent object above its definition.
   // The TaskSystem destructor waits for all the tasks to finish,
   // only after that dependent objects can be destroyed.
   TaskSystem                taskSystem{/*nrTrheads*/ 1};
-  WriteDownloadResultToFile resultsProcessor{(int)urlList.size(), options.prefix};
-
-  std::vector<DownloadElem> urlsToDownload;
-  std::transform(urlList.begin(),
-                 urlList.end(),
-                 std::back_inserter(urlsToDownload),
-                 [&taskSystem, &resultsProcessor](const std::string& url) {
-                   return DownloadElem{
-                       {url, /* urlIndex */ 0}, [&taskSystem, &resultsProcessor](DownloadResult&& downloadResult) {
-                         // task system does not support adding move only lambdas, thus the shared ptr
-                         auto dwResultPtr = std::make_shared<DownloadResult>(std::move(downloadResult));
-                         taskSystem.async_([&resultsProcessor, dwResultPtr] { resultsProcessor(dwResultPtr); });
-                       }};
-                 });
-
-  CurlAsioDownloader downloader{options.maxContentLength, getMediaTypeValidator()};
-  Crawler            crawler{CrawlOnce{},
-                  [&]() { return std::move(urlsToDownload); },
-                  &downloader,
+  WriteDownloadResultToFile resultsProcessor{std::max<size_t>(options.maxUrls, 1), options.prefix};
+
+  const auto                save = [&taskSystem, &resultsProcessor](DownloadResult&& downloadResult, bool nearDup) {
+    // task system does not support adding move only lambdas, thus the shared ptr
+    auto dwResultPtr = std::make_shared<DownloadResult>(std::move(downloadResult));
+    taskSystem.async_([&resultsProcessor, dwResultPtr, nearDup] { resultsProcessor(dwResultPtr, nearDup); });
+  };
+  // destroyed before the taskSystem, its destructor waits for the pages being hashed
+  std::unique_ptr<NearDuplicateFilter> nearDuplicateFilter;
+  if(options.filterNearDuplicates) {
+    nearDuplicateFilter = std::make_unique<NearDuplicateFilter>(
+        options.nearDuplicates, [save](DownloadResult&& downloadResult, const NearDuplicateTag& tag) {
+          save(std::move(downloadResult), tag.nearDuplicate);
+        });
+  }
+
+  DriverDispatcher dispatcher{options, [&nearDuplicateFilter, save](DownloadResult&& downloadResult) {
+                                if(nearDuplicateFilter) {
+                                  nearDuplicateFilter->process(std::move(downloadResult));
+                                }
+                                else {
+                                  save(std::move(downloadResult), false);
+                                }
+                              }};
+
+  std::unique_ptr<Downloader> downloader;
+  if(options.replayFilename.empty()) {
+    CurlAsioDownloaderOptions downloaderOptions;
+    downloaderOptions.metricsPort      = options.metricsPort;
+    downloaderOptions.bandwidthLimits  = options.bandwidth;
+    downloaderOptions.dnsCacheLimits   = options.dnsCache;
+    downloaderOptions.timeoutOptions   = options.timeouts;
+    downloaderOptions.streamingOptions = options.streaming;
+    downloaderOptions.scannerFactory   = dispatcher.scannerFactory();
+    downloader                         = std::make_unique<CurlAsioDownloader>(
+        options.maxContentLength, getMediaTypeValidator(options.streaming), std::move(downloaderOptions));
+  }
+  else {
+    downloader = std::make_unique<ReplayDownloader>(options.replayFilename, options.replaySpeed);
+  }
+  std::unique_ptr<RecordingDownloader> recorder;
+  if(!options.recordFilename.empty()) {
+    recorder = std::make_unique<RecordingDownloader>(downloader.get(), options.recordFilename);
+  }
+  Crawler crawler{[&dispatcher]() { return dispatcher.hasUrls(); },
+                  [&dispatcher]() { return dispatcher.nextBatch(); },
+                  recorder ? recorder.get() : downloader.get(),
                   options.parallelDownloads,
                   std::chrono::seconds{2}};
+  if(options.adaptConcurrency) {
+    crawler.adaptConcurrency(options.concurrency);
+  }
+  if(options.politenessByDomain) {
+    crawler.setPolitenessKey([](const std::string_view host) { return std::string{registeredDomain(host)}; });
+  }
+  crawler.setHostConcurrency(options.hostConcurrency);
+  crawler.setPrewarmWindow(std::chrono::milliseconds{options.prewarmWindow});
+  crawler.setCircuitBreaker(options.circuitBreaker);
   crawler.crawl();
 }
 
@@ -0,0 +1,31 @@
+#ifndef UTILS_CONTENTSCANNER_H_T2MJ8QXE
+#define UTILS_CONTENTSCANNER_H_T2MJ8QXE
+
+#include "MediaType.h"
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+/**
+ * Scans the content of a download while it is received, e.g. for its links, thus the scan overlaps with the transfer
+ * instead of following it. Called from the write callback on the thread of the downloader.
+ */
+class ContentScanner {
+public:
+  virtual ~ContentScanner() = default;
+
+  /**
+   * @param content the content received so far, it starts with the content of the previous calls. It may be moved
+   *                between the calls.
+   */
+  virtual void scan(std::string_view content) = 0;
+};
+
+/**
+ * Creates the scanner of a download once its media type is known.
+ * @returns nullptr if the content is not scanned
+ */
+using ContentScannerFactory = std::function<std::unique_ptr<ContentScanner>(const MediaType&)>;
+
+#endif /* end of include guard: UTILS_CONTENTSCANNER_H_T2MJ8QXE */
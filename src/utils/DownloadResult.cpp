@@ -6,6 +6,9 @@ std::ostream&
 operator<<(std::ostream& out, const DownloadResult& page) {
   out << "Url: " << page.url << " mediaType: " << page.mediaType << " success: " << page.success
       << " content: " << page.content;
+  if(!page.contentFile.empty()) {
+    out << " contentFile: " << page.contentFile;
+  }
   if(!page.success) {
     out << page.errorMessage;
   }
@@ -1,18 +1,45 @@
 #ifndef UTILS_DOWNLOADRESULT_H_DELBSWF8
 #define UTILS_DOWNLOADRESULT_H_DELBSWF8
 
+#include "ContentScanner.h"
 #include "MediaType.h"
 #include "Url.h"
 
+#include <cstdint>
 #include <iosfwd>
+#include <memory>
+
+/**
+ * Why a transfer failed, responses with HTTP error codes are successful transfers.
+ */
+enum class TransferError : uint8_t {
+  NONE,
+  TIMEOUT,
+  DNS,
+  CONNECT,
+  TLS,
+  NETWORK,          // the connection failed after it was established
+  CONTENT_REJECTED, // too large content or rejected media type
+  OTHER,
+  CIRCUIT_OPEN // not transferred, the host failed repeatedly, see CircuitBreakerOptions
+};
 
 struct DownloadResult {
-  Url         url;
-  std::string content;
-  MediaType   mediaType;
-  bool        success;
-  std::string errorMessage;
-  double      downloadSpeedByteSec;
+  Url           url;
+  std::string   content;
+  MediaType     mediaType;
+  bool          success;
+  std::string   errorMessage;
+  double        downloadSpeedByteSec;
+  TransferError transferError{TransferError::NONE};
+  bool          multiplexed{false}; // received over HTTP/2 or later, the connection carries simultaneous downloads
+  // releases the content from the memory budget of the downloader when its last copy is destroyed, see MemoryBudget
+  std::shared_ptr<const void> heldMemory{};
+  // the large content of a streamed media type was written to this segment file instead, see StreamingOptions. The
+  // receiver of the result owns the file.
+  std::string contentFile{};
+  // scanned the whole content while it was received, see ContentScannerFactory, nullptr if it was not
+  std::unique_ptr<ContentScanner> scanner{};
 
   DownloadResult()                 = default;
   DownloadResult(DownloadResult&&) = default;
@@ -1,14 +1,88 @@
 #include "Logger.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
 #include <vector>
 
 LOG_INIT(Logger);
 
+namespace {
+
+constexpr size_t RING_CAPACITY      = 1 << 18;
+constexpr size_t MAX_MESSAGE_LENGTH = RING_CAPACITY / 8;
+constexpr auto   DRAIN_INTERVAL     = std::chrono::milliseconds{5};
+
+const std::string_view TRUNCATED_MESSAGE_END{"... [truncated]\n"};
+
+/**
+ * Single producer single consumer ring of formatted log messages.
+ * A message is either copied whole or not at all, thus the ring can be written to the output as it is.
+ * The positions only grow, the position in m_data is the position modulo RING_CAPACITY.
+ */
+class LogRing {
+public:
+  LogRing() : m_data(new char[RING_CAPACITY]), m_head{0}, m_tail{0} {}
+
+  /**
+   * Called only by the thread owning the ring.
+   * @returns false if there is not enough space for the message
+   */
+  bool tryPush(const std::string_view message) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if(RING_CAPACITY - (head - m_tail.load(std::memory_order_acquire)) < message.size()) {
+      return false;
+    }
+    const size_t start     = head % RING_CAPACITY;
+    const size_t firstPart = std::min(message.size(), RING_CAPACITY - start);
+    message.copy(m_data.get() + start, firstPart);
+    message.copy(m_data.get(), message.size() - firstPart, firstPart);
+    m_head.store(head + message.size(), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Called only by the drain thread.
+   * Writes all the queued messages to output.
+   */
+  void drain(std::ostream& output) {
+    const size_t head = m_head.load(std::memory_order_acquire);
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if(head == tail) {
+      return;
+    }
+    const size_t start     = tail % RING_CAPACITY;
+    const size_t firstPart = std::min(head - tail, RING_CAPACITY - start);
+    output.write(m_data.get() + start, firstPart);
+    output.write(m_data.get(), head - tail - firstPart);
+    m_tail.store(head, std::memory_order_release);
+  }
+
+  bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed); }
+
+private:
+  std::unique_ptr<char[]> m_data;
+  std::atomic<size_t>     m_head; // written by the owning thread
+  std::atomic<size_t>     m_tail; // written by the drain thread
+};
+
+} // namespace
+
+/**
+ * Log messages are formatted by the logging thread into a reused buffer and queued into the ring of the thread.
+ * A single background thread writes the rings to the output, thus logging never waits for the output.
+ */
 class Logger {
 public:
   static Logger& getInstance() {
@@ -16,30 +90,76 @@ public:
     return instance;
   }
 
+  ~Logger() {
+    {
+      std::lock_guard<std::mutex> lck(m_stopMutex);
+      m_stop = true;
+    }
+    m_stopCondition.notify_one();
+    if(m_drainThread.joinable()) {
+      m_drainThread.join();
+    }
+    drain();
+  }
+
   size_t add(const std::string& componentName) {
     m_components.push_back(std::make_tuple(componentName, false));
+    m_debugEnabled.emplace_back(false);
     return m_components.size() - 1;
   }
 
-  std::ostream& getInfoStream(const size_t componentIndex) { return getOutputStream(); }
+  bool isDebugEnabled(const size_t componentIndex) const {
+    return m_debugEnabled[componentIndex].load(std::memory_order_relaxed);
+  }
 
-  std::ostream& getErrorStream(const size_t componentIndex) { return getOutputStream(); }
+  void push(const std::string_view message) {
+    std::call_once(m_drainThreadStarted, [this]() { m_drainThread = std::thread([this]() { runDrainThread(); }); });
+    if(!threadRing().tryPush(message)) {
+      m_nrDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
 
-  std::ostream& getDebugStream(const size_t componentIndex) {
-    if(componentIndex < m_components.size() && !std::get<1>(m_components[componentIndex])) {
-      return m_nullSink;
+  void drain() {
+    std::lock_guard<std::mutex> lck(m_outputMutex);
+    std::ostream&               output = getOutputStream();
+    {
+      // the rings are written outside of m_ringsMutex, thus a new logging thread does not wait for the output
+      std::lock_guard<std::mutex> ringsLck(m_ringsMutex);
+      m_drainedRings = m_rings;
+      // the ring of a finished thread is only held by the two vectors, it is removed after its last messages
+      m_rings.erase(std::remove_if(m_rings.begin(),
+                                   m_rings.end(),
+                                   [](const std::shared_ptr<LogRing>& ring) { return 2 == ring.use_count(); }),
+                    m_rings.end());
     }
-    else {
-      return getOutputStream();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    for(const std::shared_ptr<LogRing>& ring: m_drainedRings) {
+      ring->drain(output);
+    }
+    m_drainedRings.clear();
+    const size_t nrDropped = m_nrDropped.load(std::memory_order_relaxed);
+    if(nrDropped != m_nrReportedDropped) {
+      output << "[ERROR] Logger: dropped " << nrDropped - m_nrReportedDropped
+             << " log messages, total dropped: " << nrDropped << '\n';
+      m_nrReportedDropped = nrDropped;
     }
+    output.flush();
   }
 
-  std::mutex& getMutex() { return m_mutex; }
+  size_t getNrDropped() const { return m_nrDropped.load(std::memory_order_relaxed); }
 
   void setOutput(const std::string& filename) {
     LOG_INFO("Setting log output to file: " << filename);
+    // the messages logged so far go to the previous output
+    drain();
+    if(filename.empty()) {
+      std::lock_guard<std::mutex> lck(m_outputMutex);
+      m_fout.close();
+      return;
+    }
     std::ofstream newOutput(filename);
     if(newOutput.is_open() && newOutput.good()) {
+      std::lock_guard<std::mutex> lck(m_outputMutex);
       swap(m_fout, newOutput);
     }
     else {
@@ -49,8 +169,8 @@ public:
 
   void enable(const std::string& componentName, const bool enabled) {
     if(componentName.empty()) {
-      for(auto& component: m_components) {
-        std::get<1>(component) = enabled;
+      for(size_t index = 0; index < m_components.size(); ++index) {
+        setEnabled(index, enabled);
       }
     }
     else {
@@ -61,17 +181,57 @@ public:
       if(componentPos == m_components.end()) {
         throw std::runtime_error("[Logger] the following component does not exist: " + componentName);
       }
-      std::replace(componentPos,
-                   m_components.end(),
-                   std::make_tuple(componentName, !enabled),
-                   std::make_tuple(componentName, enabled));
+      for(; componentPos != m_components.end(); ++componentPos) {
+        if(componentName == std::get<0>(*componentPos)) {
+          setEnabled(componentPos - m_components.begin(), enabled);
+        }
+      }
     }
   }
 
   const std::vector<std::tuple<std::string, bool>>& getLoggedComponents() { return m_components; }
 
 private:
-  Logger() : m_components(), m_fout(), m_nullSink(nullptr) {}
+  Logger()
+      : m_components()
+      , m_debugEnabled()
+      , m_fout()
+      , m_outputMutex()
+      , m_rings()
+      , m_ringsMutex()
+      , m_drainedRings()
+      , m_nrDropped{0}
+      , m_nrReportedDropped{0}
+      , m_drainThreadStarted()
+      , m_drainThread()
+      , m_stop{false}
+      , m_stopMutex()
+      , m_stopCondition() {}
+
+  void setEnabled(const size_t componentIndex, const bool enabled) {
+    std::get<1>(m_components[componentIndex]) = enabled;
+    m_debugEnabled[componentIndex].store(enabled, std::memory_order_relaxed);
+  }
+
+  LogRing& threadRing() {
+    thread_local std::shared_ptr<LogRing> ring;
+    if(!ring) {
+      ring = std::make_shared<LogRing>();
+      std::lock_guard<std::mutex> lck(m_ringsMutex);
+      m_rings.push_back(ring);
+    }
+    return *ring;
+  }
+
+  void runDrainThread() {
+    std::unique_lock<std::mutex> lck(m_stopMutex);
+    while(!m_stop) {
+      lck.unlock();
+      drain();
+      lck.lock();
+      m_stopCondition.wait_for(lck, DRAIN_INTERVAL, [this]() { return m_stop; });
+    }
+  }
 
   std::ostream& getOutputStream() {
     if(m_fout.is_open() && m_fout.good()) {
@@ -83,32 +243,107 @@ private:
   }
 
   std::vector<std::tuple<std::string, bool>> m_components;
+  std::deque<std::atomic<bool>>              m_debugEnabled; // read without locking by the logging threads
   std::ofstream                              m_fout;
-  std::ostream                               m_nullSink;
-  std::mutex                                 m_mutex;
+  std::mutex                                 m_outputMutex;
+  std::vector<std::shared_ptr<LogRing>>      m_rings;
+  std::mutex                                 m_ringsMutex;
+  std::vector<std::shared_ptr<LogRing>>      m_drainedRings; // the rings written by drain, under m_outputMutex
+  std::atomic<size_t>                        m_nrDropped;
+  size_t                                     m_nrReportedDropped;
+  std::once_flag                             m_drainThreadStarted;
+  std::thread                                m_drainThread;
+  bool                                       m_stop;
+  std::mutex                                 m_stopMutex;
+  std::condition_variable                    m_stopCondition;
 };
 
-LoggerComponent::LoggerComponent(const std::string componentName)
-    : m_name(componentName), m_index(Logger::getInstance().add(m_name)) {}
+namespace {
 
-std::ostream&
-LoggerComponent::getInfoStream() {
-  return Logger::getInstance().getInfoStream(m_index);
+/**
+ * Stream buffer appending to a string which keeps its capacity between messages.
+ */
+class MessageStreamBuffer : public std::streambuf {
+public:
+  MessageStreamBuffer() : m_message() {}
+
+  std::string& message() { return m_message; }
+
+protected:
+  int_type overflow(const int_type c) override {
+    if(!traits_type::eq_int_type(c, traits_type::eof())) {
+      m_message.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* const s, const std::streamsize n) override {
+    m_message.append(s, n);
+    return n;
+  }
+
+private:
+  std::string m_message;
+};
+
+} // namespace
+
+struct LogMessage::Buffer {
+  Buffer() : streamBuffer(), output(&streamBuffer), defaultFlags(output.flags()), inUse{false} {}
+
+  MessageStreamBuffer     streamBuffer;
+  std::ostream            output;
+  std::ios_base::fmtflags defaultFlags;
+  bool                    inUse;
+};
+
+namespace {
+
+LogMessage::Buffer&
+threadBuffer() {
+  thread_local LogMessage::Buffer buffer;
+  return buffer;
 }
 
-std::ostream&
-LoggerComponent::getErrorStream() {
-  return Logger::getInstance().getErrorStream(m_index);
+} // namespace
+
+LogMessage::LogMessage() : m_buffer(&threadBuffer()), m_nestedBuffer() {
+  if(m_buffer->inUse) {
+    m_nestedBuffer = std::make_unique<Buffer>();
+    m_buffer       = m_nestedBuffer.get();
+  }
+  m_buffer->inUse = true;
+  m_buffer->streamBuffer.message().clear();
+  // formatting set by the previous message does not apply to this one
+  m_buffer->output.clear();
+  m_buffer->output.flags(m_buffer->defaultFlags);
+  m_buffer->output.precision(6);
+  m_buffer->output.fill(' ');
 }
 
+LogMessage::~LogMessage() { m_buffer->inUse = false; }
+
 std::ostream&
-LoggerComponent::getDebugStream() {
-  return Logger::getInstance().getDebugStream(m_index);
+LogMessage::stream() {
+  return m_buffer->output;
 }
 
-std::mutex&
-LoggerComponent::getMutex() {
-  return Logger::getInstance().getMutex();
+void
+LogMessage::submit() {
+  std::string& message = m_buffer->streamBuffer.message();
+  if(message.size() > MAX_MESSAGE_LENGTH) {
+    message.resize(MAX_MESSAGE_LENGTH - TRUNCATED_MESSAGE_END.size());
+    message.append(TRUNCATED_MESSAGE_END);
+  }
+  Logger::getInstance().push(message);
+}
+
+LoggerComponent::LoggerComponent(const std::string componentName)
+    : m_name(componentName), m_index(Logger::getInstance().add(m_name)) {}
+
+bool
+LoggerComponent::isDebugEnabled() const {
+  return Logger::getInstance().isDebugEnabled(m_index);
 }
 
 void
@@ -126,6 +361,16 @@ getLoggedComponents() {
   return Logger::getInstance().getLoggedComponents();
 }
 
+void
+flushLogging() {
+  Logger::getInstance().drain();
+}
+
+size_t
+getNrDroppedLogMessages() {
+  return Logger::getInstance().getNrDropped();
+}
+
 void
 configureLogging(boost::program_options::options_description& optionsDescription) {
   optionsDescription.add_options()
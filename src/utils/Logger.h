@@ -11,6 +11,7 @@
 
 #include <boost/program_options.hpp>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -20,43 +21,50 @@
 class LoggerComponent {
 public:
   LoggerComponent(const std::string componentName);
-  std::ostream&      getInfoStream();
-  std::ostream&      getErrorStream();
-  std::ostream&      getDebugStream();
   const std::string& getName() const { return m_name; }
-  std::mutex&        getMutex();
+  bool               isDebugEnabled() const;
 
 private:
   std::string m_name;
   size_t      m_index;
 };
 
+/**
+ * Formats one log message.
+ * The formatting is done into a buffer reused by the logging thread, submit() copies the message into the
+ * log ring of the thread. A background thread writes the rings to the log output.
+ * Nothing is blocking, if the ring of the thread is full the message is dropped and counted.
+ */
+class LogMessage {
+public:
+  LogMessage();
+  ~LogMessage();
+  LogMessage(const LogMessage&) = delete;
+  LogMessage& operator=(const LogMessage&) = delete;
+
+  std::ostream& stream();
+  void          submit();
+
+  struct Buffer;
+
+private:
+  Buffer*                 m_buffer;
+  std::unique_ptr<Buffer> m_nestedBuffer; // used when a message is logged while formatting another one
+};
+
 #define LOG_INIT(COMPONENT_NAME) static LoggerComponent componentLogger(#COMPONENT_NAME);
 
-// TODO
-// The temporary ostringstream is required to avoid any deadlocks caused by
-// the evaluation of the mesg inside the componentLogger mutex lock
-// Using stringstream is not efficient and a redesign should be performed
-// Possible solutions:
-// - use the Abseil library to concat strings, switch to a function based
-//   interface and use C++17 if constexpr feature to achieve 0 runtine overhead
-// - switch to a different logging library altogether, something like https://github.com/gabime/spdlog
-//   but try to keep the existing features.
-#define LOG_INFO(mesg)                                                             \
-  {                                                                                \
-    std::ostringstream output;                                                     \
-    output << "[INFO] " << componentLogger.getName() << ": " << mesg << std::endl; \
-    std::lock_guard<std::mutex> lck(componentLogger.getMutex());                   \
-    componentLogger.getInfoStream() << output.str();                               \
+// The message is formatted before it is queued, thus formatting may log itself without deadlocks.
+#define LOG_WITH_LEVEL(level, mesg)                                                             \
+  {                                                                                             \
+    LogMessage logMessage;                                                                      \
+    logMessage.stream() << "[" level "] " << componentLogger.getName() << ": " << mesg << '\n'; \
+    logMessage.submit();                                                                        \
   }
 
-#define LOG_ERROR(mesg)                                                             \
-  {                                                                                 \
-    std::ostringstream output;                                                      \
-    output << "[ERROR] " << componentLogger.getName() << ": " << mesg << std::endl; \
-    std::lock_guard<std::mutex> lck(componentLogger.getMutex());                    \
-    componentLogger.getErrorStream() << output.str();                               \
-  }
+#define LOG_INFO(mesg) LOG_WITH_LEVEL("INFO", mesg)
+
+#define LOG_ERROR(mesg) LOG_WITH_LEVEL("ERROR", mesg)
 
 #ifdef NDEBUG
 #define LOG_DEBUG(mesg)
@@ -73,12 +81,11 @@ private:
 
 #else
 
-#define LOG_DEBUG(mesg)                                                             \
-  {                                                                                 \
-    std::ostringstream output;                                                      \
-    output << "[DEBUG] " << componentLogger.getName() << ": " << mesg << std::endl; \
-    std::lock_guard<std::mutex> lck(componentLogger.getMutex());                    \
-    componentLogger.getDebugStream() << output.str();                               \
+#define LOG_DEBUG(mesg)                    \
+  {                                        \
+    if(componentLogger.isDebugEnabled()) { \
+      LOG_WITH_LEVEL("DEBUG", mesg);       \
+    }                                      \
   }
 
 #define LOG_COND_INFO_DEBUG(cond, mesg) \
@@ -107,9 +114,20 @@ private:
 
 /**
  * Set log output to <filename>
+ * Empty filename sets the log output back to the standard output.
  */
 void setLoggingOutput(const std::string& filename);
 
+/**
+ * Blocks until all the messages logged so far are written to the log output.
+ */
+void flushLogging();
+
+/**
+ * Returns the number of messages dropped because the log ring of the logging thread was full.
+ */
+size_t getNrDroppedLogMessages();
+
 /**
  * Enable/disable debugging for specific component
  * Empty component name means debug all components
@@ -0,0 +1,259 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <variant>
+
+namespace {
+
+std::string
+renderLabels(const MetricLabels& labels) {
+  if(labels.empty()) {
+    return {};
+  }
+  std::string result{"{"};
+  for(const auto& label: labels) {
+    if(result.size() > 1) {
+      result += ',';
+    }
+    result += label.first + "=\"";
+    for(const char c: label.second) {
+      if('"' == c || '\\' == c) {
+        result += '\\';
+      }
+      result += '\n' == c ? 'n' : c;
+    }
+    result += '"';
+  }
+  return result + '}';
+}
+
+std::string
+formatValue(const double value) {
+  std::ostringstream result;
+  result << std::setprecision(15) << value;
+  return result.str();
+}
+
+/**
+ * Adds the label le to the already rendered labels.
+ */
+std::string
+withLe(const std::string& labels, const std::string& le) {
+  const std::string leLabel = "le=\"" + le + "\"";
+  return labels.empty() ? '{' + leLabel + '}' : labels.substr(0, labels.size() - 1) + ',' + leLabel + '}';
+}
+
+/**
+ * All metrics registered under one name, they differ by their labels.
+ * The metrics are kept in deques, thus their addresses never change.
+ */
+template<typename Metric> using LabeledMetrics = std::deque<std::pair<std::string, Metric>>;
+
+struct MetricFamily {
+  using Metrics = std::variant<LabeledMetrics<Counter>, LabeledMetrics<Gauge>, LabeledMetrics<Histogram>>;
+
+  std::string help;
+  double      scale;
+  Metrics     metrics;
+};
+
+class MetricsRegistry {
+public:
+  static MetricsRegistry& getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+  }
+
+  template<typename Metric>
+  Metric& get(const std::string& name, const std::string& help, const double scale, const MetricLabels& labels) {
+    using FamilyMetrics = LabeledMetrics<Metric>;
+    std::lock_guard<std::mutex> lck(m_mutex);
+    auto familyIt = m_families.find(name);
+    if(end(m_families) == familyIt) {
+      familyIt = m_families.emplace(name, MetricFamily{help, scale, FamilyMetrics{}}).first;
+    }
+    auto* metrics = std::get_if<FamilyMetrics>(&familyIt->second.metrics);
+    if(nullptr == metrics) {
+      throw std::logic_error("metric registered with a different type: " + name);
+    }
+    const std::string renderedLabels = renderLabels(labels);
+    const auto        hasLabels      = [&renderedLabels](const auto& metric) { return renderedLabels == metric.first; };
+    auto              metricIt       = std::find_if(metrics->begin(), metrics->end(), hasLabels);
+    if(metrics->end() == metricIt) {
+      metrics->emplace_back(std::piecewise_construct, std::forward_as_tuple(renderedLabels), std::forward_as_tuple());
+      return metrics->back().second;
+    }
+    return metricIt->second;
+  }
+
+  void write(std::ostream& out) {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    for(const auto& family: m_families) {
+      const std::string& name = family.first;
+      out << "# HELP " << name << ' ' << family.second.help << '\n';
+      std::visit([&out, &name, scale = family.second.scale](const auto& metrics) { write(out, name, scale, metrics); },
+                 family.second.metrics);
+    }
+  }
+
+private:
+  MetricsRegistry() : m_mutex{}, m_families{} {}
+
+  static void write(std::ostream& out, const std::string& name, double, const LabeledMetrics<Counter>& counters) {
+    out << "# TYPE " << name << " counter\n";
+    for(const auto& counter: counters) {
+      out << name << counter.first << ' ' << counter.second.value() << '\n';
+    }
+  }
+
+  static void write(std::ostream& out, const std::string& name, double, const LabeledMetrics<Gauge>& gauges) {
+    out << "# TYPE " << name << " gauge\n";
+    for(const auto& gauge: gauges) {
+      out << name << gauge.first << ' ' << gauge.second.value() << '\n';
+    }
+  }
+
+  // only the power of two bucket limits are rendered, the sub buckets are used by Histogram::quantile
+  static void write(std::ostream&                    out,
+                    const std::string&               name,
+                    const double                     scale,
+                    const LabeledMetrics<Histogram>& histograms) {
+    out << "# TYPE " << name << " histogram\n";
+    for(const auto& histogram: histograms) {
+      const std::string& labels = histogram.first;
+      const auto         counts = histogram.second.bucketCounts();
+      uint64_t           count  = 0;
+      size_t             index  = 0;
+      for(unsigned exponent = 0; exponent <= Histogram::MAX_EXPONENT; ++exponent) {
+        const uint64_t limit = (uint64_t{1} << exponent) - 1;
+        for(; index < counts.size() && Histogram::bucketUpperBound(index) <= limit; ++index) {
+          count += counts[index];
+        }
+        out << name << "_bucket" << withLe(labels, formatValue(limit * scale)) << ' ' << count << '\n';
+      }
+      out << name << "_bucket" << withLe(labels, "+Inf") << ' ' << count << '\n';
+      out << name << "_sum" << labels << ' ' << formatValue(histogram.second.sum() * scale) << '\n';
+      out << name << "_count" << labels << ' ' << count << '\n';
+    }
+  }
+
+  std::mutex                          m_mutex;
+  std::map<std::string, MetricFamily> m_families;
+};
+
+} // namespace
+
+size_t
+metricShard() {
+  static std::atomic<size_t> nrThreads{0};
+  thread_local const size_t  shard = nrThreads.fetch_add(1, std::memory_order_relaxed) % NR_METRIC_SHARDS;
+  return shard;
+}
+
+// class Histogram
+void
+Histogram::record(const uint64_t value) {
+  Shard& shard = m_shards[metricShard()];
+  shard.buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  shard.sum.fetch_add(std::min(value, MAX_VALUE), std::memory_order_relaxed);
+}
+
+size_t
+Histogram::bucketIndex(uint64_t value) {
+  value = std::min(value, MAX_VALUE);
+  if(value < (uint64_t{1} << SUB_BUCKET_BITS)) {
+    return value;
+  }
+  const unsigned exponent = 63 - __builtin_clzll(value);
+  const unsigned shift    = exponent - SUB_BUCKET_BITS;
+  return ((exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + ((value >> shift) & ((1 << SUB_BUCKET_BITS) - 1));
+}
+
+uint64_t
+Histogram::bucketUpperBound(const size_t bucketIndex) {
+  if(bucketIndex < (1 << SUB_BUCKET_BITS)) {
+    return bucketIndex;
+  }
+  const size_t   group    = bucketIndex >> SUB_BUCKET_BITS;
+  const uint64_t subIndex = bucketIndex & ((1 << SUB_BUCKET_BITS) - 1);
+  return (((uint64_t{1} << SUB_BUCKET_BITS) + subIndex + 1) << (group - 1)) - 1;
+}
+
+std::array<uint64_t, Histogram::NR_BUCKETS>
+Histogram::bucketCounts() const {
+  std::array<uint64_t, NR_BUCKETS> result{};
+  for(const Shard& shard: m_shards) {
+    for(size_t index = 0; index < NR_BUCKETS; ++index) {
+      result[index] += shard.buckets[index].load(std::memory_order_relaxed);
+    }
+  }
+  return result;
+}
+
+uint64_t
+Histogram::count() const {
+  const auto counts = bucketCounts();
+  uint64_t   result = 0;
+  for(const uint64_t bucketCount: counts) {
+    result += bucketCount;
+  }
+  return result;
+}
+
+uint64_t
+Histogram::sum() const {
+  uint64_t result = 0;
+  for(const Shard& shard: m_shards) {
+    result += shard.sum.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+uint64_t
+Histogram::quantile(const double q) const {
+  const auto counts = bucketCounts();
+  uint64_t   total  = 0;
+  for(const uint64_t bucketCount: counts) {
+    total += bucketCount;
+  }
+  if(0 == total) {
+    return 0;
+  }
+  const auto rank   = static_cast<uint64_t>(std::clamp(q, 0., 1.) * (total - 1));
+  uint64_t   before = 0;
+  for(size_t index = 0; index < NR_BUCKETS; ++index) {
+    before += counts[index];
+    if(before > rank) {
+      return bucketUpperBound(index);
+    }
+  }
+  return MAX_VALUE;
+}
+
+Counter&
+getCounter(const std::string& name, const std::string& help, const MetricLabels& labels) {
+  return MetricsRegistry::getInstance().get<Counter>(name, help, 1., labels);
+}
+
+Gauge&
+getGauge(const std::string& name, const std::string& help, const MetricLabels& labels) {
+  return MetricsRegistry::getInstance().get<Gauge>(name, help, 1., labels);
+}
+
+Histogram&
+getHistogram(const std::string& name, const std::string& help, const double scale, const MetricLabels& labels) {
+  return MetricsRegistry::getInstance().get<Histogram>(name, help, scale, labels);
+}
+
+void
+writeMetrics(std::ostream& out) {
+  MetricsRegistry::getInstance().write(out);
+}
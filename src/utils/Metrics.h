@@ -0,0 +1,133 @@
+#ifndef UTILS_METRICS_H_V2KD7WPX
+#define UTILS_METRICS_H_V2KD7WPX
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Specs:
+// - metrics are registered once, usually into namespace scope references, and updated without locking
+// - counters and histograms are sharded per thread, threads rarely write the same cache line
+// - the registry is rendered in the Prometheus text exposition format
+
+constexpr size_t NR_METRIC_SHARDS = 16;
+
+/**
+ * @returns the shard of the metrics used by the calling thread
+ */
+size_t metricShard();
+
+struct alignas(64) PaddedCounter {
+  std::atomic<uint64_t> value{0};
+};
+
+/**
+ * Monotonically increasing counter.
+ */
+class Counter {
+public:
+  void add(const uint64_t increment = 1) {
+    m_shards[metricShard()].value.fetch_add(increment, std::memory_order_relaxed);
+  }
+
+  uint64_t value() const {
+    uint64_t result = 0;
+    for(const auto& shard: m_shards) {
+      result += shard.value.load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+private:
+  std::array<PaddedCounter, NR_METRIC_SHARDS> m_shards;
+};
+
+/**
+ * Value which can go up and down, e.g. the number of active downloads.
+ */
+class Gauge {
+public:
+  void set(const int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+  void add(const int64_t increment) { m_value.fetch_add(increment, std::memory_order_relaxed); }
+
+  int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * Histogram with logarithmic buckets, each power of two is split into 8 linear sub buckets as in HdrHistogram,
+ * thus the relative error of a recorded value is at most 12.5%. Values are recorded as integers,
+ * e.g. microseconds or bytes, values above MAX_VALUE are recorded as MAX_VALUE.
+ */
+class Histogram {
+public:
+  static constexpr unsigned SUB_BUCKET_BITS = 3;
+  static constexpr unsigned MAX_EXPONENT    = 40;
+  static constexpr uint64_t MAX_VALUE       = (uint64_t{1} << MAX_EXPONENT) - 1;
+  static constexpr size_t   NR_BUCKETS      = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+  void record(uint64_t value);
+
+  /**
+   * Records duration in microseconds, negative durations as 0.
+   */
+  template<typename Rep, typename Period> void recordDuration(const std::chrono::duration<Rep, Period> duration) {
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    record(microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0);
+  }
+
+  uint64_t count() const;
+  uint64_t sum() const;
+
+  /**
+   * @returns the upper bound of the bucket containing the quantile q of the recorded values, 0 if empty
+   */
+  uint64_t quantile(double q) const;
+
+  /**
+   * @returns the number of recorded values of each bucket
+   */
+  std::array<uint64_t, NR_BUCKETS> bucketCounts() const;
+
+  static size_t   bucketIndex(uint64_t value);
+  static uint64_t bucketUpperBound(size_t bucketIndex); // largest value of the bucket
+
+private:
+  struct Shard {
+    std::array<std::atomic<uint64_t>, NR_BUCKETS> buckets{};
+    std::atomic<uint64_t>                         sum{0};
+  };
+
+  std::array<Shard, NR_METRIC_SHARDS> m_shards;
+};
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Registers a counter or returns the one already registered with the same name and labels.
+ * The returned references stay valid until the end of the program.
+ */
+Counter& getCounter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+
+Gauge& getGauge(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+
+/**
+ * @param scale the recorded values are multiplied with scale when rendered, e.g. 1e-6 for microseconds
+ *              recorded in a histogram named *_seconds
+ */
+Histogram&
+getHistogram(const std::string& name, const std::string& help, double scale, const MetricLabels& labels = {});
+
+/**
+ * Writes all registered metrics in the Prometheus text exposition format.
+ */
+void writeMetrics(std::ostream& out);
+
+#endif /* end of include guard: UTILS_METRICS_H_V2KD7WPX */
@@ -0,0 +1,286 @@
+#include "Tracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "Logger.h"
+LOG_INIT(Tracer);
+
+namespace {
+
+// Fuchsia trace format, see https://fuchsia.dev/fuchsia-src/reference/tracing/trace-format
+constexpr uint64_t MAGIC_NUMBER_RECORD = 0x0016547846040010;
+constexpr uint64_t TICKS_PER_SECOND    = 1000000000;
+constexpr uint64_t PROCESS_KOID        = 1;
+constexpr uint64_t FIRST_LANE_KOID     = 2;
+constexpr size_t   MAX_STRING_INDEX    = 0x7fff;
+constexpr size_t   MAX_ARGUMENT_LENGTH = 2048;
+
+enum RecordType : uint64_t { INITIALIZATION_RECORD = 1, STRING_RECORD = 2, EVENT_RECORD = 4, KERNEL_OBJECT_RECORD = 7 };
+
+enum EventType : uint64_t { DURATION_COMPLETE_EVENT = 4 };
+
+enum ArgumentType : uint64_t { STRING_ARGUMENT = 6, KOID_ARGUMENT = 8 };
+
+enum KernelObjectType : uint64_t { PROCESS_OBJECT = 1, THREAD_OBJECT = 2 };
+
+struct Span {
+  std::string_view name;
+  SteadyTime       begin;
+  SteadyTime       end;
+};
+
+inline bool
+isSet(const SteadyTime time) {
+  return SteadyTime{} != time;
+}
+
+inline uint64_t
+nrWords(const size_t nrBytes) {
+  return (nrBytes + 7) / 8;
+}
+
+/**
+ * @returns the earliest of the set times
+ */
+SteadyTime
+earliest(std::initializer_list<SteadyTime> times) {
+  SteadyTime result{};
+  for(const SteadyTime time: times) {
+    if(isSet(time) && (!isSet(result) || time < result)) {
+      result = time;
+    }
+  }
+  return result;
+}
+
+/**
+ * Writes the records of a trace file.
+ * Names are written once to the string table, the urls are written inline.
+ * Spans are put on lanes, shown as threads of the crawler process, such that the spans of a lane never overlap.
+ */
+class TraceWriter {
+public:
+  TraceWriter(const std::string& filename) : m_out{filename, std::ios::binary}, m_start{}, m_strings{}, m_lanes{} {
+    if(!m_out.is_open()) {
+      throw std::runtime_error("Could not open trace file: " + filename);
+    }
+    m_start = std::chrono::steady_clock::now();
+    word(MAGIC_NUMBER_RECORD);
+    word(INITIALIZATION_RECORD | 2 << 4);
+    word(TICKS_PER_SECOND);
+    word(KERNEL_OBJECT_RECORD | 2 << 4 | PROCESS_OBJECT << 16 | uint64_t{stringRef("CheapCrawler")} << 24);
+    word(PROCESS_KOID);
+  }
+
+  /**
+   * The spans are written on the same lane, they must be ordered by begin and the first must contain the others.
+   * @param argument written as the "url" argument of the first span
+   */
+  void write(const std::vector<Span>& spans, const std::string_view argument) {
+    const uint64_t   lane         = laneKoid(spans.front().begin, spans.front().end);
+    const uint64_t   category     = stringRef("crawler");
+    const uint64_t   argumentName = stringRef("url");
+    std::string_view url          = argument.substr(0, MAX_ARGUMENT_LENGTH);
+    for(const Span& span: spans) {
+      const uint64_t argumentWords = url.empty() ? 0 : 1 + nrWords(url.size());
+      const uint64_t name          = stringRef(span.name);
+      word(EVENT_RECORD | (5 + argumentWords) << 4 | DURATION_COMPLETE_EVENT << 16 | (url.empty() ? 0 : 1) << 20
+           | category << 32 | name << 48);
+      word(ticks(span.begin));
+      word(PROCESS_KOID);
+      word(lane);
+      if(!url.empty()) {
+        word(STRING_ARGUMENT | argumentWords << 4 | argumentName << 16 | (0x8000 | uint64_t{url.size()}) << 32);
+        padded(url);
+        url = {};
+      }
+      word(ticks(span.end));
+    }
+  }
+
+private:
+  void word(const uint64_t value) { m_out.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+  void padded(const std::string_view text) {
+    static constexpr char ZEROS[8] = {};
+    m_out.write(text.data(), text.size());
+    m_out.write(ZEROS, nrWords(text.size()) * 8 - text.size());
+  }
+
+  uint64_t ticks(const SteadyTime time) const {
+    return static_cast<uint64_t>(std::max(std::chrono::nanoseconds{0}, time - m_start).count());
+  }
+
+  /**
+   * @returns the index of text in the string table, 0 (the empty string) when the table is full
+   */
+  uint16_t stringRef(const std::string_view text) {
+    auto stringIt = m_strings.find(text);
+    if(end(m_strings) != stringIt) {
+      return stringIt->second;
+    }
+    if(m_strings.size() == MAX_STRING_INDEX) {
+      LOG_ERROR("trace string table full, dropping string: " << text);
+      return 0;
+    }
+    const auto index = static_cast<uint16_t>(m_strings.size() + 1);
+    m_strings.emplace(text, index);
+    word(STRING_RECORD | (1 + nrWords(text.size())) << 4 | uint64_t{index} << 16 | uint64_t{text.size()} << 32);
+    padded(text);
+    return index;
+  }
+
+  uint64_t laneKoid(const SteadyTime begin, const SteadyTime end) {
+    auto laneIt =
+        std::find_if(m_lanes.begin(), m_lanes.end(), [begin](const SteadyTime laneEnd) { return laneEnd <= begin; });
+    if(m_lanes.end() == laneIt) {
+      // the strings are written before the record referencing them
+      const uint64_t koid        = FIRST_LANE_KOID + m_lanes.size();
+      const uint64_t name        = stringRef("transfers " + std::to_string(m_lanes.size()));
+      const uint64_t processName = stringRef("process");
+      word(KERNEL_OBJECT_RECORD | 4 << 4 | THREAD_OBJECT << 16 | name << 24 | uint64_t{1} << 40);
+      word(koid);
+      word(KOID_ARGUMENT | 2 << 4 | processName << 16);
+      word(PROCESS_KOID);
+      laneIt = m_lanes.insert(m_lanes.end(), SteadyTime{});
+    }
+    *laneIt = end;
+    return FIRST_LANE_KOID + (laneIt - m_lanes.begin());
+  }
+
+  std::ofstream                                m_out;
+  SteadyTime                                   m_start;
+  std::map<std::string, uint16_t, std::less<>> m_strings;
+  std::vector<SteadyTime>                      m_lanes; // end of the last span of each lane
+};
+
+class Tracer {
+public:
+  static Tracer& getInstance() {
+    static Tracer instance;
+    return instance;
+  }
+
+  void start(const std::string& filename, const size_t samplingRate) {
+    if(0 == samplingRate) {
+      throw std::logic_error("startTracing received invalid samplingRate: 0");
+    }
+    std::lock_guard<std::mutex> lck(m_mutex);
+    m_writer       = std::make_unique<TraceWriter>(filename);
+    m_samplingRate = samplingRate;
+    m_nrSampled.store(0, std::memory_order_relaxed);
+    m_enabled.store(true, std::memory_order_release);
+    LOG_INFO("Tracing one of every " << samplingRate << " transfers to: " << filename);
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    m_enabled.store(false, std::memory_order_relaxed);
+    m_writer.reset();
+  }
+
+  bool sample() {
+    return m_enabled.load(std::memory_order_acquire)
+           && 0 == m_nrSampled.fetch_add(1, std::memory_order_relaxed) % m_samplingRate;
+  }
+
+  void write(const std::vector<Span>& spans, const std::string_view url) {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    if(m_writer) {
+      m_writer->write(spans, url);
+    }
+  }
+
+private:
+  Tracer() : m_mutex{}, m_writer{}, m_samplingRate{1}, m_enabled{false}, m_nrSampled{0} {}
+
+  std::mutex                   m_mutex;
+  std::unique_ptr<TraceWriter> m_writer;
+  size_t                       m_samplingRate;
+  std::atomic<bool>            m_enabled;
+  std::atomic<size_t>          m_nrSampled;
+};
+
+} // namespace
+
+void
+startTracing(const std::string& filename, const size_t samplingRate) {
+  Tracer::getInstance().start(filename, samplingRate);
+}
+
+void
+stopTracing() {
+  Tracer::getInstance().stop();
+}
+
+bool
+sampleTrace() {
+  return Tracer::getInstance().sample();
+}
+
+void
+traceTransfer(const std::string_view url,
+              const TransferTimes&   times,
+              const CurlTimes&       curlTimes,
+              const SteadyTime       finished,
+              const SteadyTime       callbackDone) {
+  const SteadyTime started = times.started;
+  const auto       at      = [started](const std::chrono::microseconds duration) {
+    return isSet(started) ? started + duration : SteadyTime{};
+  };
+  const std::vector<Span> candidates{
+      {"download", earliest({times.queued, times.scheduled, times.popped, started, finished}), callbackDone},
+      {"queued", times.queued, times.scheduled},
+      {"politeness", times.scheduled, times.ready},
+      {"slotWait", times.ready, times.popped},
+      {"dispatch", times.popped, started},
+      {"dns", started, at(curlTimes.nameLookup)},
+      {"connect", at(curlTimes.nameLookup), at(curlTimes.connect)},
+      {"tls", at(curlTimes.connect), at(curlTimes.appConnect)},
+      {"ttfb", at(std::max(curlTimes.connect, curlTimes.appConnect)), at(curlTimes.startTransfer)},
+      {"body", at(curlTimes.startTransfer), at(curlTimes.total)},
+      {"callback", finished, callbackDone}};
+
+  std::vector<Span> spans;
+  for(const Span& span: candidates) {
+    if(isSet(span.begin) && isSet(span.end) && span.begin < span.end) {
+      spans.push_back(span);
+    }
+  }
+  if(!spans.empty() && "download" == spans.front().name) {
+    Tracer::getInstance().write(spans, url);
+  }
+}
+
+void
+traceSpan(const std::string_view name, const SteadyTime begin, const SteadyTime end) {
+  if(begin < end) {
+    Tracer::getInstance().write({Span{name, begin, end}}, {});
+  }
+}
+
+void
+configureTracing(boost::program_options::options_description& optionsDescription) {
+  // clang-format off
+  optionsDescription.add_options()
+    ("traceOutput", boost::program_options::value<std::string>(), "Write a trace of the transfers to this file, it can be opened with the Perfetto UI")
+    ("traceSampling", boost::program_options::value<size_t>()->default_value(100), "Trace one of every traceSampling transfers")
+    ;
+  // clang-format on
+}
+
+void
+processTracing(const boost::program_options::variables_map& variablesMap) {
+  if(variablesMap.count("traceOutput")) {
+    startTracing(variablesMap["traceOutput"].as<std::string>(), variablesMap["traceSampling"].as<size_t>());
+  }
+}
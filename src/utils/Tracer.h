@@ -0,0 +1,72 @@
+#ifndef UTILS_TRACER_H_R4WN8JQE
+#define UTILS_TRACER_H_R4WN8JQE
+
+#include "Url.h"
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+/**
+ * Phases of a transfer as measured by curl, relative to TransferTimes::started.
+ * Each duration is the end of the phase, see CURLINFO_NAMELOOKUP_TIME_T and the following.
+ */
+struct CurlTimes {
+  std::chrono::microseconds nameLookup;
+  std::chrono::microseconds connect;
+  std::chrono::microseconds appConnect; // zero when no TLS handshake was done
+  std::chrono::microseconds startTransfer;
+  std::chrono::microseconds total;
+};
+
+/**
+ * Starts writing spans to filename in the Fuchsia trace format (FXT), which can be opened with the
+ * Perfetto UI (https://ui.perfetto.dev). Only one of every samplingRate transfers is traced.
+ * Throws std::runtime_error when the file can not be opened.
+ */
+void startTracing(const std::string& filename, size_t samplingRate);
+
+/**
+ * Writes the buffered spans and closes the trace file.
+ */
+void stopTracing();
+
+/**
+ * Called once for each transfer or action which could be traced.
+ * Costs one relaxed atomic load when tracing is disabled.
+ * @returns true if the transfer is sampled and should be traced
+ */
+bool sampleTrace();
+
+/**
+ * Traces a finished transfer, call only if sampleTrace() returned true for it.
+ * Each span of the transfer is written if both its ends are known:
+ * queued, politeness, slotWait, dispatch, dns, connect, tls, ttfb, body and callback.
+ * @param finished when curl reported the transfer as done
+ * @param callbackDone when the callback of the download returned
+ */
+void traceTransfer(std::string_view     url,
+                   const TransferTimes& times,
+                   const CurlTimes&     curlTimes,
+                   SteadyTime           finished,
+                   SteadyTime           callbackDone);
+
+/**
+ * Traces a single span, call only if sampleTrace() returned true for it.
+ */
+void traceSpan(std::string_view name, SteadyTime begin, SteadyTime end);
+
+/**
+ * Configures the program options with the tracing:
+ *  ("traceOutput", boost::program_options::value<std::string>(), "Write a trace of the transfers to this file")
+ *  ("traceSampling", boost::program_options::value<size_t>(), "Trace one of every traceSampling transfers")
+ */
+void configureTracing(boost::program_options::options_description& optionsDescription);
+
+/**
+ * Starts the tracing when it was requested by the above configured options.
+ */
+void processTracing(const boost::program_options::variables_map& variablesMap);
+
+#endif /* end of include guard: UTILS_TRACER_H_R4WN8JQE */
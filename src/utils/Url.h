@@ -1,6 +1,7 @@
 #ifndef CRAWLER_URL_H_X64B8M1L
 #define CRAWLER_URL_H_X64B8M1L
 
+#include <chrono>
 #include <functional>
 #include <ostream>
 #include <string>
@@ -9,15 +10,29 @@
 
 struct DownloadResult;
 
+// the url and the urlIndex identifying it for the caller
 using Url = std::tuple<std::string, int>;
 
+using SteadyTime = std::chrono::steady_clock::time_point;
+
+/**
+ * Timestamps taken while a download travels through the crawler, used for tracing.
+ * Timestamps which are not taken keep the default value.
+ */
+struct TransferTimes {
+  SteadyTime queued;    // the url was added to the download queues
+  SteadyTime scheduled; // the download queue was pushed into the TimeHeap
+  SteadyTime ready;     // the politeness delay of the download queue passed
+  SteadyTime popped;    // popped from the TimeHeap and handed to the Downloader
+  SteadyTime started;   // the transfer was started by the Downloader
+};
+
 struct DownloadElem {
   Url                                   url;
   std::function<void(DownloadResult&&)> callback;
+  TransferTimes                         times{};
 };
 
-using DownloadQueue = std::vector<DownloadElem>;
-
 inline std::ostream&
 operator<<(std::ostream& out, const DownloadElem& dwElem) {
   out << '(' << std::get<0>(dwElem.url) << ',' << std::get<1>(dwElem.url) << ')';
@@ -0,0 +1,97 @@
+#ifndef UTILS_URLARENA_H_Q7ZK2MTA
+#define UTILS_URLARENA_H_Q7ZK2MTA
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Compact reference to an url stored in an UrlArena.
+ */
+struct UrlHandle {
+  uint32_t offset;     // position of the url in the arena
+  uint16_t length;     // length of the url
+  uint16_t pathOffset; // position of the path relative to the start of the url
+  uint32_t hostId;     // assigned by the owner of the arena, e.g. the download queue of the url
+  int32_t  urlIndex;   // identifies the url for the caller, see Url
+};
+
+static_assert(sizeof(UrlHandle) == 16, "UrlHandle is stored for each queued url and should stay small");
+
+/**
+ * Append only storage for the urls of one crawl batch.
+ * The urls are packed into chunks, thus an url costs its length plus the size of its UrlHandle.
+ * The chunks are never moved, views returned by url() stay valid for the lifetime of the arena.
+ * Each chunk starts at a multiple of CHUNK_SIZE in the offset space, the first chunks are allocated smaller
+ * and the size is doubled up to CHUNK_SIZE so that small batches stay small.
+ */
+class UrlArena {
+public:
+  static constexpr size_t CHUNK_SIZE     = 1 << 20;
+  static constexpr size_t MIN_CHUNK_SIZE = 1 << 12;
+  static constexpr size_t MAX_URL_LENGTH = std::numeric_limits<uint16_t>::max();
+  static constexpr size_t MAX_SIZE       = std::numeric_limits<uint32_t>::max();
+
+  UrlArena() : m_chunks{}, m_size{0}, m_lastChunkSize{0}, m_memoryUsage{0} {}
+  UrlArena(UrlArena&&) = default;
+  UrlArena& operator=(UrlArena&&) = default;
+
+  /**
+   * Copies url into the arena.
+   * @param pathOffset position of the path inside url
+   * @returns the handle of the stored url
+   */
+  UrlHandle add(std::string_view url, int urlIndex, uint32_t hostId = 0, size_t pathOffset = 0) {
+    if(url.size() > MAX_URL_LENGTH) {
+      throw std::length_error("UrlArena url too long: " + std::to_string(url.size()));
+    }
+    if(pathOffset > url.size()) {
+      throw std::logic_error("UrlArena invalid pathOffset: " + std::to_string(pathOffset));
+    }
+    // urls never span two chunks
+    const size_t chunkStart = m_chunks.empty() ? 0 : (m_chunks.size() - 1) * CHUNK_SIZE;
+    if(m_chunks.empty() || m_size + url.size() >= chunkStart + m_lastChunkSize) {
+      if(m_chunks.size() * CHUNK_SIZE + CHUNK_SIZE > MAX_SIZE + 1) {
+        throw std::length_error("UrlArena is full");
+      }
+      m_lastChunkSize = std::max(url.size(), std::min(CHUNK_SIZE, std::max(MIN_CHUNK_SIZE, 2 * m_lastChunkSize)));
+      m_size          = m_chunks.size() * CHUNK_SIZE;
+      m_chunks.emplace_back(new char[m_lastChunkSize]);
+      m_memoryUsage += m_lastChunkSize;
+    }
+    const UrlHandle result{static_cast<uint32_t>(m_size),
+                           static_cast<uint16_t>(url.size()),
+                           static_cast<uint16_t>(pathOffset),
+                           hostId,
+                           urlIndex};
+    url.copy(m_chunks.back().get() + m_size % CHUNK_SIZE, url.size());
+    m_size += url.size();
+    return result;
+  }
+
+  std::string_view url(const UrlHandle& handle) const {
+    return {m_chunks[handle.offset / CHUNK_SIZE].get() + handle.offset % CHUNK_SIZE, handle.length};
+  }
+
+  std::string_view path(const UrlHandle& handle) const { return url(handle).substr(handle.pathOffset); }
+
+  /**
+   * @returns the number of bytes allocated for the stored urls
+   */
+  size_t memoryUsage() const { return m_memoryUsage; }
+
+  bool empty() const { return 0 == m_size; }
+
+private:
+  std::vector<std::unique_ptr<char[]>> m_chunks;
+  size_t                               m_size; // end of the last url in the offset space
+  size_t                               m_lastChunkSize;
+  size_t                               m_memoryUsage;
+};
+
+#endif /* end of include guard: UTILS_URLARENA_H_Q7ZK2MTA */
@@ -0,0 +1,15 @@
+#include "UrlBatch.h"
+#include "DownloadResult.h"
+
+UrlBatch::UrlBatch() : arena{}, urls{}, onFinished{[](DownloadResult&&) {}}, downloads{} {}
+
+UrlBatch
+makeUrlBatch(std::vector<DownloadElem>&& downloads) {
+  UrlBatch result;
+  result.urls.reserve(downloads.size());
+  for(size_t index = 0; index < downloads.size(); ++index) {
+    result.add(std::get<0>(downloads[index].url), static_cast<int>(index));
+  }
+  result.downloads = std::move(downloads);
+  return result;
+}
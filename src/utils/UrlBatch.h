@@ -0,0 +1,42 @@
+#ifndef UTILS_URLBATCH_H_W3NC8RXE
+#define UTILS_URLBATCH_H_W3NC8RXE
+
+#include "Url.h"
+#include "UrlArena.h"
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+/**
+ * The urls of one crawl batch together with the single sink receiving the download results of all of them.
+ * A result is matched to its url by the urlIndex given to add(), see Url.
+ * The sink is called asynchronously from the downloader thread, or from the crawling thread for the urls failed without
+ * a download, see CircuitBreakerOptions.
+ */
+struct UrlBatch {
+  // the results are dropped
+  UrlBatch();
+  explicit UrlBatch(std::function<void(DownloadResult&&)> sink)
+      : arena{}, urls{}, onFinished{std::move(sink)}, downloads{} {}
+
+  void add(std::string_view url, int urlIndex) { urls.push_back(arena.add(url, urlIndex)); }
+
+  bool empty() const { return urls.empty(); }
+
+  size_t size() const { return urls.size(); }
+
+  UrlArena                              arena;
+  std::vector<UrlHandle>                urls;
+  std::function<void(DownloadResult&&)> onFinished;
+  // Only set by makeUrlBatch, the urlIndex of the urls is then the position in downloads.
+  std::vector<DownloadElem> downloads;
+};
+
+/**
+ * Adapts downloads with their own callbacks to a batch.
+ * The downloads are kept in the batch, thus this is not a compact representation.
+ */
+UrlBatch makeUrlBatch(std::vector<DownloadElem>&& downloads);
+
+#endif /* end of include guard: UTILS_URLBATCH_H_W3NC8RXE */
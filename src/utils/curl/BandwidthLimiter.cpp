@@ -0,0 +1,191 @@
+#include "Logger.h"
+LOG_INIT(BandwidthLimiter);
+
+#include "BandwidthLimiter.h"
+
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+Gauge&   pausedTransfers = getGauge("crawler_paused_transfers", "Transfers paused by the bandwidth limit.");
+Counter& overBudget      = getCounter("crawler_host_budget_exceeded_total",
+                                 "Downloads aborted or refused because the byte budget of their host was exhausted.");
+Counter& overcommits     = getCounter("crawler_memory_overcommits_total",
+                                  "Transfers continued over the memory budget while no result held content.");
+
+// the default burst is the rate of this fraction of a second
+constexpr uint64_t BURST_DIVISOR = 10;
+
+uint64_t
+burstOf(const BandwidthLimits& limits) {
+  if(0 != limits.burstBytes) {
+    return limits.burstBytes;
+  }
+  // at least one write callback of curl
+  return std::max<uint64_t>(limits.bytesPerSecond / BURST_DIVISOR, CURL_MAX_WRITE_SIZE);
+}
+
+} // namespace
+
+// class TokenBucket
+TokenBucket::TokenBucket(const uint64_t ratePerSecond, const uint64_t burst, const SteadyTime now)
+    : m_ratePerUs{ratePerSecond / 1e6}, m_burst(burst), m_tokens(burst), m_lastRefill{now} {}
+
+bool
+TokenBucket::take(const uint64_t tokens, const SteadyTime now) {
+  refill(now);
+  if(m_tokens <= 0) {
+    return false;
+  }
+  m_tokens -= tokens;
+  return true;
+}
+
+SteadyTime
+TokenBucket::refillTime() const {
+  if(m_tokens > 0) {
+    return m_lastRefill;
+  }
+  // the first token is back at the ceiled time
+  return m_lastRefill + std::chrono::microseconds{static_cast<int64_t>(std::ceil((1. - m_tokens) / m_ratePerUs))};
+}
+
+void
+TokenBucket::refill(const SteadyTime now) {
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastRefill);
+  if(elapsed.count() <= 0) {
+    return;
+  }
+  m_tokens     = std::min(m_burst, m_tokens + elapsed.count() * m_ratePerUs);
+  m_lastRefill = now;
+}
+
+// class BandwidthLimiter
+BandwidthLimiter::BandwidthLimiter(const BandwidthLimits&          limits,
+                                   std::function<void(SteadyTime)> wakeUp,
+                                   std::function<void()>           memoryReleased)
+    : m_limits{limits}
+    , m_wakeUp{std::move(wakeUp)}
+    , m_bucket{limits.bytesPerSecond, burstOf(limits), std::chrono::steady_clock::now()}
+    , m_paused{}
+    , m_resuming{nullptr}
+    , m_hostBytes{}
+    , m_memory{0 == limits.memoryBudgetBytes
+                   ? nullptr
+                   : std::make_shared<MemoryBudget>(limits.memoryBudgetBytes, std::move(memoryReleased))}
+    , m_overcommitting{nullptr} {}
+
+BandwidthLimiter::~BandwidthLimiter() {
+  if(m_memory) {
+    // the results can outlive the limiter
+    m_memory->stopNotifying();
+  }
+}
+
+uint64_t*
+BandwidthLimiter::hostBytes(const std::string_view url) {
+  if(0 == m_limits.hostBudgetBytes) {
+    return nullptr;
+  }
+  return &m_hostBytes[hostOf(url)];
+}
+
+bool
+BandwidthLimiter::admit(const std::string_view url) {
+  const uint64_t* const bytes = hostBytes(url);
+  if(nullptr == bytes || *bytes < m_limits.hostBudgetBytes) {
+    return true;
+  }
+  overBudget.add();
+  return false;
+}
+
+BandwidthGrant
+BandwidthLimiter::acquire(CURL* const easyHandle, uint64_t* const hostBytes, const size_t bytes) {
+  if(nullptr != hostBytes && *hostBytes + bytes > m_limits.hostBudgetBytes) {
+    overBudget.add();
+    *hostBytes = m_limits.hostBudgetBytes;
+    return BandwidthGrant::OVER_BUDGET;
+  }
+  if(m_memory && !admitMemory(easyHandle, bytes)) {
+    m_paused.push_back(easyHandle);
+    pausedTransfers.add(1);
+    return BandwidthGrant::PAUSE;
+  }
+  if(0 != m_limits.bytesPerSecond) {
+    // the paused transfers are served first
+    const bool queued = !m_paused.empty() && easyHandle != m_resuming;
+    if(queued || !m_bucket.take(bytes, std::chrono::steady_clock::now())) {
+      m_paused.push_back(easyHandle);
+      pausedTransfers.add(1);
+      if(1 == m_paused.size()) {
+        m_wakeUp(m_bucket.refillTime());
+      }
+      return BandwidthGrant::PAUSE;
+    }
+  }
+  if(nullptr != hostBytes) {
+    *hostBytes += bytes;
+  }
+  if(m_memory) {
+    m_memory->reserve(bytes);
+  }
+  return BandwidthGrant::ACCEPT;
+}
+
+void
+BandwidthLimiter::forget(CURL* const easyHandle) {
+  const auto pausedIt = std::find(begin(m_paused), end(m_paused), easyHandle);
+  if(end(m_paused) != pausedIt) {
+    m_paused.erase(pausedIt);
+    pausedTransfers.add(-1);
+  }
+  if(easyHandle == m_overcommitting) {
+    m_overcommitting = nullptr;
+  }
+}
+
+void
+BandwidthLimiter::resume() {
+  const SteadyTime now = std::chrono::steady_clock::now();
+  while(!m_paused.empty() && m_bucket.refillTime() <= now && (!m_memory || admitMemory(m_paused.front(), 1))) {
+    CURL* const resumed = m_paused.front();
+    m_resuming          = resumed;
+    m_paused.pop_front();
+    pausedTransfers.add(-1);
+    const CURLcode result = curl_easy_pause(resumed, CURLPAUSE_CONT);
+    if(CURLE_OK != result) {
+      LOG_ERROR("curl_easy_pause failed: " << curl_easy_strerror(result));
+    }
+    m_resuming = nullptr;
+    if(!m_paused.empty() && resumed == m_paused.back()) {
+      // paused again by the data held back
+      break;
+    }
+  }
+  // the transfers waiting for the memory budget are resumed by memoryReleased
+  if(!m_paused.empty() && m_bucket.refillTime() > now) {
+    m_wakeUp(m_bucket.refillTime());
+  }
+}
+
+bool
+BandwidthLimiter::admitMemory(CURL* const easyHandle, const uint64_t bytes) {
+  if(easyHandle == m_overcommitting || m_memory->fits(bytes)) {
+    return true;
+  }
+  if(nullptr == m_overcommitting && 0 == m_memory->resultBytes()) {
+    // nothing is going to be released, the transfers would wait for each other
+    m_overcommitting = easyHandle;
+    overcommits.add();
+    return true;
+  }
+  m_memory->awaitRelease();
+  // a release between the check and the request is not notified
+  return m_memory->fits(bytes);
+}
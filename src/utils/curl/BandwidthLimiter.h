@@ -0,0 +1,139 @@
+#ifndef UTILS_CURL_BANDWIDTHLIMITER_H_R3TNW8ZE
+#define UTILS_CURL_BANDWIDTHLIMITER_H_R3TNW8ZE
+
+#include "Url.h"
+#include "curl/curl.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class MemoryBudget;
+
+/**
+ * Limits of the bytes received by all the transfers of a downloader, 0 disables a limit.
+ */
+struct BandwidthLimits {
+  uint64_t bytesPerSecond{0};    // aggregate receive rate of all the transfers
+  uint64_t burstBytes{0};        // received at once after an idle time, 0 for a tenth of bytesPerSecond
+  uint64_t hostBudgetBytes{0};   // received from each host during the lifetime of the downloader
+  uint64_t memoryBudgetBytes{0}; // content held by the transfers and by their results not destroyed yet
+};
+
+/**
+ * Token bucket filled with ratePerSecond tokens per second up to burst tokens, it starts full.
+ */
+class TokenBucket {
+public:
+  TokenBucket(uint64_t ratePerSecond, uint64_t burst, SteadyTime now);
+
+  /**
+   * Takes the tokens if the bucket is not empty. The bucket can go below zero, thus a take larger than burst passes
+   * and the following takes wait until the debt is refilled.
+   * @returns false if the bucket is empty
+   */
+  bool take(uint64_t tokens, SteadyTime now);
+
+  /**
+   * @returns the time when the bucket is not empty any more
+   */
+  SteadyTime refillTime() const;
+
+private:
+  void refill(SteadyTime now);
+
+  double     m_ratePerUs;
+  double     m_burst;
+  double     m_tokens;
+  SteadyTime m_lastRefill;
+};
+
+enum class BandwidthGrant {
+  ACCEPT,     // the bytes can be consumed
+  PAUSE,      // the transfer was paused, it is resumed by BandwidthLimiter::resume()
+  OVER_BUDGET // the byte budget of the host is exhausted, the transfer should be aborted
+};
+
+/**
+ * Applies BandwidthLimits in the write callbacks of the transfers of a curl multi handle.
+ * A transfer over the rate is paused with CURL_WRITEFUNC_PAUSE and queued, the queued transfers are resumed in order
+ * as soon as the bucket refills. Transfers are only paused when the bucket is empty, below the rate they run at full
+ * speed. All the methods must be called from the thread driving the multi handle.
+ * With a memory budget, a transfer is also paused while the content held in memory would exceed the budget. It is
+ * resumed once the results holding content are destroyed. While the results hold no content, one transfer goes over
+ * the budget, thus the transfers holding the whole budget can still finish.
+ */
+class BandwidthLimiter {
+public:
+  /**
+   * @param wakeUp called with the time resume() should be called at, when a transfer is paused in an empty queue
+   *               and when resume() leaves transfers paused
+   * @param memoryReleased called from any thread when content is released while transfers wait for the memory budget,
+   *                       resume() must then be called from the thread driving the multi handle
+   */
+  BandwidthLimiter(const BandwidthLimits&          limits,
+                   std::function<void(SteadyTime)> wakeUp,
+                   std::function<void()>           memoryReleased = {});
+
+  BandwidthLimiter(const BandwidthLimiter&) = delete;
+  BandwidthLimiter& operator=(const BandwidthLimiter&) = delete;
+
+  ~BandwidthLimiter();
+
+  /**
+   * @returns the counter of the bytes received from the host of url, valid during the lifetime of the limiter, nullptr
+   *          without host budgets
+   */
+  uint64_t* hostBytes(std::string_view url);
+
+  /**
+   * @returns false if the byte budget of the host of url is exhausted, the download should not be started
+   */
+  bool admit(std::string_view url);
+
+  /**
+   * @returns the budget of the content held in memory, nullptr without a memory budget
+   */
+  MemoryBudget* memoryBudget() { return m_memory.get(); }
+
+  /**
+   * Called from the write callback of easyHandle for bytes received from the host of hostBytes. The accepted bytes
+   * are reserved in the memory budget.
+   */
+  BandwidthGrant acquire(CURL* easyHandle, uint64_t* hostBytes, size_t bytes);
+
+  /**
+   * Removes a finished transfer from the paused ones.
+   */
+  void forget(CURL* easyHandle);
+
+  /**
+   * Unpauses the queued transfers while the bucket has tokens and the memory budget is not exhausted. The data held
+   * back by curl is written during the unpause, thus each resumed transfer takes its tokens before the next one is
+   * unpaused.
+   */
+  void resume();
+
+  size_t nrPaused() const { return m_paused.size(); }
+
+private:
+  /**
+   * @returns true if bytes of easyHandle fit into the memory budget, else a release is awaited
+   */
+  bool admitMemory(CURL* easyHandle, uint64_t bytes);
+
+  BandwidthLimits                           m_limits;
+  std::function<void(SteadyTime)>           m_wakeUp;
+  TokenBucket                               m_bucket;
+  std::deque<CURL*>                         m_paused;
+  CURL*                                     m_resuming; // the transfer unpaused by resume()
+  std::unordered_map<std::string, uint64_t> m_hostBytes;
+  std::shared_ptr<MemoryBudget>             m_memory;         // shared with the results holding content
+  CURL*                                     m_overcommitting; // the transfer over the memory budget
+};
+
+#endif /* end of include guard: UTILS_CURL_BANDWIDTHLIMITER_H_R3TNW8ZE */
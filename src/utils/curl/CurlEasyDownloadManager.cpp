@@ -9,23 +9,22 @@ LOG_INIT(CurlEasyDownloadManager);
 #include <stdexcept>
 
 namespace {
-// timeout for entire download
-const long CONNECTION_TIMEOUT = 60;
-
-// timeout for establishing a  connection
-const long CONNECTION_CONNECTTIMEOUT = 15; // seconds, default is 300 seconds
+// the deadlines without TransferOptions::timeouts, curl waits 300 seconds for a connection by default
+const TimeoutOptions DEFAULT_TIMEOUTS{};
 } // namespace
 
 CurlEasyDownloadManager::CurlEasyDownloadManager(char*                  url,
                                                  void*                  userdata,
                                                  HeaderCbType           headerCb,
                                                  HeaderCbType           writeCb,
-                                                 OpenCloseSocketConfig* openCloseSocketConfig)
+                                                 OpenCloseSocketConfig* openCloseSocketConfig,
+                                                 const TransferOptions* transferOptions,
+                                                 curl_slist* const      resolve)
     : m_errorMessage{}, m_easyHandle{curl_easy_init()} {
   if(nullptr == m_easyHandle.get()) {
     throw std::runtime_error("CurlEasyDownloadManager: curl_easy_init return nullptr");
   }
-  setGeneralOptions(openCloseSocketConfig);
+  setGeneralOptions(openCloseSocketConfig, transferOptions, resolve);
   setUrlSpecific(url, userdata, headerCb, writeCb);
 }
 
@@ -36,15 +35,30 @@ CurlEasyDownloadManager::reuse(char* url, void* userdata, HeaderCbType headerCb,
 }
 
 void
-CurlEasyDownloadManager::setGeneralOptions(OpenCloseSocketConfig* openCloseSocketConfig) {
+CurlEasyDownloadManager::setGeneralOptions(OpenCloseSocketConfig* openCloseSocketConfig,
+                                           const TransferOptions* transferOptions,
+                                           curl_slist* const      resolve) {
   CURL* const easyHandle = get();
   std::string errMsg     = "CurlEasyDownloadManager::setGeneralOptions() curl_easy_setopt ";
   throwOnError(curl_easy_setopt(easyHandle, CURLOPT_ERRORBUFFER, m_errorMessage), errMsg + "CURLOPT_ERRORBUFFER");
   throwOnError(curl_easy_setopt(easyHandle, CURLOPT_VERBOSE, 0L), errMsg + "CURLOPT_VERBOSE");
   throwOnError(curl_easy_setopt(easyHandle, CURLOPT_NOPROGRESS, 1L), errMsg + "CURLOPT_NOPROGRESS");
-  throwOnError(curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT, CONNECTION_CONNECTTIMEOUT),
-               errMsg + "CURLOPT_CONNECTTIMEOUT");
-  throwOnError(curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT, CONNECTION_TIMEOUT), errMsg + "CURLOPT_TIMEOUT");
+  const TimeoutOptions& timeouts = nullptr != transferOptions && nullptr != transferOptions->timeouts
+                                      ? transferOptions->timeouts->options()
+                                      : DEFAULT_TIMEOUTS;
+  setDeadlines(TransferDeadlines{timeouts.connect, timeouts.transfer});
+  // a transfer slower than the limit during the time fails with CURLE_OPERATION_TIMEDOUT
+  if(0 != timeouts.lowSpeedLimit) {
+    throwOnError(curl_easy_setopt(easyHandle, CURLOPT_LOW_SPEED_LIMIT, static_cast<long>(timeouts.lowSpeedLimit)),
+                 errMsg + "CURLOPT_LOW_SPEED_LIMIT");
+    throwOnError(curl_easy_setopt(easyHandle, CURLOPT_LOW_SPEED_TIME, static_cast<long>(timeouts.lowSpeedTime.count())),
+                 errMsg + "CURLOPT_LOW_SPEED_TIME");
+  }
+  // HTTP/2 over TLS when the server offers it with ALPN, the downloads of a host share one multiplexed connection
+  throwOnError(curl_easy_setopt(easyHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS),
+               errMsg + "CURLOPT_HTTP_VERSION");
+  // wait for a connection being established to the same origin instead of opening another one
+  throwOnError(curl_easy_setopt(easyHandle, CURLOPT_PIPEWAIT, 1L), errMsg + "CURLOPT_PIPEWAIT");
   if(nullptr != openCloseSocketConfig) {
     throwOnError(curl_easy_setopt(easyHandle, CURLOPT_OPENSOCKETFUNCTION, openCloseSocketConfig->openSocketCb),
                  errMsg + "CURLOPT_OPENSOCKETFUNCTION");
@@ -54,10 +68,30 @@ CurlEasyDownloadManager::setGeneralOptions(OpenCloseSocketConfig* openCloseSocke
                  errMsg + "CURLOPT_CLOSESOCKETFUNCTION");
     throwOnError(curl_easy_setopt(easyHandle, CURLOPT_CLOSESOCKETDATA, openCloseSocketConfig->closeSocketData),
                  errMsg + "CURLOPT_CLOSESOCKETDATA");
+    if(nullptr != openCloseSocketConfig->sockoptCb) {
+      throwOnError(curl_easy_setopt(easyHandle, CURLOPT_SOCKOPTFUNCTION, openCloseSocketConfig->sockoptCb),
+                   errMsg + "CURLOPT_SOCKOPTFUNCTION");
+      throwOnError(curl_easy_setopt(easyHandle, CURLOPT_SOCKOPTDATA, openCloseSocketConfig->sockoptData),
+                   errMsg + "CURLOPT_SOCKOPTDATA");
+    }
+  }
+  if(nullptr != transferOptions && nullptr != transferOptions->connectTo) {
+    throwOnError(curl_easy_setopt(easyHandle, CURLOPT_CONNECT_TO, transferOptions->connectTo),
+                 errMsg + "CURLOPT_CONNECT_TO");
+  }
+  if(nullptr != resolve) {
+    throwOnError(curl_easy_setopt(easyHandle, CURLOPT_RESOLVE, resolve), errMsg + "CURLOPT_RESOLVE");
   }
-  // For future consideration:
-  // curl_easy_setopt(conn->easy, CURLOPT_LOW_SPEED_TIME, 3L);
-  // curl_easy_setopt(conn->easy, CURLOPT_LOW_SPEED_LIMIT, 10L);
+}
+
+void
+CurlEasyDownloadManager::setDeadlines(const TransferDeadlines& deadlines) {
+  CURL* const easyHandle = get();
+  std::string errMsg     = "CurlEasyDownloadManager::setDeadlines() curl_easy_setopt ";
+  throwOnError(curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(deadlines.connect.count())),
+               errMsg + "CURLOPT_CONNECTTIMEOUT_MS");
+  throwOnError(curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(deadlines.transfer.count())),
+               errMsg + "CURLOPT_TIMEOUT_MS");
 }
 
 void
@@ -3,6 +3,7 @@
 
 #include <memory>
 
+#include "TransferTimeouts.h"
 #include "curlTypes.h"
 
 namespace std {
@@ -20,24 +21,32 @@ class CurlEasyDownloadManager {
 public:
   /**
    * @param url memory must be accessable while downloading
+   * @param resolve CURLOPT_RESOLVE entries of the transfer, must be accessable while downloading
    */
   CurlEasyDownloadManager(char*                  url,
                           void*                  userdata,
                           HeaderCbType           headerCb,
                           HeaderCbType           writeCb,
-                          OpenCloseSocketConfig* openCloseSocketConfig);
+                          OpenCloseSocketConfig* openCloseSocketConfig,
+                          const TransferOptions* transferOptions = nullptr,
+                          curl_slist*            resolve         = nullptr);
 
   /**
    * @param url memory must be accessable while downloading
    */
   void reuse(char* url, void* userdata, HeaderCbType headerCb, HeaderCbType writeCb);
 
+  /**
+   * Replaces the deadlines of the TransferOptions for the next transfer.
+   */
+  void setDeadlines(const TransferDeadlines& deadlines);
+
   CURL* get() { return m_easyHandle.get(); }
 
   const char* getErrorMessage() const { return m_errorMessage; }
 
 private:
-  void setGeneralOptions(OpenCloseSocketConfig*);
+  void setGeneralOptions(OpenCloseSocketConfig*, const TransferOptions*, curl_slist* resolve);
   void setUrlSpecific(char* url, void* userdata, HeaderCbType headerCb, HeaderCbType writeCb);
 
 private:
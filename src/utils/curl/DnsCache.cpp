@@ -0,0 +1,71 @@
+#include "DnsCache.h"
+
+#include "Metrics.h"
+
+namespace {
+
+Gauge& cachedHosts = getGauge("crawler_dns_cache_entries", "Host names in the DNS cache, including the failed ones.");
+
+} // namespace
+
+DnsCache::DnsCache(const DnsCacheLimits& limits) : m_limits{limits}, m_entries{}, m_index{} {}
+
+const DnsAnswer*
+DnsCache::find(const std::string_view host, const SteadyTime now) {
+  const auto indexIt = m_index.find(host);
+  if(end(m_index) == indexIt) {
+    return nullptr;
+  }
+  const auto entryIt = indexIt->second;
+  if(entryIt->second.expires <= now) {
+    m_index.erase(indexIt);
+    m_entries.erase(entryIt);
+    cachedHosts.add(-1);
+    return nullptr;
+  }
+  m_entries.splice(begin(m_entries), m_entries, entryIt);
+  return &entryIt->second;
+}
+
+const DnsAnswer&
+DnsCache::insert(const std::string_view host, std::vector<std::string>&& addresses, const SteadyTime now) {
+  const SteadyTime expires = now + (addresses.empty() ? m_limits.negativeTtl : m_limits.ttl);
+  const auto       indexIt = m_index.find(host);
+  if(end(m_index) != indexIt) {
+    const auto entryIt = indexIt->second;
+    entryIt->second    = DnsAnswer{std::move(addresses), expires};
+    m_entries.splice(begin(m_entries), m_entries, entryIt);
+    return entryIt->second;
+  }
+  if(m_entries.size() >= m_limits.maxEntries && !m_entries.empty()) {
+    m_index.erase(m_entries.back().first);
+    m_entries.pop_back();
+    cachedHosts.add(-1);
+  }
+  m_entries.emplace_front(std::string{host}, DnsAnswer{std::move(addresses), expires});
+  m_index.emplace(m_entries.front().first, begin(m_entries));
+  cachedHosts.add(1);
+  return m_entries.front().second;
+}
+
+std::vector<std::string>
+curlResolveEntries(const std::string_view host, const std::string_view port, const DnsAnswer& answer) {
+  std::string removal{"-"};
+  removal.append(host).append(1, ':').append(port);
+  std::string result{removal, 1};
+  result.append(1, ':');
+  for(size_t index = 0; index < answer.addresses.size(); ++index) {
+    const std::string& address = answer.addresses[index];
+    if(0 != index) {
+      result += ',';
+    }
+    // curl expects IPv6 addresses in brackets
+    if(std::string::npos != address.find(':')) {
+      result.append(1, '[').append(address).append(1, ']');
+    }
+    else {
+      result += address;
+    }
+  }
+  return {std::move(removal), std::move(result)};
+}
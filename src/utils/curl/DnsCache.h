@@ -0,0 +1,63 @@
+#ifndef UTILS_CURL_DNSCACHE_H_W5KQ2HVA
+#define UTILS_CURL_DNSCACHE_H_W5KQ2HVA
+
+#include "Url.h"
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Limits of the DnsCache. getaddrinfo does not return the TTL of the records, thus the answers are kept for ttl,
+ * below the TTL of most records, and negativeTtl for the failed resolutions.
+ */
+struct DnsCacheLimits {
+  size_t               maxEntries{100'000};
+  std::chrono::seconds ttl{300};
+  std::chrono::seconds negativeTtl{30};
+};
+
+struct DnsAnswer {
+  std::vector<std::string> addresses; // numeric IPv4 and IPv6 addresses, empty if the host could not be resolved
+  SteadyTime               expires;
+};
+
+/**
+ * The answers of the resolutions by host name, the least recently used answer is evicted when the cache is full.
+ */
+class DnsCache {
+public:
+  explicit DnsCache(const DnsCacheLimits& limits);
+
+  /**
+   * @returns the answer for host, nullptr if none is cached or it expired before now, valid until the next insert
+   */
+  const DnsAnswer* find(std::string_view host, SteadyTime now);
+
+  /**
+   * Caches the answer for host, empty addresses cache a failed resolution.
+   * @returns the cached answer, valid until the next insert
+   */
+  const DnsAnswer& insert(std::string_view host, std::vector<std::string>&& addresses, SteadyTime now);
+
+  size_t size() const { return m_entries.size(); }
+
+private:
+  using Entry = std::pair<std::string, DnsAnswer>;
+
+  DnsCacheLimits                                                   m_limits;
+  std::list<Entry>                                                 m_entries; // the most recently used first
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;   // the keys point into m_entries
+};
+
+/**
+ * The entries added by CURLOPT_RESOLVE stay in the DNS cache of the multi handle and curl keeps an address it cached
+ * already, thus "-host:port" removes the address of an earlier transfer before "host:port:address,..." adds answer.
+ * @returns the CURLOPT_RESOLVE entries of answer
+ */
+std::vector<std::string> curlResolveEntries(std::string_view host, std::string_view port, const DnsAnswer& answer);
+
+#endif /* end of include guard: UTILS_CURL_DNSCACHE_H_W5KQ2HVA */
@@ -1,35 +1,155 @@
 #include "DownloadManager.h"
 
+#include "BandwidthLimiter.h"
+#include "ContentScanner.h"
 #include "CurlEasyDownloadManager.h"
 #include "CurlEasyMultiManager.h"
 #include "DownloadResult.h"
 #include "HeaderHandler.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "SegmentFiles.h"
+#include "Tracer.h"
+#include "TransferTimeouts.h"
 #include "throwOnError.h"
 
+#include <chrono>
 #include <fstream>
 #include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
 #include "Logger.h"
 LOG_INIT(DownloadManager);
 
+namespace {
+
+Counter&   downloadedBytes  = getCounter("crawler_downloaded_bytes_total", "Bytes of content received.");
+Histogram& transferDuration = getHistogram("crawler_transfer_duration_seconds", "Total time of the transfers.", 1e-6);
+Histogram& timeToFirstByte  = getHistogram("crawler_time_to_first_byte_seconds", "Time until the first byte.", 1e-6);
+Histogram& connectTime      = getHistogram("crawler_connect_seconds",
+                                      "Time to connect after the name lookup, 0 on reused and prewarmed connections.",
+                                      1e-6);
+Histogram& responseSize     = getHistogram("crawler_response_size_bytes", "Content length of the transfers.", 1.);
+Counter&   multiplexedTransfers
+    = getCounter("crawler_multiplexed_transfers_total", "Transfers over HTTP/2 or later connections.");
+
+Counter&
+transferResultCounter(const char* const result) {
+  return getCounter("crawler_transfers_total", "Finished transfers by result.", {{"result", result}});
+}
+
+TransferError
+classifyTransferResult(const CURLcode result) {
+  switch(result) {
+    // clang-format off
+    case CURLE_OK:                       return TransferError::NONE;
+    case CURLE_OPERATION_TIMEDOUT:       return TransferError::TIMEOUT;
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_RESOLVE_PROXY:    return TransferError::DNS;
+    case CURLE_COULDNT_CONNECT:          return TransferError::CONNECT;
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_PEER_FAILED_VERIFICATION:
+    case CURLE_SSL_CERTPROBLEM:
+    case CURLE_SSL_CIPHER:               return TransferError::TLS;
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:              return TransferError::NETWORK;
+    // too large content or rejected media type
+    case CURLE_WRITE_ERROR:              return TransferError::CONTENT_REJECTED;
+    default:                             return TransferError::OTHER;
+      // clang-format on
+  }
+}
+
+/**
+ * Counts the transfers by error class.
+ */
+void
+countTransferResult(const TransferError error) {
+  // in the order of TransferError, a transfer never results in CIRCUIT_OPEN
+  static Counter* const counters[] = {&transferResultCounter("ok"),
+                                      &transferResultCounter("timeout"),
+                                      &transferResultCounter("dns"),
+                                      &transferResultCounter("connect"),
+                                      &transferResultCounter("tls"),
+                                      &transferResultCounter("network"),
+                                      &transferResultCounter("content_rejected"),
+                                      &transferResultCounter("other")};
+  counters[static_cast<size_t>(error)]->add();
+}
+
+Counter&
+httpResponseCounter(const char* const code) {
+  return getCounter("crawler_http_responses_total", "Received HTTP responses by status class.", {{"code", code}});
+}
+
+void
+countHttpResponse(const long responseCode) {
+  static Counter* const classes[] = {&httpResponseCounter("1xx"),
+                                     &httpResponseCounter("2xx"),
+                                     &httpResponseCounter("3xx"),
+                                     &httpResponseCounter("4xx"),
+                                     &httpResponseCounter("5xx")};
+  if(responseCode >= 100 && responseCode < 600) {
+    classes[responseCode / 100 - 1]->add();
+  }
+}
+
+CurlSlist
+makeResolveList(const std::vector<std::string>& resolve) {
+  curl_slist* list = nullptr;
+  for(const std::string& entry : resolve) {
+    curl_slist* const appended = curl_slist_append(list, entry.c_str());
+    if(nullptr == appended) {
+      curl_slist_free_all(list);
+      throw std::runtime_error("curl_slist_append failed for: " + entry);
+    }
+    list = appended;
+  }
+  return CurlSlist{list};
+}
+
+} // namespace
+
 class DownloadManager::Pimpl {
 public:
   Pimpl(CURLM* const                                 multiHandle,
         DownloadElem&&                               download,
         const size_t                                 maxContentLength,
         const std::function<bool(const MediaType&)>& mediaTypeValidator,
-        OpenCloseSocketConfig*                       openCloseSocketConfig)
+        OpenCloseSocketConfig*                       openCloseSocketConfig,
+        const TransferOptions*                       transferOptions,
+        const std::vector<std::string>&              resolve)
       : m_download{std::move(download)}
       , m_maxContentLength{maxContentLength}
       , m_content{}
+      , m_resolve{makeResolveList(resolve)}
       , m_easyDownloadManager(const_cast<char*>(std::get<0>(m_download.url).c_str()),
                               /* callback data ptr */ this,
                               /* callback header func */ &headerCb,
                               /* callback write function */ &writeCb,
-                              openCloseSocketConfig)
+                              openCloseSocketConfig,
+                              transferOptions,
+                              m_resolve.get())
       , m_easyMultiManager(multiHandle, m_easyDownloadManager.get())
       , m_errorStream{}
-      , m_headerHandler{mediaTypeValidator, &m_errorStream} {}
+      , m_headerHandler{mediaTypeValidator, &m_errorStream}
+      , m_limiter{nullptr == transferOptions ? nullptr : transferOptions->bandwidthLimiter}
+      , m_hostBytes{nullptr == m_limiter ? nullptr : m_limiter->hostBytes(std::get<0>(m_download.url))}
+      , m_timeouts{nullptr == transferOptions ? nullptr : transferOptions->timeouts}
+      , m_memory{nullptr == m_limiter ? nullptr : m_limiter->memoryBudget()}
+      , m_segmentFiles{nullptr == transferOptions ? nullptr : transferOptions->segmentFiles}
+      , m_segment{nullptr == m_segmentFiles ? 0 : m_segmentFiles->options().writeBytes}
+      , m_streamed{false}
+      , m_scannerFactory{nullptr == transferOptions ? nullptr : &transferOptions->scannerFactory}
+      , m_scanner{} {
+    m_download.times.started = std::chrono::steady_clock::now();
+    setAdaptiveDeadlines();
+  }
+
+  ~Pimpl() { releaseContent(); }
 
   Pimpl(const Pimpl&) = delete;
   Pimpl& operator=(const Pimpl&) = delete;
@@ -39,6 +159,25 @@ public:
   void reuse(DownloadElem&&);
 
   std::function<void()> finish(const CURLcode infoResult) {
+    if(nullptr != m_limiter) {
+      m_limiter->forget(m_easyDownloadManager.get());
+    }
+    const uint64_t                  contentLength = receivedBytes();
+    std::string                     contentFile;
+    bool                            segmentFailed = false;
+    std::unique_ptr<ContentScanner> scanner       = CURLE_OK == infoResult ? std::move(m_scanner) : nullptr;
+    m_scanner.reset();
+    if(m_segment.isOpen()) {
+      const size_t buffered = m_segment.buffered();
+      if(CURLE_OK == infoResult && m_segment.finish()) {
+        contentFile = m_segment.path();
+      }
+      else {
+        segmentFailed = CURLE_OK == infoResult;
+        m_segment.discard();
+      }
+      releaseMemory(buffered);
+    }
     m_errorStream << "ERROR: " << std::endl;
     if(strlen(m_easyDownloadManager.getErrorMessage())) {
       m_errorStream << m_easyDownloadManager.getErrorMessage() << std::endl;
@@ -47,18 +186,61 @@ public:
     if(CURLE_OK != infoResult) {
       m_errorStream << "Curl ERROR: " << curl_easy_strerror(infoResult) << std::endl;
     }
+    if(segmentFailed) {
+      m_errorStream << m_segment.error() << std::endl;
+    }
 
     double downloadSpeedByteSec = 0.;
     if(CURLE_OK != curl_easy_getinfo(m_easyDownloadManager.get(), CURLINFO_SPEED_DOWNLOAD, &downloadSpeedByteSec)) {
       LOG_ERROR("Can't read download speed.");
     }
 
+    long responseCode = 0;
+    if(CURLE_OK == curl_easy_getinfo(m_easyDownloadManager.get(), CURLINFO_RESPONSE_CODE, &responseCode)) {
+      countHttpResponse(responseCode);
+    }
+    long httpVersion = CURL_HTTP_VERSION_NONE;
+    if(CURLE_OK != curl_easy_getinfo(m_easyDownloadManager.get(), CURLINFO_HTTP_VERSION, &httpVersion)) {
+      LOG_ERROR("Can't read the http version.");
+    }
+    const bool multiplexed = httpVersion >= CURL_HTTP_VERSION_2_0;
+    if(multiplexed) {
+      multiplexedTransfers.add();
+    }
+    const TransferError transferError = segmentFailed ? TransferError::OTHER : classifyTransferResult(infoResult);
+    countTransferResult(transferError);
+    const CurlTimes curlTimes = getCurlTimes();
+    transferDuration.recordDuration(curlTimes.total);
+    if(CURLE_OK == infoResult) {
+      timeToFirstByte.recordDuration(curlTimes.startTransfer);
+      connectTime.recordDuration(curlTimes.connect - curlTimes.nameLookup);
+      responseSize.record(contentLength);
+      if(nullptr != m_timeouts) {
+        m_timeouts->record(std::get<0>(m_download.url), curlTimes.connect - curlTimes.nameLookup, curlTimes.total);
+      }
+    }
+
+    const bool        traced   = sampleTrace();
+    const SteadyTime  finished = traced ? std::chrono::steady_clock::now() : SteadyTime{};
+    const std::string tracedUrl{traced ? std::get<0>(m_download.url) : std::string{}};
+
+    // every accepted chunk was appended to the content
+    std::shared_ptr<const void> heldMemory = nullptr == m_memory ? nullptr : m_memory->handOver(m_content.size());
     m_download.callback(DownloadResult{std::move(m_download.url),
                                        std::move(m_content),
                                        m_headerHandler.getMediaType(),
-                                       CURLE_OK == infoResult,
+                                       CURLE_OK == infoResult && !segmentFailed,
                                        m_errorStream.str(),
-                                       downloadSpeedByteSec});
+                                       downloadSpeedByteSec,
+                                       transferError,
+                                       multiplexed,
+                                       std::move(heldMemory),
+                                       std::move(contentFile),
+                                       std::move(scanner)});
+    m_content.clear();
+    if(traced) {
+      traceTransfer(tracedUrl, m_download.times, curlTimes, finished, std::chrono::steady_clock::now());
+    }
     return std::move(m_finishedCallback);
   }
 
@@ -67,6 +249,80 @@ public:
   }
 
 private:
+  void releaseMemory(const uint64_t bytes) {
+    if(nullptr != m_memory && 0 != bytes) {
+      m_memory->releaseTransfer(bytes);
+    }
+  }
+
+  void releaseContent() {
+    releaseMemory(m_content.size() + m_segment.buffered());
+    m_segment.discard();
+  }
+
+  uint64_t receivedBytes() const {
+    return m_content.size() + (m_segment.isOpen() ? m_segment.written() + m_segment.buffered() : 0);
+  }
+
+  /**
+   * Keeps the accepted data in memory or in the segment file of a large body of a streamed media type.
+   */
+  bool storeContent(const std::string_view data) {
+    if(!m_segment.isOpen()) {
+      if(!m_streamed || m_content.size() + data.size() <= m_segmentFiles->options().memoryThreshold) {
+        m_content.append(data.data(), data.size());
+        if(m_scanner) {
+          m_scanner->scan(m_content);
+        }
+        return true;
+      }
+      // the content of the segment file is not scanned
+      m_scanner.reset();
+      if(!m_segment.open(m_segmentFiles->nextPath())) {
+        releaseMemory(data.size());
+        return false;
+      }
+      const bool moved = writeSegment(m_content);
+      m_content        = std::string{}; // releases the capacity too
+      if(!moved) {
+        releaseMemory(data.size());
+        return false;
+      }
+    }
+    return writeSegment(data);
+  }
+
+  bool writeSegment(const std::string_view data) {
+    const size_t buffered = m_segment.buffered();
+    const bool   result   = m_segment.append(data);
+    // the bytes written to the file are not held in memory any more, a failure drops the buffered ones
+    releaseMemory(buffered + data.size() - (result ? m_segment.buffered() : 0));
+    return result;
+  }
+
+  void setAdaptiveDeadlines() {
+    if(nullptr != m_timeouts && m_timeouts->options().adaptive) {
+      m_easyDownloadManager.setDeadlines(m_timeouts->deadlines(std::get<0>(m_download.url)));
+    }
+  }
+
+  CurlTimes getCurlTimes() {
+    CurlTimes result{};
+    const std::pair<CURLINFO, std::chrono::microseconds*> infos[] = {
+        {CURLINFO_NAMELOOKUP_TIME_T, &result.nameLookup},
+        {CURLINFO_CONNECT_TIME_T, &result.connect},
+        {CURLINFO_APPCONNECT_TIME_T, &result.appConnect},
+        {CURLINFO_STARTTRANSFER_TIME_T, &result.startTransfer},
+        {CURLINFO_TOTAL_TIME_T, &result.total}};
+    for(const auto& info: infos) {
+      curl_off_t timeUs = 0;
+      if(CURLE_OK == curl_easy_getinfo(m_easyDownloadManager.get(), info.first, &timeUs)) {
+        *info.second = std::chrono::microseconds{timeUs};
+      }
+    }
+    return result;
+  }
+
   size_t headerCb(char* buffer, size_t size, size_t nitems) {
     LOG_DEBUG("headerCb");
     return m_headerHandler(buffer, size * nitems);
@@ -77,14 +333,39 @@ private:
   }
 
   size_t writeCb(char* buffer, size_t size, size_t nitems) {
-    const size_t chunkSize = nitems * size;
-    if(m_content.length() + chunkSize > m_maxContentLength) {
-      LOG_INFO("m_maxContentLength " << m_maxContentLength << " exceeded. url: " << m_download
-                                     << " mediaType: " << m_headerHandler.getMediaType());
+    const size_t   chunkSize = nitems * size;
+    const uint64_t received  = receivedBytes();
+    if(0 == received) {
+      // the headers were received
+      const MediaType mediaType = m_headerHandler.getMediaType();
+      m_streamed                = nullptr != m_segmentFiles && m_segmentFiles->streamed(mediaType);
+      if(nullptr != m_scannerFactory && *m_scannerFactory) {
+        m_scanner = (*m_scannerFactory)(mediaType);
+      }
+    }
+    const size_t maxContentLength = m_streamed ? m_segmentFiles->options().maxStreamedLength : m_maxContentLength;
+    if(received + chunkSize > maxContentLength) {
+      LOG_INFO("maxContentLength " << maxContentLength << " exceeded. url: " << m_download
+                                   << " mediaType: " << m_headerHandler.getMediaType());
       m_errorStream << "max_content length exceeded" << std::endl;
       return 0; // generate CURL_WRITE_ERROR
     }
-    m_content.append(buffer, chunkSize);
+    if(nullptr != m_limiter) {
+      switch(m_limiter->acquire(m_easyDownloadManager.get(), m_hostBytes, chunkSize)) {
+        case BandwidthGrant::ACCEPT:
+          break;
+        case BandwidthGrant::PAUSE:
+          return CURL_WRITEFUNC_PAUSE; // curl writes the chunk again when resumed
+        case BandwidthGrant::OVER_BUDGET:
+          m_errorStream << "host byte budget exceeded" << std::endl;
+          return 0; // generate CURL_WRITE_ERROR
+      }
+    }
+    if(!storeContent(std::string_view{buffer, chunkSize})) {
+      m_errorStream << m_segment.error() << std::endl;
+      return 0; // generate CURL_WRITE_ERROR
+    }
+    downloadedBytes.add(chunkSize);
     return chunkSize;
   }
 
@@ -94,14 +375,24 @@ private:
   }
 
 private:
-  DownloadElem            m_download;
-  size_t                  m_maxContentLength;
-  std::string             m_content;
-  CurlEasyDownloadManager m_easyDownloadManager;
-  CurlEasyMultiManager    m_easyMultiManager;
-  std::ostringstream      m_errorStream;
-  HeaderHandler           m_headerHandler;
-  std::function<void()>   m_finishedCallback;
+  DownloadElem                    m_download;
+  size_t                          m_maxContentLength;
+  std::string                     m_content;
+  CurlSlist                       m_resolve; // nullptr if curl resolves the host
+  CurlEasyDownloadManager         m_easyDownloadManager;
+  CurlEasyMultiManager            m_easyMultiManager;
+  std::ostringstream              m_errorStream;
+  HeaderHandler                   m_headerHandler;
+  BandwidthLimiter*               m_limiter;
+  uint64_t*                       m_hostBytes;      // received from the host of the url, nullptr without host budgets
+  TransferTimeouts*               m_timeouts;       // nullptr for the default deadlines
+  MemoryBudget*                   m_memory;         // holds the content, nullptr without a memory budget
+  SegmentFiles*                   m_segmentFiles;   // nullptr without streaming
+  SegmentWriter                   m_segment;        // open while a large body is streamed
+  bool                            m_streamed;       // the media type of the transfer is streamed when large
+  const ContentScannerFactory*    m_scannerFactory; // nullptr if the content is not scanned
+  std::unique_ptr<ContentScanner> m_scanner;        // scans the content received in memory
+  std::function<void()>           m_finishedCallback;
 };
 
 // class DownloadManager
@@ -109,9 +400,16 @@ DownloadManager::DownloadManager(CURLM* const                                 mu
                                  DownloadElem&&                               download,
                                  const size_t                                 maxContentLength,
                                  const std::function<bool(const MediaType&)>& mediaTypeValidator,
-                                 OpenCloseSocketConfig*                       openCloseSocketConfig)
-    : m_pimpl(
-        new Pimpl(multiHandle, std::move(download), maxContentLength, mediaTypeValidator, openCloseSocketConfig)) {}
+                                 OpenCloseSocketConfig*                       openCloseSocketConfig,
+                                 const TransferOptions*                       transferOptions,
+                                 const std::vector<std::string>&              resolve)
+    : m_pimpl(new Pimpl(multiHandle,
+                        std::move(download),
+                        maxContentLength,
+                        mediaTypeValidator,
+                        openCloseSocketConfig,
+                        transferOptions,
+                        resolve)) {}
 
 DownloadManager&
 DownloadManager::operator=(DownloadManager&& other) noexcept {
@@ -132,13 +430,18 @@ DownloadManager::reuse(DownloadElem&& download) {
 void
 DownloadManager::Pimpl::reuse(DownloadElem&& download) {
   m_easyMultiManager.release();
-  m_download = std::move(download);
+  m_download               = std::move(download);
+  m_download.times.started = std::chrono::steady_clock::now();
   m_easyDownloadManager.reuse(const_cast<char*>(std::get<0>(m_download.url).c_str()), this, headerCb, writeCb);
   m_easyMultiManager.reuse();
   m_errorStream.str("");
   m_headerHandler.reuse();
+  m_scanner.reset();
+  m_hostBytes = nullptr == m_limiter ? nullptr : m_limiter->hostBytes(std::get<0>(m_download.url));
+  setAdaptiveDeadlines();
   if(!m_content.empty()) {
     LOG_ERROR("downloaded content not consumed");
+    releaseContent();
   }
   m_content.erase();
 }
@@ -4,6 +4,7 @@
 #include <curl/multi.h>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "MediaType.h"
 #include "Url.h"
@@ -13,11 +14,16 @@ struct DownloadResult;
 
 class DownloadManager {
 public:
+  /**
+   * @param resolve CURLOPT_RESOLVE entries with the addresses of the host of the url, empty to let curl resolve it
+   */
   DownloadManager(CURLM*                                       multiHandle,
                   DownloadElem&&                               download,
                   size_t                                       maxContentLength,
                   const std::function<bool(const MediaType&)>& mediaTypeValidator,
-                  OpenCloseSocketConfig*                       openCloseSocketConfig = nullptr);
+                  OpenCloseSocketConfig*                       openCloseSocketConfig = nullptr,
+                  const TransferOptions*                       transferOptions       = nullptr,
+                  const std::vector<std::string>&              resolve               = {});
 
   DownloadManager(const DownloadManager&) = delete;
   DownloadManager& operator=(const DownloadManager&) = delete;
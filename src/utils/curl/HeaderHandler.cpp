@@ -84,7 +84,8 @@ HeaderHandler::operator()(char* const buffer, const size_t size) {
 
 bool
 HeaderHandler::process(const std::string& line) {
-  static const std::regex statusLineExpr("^HTTP/1\\.1 (\\d\\d\\d) ");
+  // curl writes HTTP/2 and HTTP/3 status lines as "HTTP/2 200 ", without a minor version and a reason phrase
+  static const std::regex statusLineExpr("^HTTP/(?:1\\.[01]|2(?:\\.0)?|3) (\\d\\d\\d)(?: |$)");
 
   LOG_DEBUG("processing line: " << line);
   switch(m_state) {
@@ -0,0 +1,57 @@
+#include "MemoryBudget.h"
+
+#include "Metrics.h"
+
+namespace {
+
+Gauge& heldContent = getGauge("crawler_held_content_bytes",
+                              "Downloaded content held by the transfers and their results, with a memory budget.");
+
+} // namespace
+
+MemoryBudget::MemoryBudget(const uint64_t budgetBytes, std::function<void()> released)
+    : m_budgetBytes{budgetBytes}
+    , m_used{0}
+    , m_transferBytes{0}
+    , m_awaitingRelease{false}
+    , m_releasedMutex{}
+    , m_released{std::move(released)} {}
+
+void
+MemoryBudget::reserve(const uint64_t bytes) {
+  m_transferBytes += bytes;
+  m_used.fetch_add(bytes);
+  heldContent.add(static_cast<int64_t>(bytes));
+}
+
+void
+MemoryBudget::releaseTransfer(const uint64_t bytes) {
+  m_transferBytes -= bytes;
+  release(bytes);
+}
+
+std::shared_ptr<const void>
+MemoryBudget::handOver(const uint64_t bytes) {
+  m_transferBytes -= bytes;
+  // the deleter keeps the budget alive, the results may outlive the downloader
+  return std::shared_ptr<const void>{this,
+                                     [budget = shared_from_this(), bytes](const void*) { budget->release(bytes); }};
+}
+
+void
+MemoryBudget::stopNotifying() {
+  std::lock_guard<std::mutex> lock{m_releasedMutex};
+  m_released = nullptr;
+}
+
+void
+MemoryBudget::release(const uint64_t bytes) {
+  m_used.fetch_sub(bytes);
+  heldContent.add(-static_cast<int64_t>(bytes));
+  if(m_awaitingRelease.exchange(false)) {
+    std::lock_guard<std::mutex> lock{m_releasedMutex};
+    if(m_released) {
+      m_released();
+    }
+  }
+}
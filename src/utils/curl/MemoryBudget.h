@@ -0,0 +1,72 @@
+#ifndef UTILS_CURL_MEMORYBUDGET_H_F6RY2KCM
+#define UTILS_CURL_MEMORYBUDGET_H_F6RY2KCM
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ * The bytes of downloaded content held in memory by the transfers of a downloader and by their results, see
+ * BandwidthLimits::memoryBudgetBytes. A transfer reserves the bytes it receives from the thread of the multi handle.
+ * When it finishes, its bytes are handed over to its DownloadResult and released once the last copy of the result is
+ * destroyed, from any thread.
+ */
+class MemoryBudget : public std::enable_shared_from_this<MemoryBudget> {
+public:
+  /**
+   * @param released called from the releasing thread at the first release after awaitRelease()
+   */
+  MemoryBudget(uint64_t budgetBytes, std::function<void()> released);
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+  bool fits(const uint64_t bytes) const { return m_used.load() + bytes <= m_budgetBytes; }
+
+  uint64_t used() const { return m_used.load(); }
+
+  /**
+   * @returns the bytes held by the results, those are released without the transfers receiving more
+   */
+  uint64_t resultBytes() const { return m_used.load() - m_transferBytes; }
+
+  /**
+   * Reserves bytes received by a transfer.
+   */
+  void reserve(uint64_t bytes);
+
+  /**
+   * Releases bytes reserved by a transfer which did not hand them over.
+   */
+  void releaseTransfer(uint64_t bytes);
+
+  /**
+   * Hands bytes reserved by a finished transfer over to its result.
+   * @returns the handle of the bytes, they are released when its last copy is destroyed
+   */
+  std::shared_ptr<const void> handOver(uint64_t bytes);
+
+  /**
+   * Requests a call of released at the next release.
+   */
+  void awaitRelease() { m_awaitingRelease.store(true); }
+
+  /**
+   * Stops the calls of released, e.g. before the downloader is destroyed while results are still held.
+   */
+  void stopNotifying();
+
+private:
+  void release(uint64_t bytes);
+
+  const uint64_t        m_budgetBytes;
+  std::atomic<uint64_t> m_used;
+  uint64_t              m_transferBytes; // only used from the thread of the multi handle
+  std::atomic<bool>     m_awaitingRelease;
+  std::mutex            m_releasedMutex;
+  std::function<void()> m_released;
+};
+
+#endif /* end of include guard: UTILS_CURL_MEMORYBUDGET_H_F6RY2KCM */
@@ -0,0 +1,154 @@
+#include "Logger.h"
+LOG_INIT(SegmentFiles);
+
+#include "SegmentFiles.h"
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+Counter& segmentFiles = getCounter("crawler_segment_files_total", "Bodies streamed into a segment file.");
+Counter& segmentBytes = getCounter("crawler_segment_bytes_total", "Bytes written into segment files.");
+
+// numbers the segment files of all the downloaders of the process
+std::atomic<uint64_t> nextSegment{0};
+
+size_t
+roundUpToBlocks(const size_t bytes) {
+  const size_t blocks = (std::max<size_t>(bytes, 1) + SegmentWriter::BLOCK_SIZE - 1) / SegmentWriter::BLOCK_SIZE;
+  return blocks * SegmentWriter::BLOCK_SIZE;
+}
+
+} // namespace
+
+// class SegmentFiles
+SegmentFiles::SegmentFiles(StreamingOptions options)
+    : m_options{std::move(options)}
+    , m_prefix{m_options.directory + "/segment_" + std::to_string(getpid()) + '_'} {
+  if(m_options.directory.empty() || !m_options.streamed) {
+    throw std::invalid_argument("SegmentFiles received no directory or no streamed media types");
+  }
+  if(m_options.memoryThreshold >= m_options.maxStreamedLength) {
+    throw std::invalid_argument("SegmentFiles received a memoryThreshold not below maxStreamedLength");
+  }
+}
+
+std::string
+SegmentFiles::nextPath() {
+  return m_prefix + std::to_string(nextSegment.fetch_add(1));
+}
+
+// class SegmentWriter
+SegmentWriter::SegmentWriter(const size_t writeBytes)
+    : m_bufferSize{roundUpToBlocks(writeBytes)}
+    , m_buffer{}
+    , m_buffered{0}
+    , m_written{0}
+    , m_fd{-1}
+    , m_path{}
+    , m_error{} {}
+
+SegmentWriter::~SegmentWriter() { discard(); }
+
+bool
+SegmentWriter::open(std::string path) {
+  discard();
+  m_buffered = 0;
+  m_written  = 0;
+  m_path     = std::move(path);
+  m_error    = std::string{};
+  if(!m_buffer) {
+    // aligned like the blocks of the file it is written to
+    m_buffer.reset(static_cast<char*>(std::aligned_alloc(BLOCK_SIZE, m_bufferSize)));
+    if(!m_buffer) {
+      m_error = "allocating the buffer of the segment file failed";
+      return false;
+    }
+  }
+  m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if(-1 == m_fd) {
+    return fail("open");
+  }
+  segmentFiles.add();
+  return true;
+}
+
+bool
+SegmentWriter::append(std::string_view data) {
+  while(!data.empty()) {
+    const size_t copied = std::min(data.size(), m_bufferSize - m_buffered);
+    std::memcpy(m_buffer.get() + m_buffered, data.data(), copied);
+    m_buffered += copied;
+    data.remove_prefix(copied);
+    if(m_buffered == m_bufferSize && !writeBuffer()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+SegmentWriter::finish() {
+  if(!writeBuffer()) {
+    return false;
+  }
+  const int fd = m_fd;
+  m_fd         = -1;
+  if(0 != ::close(fd)) {
+    fail("close");
+    ::unlink(m_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void
+SegmentWriter::discard() {
+  if(!isOpen()) {
+    return;
+  }
+  ::close(m_fd);
+  m_fd = -1;
+  if(0 != ::unlink(m_path.c_str())) {
+    LOG_ERROR("removing the segment file " << m_path << " failed: " << std::strerror(errno));
+  }
+  m_buffered = 0;
+  m_written  = 0;
+}
+
+bool
+SegmentWriter::writeBuffer() {
+  size_t offset = 0;
+  while(offset < m_buffered) {
+    const ssize_t result = ::write(m_fd, m_buffer.get() + offset, m_buffered - offset);
+    if(result < 0) {
+      if(EINTR == errno) {
+        continue;
+      }
+      return fail("write");
+    }
+    offset += static_cast<size_t>(result);
+  }
+  segmentBytes.add(m_buffered);
+  m_written += m_buffered;
+  m_buffered = 0;
+  return true;
+}
+
+bool
+SegmentWriter::fail(const char* const operation) {
+  m_error = std::string{operation} + " of the segment file " + m_path + " failed: " + std::strerror(errno);
+  LOG_ERROR(m_error);
+  discard();
+  m_buffered = 0;
+  m_written  = 0;
+  return false;
+}
@@ -0,0 +1,121 @@
+#ifndef UTILS_CURL_SEGMENTFILES_H_N7WQ4HZC
+#define UTILS_CURL_SEGMENTFILES_H_N7WQ4HZC
+
+#include "MediaType.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * Where the content of the transfers is kept. The bodies of the streamed media types stay in memory up to
+ * memoryThreshold, a larger body is moved into its own segment file in directory and the following bytes are written
+ * to it. The DownloadResult then names the file instead of holding the content.
+ * The streamed media types must also pass the media type validator of the downloader.
+ */
+struct StreamingOptions {
+  std::string                           directory; // streaming is disabled when empty
+  std::function<bool(const MediaType&)> streamed;  // media types which may go into a segment file
+  size_t                                memoryThreshold{256 * 1024};
+  size_t                                maxStreamedLength{64 * 1024 * 1024}; // replaces maxContentLength
+  size_t                                writeBytes{1024 * 1024}; // rounded up to whole blocks
+};
+
+/**
+ * The segment files of a downloader.
+ */
+class SegmentFiles {
+public:
+  /**
+   * @throws std::invalid_argument without a directory or media types, or for a memoryThreshold not below
+   *                               maxStreamedLength
+   */
+  explicit SegmentFiles(StreamingOptions options);
+
+  const StreamingOptions& options() const { return m_options; }
+
+  bool streamed(const MediaType& mediaType) const { return m_options.streamed(mediaType); }
+
+  /**
+   * @returns the path of a new segment file, unique among the downloaders of all processes
+   */
+  std::string nextPath();
+
+private:
+  StreamingOptions m_options;
+  std::string      m_prefix;
+};
+
+/**
+ * Writes the content of one transfer into a segment file. The bytes are buffered and written in writes of the size of
+ * the buffer, a whole number of file system blocks, thus all the writes but the last one start and end at block
+ * boundaries. A failed write closes and removes the file, error() then describes the failure.
+ */
+class SegmentWriter {
+public:
+  static constexpr size_t BLOCK_SIZE = 4096;
+
+  /**
+   * @param writeBytes rounded up to whole blocks, the buffer is allocated at the first open()
+   */
+  explicit SegmentWriter(size_t writeBytes);
+
+  SegmentWriter(const SegmentWriter&) = delete;
+  SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+  /**
+   * Removes the file of an unfinished transfer.
+   */
+  ~SegmentWriter();
+
+  /**
+   * Creates the file at path, which must not exist.
+   */
+  bool open(std::string path);
+
+  bool append(std::string_view data);
+
+  /**
+   * Writes the buffered bytes and closes the file, which is kept.
+   */
+  bool finish();
+
+  /**
+   * Closes and removes the file.
+   */
+  void discard();
+
+  bool isOpen() const { return -1 != m_fd; }
+
+  size_t buffered() const { return m_buffered; }
+
+  uint64_t written() const { return m_written; }
+
+  /**
+   * @returns the file of the last open()
+   */
+  const std::string& path() const { return m_path; }
+
+  const std::string& error() const { return m_error; }
+
+private:
+  struct FreeBuffer {
+    void operator()(char* buffer) const { std::free(buffer); }
+  };
+
+  bool writeBuffer();
+  bool fail(const char* operation);
+
+  size_t                            m_bufferSize;
+  std::unique_ptr<char, FreeBuffer> m_buffer;
+  size_t                            m_buffered;
+  uint64_t                          m_written;
+  int                               m_fd;
+  std::string                       m_path;
+  std::string                       m_error;
+};
+
+#endif /* end of include guard: UTILS_CURL_SEGMENTFILES_H_N7WQ4HZC */
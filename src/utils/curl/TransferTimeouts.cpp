@@ -0,0 +1,100 @@
+#include "TransferTimeouts.h"
+
+#include "Metrics.h"
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+Gauge&   observedOrigins  = getGauge("crawler_timeout_origins", "Origins with latencies for the adaptive deadlines.");
+Counter& adaptedDeadlines = getCounter("crawler_adapted_deadlines_total",
+                                      "Transfers started with deadlines derived from the latencies of their origin.");
+
+// an origin gets adaptive deadlines after this number of latencies
+constexpr uint8_t MIN_SAMPLES = 4;
+
+} // namespace
+
+void
+TransferTimeouts::Samples::add(const std::chrono::microseconds latency) {
+  constexpr int64_t MAX_LATENCY = std::numeric_limits<uint32_t>::max();
+  latencies[next]               = static_cast<uint32_t>(std::clamp<int64_t>(latency.count(), 0, MAX_LATENCY));
+  next                          = static_cast<uint8_t>((next + 1) % SIZE);
+  size                          = static_cast<uint8_t>(std::min<size_t>(size + 1, SIZE));
+}
+
+std::chrono::microseconds
+TransferTimeouts::Samples::percentile90() const {
+  std::array<uint32_t, SIZE> sorted = latencies;
+  // the nearest rank is the smallest sample with at least 90% of the samples below or equal
+  const size_t rank = (size * 9 + 9) / 10;
+  std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.begin() + size);
+  return std::chrono::microseconds{sorted[rank - 1]};
+}
+
+// class TransferTimeouts
+TransferTimeouts::TransferTimeouts(const TimeoutOptions& options) : m_options{options}, m_origins{} {
+  if(options.connect.count() <= 0 || options.transfer.count() <= 0 || options.prewarmIdle.count() <= 0) {
+    throw std::invalid_argument("TransferTimeouts received a deadline which is not positive");
+  }
+  if(options.adaptive && (options.latencyFactor < 1 || options.minConnect.count() <= 0
+                          || options.minTransfer.count() <= 0)) {
+    throw std::invalid_argument("TransferTimeouts received invalid adaptive deadlines");
+  }
+}
+
+TransferDeadlines
+TransferTimeouts::deadlines(const std::string_view url) const {
+  const TransferDeadlines configured{m_options.connect, m_options.transfer};
+  if(!m_options.adaptive) {
+    return configured;
+  }
+  const auto originIt = m_origins.find(originOf(url));
+  if(end(m_origins) == originIt) {
+    return configured;
+  }
+  const TransferDeadlines result{deadline(originIt->second.connect, m_options.minConnect, m_options.connect),
+                                 deadline(originIt->second.total, m_options.minTransfer, m_options.transfer)};
+  if(result.connect != configured.connect || result.transfer != configured.transfer) {
+    adaptedDeadlines.add();
+  }
+  return result;
+}
+
+void
+TransferTimeouts::record(const std::string_view          url,
+                         const std::chrono::microseconds connectTime,
+                         const std::chrono::microseconds totalTime) {
+  if(!m_options.adaptive) {
+    return;
+  }
+  std::string origin   = originOf(url);
+  auto        originIt = m_origins.find(origin);
+  if(end(m_origins) == originIt) {
+    if(m_origins.size() >= m_options.maxOrigins) {
+      observedOrigins.add(-static_cast<int64_t>(m_origins.size()));
+      m_origins.clear();
+    }
+    originIt = m_origins.emplace(std::move(origin), OriginLatencies{}).first;
+    observedOrigins.add(1);
+  }
+  if(connectTime.count() > 0) {
+    originIt->second.connect.add(connectTime);
+  }
+  originIt->second.total.add(totalTime);
+}
+
+std::chrono::milliseconds
+TransferTimeouts::deadline(const Samples&                  samples,
+                           const std::chrono::milliseconds minimum,
+                           const std::chrono::milliseconds maximum) const {
+  if(samples.size < MIN_SAMPLES) {
+    return maximum;
+  }
+  const auto scaled = std::chrono::duration_cast<std::chrono::milliseconds>(samples.percentile90()
+                                                                             * m_options.latencyFactor);
+  return std::clamp(scaled, std::min(minimum, maximum), maximum);
+}
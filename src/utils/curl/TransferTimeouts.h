@@ -0,0 +1,96 @@
+#ifndef UTILS_CURL_TRANSFERTIMEOUTS_H_Q8VLD3XR
+#define UTILS_CURL_TRANSFERTIMEOUTS_H_Q8VLD3XR
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * Deadlines of the transfers of a downloader. A transfer receiving less than lowSpeedLimit bytes per second during
+ * lowSpeedTime is aborted as timed out, thus a slowly dripping server does not hold a download slot until the
+ * transfer deadline. Paused transfers, see BandwidthLimiter, are not checked.
+ * With adaptive the deadlines are derived per origin from the latencies observed for it, see TransferTimeouts.
+ */
+struct TimeoutOptions {
+  std::chrono::milliseconds connect{15'000};
+  std::chrono::milliseconds transfer{60'000};
+  uint32_t                  lowSpeedLimit{1024}; // bytes per second, 0 disables the low speed limit
+  std::chrono::seconds      lowSpeedTime{10};
+  bool                      adaptive{false};
+  double                    latencyFactor{4}; // the adaptive deadline is this multiple of the 90th percentile
+  std::chrono::milliseconds minConnect{1000};
+  std::chrono::milliseconds minTransfer{10'000};
+  size_t                    maxOrigins{100'000}; // all the latencies are forgotten when more origins are observed
+  std::chrono::milliseconds prewarmIdle{2000}; // a prewarmed connection not taken within this time is closed
+};
+
+struct TransferDeadlines {
+  std::chrono::milliseconds connect;
+  std::chrono::milliseconds transfer;
+};
+
+/**
+ * The deadlines of the transfers by origin. With TimeoutOptions::adaptive the connect times and the total times of the
+ * last successful transfers of each origin are kept. Once enough of them are known, the deadlines of the origin are
+ * latencyFactor times their 90th percentile, between the minimum and the configured deadline. The other origins get
+ * the configured deadlines. A transfer far slower than the usual ones of its origin thus times out early instead of
+ * holding a download slot for the whole configured deadline.
+ * Must be used from one thread.
+ */
+class TransferTimeouts {
+public:
+  /**
+   * @throws std::invalid_argument for deadlines which are not positive or a latencyFactor below 1
+   */
+  explicit TransferTimeouts(const TimeoutOptions& options);
+
+  const TimeoutOptions& options() const { return m_options; }
+
+  /**
+   * @returns the deadlines of a transfer of url
+   */
+  TransferDeadlines deadlines(std::string_view url) const;
+
+  /**
+   * Records the latencies of a successful transfer of url, a connect time of 0 for a reused connection is skipped.
+   */
+  void record(std::string_view url, std::chrono::microseconds connectTime, std::chrono::microseconds totalTime);
+
+  size_t nrOrigins() const { return m_origins.size(); }
+
+private:
+  /**
+   * The last latencies of one kind, in microseconds.
+   */
+  struct Samples {
+    static constexpr size_t SIZE = 16;
+
+    void add(std::chrono::microseconds latency);
+
+    /**
+     * @returns the 90th percentile of the samples, by nearest rank
+     */
+    std::chrono::microseconds percentile90() const;
+
+    std::array<uint32_t, SIZE> latencies;
+    uint8_t                    next;
+    uint8_t                    size;
+  };
+
+  struct OriginLatencies {
+    Samples connect;
+    Samples total;
+  };
+
+  std::chrono::milliseconds deadline(const Samples&            samples,
+                                     std::chrono::milliseconds minimum,
+                                     std::chrono::milliseconds maximum) const;
+
+  TimeoutOptions                                   m_options;
+  std::unordered_map<std::string, OriginLatencies> m_origins;
+};
+
+#endif /* end of include guard: UTILS_CURL_TRANSFERTIMEOUTS_H_Q8VLD3XR */
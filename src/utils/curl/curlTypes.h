@@ -1,18 +1,47 @@
 #ifndef UTILS_CURL_CURLTYPES_H_AMRP81XC
 #define UTILS_CURL_CURLTYPES_H_AMRP81XC
 
+#include "ContentScanner.h"
 #include "curl/curl.h"
 
+#include <memory>
+
+class BandwidthLimiter;
+class SegmentFiles;
+class TransferTimeouts;
+
 using HeaderCbType = size_t (*)(char*, size_t, size_t, void*);
 
+struct CurlSlistReleaser {
+  void operator()(curl_slist* list) const { curl_slist_free_all(list); }
+};
+
+using CurlSlist = std::unique_ptr<curl_slist, CurlSlistReleaser>;
+
 struct OpenCloseSocketConfig {
   using OpenSocketCbType  = curl_socket_t (*)(void*, curlsocktype, struct curl_sockaddr*);
   using CloseSocketCbType = int (*)(void*, curl_socket_t);
+  using SockoptCbType     = int (*)(void*, curl_socket_t, curlsocktype);
 
   OpenSocketCbType  openSocketCb;
   void*             openSocketData;
   CloseSocketCbType closeSocketCb;
   void*             closeSocketData;
+  SockoptCbType     sockoptCb; // nullptr keeps the default, e.g. for sockets opened already connected
+  void*             sockoptData;
+};
+
+/**
+ * Options of the downloader applied to each transfer.
+ * The pointed to curl lists, limiter, timeouts and segment files must outlive the transfers.
+ */
+struct TransferOptions {
+  // CURLOPT_CONNECT_TO, e.g. "::127.0.0.1:8080" sends all transfers to a local server
+  curl_slist*           connectTo;
+  BandwidthLimiter*     bandwidthLimiter; // nullptr without BandwidthLimits
+  TransferTimeouts*     timeouts;         // nullptr for the default TimeoutOptions
+  SegmentFiles*         segmentFiles;     // nullptr without StreamingOptions
+  ContentScannerFactory scannerFactory;   // empty if the content is not scanned
 };
 
 #endif /* end of include guard: UTILS_CURL_CURLTYPES_H_AMRP81XC */
@@ -0,0 +1,73 @@
+#ifndef UTILS_HTMLMARKUP_H_Q4LKV8RD
+#define UTILS_HTMLMARKUP_H_Q4LKV8RD
+
+#include <string_view>
+
+/**
+ * The markers and case insensitive comparisons shared by the scanners of html pages, the HtmlTokenizer and simHash.
+ * The html tag and attribute names are ASCII, thus only the ASCII letters are folded.
+ */
+constexpr std::string_view HTML_COMMENT_START{"<!--"};
+constexpr std::string_view HTML_COMMENT_END{"-->"};
+constexpr std::string_view HTML_SCRIPT_END{"</script"};
+constexpr std::string_view HTML_STYLE_END{"</style"};
+
+inline char
+toLowerAscii(const char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/**
+ * @param lowerName lowercase name
+ */
+inline bool
+equalsIgnoreCase(const std::string_view value, const std::string_view lowerName) {
+  if(value.size() != lowerName.size()) {
+    return false;
+  }
+  for(size_t pos = 0; pos < value.size(); ++pos) {
+    if(toLowerAscii(value[pos]) != lowerName[pos]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @param lowerPrefix lowercase prefix
+ * @returns true if html continues at pos with lowerPrefix ignoring case
+ */
+inline bool
+startsWithIgnoreCase(const std::string_view html, const size_t pos, const std::string_view lowerPrefix) {
+  return pos <= html.size() && equalsIgnoreCase(html.substr(pos, lowerPrefix.size()), lowerPrefix);
+}
+
+/**
+ * @param lowerNeedle lowercase needle starting with a character which is not a letter, e.g. HTML_SCRIPT_END
+ * @returns the position of lowerNeedle in html ignoring case, starting at pos, or npos
+ */
+inline size_t
+findIgnoreCase(const std::string_view html, const std::string_view lowerNeedle, size_t pos) {
+  while(std::string_view::npos != (pos = html.find(lowerNeedle.front(), pos))) {
+    if(startsWithIgnoreCase(html, pos, lowerNeedle)) {
+      return pos;
+    }
+    ++pos;
+  }
+  return std::string_view::npos;
+}
+
+/**
+ * @param lowerNeedle lowercase needle
+ */
+inline bool
+containsIgnoreCase(const std::string_view value, const std::string_view lowerNeedle) {
+  for(size_t pos = 0; pos + lowerNeedle.size() <= value.size(); ++pos) {
+    if(startsWithIgnoreCase(value, pos, lowerNeedle)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif /* end of include guard: UTILS_HTMLMARKUP_H_Q4LKV8RD */
@@ -0,0 +1,90 @@
+#include "Logger.h"
+LOG_INIT(NearDuplicateFilter);
+
+#include "NearDuplicateFilter.h"
+#include "DownloadResult.h"
+#include "Metrics.h"
+#include "TaskSystem.h"
+#include "simHash.h"
+
+#include <mutex>
+#include <vector>
+
+namespace {
+
+Counter& uniquePages = getCounter("crawler_near_duplicate_checks_total", "Pages checked for near duplicates.",
+                                  {{"result", "unique"}});
+Counter& nearDuplicatePages = getCounter("crawler_near_duplicate_checks_total", "Pages checked for near duplicates.",
+                                         {{"result", "near_duplicate"}});
+
+} // namespace
+
+struct NearDuplicateFilter::Pimpl {
+  Pimpl(const NearDuplicateOptions& options, Sink sink)
+      : m_options{options}
+      , m_sink{std::move(sink)}
+      , m_mutex{}
+      , m_index{options.maxDistance}
+      , m_urlIndexes{}
+      , m_nrNearDuplicates{0}
+      , m_tasks{options.nrThreads} {}
+
+  /**
+   * Runs on the threads of the TaskSystem.
+   */
+  void filter(DownloadResult&& page) {
+    NearDuplicateTag tag;
+    if(page.success) {
+      tag.simHash = simHash(page.content, m_options.shingleSize);
+    }
+    if(0 != tag.simHash) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      uint32_t                    original = 0;
+      tag.nearDuplicate                    = m_index.findNear(tag.simHash, original);
+      if(tag.nearDuplicate) {
+        tag.originalUrlIndex = m_urlIndexes[original];
+        ++m_nrNearDuplicates;
+      }
+      else {
+        m_index.insert(tag.simHash, static_cast<uint32_t>(m_urlIndexes.size()));
+        m_urlIndexes.push_back(std::get<1>(page.url));
+      }
+      (tag.nearDuplicate ? nearDuplicatePages : uniquePages).add();
+    }
+    if(!tag.nearDuplicate) {
+      m_sink(std::move(page), tag);
+      return;
+    }
+    LOG_DEBUG("page: " << std::get<0>(page.url) << " near duplicate of urlIndex: " << tag.originalUrlIndex);
+    if(NearDuplicateAction::TAG == m_options.action) {
+      m_sink(std::move(page), tag);
+    }
+  }
+
+  NearDuplicateOptions m_options;
+  Sink                 m_sink;
+  std::mutex           m_mutex;
+  SimHashIndex         m_index;
+  std::vector<int>     m_urlIndexes; // of the pages in m_index, by their id
+  size_t               m_nrNearDuplicates;
+  // Keep the TaskSystem the last member, its destructor waits for the tasks using the members above.
+  TaskSystem m_tasks;
+};
+
+NearDuplicateFilter::NearDuplicateFilter(const NearDuplicateOptions& options, Sink sink)
+    : m_pimpl{std::make_unique<Pimpl>(options, std::move(sink))} {}
+
+NearDuplicateFilter::~NearDuplicateFilter() = default;
+
+void
+NearDuplicateFilter::process(DownloadResult&& result) {
+  // task system does not support adding move only lambdas, thus the shared ptr
+  auto page = std::make_shared<DownloadResult>(std::move(result));
+  m_pimpl->m_tasks.async_([pimpl = m_pimpl.get(), page]() { pimpl->filter(std::move(*page)); });
+}
+
+size_t
+NearDuplicateFilter::nrNearDuplicates() const {
+  std::lock_guard<std::mutex> lock{m_pimpl->m_mutex};
+  return m_pimpl->m_nrNearDuplicates;
+}
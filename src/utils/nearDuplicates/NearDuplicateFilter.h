@@ -0,0 +1,59 @@
+#ifndef UTILS_NEARDUPLICATEFILTER_H_T4HWZ9QB
+#define UTILS_NEARDUPLICATEFILTER_H_T4HWZ9QB
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+struct DownloadResult;
+
+enum class NearDuplicateAction {
+  TAG, // the near duplicates are passed to the sink with NearDuplicateTag::nearDuplicate set
+  SKIP // the near duplicates are dropped
+};
+
+struct NearDuplicateOptions {
+  unsigned            maxDistance{3}; // pages whose SimHashes differ in at most maxDistance bits are near duplicates
+  size_t              shingleSize{4}; // consecutive tokens hashed together
+  NearDuplicateAction action{NearDuplicateAction::SKIP};
+  unsigned            nrThreads{0}; // threads of the hashing, see TaskSystem
+};
+
+struct NearDuplicateTag {
+  uint64_t simHash{0}; // 0 for failed downloads and pages without text, they are never near duplicates
+  bool     nearDuplicate{false};
+  int      originalUrlIndex{-1}; // urlIndex of the first page near this one, if nearDuplicate
+};
+
+/**
+ * Stage between the crawler and the storage detecting the pages which differ only slightly from a page passed before,
+ * e.g. in timestamps or ads. The SimHash of the content of each successful download is computed on the threads of a
+ * TaskSystem owned by the filter, then looked up in a SimHashIndex of all the pages passed so far.
+ * Of several near duplicate pages, the first one hashed is passed as original.
+ * The destructor waits for the pages being hashed.
+ */
+class NearDuplicateFilter {
+public:
+  using Sink = std::function<void(DownloadResult&&, const NearDuplicateTag&)>;
+
+  /**
+   * @param sink receives the passed pages, it is called from the threads of the filter
+   * @throws std::invalid_argument if options.maxDistance is above SimHashIndex::MAX_DISTANCE
+   */
+  NearDuplicateFilter(const NearDuplicateOptions& options, Sink sink);
+  ~NearDuplicateFilter();
+
+  /**
+   * Hashes result asynchronously, thread safe.
+   */
+  void process(DownloadResult&& result);
+
+  size_t nrNearDuplicates() const;
+
+  struct Pimpl;
+
+private:
+  const std::unique_ptr<Pimpl> m_pimpl;
+};
+
+#endif /* end of include guard: UTILS_NEARDUPLICATEFILTER_H_T4HWZ9QB */
@@ -0,0 +1,229 @@
+#include "simHash.h"
+#include "htmlMarkup.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME  = 1099511628211ull;
+constexpr size_t   HASH_BITS  = 64;
+
+/**
+ * Finalizer of splitmix64, spreads the bits of the combined token hashes over the whole hash.
+ */
+uint64_t
+mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+  return value ^ (value >> 31);
+}
+
+/**
+ * @returns the table of the lowercase value of the bytes of the tokens, 0 for the other bytes
+ */
+constexpr std::array<unsigned char, 256>
+tokenCharTable() {
+  std::array<unsigned char, 256> result{};
+  for(size_t c = 0; c < result.size(); ++c) {
+    if('a' <= (c | 0x20) && (c | 0x20) <= 'z') {
+      result[c] = static_cast<unsigned char>(c | 0x20);
+    }
+    else if(('0' <= c && c <= '9') || 0x80 <= c) { // utf-8 sequences are kept whole
+      result[c] = static_cast<unsigned char>(c);
+    }
+  }
+  return result;
+}
+
+constexpr std::array<unsigned char, 256> TOKEN_CHARS = tokenCharTable();
+
+bool
+isLetter(const unsigned char c) {
+  return 'a' <= (c | 0x20) && (c | 0x20) <= 'z';
+}
+
+/**
+ * @param pos a '<' starting a tag or a comment
+ * @returns the position after the markup, raw text elements are skipped up to their end tag
+ */
+size_t
+skipMarkup(const std::string_view html, const size_t pos) {
+  if(0 == html.compare(pos, HTML_COMMENT_START.size(), HTML_COMMENT_START)) {
+    const size_t end = html.find(HTML_COMMENT_END, pos + HTML_COMMENT_START.size());
+    return std::string_view::npos == end ? html.size() : end + HTML_COMMENT_END.size();
+  }
+  const size_t tagEnd = html.find('>', pos + 1);
+  if(std::string_view::npos == tagEnd) {
+    return html.size();
+  }
+  for(const std::string_view rawTextEnd: {HTML_SCRIPT_END, HTML_STYLE_END}) {
+    if(startsWithIgnoreCase(html, pos + 1, rawTextEnd.substr(2))) {
+      const size_t end = findIgnoreCase(html, rawTextEnd, tagEnd + 1);
+      return std::string_view::npos == end ? html.size() : end;
+    }
+  }
+  return tagEnd + 1;
+}
+
+/**
+ * @returns the table setting the byte i of an entry to bit i of its index
+ */
+constexpr std::array<uint64_t, 256>
+spreadBitsTable() {
+  std::array<uint64_t, 256> result{};
+  for(size_t index = 0; index < result.size(); ++index) {
+    for(size_t bit = 0; bit < 8; ++bit) {
+      result[index] |= static_cast<uint64_t>((index >> bit) & 1) << (8 * bit);
+    }
+  }
+  return result;
+}
+
+constexpr std::array<uint64_t, 256> SPREAD_BITS = spreadBitsTable();
+
+/**
+ * Counts how many of the added hashes have each bit set.
+ * The bits of each byte of a hash are spread into 8 byte counters with a table and added at once,
+ * the byte counters are added to the totals before they overflow.
+ */
+class BitCounts {
+public:
+  void add(const uint64_t hash) {
+    for(size_t byte = 0; byte < 8; ++byte) {
+      m_partial[byte] += SPREAD_BITS[(hash >> (8 * byte)) & 0xff];
+    }
+    ++m_nrHashes;
+    if(MAX_PARTIAL_COUNT == ++m_nrPartial) {
+      flush();
+    }
+  }
+
+  /**
+   * @returns the hash having the bits set by more than half of the added hashes
+   */
+  uint64_t majority() {
+    flush();
+    uint64_t result = 0;
+    for(size_t bit = 0; bit < HASH_BITS; ++bit) {
+      result |= static_cast<uint64_t>(2 * m_totals[bit] > m_nrHashes) << bit;
+    }
+    return result;
+  }
+
+private:
+  static constexpr size_t MAX_PARTIAL_COUNT = 255;
+
+  void flush() {
+    for(size_t byte = 0; byte < 8; ++byte) {
+      for(size_t bit = 0; bit < 8; ++bit) {
+        m_totals[8 * byte + bit] += (m_partial[byte] >> (8 * bit)) & 0xff;
+      }
+      m_partial[byte] = 0;
+    }
+    m_nrPartial = 0;
+  }
+
+  std::array<uint64_t, 8>         m_partial{};
+  std::array<uint64_t, HASH_BITS> m_totals{};
+  uint64_t                        m_nrHashes{0};
+  size_t                          m_nrPartial{0}; // hashes added to m_partial
+};
+
+} // namespace
+
+uint64_t
+simHash(const std::string_view html, size_t shingleSize) {
+  shingleSize = std::max<size_t>(shingleSize, 1);
+  BitCounts             bitCounts;
+  std::vector<uint64_t> window(shingleSize); // ring of the hashes of the last tokens
+  size_t                next     = 0;        // position of the next token in window
+  size_t                nrTokens = 0;
+
+  const auto shingle = [&window](size_t token, const size_t size) {
+    uint64_t result = 0;
+    for(size_t index = 0; index < size; ++index) {
+      result = (result ^ window[token]) * FNV_PRIME;
+      token  = window.size() == token + 1 ? 0 : token + 1;
+    }
+    return mix(result);
+  };
+
+  size_t pos = 0;
+  while(pos < html.size()) {
+    const auto c = static_cast<unsigned char>(html[pos]);
+    if('<' == c && pos + 1 < html.size()
+       && (isLetter(html[pos + 1]) || '/' == html[pos + 1] || '!' == html[pos + 1])) {
+      pos = skipMarkup(html, pos);
+      continue;
+    }
+    if(0 == TOKEN_CHARS[c]) {
+      ++pos;
+      continue;
+    }
+    uint64_t tokenHash = FNV_OFFSET;
+    for(; pos < html.size() && 0 != TOKEN_CHARS[static_cast<unsigned char>(html[pos])]; ++pos) {
+      tokenHash = (tokenHash ^ TOKEN_CHARS[static_cast<unsigned char>(html[pos])]) * FNV_PRIME;
+    }
+    window[next] = tokenHash;
+    next         = shingleSize == next + 1 ? 0 : next + 1;
+    if(++nrTokens >= shingleSize) {
+      bitCounts.add(shingle(next, shingleSize));
+    }
+  }
+  if(0 == nrTokens) {
+    return 0;
+  }
+  if(nrTokens < shingleSize) {
+    bitCounts.add(shingle(0, nrTokens));
+  }
+  return bitCounts.majority();
+}
+
+// class SimHashIndex
+SimHashIndex::SimHashIndex(const unsigned maxDistance)
+    : m_maxDistance{maxDistance}, m_bandShifts{}, m_bandMasks{}, m_bands{}, m_size{0} {
+  if(maxDistance > MAX_DISTANCE) {
+    throw std::invalid_argument("SimHash distance above " + std::to_string(MAX_DISTANCE));
+  }
+  const unsigned nrBands = maxDistance + 1;
+  unsigned       shift   = 0;
+  for(unsigned band = 0; band < nrBands; ++band) {
+    const unsigned width = HASH_BITS / nrBands + (band < HASH_BITS % nrBands ? 1 : 0);
+    m_bandShifts.push_back(shift);
+    m_bandMasks.push_back(HASH_BITS == width ? ~uint64_t{0} : (uint64_t{1} << width) - 1);
+    shift += width;
+  }
+  m_bands.resize(nrBands);
+}
+
+bool
+SimHashIndex::findNear(const uint64_t hash, uint32_t& o_id) const {
+  for(unsigned band = 0; band < m_bands.size(); ++band) {
+    const auto bucketIt = m_bands[band].find(bandKey(hash, band));
+    if(end(m_bands[band]) == bucketIt) {
+      continue;
+    }
+    const Bucket& bucket = bucketIt->second;
+    for(size_t index = 0; index < bucket.hashes.size(); ++index) {
+      if(hammingDistance(hash, bucket.hashes[index]) <= m_maxDistance) {
+        o_id = bucket.ids[index];
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void
+SimHashIndex::insert(const uint64_t hash, const uint32_t id) {
+  for(unsigned band = 0; band < m_bands.size(); ++band) {
+    Bucket& bucket = m_bands[band][bandKey(hash, band)];
+    bucket.hashes.push_back(hash);
+    bucket.ids.push_back(id);
+  }
+  ++m_size;
+}
@@ -0,0 +1,71 @@
+#ifndef UTILS_SIMHASH_H_N8RQ2VXC
+#define UTILS_SIMHASH_H_N8RQ2VXC
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 64 bit SimHash of the text of a html page: the markup, comments and the contents of <script> and <style> elements
+ * are skipped, the text is split into lowercase alphanumeric tokens and each shingle of shingleSize consecutive tokens
+ * votes for the bits of its hash. Pages differing in a few tokens get hashes differing in a few bits.
+ * A page with less than shingleSize tokens is a single shingle.
+ * @returns 0 for pages without text
+ */
+uint64_t simHash(std::string_view html, size_t shingleSize);
+
+/**
+ * @returns the number of bits which differ
+ */
+inline unsigned
+hammingDistance(const uint64_t hash1, const uint64_t hash2) {
+  return static_cast<unsigned>(__builtin_popcountll(hash1 ^ hash2));
+}
+
+/**
+ * Index of SimHashes answering which stored hash is within maxDistance bits of a given hash.
+ * The hashes are split into maxDistance + 1 bands, two hashes within maxDistance bits agree on at least one band.
+ * Each band maps its bits to the hashes having them, a lookup compares only the hashes sharing a band.
+ * With the default distance of 3 the bands have 16 bits, thus a lookup compares about 4 * size() / 65536 hashes.
+ * Not thread safe.
+ */
+class SimHashIndex {
+public:
+  static constexpr unsigned MAX_DISTANCE = 31;
+
+  /**
+   * @throws std::invalid_argument if maxDistance is above MAX_DISTANCE
+   */
+  explicit SimHashIndex(unsigned maxDistance = 3);
+
+  /**
+   * @param o_id receives the id of an inserted hash within maxDistance bits of hash
+   * @returns false if there is none
+   */
+  bool findNear(uint64_t hash, uint32_t& o_id) const;
+
+  void insert(uint64_t hash, uint32_t id);
+
+  size_t size() const { return m_size; }
+
+  unsigned maxDistance() const { return m_maxDistance; }
+
+private:
+  struct Bucket {
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> ids;
+  };
+
+  uint64_t bandKey(const uint64_t hash, const unsigned band) const {
+    return (hash >> m_bandShifts[band]) & m_bandMasks[band];
+  }
+
+  unsigned                                          m_maxDistance;
+  std::vector<unsigned>                             m_bandShifts;
+  std::vector<uint64_t>                             m_bandMasks;
+  std::vector<std::unordered_map<uint64_t, Bucket>> m_bands;
+  size_t                                            m_size;
+};
+
+#endif /* end of include guard: UTILS_SIMHASH_H_N8RQ2VXC */
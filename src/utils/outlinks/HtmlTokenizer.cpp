@@ -0,0 +1,405 @@
+#include "HtmlTokenizer.h"
+#include "htmlMarkup.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHEAP_CRAWLER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// the candidates are searched in blocks of this size, one bit per byte
+constexpr size_t BLOCK_SIZE = 64;
+
+// ORed into a byte, lowercases the ASCII letters and keeps '!'
+constexpr char LOWERCASE_BIT = 0x20;
+
+// the first letters of the reported tags and '!' of the comments, see HtmlTagName
+constexpr std::array<char, 8> CANDIDATE_CHARS{'a', 'b', 'f', 'i', 'l', 'm', 's', '!'};
+
+// the longest name of HtmlTagName
+constexpr size_t MAX_TAG_NAME_LENGTH = 6;
+
+/**
+ * @returns the lowercase name packed into an integer, a name is compared in a single instruction
+ */
+constexpr uint64_t
+packName(const std::string_view lowerName) {
+  uint64_t result = 0;
+  for(size_t pos = 0; pos < lowerName.size(); ++pos) {
+    result |= static_cast<uint64_t>(static_cast<unsigned char>(lowerName[pos])) << (8 * pos);
+  }
+  return result;
+}
+
+struct TagNameEntry {
+  uint64_t    packedName;
+  HtmlTagName tag;
+};
+
+constexpr std::array<TagNameEntry, 10> TAG_NAMES{{
+    {packName("a"), HtmlTagName::A},
+    {packName("area"), HtmlTagName::AREA},
+    {packName("base"), HtmlTagName::BASE},
+    {packName("frame"), HtmlTagName::FRAME},
+    {packName("iframe"), HtmlTagName::IFRAME},
+    {packName("img"), HtmlTagName::IMG},
+    {packName("link"), HtmlTagName::LINK},
+    {packName("meta"), HtmlTagName::META},
+    {packName("script"), HtmlTagName::SCRIPT},
+    {packName("style"), HtmlTagName::STYLE},
+}};
+
+struct CandidateTable {
+  bool second[256];
+};
+
+constexpr CandidateTable
+makeCandidateTable() {
+  CandidateTable table{};
+  for(int c = 0; c < 256; ++c) {
+    for(const char candidate: CANDIDATE_CHARS) {
+      table.second[c] = table.second[c] || static_cast<char>(c | LOWERCASE_BIT) == candidate;
+    }
+  }
+  return table;
+}
+
+constexpr CandidateTable CANDIDATE_TABLE = makeCandidateTable();
+
+constexpr bool
+isSpace(const char c) {
+  return ' ' == c || '\t' == c || '\n' == c || '\r' == c || '\f' == c;
+}
+
+struct NameCharTable {
+  bool nameChar[256];
+};
+
+constexpr NameCharTable
+makeNameCharTable() {
+  NameCharTable table{};
+  for(int c = 0; c < 256; ++c) {
+    table.nameChar[c] = !isSpace(static_cast<char>(c)) && '>' != c && '/' != c && '=' != c && '<' != c;
+  }
+  return table;
+}
+
+constexpr NameCharTable NAME_CHAR_TABLE = makeNameCharTable();
+
+inline bool
+isNameChar(const char c) {
+  return NAME_CHAR_TABLE.nameChar[static_cast<unsigned char>(c)];
+}
+
+/**
+ * @returns the position of the first '<' followed by a candidate character in [pos, size - 1) or npos
+ */
+size_t
+findCandidateScalar(const char* const html, size_t pos, const size_t size) {
+  while(pos + 1 < size) {
+    const void* const lt = std::memchr(html + pos, '<', size - 1 - pos);
+    if(nullptr == lt) {
+      return std::string_view::npos;
+    }
+    pos = static_cast<const char*>(lt) - html;
+    if(CANDIDATE_TABLE.second[static_cast<unsigned char>(html[pos + 1])]) {
+      return pos;
+    }
+    ++pos;
+  }
+  return std::string_view::npos;
+}
+
+// The mask functions set bit i if block[i] is '<' followed by a candidate character, block[BLOCK_SIZE] is read.
+using CandidateMask = uint64_t (*)(const char* block);
+
+#ifdef CHEAP_CRAWLER_X86_SIMD
+
+__attribute__((target("sse2"))) uint64_t
+candidateMaskSse2(const char* const block) {
+  const __m128i lt    = _mm_set1_epi8('<');
+  const __m128i lower = _mm_set1_epi8(LOWERCASE_BIT);
+  uint64_t      result = 0;
+  for(size_t offset = 0; offset < BLOCK_SIZE; offset += sizeof(__m128i)) {
+    const __m128i isLt = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset)), lt);
+    if(0 == _mm_movemask_epi8(isLt)) {
+      continue;
+    }
+    const __m128i second
+        = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset + 1)), lower);
+    __m128i isCandidate = _mm_cmpeq_epi8(second, _mm_set1_epi8(CANDIDATE_CHARS[0]));
+    for(size_t index = 1; index < CANDIDATE_CHARS.size(); ++index) {
+      isCandidate = _mm_or_si128(isCandidate, _mm_cmpeq_epi8(second, _mm_set1_epi8(CANDIDATE_CHARS[index])));
+    }
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(isLt, isCandidate)));
+    result |= static_cast<uint64_t>(mask) << offset;
+  }
+  return result;
+}
+
+__attribute__((target("avx2"))) uint64_t
+candidateMaskAvx2(const char* const block) {
+  const __m256i lt    = _mm256_set1_epi8('<');
+  const __m256i lower = _mm256_set1_epi8(LOWERCASE_BIT);
+  uint64_t      result = 0;
+  for(size_t offset = 0; offset < BLOCK_SIZE; offset += sizeof(__m256i)) {
+    const __m256i isLt
+        = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + offset)), lt);
+    if(0 == _mm256_movemask_epi8(isLt)) {
+      continue;
+    }
+    const __m256i second
+        = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + offset + 1)), lower);
+    __m256i isCandidate = _mm256_cmpeq_epi8(second, _mm256_set1_epi8(CANDIDATE_CHARS[0]));
+    for(size_t index = 1; index < CANDIDATE_CHARS.size(); ++index) {
+      isCandidate = _mm256_or_si256(isCandidate, _mm256_cmpeq_epi8(second, _mm256_set1_epi8(CANDIDATE_CHARS[index])));
+    }
+    const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(isLt, isCandidate)));
+    result |= static_cast<uint64_t>(mask) << offset;
+  }
+  return result;
+}
+
+#endif
+
+SimdLevel
+detectSimdLevel() {
+#ifdef CHEAP_CRAWLER_X86_SIMD
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  if(__builtin_cpu_supports("sse2")) {
+    return SimdLevel::SSE2;
+  }
+#endif
+  return SimdLevel::SCALAR;
+}
+
+/**
+ * @returns nullptr for the scalar search
+ */
+CandidateMask
+candidateMaskFor(const SimdLevel simdLevel) {
+#ifdef CHEAP_CRAWLER_X86_SIMD
+  switch(simdLevel) {
+    case SimdLevel::AVX2:
+      return candidateMaskAvx2;
+    case SimdLevel::SSE2:
+      return candidateMaskSse2;
+    case SimdLevel::SCALAR:
+      break;
+  }
+#endif
+  return nullptr;
+}
+
+/**
+ * Parses the attributes of a tag starting after its name.
+ * @returns the position after the closing '>' or npos if the tag is not closed
+ */
+size_t
+parseAttributes(const std::string_view html, size_t pos, std::vector<HtmlAttribute>& o_attributes) {
+  const size_t size = html.size();
+  while(true) {
+    while(pos < size && (isSpace(html[pos]) || '/' == html[pos])) {
+      ++pos;
+    }
+    if(pos >= size) {
+      return std::string_view::npos;
+    }
+    if('>' == html[pos]) {
+      return pos + 1;
+    }
+    const size_t nameStart = pos;
+    while(pos < size && isNameChar(html[pos])) {
+      ++pos;
+    }
+    // a stray '<' or '=' is skipped as an attribute without name
+    pos += nameStart == pos && '>' != html[pos] ? 1 : 0;
+    const std::string_view name = html.substr(nameStart, pos - nameStart);
+    while(pos < size && isSpace(html[pos])) {
+      ++pos;
+    }
+    if(pos >= size) {
+      return std::string_view::npos;
+    }
+    if('=' != html[pos]) {
+      o_attributes.push_back(HtmlAttribute{name, std::string_view{}});
+      continue;
+    }
+    ++pos;
+    while(pos < size && isSpace(html[pos])) {
+      ++pos;
+    }
+    if(pos >= size) {
+      return std::string_view::npos;
+    }
+    size_t valueStart = pos;
+    size_t valueEnd   = pos;
+    if('"' == html[pos] || '\'' == html[pos]) {
+      valueStart = pos + 1;
+      valueEnd   = html.find(html[pos], valueStart);
+      if(std::string_view::npos == valueEnd) {
+        return std::string_view::npos;
+      }
+      pos = valueEnd + 1;
+    }
+    else {
+      while(pos < size && !isSpace(html[pos]) && '>' != html[pos]) {
+        ++pos;
+      }
+      valueEnd = pos;
+    }
+    o_attributes.push_back(HtmlAttribute{name, html.substr(valueStart, valueEnd - valueStart)});
+  }
+}
+
+} // namespace
+
+std::string_view
+HtmlTag::attribute(const std::string_view lowerName) const {
+  for(const HtmlAttribute& attribute: attributes) {
+    if(equalsIgnoreCase(attribute.name, lowerName)) {
+      return attribute.value;
+    }
+  }
+  return std::string_view{};
+}
+
+SimdLevel
+bestSimdLevel() {
+  static const SimdLevel simdLevel = detectSimdLevel();
+  return simdLevel;
+}
+
+// class HtmlTokenizer
+HtmlTokenizer::HtmlTokenizer(const SimdLevel simdLevel)
+    : m_candidateMask{candidateMaskFor(simdLevel)}
+    , m_blockStart{std::string_view::npos}
+    , m_blockMask{0}
+    , m_pos{0}
+    , m_state{State::TEXT}
+    , m_rawTextEnd{}
+    , m_tag{} {}
+
+void
+HtmlTokenizer::reset() {
+  m_blockStart = std::string_view::npos;
+  m_pos        = 0;
+  m_state      = State::TEXT;
+}
+
+size_t
+HtmlTokenizer::findCandidate(const std::string_view html, size_t pos) {
+  if(nullptr == m_candidateMask) {
+    return findCandidateScalar(html.data(), pos, html.size());
+  }
+  while(true) {
+    // the mask of a block stays valid between the calls of feed(), the bytes received before do not change
+    if(pos >= m_blockStart && pos - m_blockStart < BLOCK_SIZE) {
+      const uint64_t mask = m_blockMask & (~uint64_t{0} << (pos - m_blockStart));
+      if(0 != mask) {
+        return m_blockStart + __builtin_ctzll(mask);
+      }
+      pos = m_blockStart + BLOCK_SIZE;
+    }
+    if(pos + BLOCK_SIZE + 1 > html.size()) {
+      return findCandidateScalar(html.data(), pos, html.size());
+    }
+    m_blockStart = pos;
+    m_blockMask  = m_candidateMask(html.data() + pos);
+  }
+}
+
+void
+HtmlTokenizer::feed(const std::string_view html, const TagHandler& onTag) {
+  while(true) {
+    if(State::TEXT != m_state) {
+      const size_t end = skipToEnd(html, m_pos);
+      if(std::string_view::npos == end) {
+        // the end marker may be cut by the end of html
+        const size_t markerSize = State::COMMENT == m_state ? HTML_COMMENT_END.size() : m_rawTextEnd.size();
+        m_pos = std::max(m_pos, html.size() - std::min(html.size(), markerSize - 1));
+        return;
+      }
+      m_pos   = end;
+      m_state = State::TEXT;
+    }
+    const size_t candidate = findCandidate(html, m_pos);
+    if(std::string_view::npos == candidate) {
+      // a '<' at the end is checked again with the next byte
+      m_pos = std::max(m_pos, html.size() - std::min<size_t>(html.size(), 1));
+      return;
+    }
+    const size_t next = scanTag(html, candidate, onTag);
+    if(std::string_view::npos == next) {
+      m_pos = candidate;
+      return;
+    }
+    m_pos = next;
+  }
+}
+
+size_t
+HtmlTokenizer::scanTag(const std::string_view html, const size_t pos, const TagHandler& onTag) {
+  if('!' == html[pos + 1]) {
+    if(html.size() - pos < HTML_COMMENT_START.size()) {
+      return std::string_view::npos;
+    }
+    if(0 == html.compare(pos, HTML_COMMENT_START.size(), HTML_COMMENT_START)) {
+      m_state = State::COMMENT;
+      return pos + HTML_COMMENT_START.size();
+    }
+    // doctype
+    return pos + 1;
+  }
+  const size_t nameStart  = pos + 1;
+  size_t       nameEnd    = nameStart;
+  uint64_t     packedName = 0;
+  while(nameEnd < html.size() && isNameChar(html[nameEnd])) {
+    if(nameEnd - nameStart == MAX_TAG_NAME_LENGTH) {
+      // e.g. <section>
+      return pos + 1;
+    }
+    const auto nameChar = static_cast<unsigned char>(toLowerAscii(html[nameEnd]));
+    packedName |= static_cast<uint64_t>(nameChar) << (8 * (nameEnd - nameStart));
+    ++nameEnd;
+  }
+  if(nameEnd == html.size()) {
+    return std::string_view::npos;
+  }
+  const auto entry = std::find_if(TAG_NAMES.begin(), TAG_NAMES.end(), [packedName](const TagNameEntry& tagName) {
+    return packedName == tagName.packedName;
+  });
+  if(TAG_NAMES.end() == entry) {
+    return pos + 1;
+  }
+  m_tag.name = entry->tag;
+  m_tag.attributes.clear();
+  const size_t tagEnd = parseAttributes(html, nameEnd, m_tag.attributes);
+  if(std::string_view::npos == tagEnd) {
+    return std::string_view::npos;
+  }
+  onTag(m_tag);
+  if(HtmlTagName::SCRIPT == m_tag.name || HtmlTagName::STYLE == m_tag.name) {
+    m_state      = State::RAW_TEXT;
+    m_rawTextEnd = HtmlTagName::SCRIPT == m_tag.name ? HTML_SCRIPT_END : HTML_STYLE_END;
+  }
+  return tagEnd;
+}
+
+size_t
+HtmlTokenizer::skipToEnd(const std::string_view html, const size_t pos) const {
+  if(State::COMMENT == m_state) {
+    const size_t end = html.find(HTML_COMMENT_END, pos);
+    return std::string_view::npos == end ? end : end + HTML_COMMENT_END.size();
+  }
+  const size_t end = findIgnoreCase(html, m_rawTextEnd, pos);
+  return std::string_view::npos == end ? end : end + m_rawTextEnd.size();
+}
@@ -0,0 +1,93 @@
+#ifndef UTILS_HTMLTOKENIZER_H_V9DPX4LS
+#define UTILS_HTMLTOKENIZER_H_V9DPX4LS
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+/**
+ * The tags reported by the HtmlTokenizer, all the other tags are skipped.
+ */
+enum class HtmlTagName : uint8_t { A, AREA, BASE, FRAME, IFRAME, IMG, LINK, META, SCRIPT, STYLE };
+
+struct HtmlAttribute {
+  std::string_view name;  // as written in the page, compare with HtmlTag::attribute
+  std::string_view value; // without quotes, not decoded
+};
+
+struct HtmlTag {
+  HtmlTagName                name;
+  std::vector<HtmlAttribute> attributes;
+
+  /**
+   * @param lowerName lowercase attribute name
+   * @returns the value of the first attribute named lowerName ignoring case, empty if there is none
+   */
+  std::string_view attribute(std::string_view lowerName) const;
+};
+
+/**
+ * Instruction sets used to search the tags. The fastest one supported by the CPU is selected at runtime.
+ */
+enum class SimdLevel { SCALAR, SSE2, AVX2 };
+
+SimdLevel bestSimdLevel();
+
+/**
+ * Scans html for the start tags of HtmlTagName without copying the page.
+ * The candidate tags, '<' followed by the first letter of a reported tag or by '!', are searched 16 or 32 bytes at a
+ * time into a bit mask of 64 bytes, only they are parsed byte by byte.
+ * Comments and the contents of <script> and <style> elements are skipped.
+ * Malformed html is scanned on a best effort basis, a tag which is not closed ends the scan.
+ *
+ * The page can be scanned incrementally while it is downloaded: each call of feed() gets the whole page received so
+ * far and continues where the previous call stopped, a tag cut by the end of the received bytes is reported by the
+ * next call. The buffer may be moved between the calls, the reported views point into the html of the current call.
+ */
+class HtmlTokenizer {
+public:
+  using TagHandler = std::function<void(const HtmlTag&)>;
+
+  explicit HtmlTokenizer(SimdLevel simdLevel = bestSimdLevel());
+
+  /**
+   * Reports the complete tags of html after the position where the previous call stopped.
+   * @param html the page received so far, it starts with the html of the previous calls
+   * @param onTag called for each tag, the views of the tag are valid during the call
+   */
+  void feed(std::string_view html, const TagHandler& onTag);
+
+  /**
+   * Restarts with a new page.
+   */
+  void reset();
+
+private:
+  enum class State : uint8_t { TEXT, COMMENT, RAW_TEXT };
+
+  /**
+   * @returns the position after the tag starting at pos or npos if the tag is cut by the end of html
+   */
+  size_t scanTag(std::string_view html, size_t pos, const TagHandler& onTag);
+
+  /**
+   * @returns the position after the end of the comment or raw text or npos if it continues after html
+   */
+  size_t skipToEnd(std::string_view html, size_t pos) const;
+
+  /**
+   * @returns the position of the next '<' followed by the first letter of a reported tag or by '!' or npos
+   */
+  size_t findCandidate(std::string_view html, size_t pos);
+
+  uint64_t (*m_candidateMask)(const char* block); // nullptr for SimdLevel::SCALAR
+  size_t           m_blockStart;                  // the block of m_blockMask, npos if none
+  uint64_t         m_blockMask;
+  size_t           m_pos;
+  State            m_state;
+  std::string_view m_rawTextEnd; // "</script" or "</style" in RAW_TEXT
+  HtmlTag          m_tag;
+};
+
+#endif /* end of include guard: UTILS_HTMLTOKENIZER_H_V9DPX4LS */
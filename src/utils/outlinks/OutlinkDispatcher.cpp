@@ -0,0 +1,256 @@
+#include "Logger.h"
+LOG_INIT(OutlinkDispatcher);
+
+#include "OutlinkDispatcher.h"
+#include "DownloadResult.h"
+#include "TaskSystem.h"
+#include "extractLinks.h"
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+constexpr std::string_view WWW_PREFIX{"www."};
+constexpr std::string_view ENCODED_AMPERSAND{"&amp;"};
+
+std::string
+toLower(std::string_view value) {
+  std::string result{value};
+  std::transform(result.begin(), result.end(), result.begin(), [](const unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+/**
+ * "&amp;" is the usual escaping of '&' inside the attributes of a html page.
+ */
+void
+decodeAmpersands(std::string& url) {
+  for(size_t pos = url.find(ENCODED_AMPERSAND); std::string::npos != pos; pos = url.find(ENCODED_AMPERSAND, pos + 1)) {
+    url.erase(pos + 1, ENCODED_AMPERSAND.size() - 1);
+  }
+}
+
+/**
+ * Canonicalises url into o_canonical.
+ * @returns false if url is not a valid http or https url
+ */
+bool
+canonicalHttpUrl(const std::string_view url, std::string& o_canonical, UrlParts& o_parts) {
+  o_canonical.resize(url.size() + 1);
+  o_canonical.resize(canonicalizeUrl(url, &o_canonical[0], o_canonical.size(), &o_parts));
+  return !o_canonical.empty() && o_canonical.size() <= UrlArena::MAX_URL_LENGTH
+         && ("http" == o_parts.scheme || "https" == o_parts.scheme);
+}
+
+} // namespace
+
+struct OutlinkDispatcher::Pimpl {
+  Pimpl(const OutlinkOptions& options, std::function<void(DownloadResult&&)> sink)
+      : m_options{options}
+      , m_sink{std::move(sink)}
+      , m_scopeHosts{}
+      , m_includeSubdomains{CrawlScope::SAME_HOST != options.scope}
+      , m_mutex{}
+      , m_extracted{}
+      , m_nrPendingPages{0}
+      , m_seen{}
+      , m_frontier{}
+      , m_nextDepth{0}
+      , m_nextUrlIndex{0}
+      , m_nrDispatchedUrls{0}
+      , m_tasks{options.nrThreads} {}
+
+  ~Pimpl() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_extracted.wait(lock, [this]() { return 0 == m_nrPendingPages; });
+  }
+
+  bool inScope(const std::string_view host) const {
+    if(m_scopeHosts.count(std::string{host})) {
+      return true;
+    }
+    if(!m_includeSubdomains) {
+      return false;
+    }
+    for(size_t dot = host.find('.'); std::string_view::npos != dot; dot = host.find('.', dot + 1)) {
+      if(m_scopeHosts.count(std::string{host.substr(dot + 1)})) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Adds url to the frontier if it was not seen before and the maximum number of urls is not reached.
+   * Must be called with m_mutex locked.
+   */
+  void addToFrontier(std::string&& url) {
+    if(m_seen.size() >= m_options.maxUrls) {
+      return;
+    }
+    if(m_seen.insert(url).second) {
+      m_frontier.push_back(std::move(url));
+    }
+  }
+
+  void addSeed(const std::string& seed) {
+    std::string canonical;
+    UrlParts    parts;
+    if(!canonicalHttpUrl(seed, canonical, parts)) {
+      LOG_INFO("skipping invalid seed: " << seed);
+      return;
+    }
+    std::string_view scopeHost = parts.host;
+    if(CrawlScope::SAME_DOMAIN == m_options.scope && 0 == scopeHost.compare(0, WWW_PREFIX.size(), WWW_PREFIX)) {
+      scopeHost.remove_prefix(WWW_PREFIX.size());
+    }
+    if(CrawlScope::ALLOW_LIST != m_options.scope) {
+      m_scopeHosts.emplace(scopeHost);
+    }
+    addToFrontier(std::move(canonical));
+  }
+
+  /**
+   * Runs on the threads of the TaskSystem.
+   */
+  void extractOutlinks(const DownloadResult& page) {
+    HtmlLinks links;
+    if(const auto* const scanner = dynamic_cast<const LinkScanner*>(page.scanner.get())) {
+      scanner->appendLinks(page.content, links);
+    }
+    else {
+      extractLinks(page.content, links);
+    }
+    if(links.nofollow) {
+      LOG_DEBUG("page: " << std::get<0>(page.url) << " nofollow");
+      return;
+    }
+
+    std::string base;
+    if(!resolveUrl(std::get<0>(page.url), links.base, base)) {
+      return;
+    }
+    std::vector<std::string> outlinks;
+    std::string              absolute;
+    std::string              canonical;
+    UrlParts                 parts;
+    for(const std::string_view link: links.links) {
+      if(!resolveUrl(base, link, absolute)) {
+        continue;
+      }
+      decodeAmpersands(absolute);
+      if(canonicalHttpUrl(absolute, canonical, parts) && inScope(parts.host)) {
+        outlinks.push_back(canonical);
+      }
+    }
+    LOG_DEBUG("page: " << std::get<0>(page.url) << " links: " << links.links.size()
+                       << " followed: " << outlinks.size());
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for(std::string& outlink: outlinks) {
+      addToFrontier(std::move(outlink));
+    }
+  }
+
+  void onResult(const size_t depth, DownloadResult&& result) {
+    if(depth >= m_options.maxDepth || !result.success || result.content.empty()) {
+      m_sink(std::move(result));
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      ++m_nrPendingPages;
+    }
+    // task system does not support adding move only lambdas, thus the shared ptr
+    auto page = std::make_shared<DownloadResult>(std::move(result));
+    m_tasks.async_([this, page]() {
+      handleExceptions([this, &page]() { extractOutlinks(*page); });
+      page->scanner.reset();
+      // called before the page is done, hasUrls() then also waits for the sink
+      handleExceptions([this, &page]() { m_sink(std::move(*page)); });
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        --m_nrPendingPages;
+      }
+      m_extracted.notify_all();
+    });
+  }
+
+  OutlinkOptions                        m_options;
+  std::function<void(DownloadResult&&)> m_sink;
+  std::unordered_set<std::string>       m_scopeHosts;
+  bool                                  m_includeSubdomains;
+  std::mutex                            m_mutex;
+  std::condition_variable               m_extracted;
+  size_t                                m_nrPendingPages;
+  std::unordered_set<std::string>       m_seen;
+  std::vector<std::string>              m_frontier; // the urls of the next batch
+  size_t                                m_nextDepth;
+  int                                   m_nextUrlIndex;
+  size_t                                m_nrDispatchedUrls;
+  // Keep the TaskSystem the last member, its destructor waits for the tasks using the members above.
+  TaskSystem m_tasks;
+};
+
+OutlinkDispatcher::OutlinkDispatcher(const std::vector<std::string>&       seeds,
+                                     const OutlinkOptions&                 options,
+                                     std::function<void(DownloadResult&&)> sink)
+    : m_pimpl{std::make_unique<Pimpl>(options, std::move(sink))} {
+  if(CrawlScope::ALLOW_LIST == options.scope) {
+    for(const std::string& host: options.allowedHosts) {
+      m_pimpl->m_scopeHosts.insert(toLower(host));
+    }
+  }
+  for(const std::string& seed: seeds) {
+    m_pimpl->addSeed(seed);
+  }
+}
+
+OutlinkDispatcher::~OutlinkDispatcher() = default;
+
+bool
+OutlinkDispatcher::hasUrls() {
+  std::unique_lock<std::mutex> lock{m_pimpl->m_mutex};
+  m_pimpl->m_extracted.wait(lock, [this]() { return 0 == m_pimpl->m_nrPendingPages; });
+  return !m_pimpl->m_frontier.empty();
+}
+
+UrlBatch
+OutlinkDispatcher::nextBatch() {
+  std::vector<std::string> urls;
+  {
+    std::lock_guard<std::mutex> lock{m_pimpl->m_mutex};
+    urls.swap(m_pimpl->m_frontier);
+  }
+  const size_t depth = m_pimpl->m_nextDepth++;
+  LOG_INFO("dispatching " << urls.size() << " urls of depth " << depth);
+  UrlBatch result{[pimpl = m_pimpl.get(), depth](DownloadResult&& dwResult) {
+    pimpl->onResult(depth, std::move(dwResult));
+  }};
+  result.urls.reserve(urls.size());
+  for(const std::string& url: urls) {
+    result.add(url, m_pimpl->m_nextUrlIndex++);
+  }
+  m_pimpl->m_nrDispatchedUrls += urls.size();
+  return result;
+}
+
+size_t
+OutlinkDispatcher::nrDispatchedUrls() const {
+  return m_pimpl->m_nrDispatchedUrls;
+}
+
+ContentScannerFactory
+OutlinkDispatcher::scannerFactory() const {
+  return [](const MediaType& mediaType) -> std::unique_ptr<ContentScanner> {
+    if("text" == toLower(mediaType.type) && "html" == toLower(mediaType.subtype)) {
+      return std::make_unique<LinkScanner>();
+    }
+    return nullptr;
+  };
+}
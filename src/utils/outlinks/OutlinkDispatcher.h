@@ -0,0 +1,72 @@
+#ifndef UTILS_OUTLINKDISPATCHER_H_K3ZT6YWA
+#define UTILS_OUTLINKDISPATCHER_H_K3ZT6YWA
+
+#include "ContentScanner.h"
+#include "UrlBatch.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Hosts whose links are followed by the OutlinkDispatcher.
+ */
+enum class CrawlScope {
+  SAME_HOST,   // the hosts of the seeds
+  SAME_DOMAIN, // the hosts of the seeds without a leading "www." and their subdomains
+  ALLOW_LIST   // the allowedHosts and their subdomains
+};
+
+struct OutlinkOptions {
+  size_t                   maxDepth{1}; // the seeds have depth 0, the links of pages at maxDepth are not followed
+  size_t                   maxUrls{1000}; // maximum number of dispatched urls, seeds included
+  CrawlScope               scope{CrawlScope::SAME_HOST};
+  std::vector<std::string> allowedHosts{};
+  unsigned                 nrThreads{0}; // threads of the link extraction, see TaskSystem
+};
+
+/**
+ * Dispatcher of a recursive crawl: the links of the downloaded pages are dispatched as the next batch.
+ * Each batch holds the urls of one depth, starting with the seeds. An url is dispatched at most once.
+ * The links of the successful downloads are extracted on the threads of a TaskSystem owned by the dispatcher,
+ * resolved against the page url and canonicalised. Only http and https links inside the scope are followed.
+ * Use hasUrls() as keepCrawling and nextBatch() as dispatcher of the crawler.
+ */
+class OutlinkDispatcher {
+public:
+  /**
+   * @param seeds the urls of the first batch, invalid urls are skipped
+   * @param sink receives the download results of all the batches, it is called from the threads of the
+   *             downloader and of the link extraction
+   */
+  OutlinkDispatcher(const std::vector<std::string>&       seeds,
+                    const OutlinkOptions&                 options,
+                    std::function<void(DownloadResult&&)> sink);
+  ~OutlinkDispatcher();
+
+  /**
+   * Waits for the links of the last batch to be extracted.
+   */
+  bool hasUrls();
+
+  UrlBatch nextBatch();
+
+  /**
+   * @returns the number of urls dispatched so far
+   */
+  size_t nrDispatchedUrls() const;
+
+  /**
+   * @returns the scanners of the downloader, the links of a html page are then scanned while it is received instead
+   *          of after the download
+   */
+  ContentScannerFactory scannerFactory() const;
+
+  struct Pimpl;
+
+private:
+  const std::unique_ptr<Pimpl> m_pimpl;
+};
+
+#endif /* end of include guard: UTILS_OUTLINKDISPATCHER_H_K3ZT6YWA */
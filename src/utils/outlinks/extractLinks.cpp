@@ -0,0 +1,47 @@
+#include "extractLinks.h"
+#include "htmlMarkup.h"
+
+// class LinkScanner
+void
+LinkScanner::scan(const std::string_view html) {
+  m_tokenizer.feed(html, [this, html](const HtmlTag& tag) {
+    if(HtmlTagName::META == tag.name) {
+      if(equalsIgnoreCase(tag.attribute("name"), "robots")
+         && containsIgnoreCase(tag.attribute("content"), "nofollow")) {
+        m_nofollow = true;
+      }
+      return;
+    }
+    for(const HtmlAttribute& attribute: tag.attributes) {
+      // an attribute without value has no position in html
+      const Span value{attribute.value.empty() ? 0 : static_cast<size_t>(attribute.value.data() - html.data()),
+                       attribute.value.size()};
+      const bool isHref = equalsIgnoreCase(attribute.name, "href");
+      if(isHref && HtmlTagName::BASE == tag.name && 0 == m_base.size) {
+        m_base = value;
+      }
+      else if(isHref || equalsIgnoreCase(attribute.name, "src")) {
+        m_links.push_back(value);
+      }
+    }
+  });
+}
+
+void
+LinkScanner::appendLinks(const std::string_view html, HtmlLinks& o_links) const {
+  if(o_links.base.empty()) {
+    o_links.base = html.substr(m_base.pos, m_base.size);
+  }
+  o_links.links.reserve(o_links.links.size() + m_links.size());
+  for(const Span& link: m_links) {
+    o_links.links.push_back(html.substr(link.pos, link.size));
+  }
+  o_links.nofollow = o_links.nofollow || m_nofollow;
+}
+
+void
+extractLinks(const std::string_view html, HtmlLinks& o_links) {
+  LinkScanner scanner;
+  scanner.scan(html);
+  scanner.appendLinks(html, o_links);
+}
@@ -0,0 +1,51 @@
+#ifndef UTILS_EXTRACTLINKS_H_R5WBJ8NE
+#define UTILS_EXTRACTLINKS_H_R5WBJ8NE
+
+#include "ContentScanner.h"
+#include "HtmlTokenizer.h"
+
+#include <string_view>
+#include <vector>
+
+/**
+ * The links of a html page as views into the page, the values are neither resolved nor decoded.
+ */
+struct HtmlLinks {
+  std::string_view              base;  // href of the first <base> tag, empty if there is none
+  std::vector<std::string_view> links; // href and src attribute values of the tags, in document order
+  bool                          nofollow{false}; // set by <meta name="robots" content="nofollow">
+};
+
+/**
+ * Scans a page for its links while it is downloaded, see ContentScanner. The links are kept as offsets because the
+ * page may be moved between the calls of scan().
+ */
+class LinkScanner : public ContentScanner {
+public:
+  void scan(std::string_view html) override;
+
+  /**
+   * @param html the page given to the last scan()
+   * @param o_links the links are appended, views into html
+   */
+  void appendLinks(std::string_view html, HtmlLinks& o_links) const;
+
+private:
+  struct Span {
+    size_t pos;
+    size_t size;
+  };
+
+  HtmlTokenizer     m_tokenizer;
+  Span              m_base{0, 0};
+  std::vector<Span> m_links;
+  bool              m_nofollow{false};
+};
+
+/**
+ * Scans html for the href and src attributes of the tags reported by the HtmlTokenizer.
+ * @param o_links the links are appended, views into html
+ */
+void extractLinks(std::string_view html, HtmlLinks& o_links);
+
+#endif /* end of include guard: UTILS_EXTRACTLINKS_H_R5WBJ8NE */
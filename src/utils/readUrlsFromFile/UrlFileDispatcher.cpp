@@ -0,0 +1,49 @@
+#include "UrlFileDispatcher.h"
+#include "DownloadResult.h"
+
+#include <stdexcept>
+
+UrlFileDispatcher::UrlFileDispatcher(const std::string&                    urlsFilename,
+                                     const size_t                          maxUrls,
+                                     const size_t                          batchSize,
+                                     std::function<void(DownloadResult&&)> sink,
+                                     const int                             firstUrlIndex)
+    : m_reader{urlsFilename, maxUrls}
+    , m_batchSize{batchSize}
+    , m_sink{std::move(sink)}
+    , m_firstUrlIndex{firstUrlIndex}
+    , m_urls{}
+    , m_lines{} {
+  if(0 == m_batchSize) {
+    throw std::logic_error("UrlFileDispatcher received invalid batchSize: 0");
+  }
+}
+
+UrlBatch
+UrlFileDispatcher::nextBatch() {
+  m_urls.clear();
+  m_lines.clear();
+  m_reader.next(m_batchSize, m_urls, &m_lines);
+  UrlBatch result{m_sink};
+  result.urls.reserve(m_urls.size());
+  for(size_t index = 0; index < m_urls.size(); ++index) {
+    const int urlIndex = m_firstUrlIndex + static_cast<int>(m_lines[index]);
+    if(m_urls[index].size() > UrlArena::MAX_URL_LENGTH) {
+      failTooLong(m_urls[index], urlIndex);
+      continue;
+    }
+    result.add(m_urls[index], urlIndex);
+  }
+  return result;
+}
+
+void
+UrlFileDispatcher::failTooLong(const std::string_view url, const int urlIndex) {
+  DownloadResult result;
+  result.url                  = Url{std::string{url}, urlIndex};
+  result.success              = false;
+  result.errorMessage         = "url longer than " + std::to_string(UrlArena::MAX_URL_LENGTH) + " bytes";
+  result.downloadSpeedByteSec = 0;
+  result.transferError        = TransferError::OTHER;
+  m_sink(std::move(result));
+}
@@ -0,0 +1,47 @@
+#ifndef UTILS_URLFILEDISPATCHER_H_C2HVD9SE
+#define UTILS_URLFILEDISPATCHER_H_C2HVD9SE
+
+#include "UrlBatch.h"
+#include "UrlFileReader.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Feeds the crawler with the urls of a file in batches, without reading the whole file into memory.
+ * Use hasUrls() as keepCrawling and nextBatch() as dispatcher of the crawler.
+ * The urlIndex of an url is firstUrlIndex plus its line in the file counting from 0, the skipped empty lines leave
+ * their urlIndex unused.
+ * The urls longer than UrlArena::MAX_URL_LENGTH fail through the sink without a download.
+ */
+class UrlFileDispatcher {
+public:
+  /**
+   * @param maxUrls the maximum number of urls dispatched from the file
+   * @param batchSize the maximum number of urls of a batch
+   * @param sink receives the download results of all the batches
+   */
+  UrlFileDispatcher(const std::string&                    urlsFilename,
+                    size_t                                maxUrls,
+                    size_t                                batchSize,
+                    std::function<void(DownloadResult&&)> sink,
+                    int                                   firstUrlIndex = 0);
+
+  bool hasUrls() const { return !m_reader.finished(); }
+
+  UrlBatch nextBatch();
+
+private:
+  void failTooLong(std::string_view url, int urlIndex);
+
+  UrlFileReader                         m_reader;
+  size_t                                m_batchSize;
+  std::function<void(DownloadResult&&)> m_sink;
+  int                                   m_firstUrlIndex;
+  std::vector<std::string_view>         m_urls;
+  std::vector<size_t>                   m_lines; // the line of each of m_urls
+};
+
+#endif /* end of include guard: UTILS_URLFILEDISPATCHER_H_C2HVD9SE */
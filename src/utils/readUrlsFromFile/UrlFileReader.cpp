@@ -0,0 +1,112 @@
+#include "UrlFileReader.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t RELEASE_GRANULARITY = 16 << 20;
+
+/**
+ * @returns the position of the first '\n' in [in, end) or end
+ */
+const char*
+findNewline(const char* in, const char* const end) {
+#ifdef __SSE2__
+  const __m128i newline = _mm_set1_epi8('\n');
+  for(; end - in >= 16; in += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const int     mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+    if(0 != mask) {
+      return in + __builtin_ctz(mask);
+    }
+  }
+#endif
+  return std::find(in, end, '\n');
+}
+
+} // namespace
+
+UrlFileReader::UrlFileReader(const std::string& urlsFilename, const size_t maxUrls)
+    : m_begin{nullptr}
+    , m_end{nullptr}
+    , m_position{nullptr}
+    , m_released{nullptr}
+    , m_maxUrls{maxUrls}
+    , m_nrUrls{0}
+    , m_nrLines{0} {
+  const int fd = open(urlsFilename.c_str(), O_RDONLY | O_CLOEXEC);
+  if(-1 == fd) {
+    throw std::runtime_error("UrlFileReader could not open file: " + urlsFilename);
+  }
+  struct stat fileStat;
+  if(-1 == fstat(fd, &fileStat)) {
+    close(fd);
+    throw std::runtime_error("UrlFileReader could not stat file: " + urlsFilename);
+  }
+  const auto fileSize = static_cast<size_t>(fileStat.st_size);
+  if(0 != fileSize) {
+    void* const mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(MAP_FAILED == mapping) {
+      close(fd);
+      throw std::runtime_error("UrlFileReader could not map file: " + urlsFilename);
+    }
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    m_begin = static_cast<const char*>(mapping);
+  }
+  // the mapping stays valid after closing the file
+  close(fd);
+  m_end      = m_begin + fileSize;
+  m_position = m_begin;
+  m_released = m_begin;
+}
+
+UrlFileReader::~UrlFileReader() {
+  if(nullptr != m_begin) {
+    munmap(const_cast<char*>(m_begin), m_end - m_begin);
+  }
+}
+
+size_t
+UrlFileReader::next(const size_t maxNrUrls, std::vector<std::string_view>& o_urls, std::vector<size_t>* const o_lines) {
+  releaseReadPages();
+  size_t result = 0;
+  while(result < maxNrUrls && !finished()) {
+    const char* const lineEnd = findNewline(m_position, m_end);
+    const char*       urlEnd  = lineEnd;
+    if(urlEnd != m_position && '\r' == *(urlEnd - 1)) {
+      --urlEnd;
+    }
+    if(urlEnd != m_position) {
+      o_urls.emplace_back(m_position, urlEnd - m_position);
+      if(nullptr != o_lines) {
+        o_lines->push_back(m_nrLines);
+      }
+      ++result;
+      ++m_nrUrls;
+    }
+    ++m_nrLines;
+    m_position = lineEnd == m_end ? m_end : lineEnd + 1;
+  }
+  return result;
+}
+
+void
+UrlFileReader::releaseReadPages() {
+  // The urls returned by the previous call might still be in use, they are read again from the file if needed.
+  if(static_cast<size_t>(m_position - m_released) < RELEASE_GRANULARITY) {
+    return;
+  }
+  const auto   pageSize     = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t releaseBytes = (m_position - m_released) / pageSize * pageSize;
+  madvise(const_cast<char*>(m_released), releaseBytes, MADV_DONTNEED);
+  m_released += releaseBytes;
+}
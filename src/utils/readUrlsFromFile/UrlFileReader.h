@@ -0,0 +1,47 @@
+#ifndef UTILS_URLFILEREADER_H_P4GJ7WQN
+#define UTILS_URLFILEREADER_H_P4GJ7WQN
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Reads the urls of a file, one url per line, through a read only memory mapping of the file.
+ * The urls are returned as views into the mapping without copying them.
+ * Empty lines are skipped and a trailing '\r' is removed.
+ */
+class UrlFileReader {
+public:
+  /**
+   * @param maxUrls the maximum number of urls returned from the file
+   */
+  UrlFileReader(const std::string& urlsFilename, size_t maxUrls);
+  ~UrlFileReader();
+
+  UrlFileReader(const UrlFileReader&) = delete;
+  UrlFileReader& operator=(const UrlFileReader&) = delete;
+
+  /**
+   * Appends the next urls of the file to o_urls.
+   * The views stay valid for the lifetime of the reader.
+   * The pages of the file before the returned urls are released from memory.
+   * @param o_lines receives the line of each appended url counting from 0, empty lines included, unless nullptr
+   * @returns the number of appended urls, less than maxNrUrls only at the end of the file
+   */
+  size_t next(size_t maxNrUrls, std::vector<std::string_view>& o_urls, std::vector<size_t>* o_lines = nullptr);
+
+  bool finished() const { return m_nrUrls == m_maxUrls || m_position == m_end; }
+
+private:
+  void releaseReadPages();
+
+  const char* m_begin;
+  const char* m_end;
+  const char* m_position;
+  const char* m_released;
+  size_t      m_maxUrls;
+  size_t      m_nrUrls;
+  size_t      m_nrLines;
+};
+
+#endif /* end of include guard: UTILS_URLFILEREADER_H_P4GJ7WQN */
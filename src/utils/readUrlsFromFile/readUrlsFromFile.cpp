@@ -1,19 +1,12 @@
 #include "readUrlsFromFile.h"
-#include <fstream>
+#include "UrlFileReader.h"
+
+#include <string_view>
 
 std::vector<std::string>
 readUrlsFromFile(const std::string& urlsFilename, const size_t maxUrls) {
-  std::ifstream urlsFin;
-  urlsFin.open(urlsFilename);
-  if(!urlsFin.is_open()) {
-    throw std::runtime_error("readUrlsFromFile could not open file: " + urlsFilename);
-  }
-
-  std::vector<std::string> result;
-  std::string              tempString;
-  while(result.size() < maxUrls && std::getline(urlsFin, tempString)) {
-    result.push_back(tempString);
-  }
-
-  return result;
+  UrlFileReader                 reader{urlsFilename, maxUrls};
+  std::vector<std::string_view> urls;
+  reader.next(maxUrls, urls);
+  return std::vector<std::string>(urls.begin(), urls.end());
 }
@@ -0,0 +1,364 @@
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+constexpr size_t MAX_SORTED_QUERY_PARAMETERS = 32;
+
+inline char
+toLower(const char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline bool
+isAlpha(const char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool
+isDigit(const char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline bool
+isSchemeChar(const char c) {
+  return isAlpha(c) || isDigit(c) || c == '+' || c == '-' || c == '.';
+}
+
+inline bool
+isUnreserved(const char c) {
+  return isAlpha(c) || isDigit(c) || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+// control characters, space and non ASCII bytes are not allowed anywhere in the url
+inline bool
+isForbidden(const char c) {
+  const auto u = static_cast<unsigned char>(c);
+  return u <= 0x20 || u >= 0x7f;
+}
+
+inline int
+hexValue(const char c) {
+  if(isDigit(c)) {
+    return c - '0';
+  }
+  const char lower = toLower(c);
+  if(lower >= 'a' && lower <= 'f') {
+    return lower - 'a' + 10;
+  }
+  return -1;
+}
+
+inline char
+toUpperHex(const char c) {
+  return (c >= 'a' && c <= 'f') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+enum class AuthorityChar : unsigned char { FORBIDDEN, HOST, END, COLON, AT, IP_LITERAL_START, IP_LITERAL_END };
+
+struct CharTables {
+  // characters of the path and of the query which are copied to the output unchanged
+  bool          plainInPath[256];
+  bool          plainInQuery[256];
+  AuthorityChar authority[256];
+};
+
+constexpr CharTables
+makeCharTables() {
+  CharTables tables{};
+  for(int c = 0x21; c < 0x7f; ++c) {
+    tables.plainInQuery[c] = c != '%' && c != '#';
+    tables.plainInPath[c]  = tables.plainInQuery[c] && c != '/' && c != '?';
+    switch(c) {
+      // clang-format off
+      case '/': case '?': case '#': tables.authority[c] = AuthorityChar::END;              break;
+      case ':':                     tables.authority[c] = AuthorityChar::COLON;            break;
+      case '@':                     tables.authority[c] = AuthorityChar::AT;               break;
+      case '[':                     tables.authority[c] = AuthorityChar::IP_LITERAL_START; break;
+      case ']':                     tables.authority[c] = AuthorityChar::IP_LITERAL_END;   break;
+      default:                      tables.authority[c] = AuthorityChar::HOST;             break;
+        // clang-format on
+    }
+  }
+  return tables;
+}
+
+constexpr CharTables CHAR_TABLES = makeCharTables();
+
+/**
+ * Copies the longest run of characters starting at in which need no normalisation.
+ * @returns the end of the copied run
+ */
+inline const char*
+copyPlain(const char* const in, const char* const inEnd, const bool (&plain)[256], char* const out, size_t& o_written) {
+  const char* runEnd = in;
+  while(runEnd != inEnd && plain[static_cast<unsigned char>(*runEnd)]) {
+    ++runEnd;
+  }
+  std::copy(in, runEnd, out + o_written);
+  o_written += runEnd - in;
+  return runEnd;
+}
+
+/**
+ * Copies one character of a path or a query, normalising percent-encoding.
+ * @returns the number of input characters consumed, 0 on invalid input
+ */
+inline size_t
+copyNormalized(const char* const in, const char* const inEnd, char* const out, size_t& o_written) {
+  if(isForbidden(*in)) {
+    return 0;
+  }
+  if('%' != *in || inEnd - in < 3 || hexValue(in[1]) < 0 || hexValue(in[2]) < 0) {
+    // a stray '%' is kept as it is
+    out[o_written++] = *in;
+    return 1;
+  }
+  const char decoded = static_cast<char>(hexValue(in[1]) * 16 + hexValue(in[2]));
+  if(isUnreserved(decoded)) {
+    out[o_written++] = decoded;
+  }
+  else {
+    out[o_written++] = '%';
+    out[o_written++] = toUpperHex(in[1]);
+    out[o_written++] = toUpperHex(in[2]);
+  }
+  return 3;
+}
+
+inline bool
+isDefaultPort(const std::string_view scheme, const std::string_view port) {
+  return (scheme == "http" && port == "80") || (scheme == "https" && port == "443");
+}
+
+/**
+ * Called at the end of each path segment [segmentStart, written).
+ * Removes "." and ".." segments as described in RFC 3986 section 5.2.4.
+ * @returns true if the segment was removed, the output then ends with '/'
+ */
+inline bool
+closeSegment(const char* const out, const size_t pathStart, const size_t segmentStart, size_t& o_written) {
+  const size_t length = o_written - segmentStart;
+  if(1 == length && '.' == out[segmentStart]) {
+    o_written = segmentStart;
+    return true;
+  }
+  if(2 == length && '.' == out[segmentStart] && '.' == out[segmentStart + 1]) {
+    // drop the previous segment but keep its leading '/'
+    size_t previousSlash = segmentStart - 1;
+    while(previousSlash > pathStart && '/' != out[previousSlash - 1]) {
+      --previousSlash;
+    }
+    o_written = std::max(previousSlash, pathStart + 1);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Sorts the '&' separated parameters of the query in place by swapping neighbouring parameters.
+ * Queries with more than MAX_SORTED_QUERY_PARAMETERS parameters are left unchanged.
+ */
+void
+sortQuery(char* const query, const size_t queryLength) {
+  std::array<size_t, MAX_SORTED_QUERY_PARAMETERS> starts;
+  std::array<size_t, MAX_SORTED_QUERY_PARAMETERS> lengths;
+  size_t                                          nrParameters = 0;
+  size_t                                          start        = 0;
+  for(size_t pos = 0; pos <= queryLength; ++pos) {
+    if(pos == queryLength || '&' == query[pos]) {
+      if(nrParameters == starts.size()) {
+        return;
+      }
+      starts[nrParameters]  = start;
+      lengths[nrParameters] = pos - start;
+      ++nrParameters;
+      start = pos + 1;
+    }
+  }
+
+  for(size_t index = 1; index < nrParameters; ++index) {
+    for(size_t crt = index; crt > 0; --crt) {
+      char* const first  = query + starts[crt - 1];
+      char* const second = query + starts[crt];
+      if(std::string_view{first, lengths[crt - 1]} <= std::string_view{second, lengths[crt]}) {
+        break;
+      }
+      // "first&second" -> "second&first"
+      char* const secondEnd = second + lengths[crt];
+      std::reverse(first, first + lengths[crt - 1]);
+      std::reverse(second, secondEnd);
+      std::reverse(first, secondEnd);
+      std::swap(lengths[crt - 1], lengths[crt]);
+      starts[crt] = starts[crt - 1] + lengths[crt - 1] + 1;
+    }
+  }
+}
+
+} // namespace
+
+size_t
+canonicalizeUrl(const std::string_view url,
+                char* const            buffer,
+                const size_t           bufferSize,
+                UrlParts* const        o_parts,
+                const bool             sortQueryParameters) {
+  if(bufferSize < url.size() + 1) {
+    return 0;
+  }
+  const char* in  = url.data();
+  const char* end = url.data() + url.size();
+  size_t      written{0};
+
+  // scheme
+  if(in == end || !isAlpha(*in)) {
+    return 0;
+  }
+  while(in != end && isSchemeChar(*in)) {
+    buffer[written++] = toLower(*in++);
+  }
+  const std::string_view scheme{buffer, written};
+  if(end - in < 3 || ':' != in[0] || '/' != in[1] || '/' != in[2]) {
+    return 0;
+  }
+  buffer[written++] = ':';
+  buffer[written++] = '/';
+  buffer[written++] = '/';
+  in += 3;
+
+  // authority: [userinfo@]host[:port], lowercased while scanning, userinfo is copied unchanged
+  const char* const authorityIn    = in;
+  const size_t      authorityStart = written;
+  size_t            hostStart      = written;
+  size_t            portSeparator  = 0; // the scheme precedes the authority, so 0 means no port
+  bool              inIpLiteral    = false;
+  for(bool authorityEnd = false; !authorityEnd && in != end;) {
+    switch(CHAR_TABLES.authority[static_cast<unsigned char>(*in)]) {
+      case AuthorityChar::HOST:
+        buffer[written++] = toLower(*in++);
+        break;
+      case AuthorityChar::END:
+        authorityEnd = true;
+        break;
+      case AuthorityChar::COLON:
+        if(!inIpLiteral) {
+          if(0 != portSeparator) {
+            return 0;
+          }
+          portSeparator = written;
+        }
+        buffer[written++] = *in++;
+        break;
+      case AuthorityChar::AT:
+        ++in;
+        written       = std::copy(authorityIn, in, buffer + authorityStart) - buffer;
+        hostStart     = written;
+        portSeparator = 0;
+        break;
+      case AuthorityChar::IP_LITERAL_START:
+      case AuthorityChar::IP_LITERAL_END:
+        inIpLiteral       = '[' == *in;
+        buffer[written++] = *in++;
+        break;
+      case AuthorityChar::FORBIDDEN:
+        return 0;
+    }
+  }
+  if(inIpLiteral) {
+    return 0;
+  }
+  size_t hostEnd = 0 == portSeparator ? written : portSeparator;
+  if(hostEnd != hostStart && '.' == buffer[hostEnd - 1]) {
+    // "example.com." and "example.com" denote the same host
+    written = std::copy(buffer + hostEnd, buffer + written, buffer + hostEnd - 1) - buffer;
+    portSeparator -= 0 == portSeparator ? 0 : 1;
+    --hostEnd;
+  }
+  const std::string_view host{buffer + hostStart, hostEnd - hostStart};
+  if(host.empty()) {
+    return 0;
+  }
+
+  std::string_view port;
+  if(0 != portSeparator) {
+    size_t digitsStart = portSeparator + 1;
+    while(written - digitsStart > 1 && '0' == buffer[digitsStart]) {
+      ++digitsStart;
+    }
+    const std::string_view inputPort{buffer + digitsStart, written - digitsStart};
+    if(!std::all_of(inputPort.begin(), inputPort.end(), isDigit)) {
+      return 0;
+    }
+    if(inputPort.empty() || isDefaultPort(scheme, inputPort)) {
+      written = portSeparator;
+    }
+    else {
+      written = std::copy(inputPort.begin(), inputPort.end(), buffer + portSeparator + 1) - buffer;
+      port    = std::string_view{buffer + portSeparator + 1, inputPort.size()};
+    }
+  }
+
+  // path
+  const size_t pathStart = written;
+  buffer[written++]      = '/';
+  if(in != end && '/' == *in) {
+    ++in;
+  }
+  size_t segmentStart = written;
+  while(true) {
+    in = copyPlain(in, end, CHAR_TABLES.plainInPath, buffer, written);
+    if(in == end || '?' == *in || '#' == *in) {
+      break;
+    }
+    if('/' == *in) {
+      ++in;
+      if(!closeSegment(buffer, pathStart, segmentStart, written)) {
+        buffer[written++] = '/';
+      }
+      segmentStart = written;
+      continue;
+    }
+    const size_t consumed = copyNormalized(in, end, buffer, written);
+    if(0 == consumed) {
+      return 0;
+    }
+    in += consumed;
+  }
+  closeSegment(buffer, pathStart, segmentStart, written);
+  const std::string_view path{buffer + pathStart, written - pathStart};
+
+  // query
+  std::string_view query;
+  if(in != end && '?' == *in) {
+    ++in;
+    buffer[written++]       = '?';
+    const size_t queryStart = written;
+    while(true) {
+      in = copyPlain(in, end, CHAR_TABLES.plainInQuery, buffer, written);
+      if(in == end || '#' == *in) {
+        break;
+      }
+      const size_t consumed = copyNormalized(in, end, buffer, written);
+      if(0 == consumed) {
+        return 0;
+      }
+      in += consumed;
+    }
+    if(sortQueryParameters) {
+      sortQuery(buffer + queryStart, written - queryStart);
+    }
+    query = std::string_view{buffer + queryStart, written - queryStart};
+  }
+
+  // the fragment is dropped, but it still has to be a valid one
+  if(std::any_of(in, end, isForbidden)) {
+    return 0;
+  }
+
+  if(nullptr != o_parts) {
+    *o_parts = UrlParts{scheme, host, port, path, query};
+  }
+  return written;
+}
@@ -4,8 +4,89 @@
 #include <uriparser/Uri.h>
 
 #include <string>
+#include <string_view>
 
 bool        isValid(const UriUriA& uri);
 std::string toString(const UriUriA& uri);
 
+/**
+ * Components of a URL, all pointing into the buffer the URL was written to.
+ * Empty views denote missing components.
+ */
+struct UrlParts {
+  std::string_view scheme;
+  std::string_view host;
+  std::string_view port;
+  std::string_view path;
+  std::string_view query;
+};
+
+/**
+ * Canonicalises an absolute URL of the form scheme://authority[/path][?query][#fragment]
+ * in a single pass and writes the result into the caller provided buffer:
+ *  - scheme and host are lowercased, a trailing dot of the host is removed
+ *  - default ports (http:80, https:443) and empty ports are removed
+ *  - an empty path becomes "/", dot segments are removed
+ *  - percent-encoded unreserved characters are decoded, all other escapes use uppercase hex digits
+ *  - the fragment is removed
+ *  - optionally the query parameters are sorted
+ * No memory is allocated and the result is not null terminated.
+ * @param buffer must hold at least url.size() + 1 bytes, the canonical url is never longer
+ * @param o_parts if not null receives the components of the canonical url, pointing into buffer
+ * @returns the length of the canonical url or 0 if url could not be canonicalised
+ */
+size_t canonicalizeUrl(std::string_view url,
+                       char*            buffer,
+                       size_t           bufferSize,
+                       UrlParts*        o_parts             = nullptr,
+                       bool             sortQueryParameters = false);
+
+/**
+ * Fast path for the common case of clean absolute http(s) URLs.
+ * Only URLs which are valid according to isValid() and already in canonical form (see canonicalizeUrl)
+ * are accepted: lowercase "http" or "https" scheme, a lowercase host name, no port, no user info,
+ * a non empty path without dot segments, no percent-encoding and no fragment.
+ * @param o_parts receives the components of url, pointing into url
+ * @returns false if url has to be checked with the full parser
+ */
+bool splitCleanHttpUrl(std::string_view url, UrlParts& o_parts);
+
+/**
+ * Splits url for its origin, the key of the state kept per host or per origin. Clean urls are split by
+ * splitCleanHttpUrl, the others are canonicalised (see canonicalizeUrl): the scheme and the host are lowercase, the
+ * user info is dropped, an IPv6 host keeps its brackets and a default port is empty.
+ * @param o_buffer receives the canonical url of an url which is not clean, o_parts then point into it
+ * @param o_parts receives the components of url
+ * @returns false if url could not be canonicalised
+ */
+bool splitOrigin(std::string_view url, std::string& o_buffer, UrlParts& o_parts);
+
+/**
+ * @returns the host of url as split by splitOrigin, empty if url could not be canonicalised
+ */
+std::string hostOf(std::string_view url);
+
+/**
+ * @returns scheme://host[:port] of url as split by splitOrigin, empty if url could not be canonicalised
+ */
+std::string originOf(std::string_view url);
+
+/**
+ * Resolves a reference found in a page against the url of the page as described in RFC 3986 section 5.2.
+ * Surrounding whitespace of the reference is ignored. The result is not canonical, dot segments are only
+ * removed by canonicalizeUrl.
+ * @param baseUrl absolute url of the form scheme://authority[/path][?query][#fragment]
+ * @param o_url receives the absolute url
+ * @returns false if baseUrl is not absolute, o_url is then unchanged
+ */
+bool resolveUrl(std::string_view baseUrl, std::string_view reference, std::string& o_url);
+
+/**
+ * Finds the domain registered by the owner of a lowercase host, e.g. "example.co.uk" for "www.a.example.co.uk".
+ * The public suffixes are the top level domains and an embedded subset of the multi label suffixes of the Public
+ * Suffix List, thus subdomains of unknown multi label suffixes are grouped under the second level domain.
+ * @returns a view into host, host itself for IP addresses and hosts without a registered domain
+ */
+std::string_view registeredDomain(std::string_view host);
+
 #endif /* end of include guard: ADDURLSTODB_URIUTILS_H_HWCU1DIZ */
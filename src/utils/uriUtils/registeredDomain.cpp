@@ -0,0 +1,62 @@
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+/**
+ * Public suffixes of more than one label from the ICANN section of the Public Suffix List, for the country code
+ * domains with most registrations below second level domains. Sorted for the binary search.
+ */
+constexpr std::string_view MULTI_LABEL_SUFFIXES[] = {
+    "ac.at",     "ac.cn",     "ac.id",     "ac.il",     "ac.in",     "ac.jp",     "ac.kr",     "ac.nz",
+    "ac.th",     "ac.uk",     "ac.za",     "ad.jp",     "asn.au",    "co.at",     "co.id",     "co.il",
+    "co.in",     "co.jp",     "co.ke",     "co.kr",     "co.nz",     "co.th",     "co.uk",     "co.za",
+    "com.ar",    "com.au",    "com.br",    "com.cn",    "com.co",    "com.eg",    "com.es",    "com.hk",
+    "com.mx",    "com.my",    "com.ng",    "com.pe",    "com.ph",    "com.pk",    "com.pl",    "com.sa",
+    "com.sg",    "com.tr",    "com.tw",    "com.ua",    "com.vn",    "ed.jp",     "edu.au",    "edu.br",
+    "edu.cn",    "edu.hk",    "edu.in",    "edu.mx",    "edu.sg",    "edu.tr",    "edu.tw",    "firm.in",
+    "gen.in",    "go.id",     "go.jp",     "go.kr",     "go.th",     "gob.es",    "gob.mx",    "gov.au",
+    "gov.br",    "gov.cn",    "gov.hk",    "gov.il",    "gov.in",    "gov.sg",    "gov.tr",    "gov.tw",
+    "gov.uk",    "gov.za",    "govt.nz",   "gr.jp",     "gv.at",     "idv.tw",    "in.th",     "ind.in",
+    "lg.jp",     "ltd.uk",    "me.uk",     "muni.il",   "ne.jp",     "ne.kr",     "net.ar",    "net.au",
+    "net.br",    "net.cn",    "net.hk",    "net.id",    "net.il",    "net.in",    "net.mx",    "net.my",
+    "net.nz",    "net.pl",    "net.sg",    "net.tr",    "net.tw",    "net.uk",    "net.za",    "nhs.uk",
+    "nom.es",    "or.at",     "or.id",     "or.jp",     "or.kr",     "or.th",     "org.ar",    "org.au",
+    "org.br",    "org.cn",    "org.es",    "org.hk",    "org.il",    "org.in",    "org.mx",    "org.my",
+    "org.nz",    "org.pl",    "org.sg",    "org.tr",    "org.tw",    "org.uk",    "org.za",    "plc.uk",
+    "police.uk", "re.kr",     "res.in",    "sch.uk",    "school.nz", "web.id",    "web.za"};
+
+bool
+isMultiLabelSuffix(const std::string_view suffix) {
+  return std::binary_search(std::begin(MULTI_LABEL_SUFFIXES), std::end(MULTI_LABEL_SUFFIXES), suffix);
+}
+
+bool
+isIpAddress(const std::string_view host) {
+  return host.empty() || '[' == host.front() || std::string_view::npos == host.find_first_not_of("0123456789.");
+}
+
+} // namespace
+
+std::string_view
+registeredDomain(const std::string_view host) {
+  if(isIpAddress(host)) {
+    return host;
+  }
+  // the labels of host from the right: domain, suffix, topLevel
+  const size_t topLevel = host.rfind('.');
+  if(std::string_view::npos == topLevel || 0 == topLevel) {
+    return host;
+  }
+  const size_t suffix = host.rfind('.', topLevel - 1);
+  if(std::string_view::npos == suffix) {
+    return host;
+  }
+  if(!isMultiLabelSuffix(host.substr(suffix + 1))) {
+    return host.substr(suffix + 1);
+  }
+  const size_t domain = 0 == suffix ? std::string_view::npos : host.rfind('.', suffix - 1);
+  return std::string_view::npos == domain ? host : host.substr(domain + 1);
+}
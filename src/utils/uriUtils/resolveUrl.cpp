@@ -0,0 +1,99 @@
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr std::string_view URI_PROTOCOL_HOST_DELIMITER{"://"};
+
+inline bool
+isSpace(const char c) {
+  return static_cast<unsigned char>(c) <= 0x20;
+}
+
+inline bool
+isAlpha(const char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool
+isSchemeChar(const char c) {
+  return isAlpha(c) || (c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.';
+}
+
+std::string_view
+trim(std::string_view value) {
+  while(!value.empty() && isSpace(value.front())) {
+    value.remove_prefix(1);
+  }
+  while(!value.empty() && isSpace(value.back())) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+/**
+ * @returns true if reference starts with a scheme followed by ':'
+ */
+bool
+hasScheme(const std::string_view reference) {
+  if(reference.empty() || !isAlpha(reference.front())) {
+    return false;
+  }
+  size_t pos = 1;
+  while(pos < reference.size() && isSchemeChar(reference[pos])) {
+    ++pos;
+  }
+  return pos < reference.size() && ':' == reference[pos];
+}
+
+void
+assign(std::string& o_url, const std::string_view prefix, const std::string_view suffix) {
+  o_url.reserve(prefix.size() + suffix.size());
+  o_url.assign(prefix.data(), prefix.size());
+  o_url.append(suffix.data(), suffix.size());
+}
+
+} // namespace
+
+bool
+resolveUrl(const std::string_view baseUrl, std::string_view reference, std::string& o_url) {
+  const size_t schemeEnd = baseUrl.find(URI_PROTOCOL_HOST_DELIMITER);
+  if(std::string_view::npos == schemeEnd || 0 == schemeEnd) {
+    return false;
+  }
+  const size_t authorityEnd = std::min(baseUrl.find_first_of("/?#", schemeEnd + URI_PROTOCOL_HOST_DELIMITER.size()),
+                                       baseUrl.size());
+  const size_t pathEnd      = std::min(baseUrl.find_first_of("?#", authorityEnd), baseUrl.size());
+  const size_t queryEnd     = std::min(baseUrl.find('#', pathEnd), baseUrl.size());
+
+  reference = trim(reference);
+  if(hasScheme(reference)) {
+    o_url.assign(reference.data(), reference.size());
+  }
+  else if(0 == reference.compare(0, 2, "//")) {
+    // network-path reference, keeps the scheme only
+    assign(o_url, baseUrl.substr(0, schemeEnd + 1), reference);
+  }
+  else if(!reference.empty() && '/' == reference.front()) {
+    assign(o_url, baseUrl.substr(0, authorityEnd), reference);
+  }
+  else if(reference.empty() || '#' == reference.front()) {
+    assign(o_url, baseUrl.substr(0, queryEnd), reference);
+  }
+  else if('?' == reference.front()) {
+    assign(o_url, baseUrl.substr(0, pathEnd), reference);
+  }
+  else if(authorityEnd == pathEnd) {
+    // the base has an empty path
+    o_url.assign(baseUrl.data(), authorityEnd);
+    o_url += '/';
+    o_url.append(reference.data(), reference.size());
+  }
+  else {
+    // merge with the path of the base up to its last segment
+    const size_t lastSlash = baseUrl.rfind('/', pathEnd - 1);
+    assign(o_url, baseUrl.substr(0, lastSlash + 1), reference);
+  }
+  return true;
+}
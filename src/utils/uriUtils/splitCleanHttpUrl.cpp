@@ -0,0 +1,125 @@
+#include "uriUtils/uriUtils.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr char EXCLUDED_CHARS[] = {'"', '#', '%', '<', '>', '\\', '^', '`', '{', '|', '}'};
+
+struct CleanCharTables {
+  bool host[256];
+  bool pathAndQuery[256];
+};
+
+constexpr CleanCharTables
+makeCleanCharTables() {
+  CleanCharTables tables{};
+  for(int c = 'a'; c <= 'z'; ++c) {
+    tables.host[c] = true;
+  }
+  for(int c = '0'; c <= '9'; ++c) {
+    tables.host[c] = true;
+  }
+  tables.host[static_cast<int>('-')] = true;
+  tables.host[static_cast<int>('.')] = true;
+
+  for(int c = 0x21; c < 0x7f; ++c) {
+    tables.pathAndQuery[c] = true;
+  }
+  for(const char c: EXCLUDED_CHARS) {
+    tables.pathAndQuery[static_cast<int>(c)] = false;
+  }
+  return tables;
+}
+
+constexpr CleanCharTables CLEAN_CHARS = makeCleanCharTables();
+
+/**
+ * Checks that all characters are allowed and that there is no "/." which could start a dot segment.
+ * Processes 16 bytes at a time when SSE2 is available.
+ */
+bool
+isCleanPathAndQuery(const char* in, const char* const end) {
+  bool previousSlash = false;
+#ifdef __SSE2__
+  const __m128i minAllowed = _mm_set1_epi8(0x21);
+  const __m128i del        = _mm_set1_epi8(0x7f);
+  const __m128i slash      = _mm_set1_epi8('/');
+  const __m128i dot        = _mm_set1_epi8('.');
+  for(; end - in >= 16; in += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    // signed comparison, bytes >= 0x80 are negative and thus also rejected
+    __m128i rejected = _mm_or_si128(_mm_cmplt_epi8(block, minAllowed), _mm_cmpeq_epi8(block, del));
+    for(const char c: EXCLUDED_CHARS) {
+      rejected = _mm_or_si128(rejected, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+    }
+    if(0 != _mm_movemask_epi8(rejected)) {
+      return false;
+    }
+    const int slashes = _mm_movemask_epi8(_mm_cmpeq_epi8(block, slash));
+    const int dots    = _mm_movemask_epi8(_mm_cmpeq_epi8(block, dot));
+    if(0 != (((slashes << 1) | static_cast<int>(previousSlash)) & dots)) {
+      return false;
+    }
+    previousSlash = 0 != (slashes & 0x8000);
+  }
+#endif
+  for(; in != end; ++in) {
+    if(!CLEAN_CHARS.pathAndQuery[static_cast<unsigned char>(*in)] || (previousSlash && '.' == *in)) {
+      return false;
+    }
+    previousSlash = '/' == *in;
+  }
+  return true;
+}
+
+} // namespace
+
+bool
+splitCleanHttpUrl(const std::string_view url, UrlParts& o_parts) {
+  static constexpr std::string_view HTTP{"http://"};
+  static constexpr std::string_view HTTPS{"https://"};
+
+  size_t schemeLength = 0;
+  if(0 == url.compare(0, HTTP.size(), HTTP)) {
+    schemeLength = HTTP.size() - 3;
+  }
+  else if(0 == url.compare(0, HTTPS.size(), HTTPS)) {
+    schemeLength = HTTPS.size() - 3;
+  }
+  else {
+    return false;
+  }
+
+  const char* const hostStart = url.data() + schemeLength + 3;
+  const char* const end       = url.data() + url.size();
+  const char*       hostEnd   = hostStart;
+  bool              onlyDigitsAndDots{true};
+  while(hostEnd != end && CLEAN_CHARS.host[static_cast<unsigned char>(*hostEnd)]) {
+    onlyDigitsAndDots = onlyDigitsAndDots && ('.' == *hostEnd || ('0' <= *hostEnd && *hostEnd <= '9'));
+    ++hostEnd;
+  }
+  // anything else after the host (port, user info, ...) or a missing path is left to the full parser
+  if(hostEnd == hostStart || hostEnd == end || '/' != *hostEnd || '.' == *(hostEnd - 1) || onlyDigitsAndDots) {
+    return false;
+  }
+
+  if(!isCleanPathAndQuery(hostEnd, end)) {
+    return false;
+  }
+
+  const char* const queryStart = std::find(hostEnd, end, '?');
+  o_parts.scheme               = url.substr(0, schemeLength);
+  o_parts.host                 = std::string_view{hostStart, static_cast<size_t>(hostEnd - hostStart)};
+  o_parts.port                 = std::string_view{};
+  o_parts.path                 = std::string_view{hostEnd, static_cast<size_t>(queryStart - hostEnd)};
+  o_parts.query                = std::string_view{};
+  if(queryStart != end) {
+    o_parts.query = std::string_view{queryStart + 1, static_cast<size_t>(end - queryStart - 1)};
+  }
+  return true;
+}
@@ -0,0 +1,36 @@
+#include "uriUtils/uriUtils.h"
+
+bool
+splitOrigin(const std::string_view url, std::string& o_buffer, UrlParts& o_parts) {
+  if(splitCleanHttpUrl(url, o_parts)) {
+    return true;
+  }
+  o_buffer.resize(url.size() + 1);
+  const size_t size = canonicalizeUrl(url, &o_buffer[0], o_buffer.size(), &o_parts);
+  // shrinking keeps the buffer, thus the parts stay valid
+  o_buffer.resize(size);
+  return 0 != size;
+}
+
+std::string
+hostOf(const std::string_view url) {
+  std::string buffer;
+  UrlParts    parts;
+  return splitOrigin(url, buffer, parts) ? std::string{parts.host} : std::string{};
+}
+
+std::string
+originOf(const std::string_view url) {
+  std::string buffer;
+  UrlParts    parts;
+  if(!splitOrigin(url, buffer, parts)) {
+    return std::string{};
+  }
+  std::string result;
+  result.reserve(parts.scheme.size() + 3 + parts.host.size() + 1 + parts.port.size());
+  result.append(parts.scheme).append("://").append(parts.host);
+  if(!parts.port.empty()) {
+    result.append(1, ':').append(parts.port);
+  }
+  return result;
+}
@@ -3,13 +3,18 @@ LOG_INIT(addUrlsToDbIsValid);
 
 #include "uriUtils/uriUtils.h"
 
-#include <regex>
+#include <string_view>
 
 namespace {
 inline bool
 hasValidScheme(const UriUriA& uri) {
-  static const std::regex schemaExpr("https?", std::regex_constants::ECMAScript | std::regex_constants::icase);
-  return std::regex_match(uri.scheme.first, uri.scheme.afterLast, schemaExpr);
+  const std::string_view scheme{uri.scheme.first, static_cast<size_t>(uri.scheme.afterLast - uri.scheme.first)};
+  const auto             isSchemeChar = [&scheme](const size_t pos, const char lower) {
+    return scheme[pos] == lower || scheme[pos] == lower - 'a' + 'A';
+  };
+  // case insensitive match of "https?"
+  return (4 == scheme.size() || (5 == scheme.size() && isSchemeChar(4, 's'))) && isSchemeChar(0, 'h')
+         && isSchemeChar(1, 't') && isSchemeChar(2, 't') && isSchemeChar(3, 'p');
 }
 
 inline bool
@@ -43,15 +48,22 @@ hasNoPort(const UriUriA& uri) {
 
 std::string
 toString(const UriUriA& uri) {
-  static const size_t MAX_URL_LENGTH = 8000;
-
-  std::string result(MAX_URL_LENGTH, '\0');
+  int charsRequired{0};
+  int callResult = uriToStringCharsRequiredA(&uri, &charsRequired);
+  if(URI_SUCCESS != callResult) {
+    LOG_ERROR("calculating the length of the url string failed error:" << callResult);
+    return std::string{};
+  }
 
-  int callResult = uriToStringA(&result[0], &uri, result.length() + 1, NULL);
+  std::string result(charsRequired + 1, '\0');
+  int         charsWritten{0};
+  callResult = uriToStringA(&result[0], &uri, charsRequired + 1, &charsWritten);
   if(URI_SUCCESS != callResult) {
     LOG_ERROR("convestion of url to string failed error:" << callResult);
     return std::string{};
   }
+  // charsWritten includes the terminating null character
+  result.resize(charsWritten - 1);
   return result;
 }
 
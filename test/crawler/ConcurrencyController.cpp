@@ -0,0 +1,117 @@
+#include "ConcurrencyController.h"
+#include "DownloadResult.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct ConcurrencyControllerFixture : public ::testing::Test {
+  ConcurrencyControllerFixture() : Test{}, options{}, now{} {
+    options.minActiveDownloads = 4;
+    options.maxActiveDownloads = 30;
+    options.increaseStep       = 4;
+    options.decreaseFactor     = .5;
+    options.interval           = 1s;
+  }
+
+  void finish(ConcurrencyController& controller, const size_t nrDownloads, const TransferError error) {
+    for(size_t download = 0; download < nrDownloads; ++download) {
+      DownloadResult result;
+      result.success       = TransferError::NONE == error;
+      result.transferError = error;
+      controller.onFinished(result);
+    }
+  }
+
+  /**
+   * Passes one interval in which the limit was reached and nrSucceeded downloads succeeded.
+   */
+  size_t limitedInterval(ConcurrencyController& controller, const size_t nrSucceeded) {
+    controller.onLimitReached();
+    finish(controller, nrSucceeded, TransferError::NONE);
+    now += options.interval;
+    EXPECT_TRUE(controller.due(now));
+    return controller.update(now, 0us);
+  }
+
+  AdaptiveConcurrencyOptions options;
+  SteadyTime                 now;
+};
+
+} // namespace
+
+TEST_F(ConcurrencyControllerFixture, increasesWhileTheLimitIsReached) {
+  ConcurrencyController controller{options, 10, now};
+  EXPECT_EQ(10u, controller.limit());
+  EXPECT_FALSE(controller.due(now + 999ms));
+  EXPECT_EQ(14u, limitedInterval(controller, 100));
+  EXPECT_EQ(18u, limitedInterval(controller, 100));
+
+  finish(controller, 100, TransferError::NONE);
+  now += options.interval;
+  EXPECT_EQ(18u, controller.update(now, 0us));
+}
+
+TEST_F(ConcurrencyControllerFixture, staysWithinTheLimits) {
+  ConcurrencyController controller{options, 100, now};
+  EXPECT_EQ(30u, controller.limit());
+  EXPECT_EQ(30u, limitedInterval(controller, 100));
+
+  EXPECT_EQ(4u, ConcurrencyController(options, 1, now).limit());
+}
+
+TEST_F(ConcurrencyControllerFixture, decreasesOnCongestionErrors) {
+  ConcurrencyController controller{options, 20, now};
+  controller.onLimitReached();
+  finish(controller, 18, TransferError::NONE);
+  finish(controller, 10, TransferError::DNS); // not caused by the crawler
+  finish(controller, 2, TransferError::TIMEOUT);
+  now += options.interval;
+  EXPECT_EQ(24u, controller.update(now, 0us));
+
+  controller.onLimitReached();
+  finish(controller, 16, TransferError::NONE);
+  finish(controller, 2, TransferError::TIMEOUT);
+  finish(controller, 2, TransferError::CONNECT);
+  now += options.interval;
+  EXPECT_EQ(12u, controller.update(now, 0us));
+}
+
+TEST_F(ConcurrencyControllerFixture, fewDownloadsGiveNoErrorRate) {
+  ConcurrencyController controller{options, 20, now};
+  controller.onLimitReached();
+  finish(controller, 5, TransferError::TIMEOUT);
+  now += options.interval;
+  EXPECT_EQ(24u, controller.update(now, 0us));
+}
+
+TEST_F(ConcurrencyControllerFixture, decreasesOnEventLoopLag) {
+  ConcurrencyController controller{options, 20, now};
+  controller.onLimitReached();
+  now += options.interval;
+  EXPECT_EQ(10u, controller.update(now, 200ms));
+}
+
+TEST_F(ConcurrencyControllerFixture, decreasesWhenAnIncreaseLowersTheThroughput) {
+  ConcurrencyController controller{options, 20, now};
+  EXPECT_EQ(24u, limitedInterval(controller, 100));
+  EXPECT_EQ(12u, limitedInterval(controller, 70));
+  // no increase before, the throughput is not compared
+  EXPECT_EQ(16u, limitedInterval(controller, 10));
+}
+
+TEST_F(ConcurrencyControllerFixture, invalidOptions) {
+  options.minActiveDownloads = 0;
+  EXPECT_THROW(ConcurrencyController(options, 10, now), std::invalid_argument);
+  options.minActiveDownloads = 40;
+  EXPECT_THROW(ConcurrencyController(options, 10, now), std::invalid_argument);
+  options.minActiveDownloads = 4;
+  options.decreaseFactor     = 1.;
+  EXPECT_THROW(ConcurrencyController(options, 10, now), std::invalid_argument);
+}
@@ -1,11 +1,20 @@
 #include "crawler/CurlAsioDownloader.h"
+#include "CurlMultiManager.h"
+#include "DnsCache.h"
+#include "DownloadManager.h"
 #include "DownloadResult.h"
 #include "NotifyBox.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <boost/asio.hpp>
+#include <chrono>
+#include <future>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 using ::testing::AllOf;
 using ::testing::ContainsRegex;
@@ -18,6 +27,113 @@ struct CurlAsioDownloaderFixture : public ::testing::Test {
   std::function<bool(const MediaType&)> defaultMediaTypeValidator;
 };
 
+namespace {
+
+/**
+ * Answers one request on the IPv6 loopback address with a small page, it stops after 10 secs.
+ */
+class Ipv6PageServer {
+public:
+  /**
+   * @param closedConnections the first connections are closed without reading a request
+   */
+  explicit Ipv6PageServer(const size_t closedConnections = 0)
+      : m_io_context{}
+      , m_acceptor{m_io_context, {boost::asio::ip::address_v6::loopback(), 0}}
+      , m_socket{m_io_context}
+      , m_request{}
+      , m_closedConnections{closedConnections}
+      , m_closed{}
+      , m_thread{} {
+    accept();
+    m_thread = std::thread{[this]() { m_io_context.run_for(std::chrono::seconds{10}); }};
+  }
+
+  /**
+   * Waits for the closedConnections to be closed.
+   */
+  bool waitForClosed() { return std::future_status::ready == m_closed.get_future().wait_for(std::chrono::seconds{5}); }
+
+  ~Ipv6PageServer() { m_thread.join(); }
+
+  unsigned short port() const { return m_acceptor.local_endpoint().port(); }
+
+private:
+  void accept() {
+    m_acceptor.async_accept(m_socket, [this](const boost::system::error_code& error) {
+      if(error) {
+        return;
+      }
+      if(0 < m_closedConnections) {
+        m_socket.close();
+        if(0 == --m_closedConnections) {
+          m_closed.set_value();
+        }
+        accept();
+        return;
+      }
+      boost::asio::async_read_until(m_socket, m_request, "\r\n\r\n", [this](auto error, size_t) {
+        if(!error) {
+          boost::asio::write(m_socket, boost::asio::buffer(std::string_view{RESPONSE}), error);
+        }
+      });
+    });
+  }
+
+  static constexpr const char* RESPONSE
+      = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello";
+
+  boost::asio::io_context        m_io_context;
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  boost::asio::ip::tcp::socket   m_socket;
+  boost::asio::streambuf         m_request;
+  size_t                         m_closedConnections;
+  std::promise<void>             m_closed;
+  std::thread                    m_thread;
+};
+
+/**
+ * Keeps the content of the last scan.
+ */
+struct CopyingScanner : public ContentScanner {
+  void scan(const std::string_view content) override { scanned = content; }
+
+  std::string scanned;
+};
+
+/**
+ * Downloads url with the CURLOPT_RESOLVE entries resolve, driving multi until the transfer finished.
+ */
+DownloadResult
+downloadResolved(CURLM* const multi, const std::string& url, const std::vector<std::string>& resolve) {
+  DownloadResult  downloaded;
+  bool            finished = false;
+  DownloadManager manager{multi,
+                          {{url, 0}, [&downloaded](DownloadResult&& result) { downloaded = std::move(result); }},
+                          1024,
+                          [](const MediaType&) { return true; },
+                          nullptr,
+                          nullptr,
+                          resolve};
+  manager.setFinishedCallback([&finished]() { finished = true; });
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+  while(!finished && std::chrono::steady_clock::now() < deadline) {
+    int running = 0;
+    curl_multi_perform(multi, &running);
+    int      messagesInQueue = 0;
+    CURLMsg* infoMsg         = nullptr;
+    while(nullptr != (infoMsg = curl_multi_info_read(multi, &messagesInQueue))) {
+      if(CURLMSG_DONE == infoMsg->msg) {
+        processFinishedDownload(infoMsg)();
+      }
+    }
+    curl_multi_wait(multi, nullptr, 0, 100, nullptr);
+  }
+  return downloaded;
+}
+
+} // namespace
+
 TEST_F(CurlAsioDownloaderFixture, instance) {
   CurlAsioDownloader inst{defaultMaxContentLength, defaultMediaTypeValidator};
 }
@@ -50,3 +166,75 @@ TEST_F(CurlAsioDownloaderFixture, download) {
                    notification();
                  }});
 }
+
+TEST_F(CurlAsioDownloaderFixture, downloadFromIpv6Literal) {
+  Ipv6PageServer     server;
+  CurlAsioDownloader inst{defaultMaxContentLength, defaultMediaTypeValidator};
+  DownloadResult     downloaded;
+  NotifyBox          notification;
+  inst.download({{"http://[::1]:" + std::to_string(server.port()) + "/page", 0}, [&](DownloadResult&& result) {
+                   downloaded = std::move(result);
+                   notification();
+                 }});
+  notification.waitWithTimeout();
+  EXPECT_TRUE(downloaded.success) << downloaded.errorMessage;
+  EXPECT_EQ("hello", downloaded.content);
+}
+
+TEST(DownloadManager, connectsToTheResolvedAddresses) {
+  Ipv6PageServer    server;
+  CurlMultiManager  multi;
+  const std::string port = std::to_string(server.port());
+  const std::string url  = "http://cheapcrawler.invalid:" + port + "/page";
+
+  // the server listens only on the IPv6 loopback address
+  const DownloadResult refused
+      = downloadResolved(multi.get(), url, curlResolveEntries("cheapcrawler.invalid", port, {{"127.0.0.1"}, {}}));
+  EXPECT_EQ(TransferError::CONNECT, refused.transferError) << refused.errorMessage;
+
+  // the address left by the first transfer in the DNS cache of the multi handle is replaced
+  const DownloadResult downloaded
+      = downloadResolved(multi.get(), url, curlResolveEntries("cheapcrawler.invalid", port, {{"::1"}, {}}));
+  EXPECT_TRUE(downloaded.success) << downloaded.errorMessage;
+  EXPECT_EQ("hello", downloaded.content);
+}
+
+TEST_F(CurlAsioDownloaderFixture, contentIsScannedWhileReceived) {
+  Ipv6PageServer            server;
+  MediaType                 scannedType;
+  CurlAsioDownloaderOptions options;
+  options.scannerFactory = [&scannedType](const MediaType& mediaType) {
+    scannedType = mediaType;
+    return std::make_unique<CopyingScanner>();
+  };
+  CurlAsioDownloader inst{defaultMaxContentLength, defaultMediaTypeValidator, std::move(options)};
+  DownloadResult     downloaded;
+  NotifyBox          notification;
+  inst.download({{"http://[::1]:" + std::to_string(server.port()) + "/page", 0}, [&](DownloadResult&& result) {
+                   downloaded = std::move(result);
+                   notification();
+                 }});
+  notification.waitWithTimeout();
+  ASSERT_TRUE(downloaded.success) << downloaded.errorMessage;
+  EXPECT_EQ("html", scannedType.subtype);
+  ASSERT_NE(nullptr, downloaded.scanner);
+  EXPECT_EQ("hello", static_cast<const CopyingScanner&>(*downloaded.scanner).scanned);
+}
+
+TEST_F(CurlAsioDownloaderFixture, prewarmedConnectionClosedByTheServer) {
+  Ipv6PageServer     server{1};
+  CurlAsioDownloader inst{defaultMaxContentLength, defaultMediaTypeValidator};
+  const std::string  url = "http://[::1]:" + std::to_string(server.port()) + "/page";
+  inst.prewarm(url);
+  ASSERT_TRUE(server.waitForClosed());
+  // the prewarmed connection is dropped, the download connects again
+  DownloadResult downloaded;
+  NotifyBox      notification;
+  inst.download({{url, 0}, [&](DownloadResult&& result) {
+                   downloaded = std::move(result);
+                   notification();
+                 }});
+  notification.waitWithTimeout();
+  EXPECT_TRUE(downloaded.success) << downloaded.errorMessage;
+  EXPECT_EQ("hello", downloaded.content);
+}
@@ -0,0 +1,80 @@
+#include "DownloadQueues.h"
+#include "crawler/HostConcurrency.h"
+#include "crawler/crawler.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+TEST(HostConcurrency, readHostSlots) {
+  std::istringstream in{"# partner sites\n"
+                        "example.com 4\n"
+                        "\n"
+                        "  static.example.org\t16  \n"};
+  HostConcurrency hostConcurrency;
+  readHostSlots(in, hostConcurrency);
+  EXPECT_EQ(2u, hostConcurrency.slots.size());
+  EXPECT_EQ(4u, hostConcurrency.slotsOf("example.com"));
+  EXPECT_EQ(16u, hostConcurrency.slotsOf("static.example.org"));
+  EXPECT_EQ(1u, hostConcurrency.slotsOf("example.net"));
+}
+
+TEST(HostConcurrency, invalidLines) {
+  for(const char* const line: {"example.com", "example.com 0", "example.com -2", "example.com 4 5", "example.com x"}) {
+    std::istringstream in{std::string{"example.org 2\n"} + line};
+    HostConcurrency    hostConcurrency;
+    EXPECT_THROW(readHostSlots(in, hostConcurrency), std::runtime_error) << line;
+  }
+}
+
+TEST(HostConcurrency, crawlerRejectsZeroSlots) {
+  Crawler crawler{
+      []() { return false; }, []() { return UrlBatch{[](DownloadResult&&) {}}; }, nullptr, 1, std::chrono::seconds{1}};
+  HostConcurrency hostConcurrency;
+  hostConcurrency.defaultSlots = 0;
+  EXPECT_THROW(crawler.setHostConcurrency(hostConcurrency), std::invalid_argument);
+  hostConcurrency.defaultSlots         = 2;
+  hostConcurrency.slots["example.com"] = 0;
+  EXPECT_THROW(crawler.setHostConcurrency(hostConcurrency), std::invalid_argument);
+  hostConcurrency.slots["example.com"] = 8;
+  EXPECT_NO_THROW(crawler.setHostConcurrency(hostConcurrency));
+}
+
+TEST(HostSlots, adapt) {
+  HostSlots slots;
+  slots.limit    = 2;
+  slots.maxLimit = 3;
+  slots.adapt(TransferError::NONE);
+  EXPECT_EQ(2u, slots.limit);
+  slots.adapt(TransferError::NONE);
+  EXPECT_EQ(3u, slots.limit);
+  for(int download = 0; download < 10; ++download) {
+    slots.adapt(TransferError::NONE);
+  }
+  EXPECT_EQ(3u, slots.limit);
+  slots.adapt(TransferError::OTHER);
+  EXPECT_EQ(3u, slots.limit);
+  slots.adapt(TransferError::TIMEOUT);
+  EXPECT_EQ(1u, slots.limit);
+  slots.adapt(TransferError::CONNECT);
+  EXPECT_EQ(1u, slots.limit);
+}
+
+TEST(HostSlots, multiplexed) {
+  HostSlots slots;
+  slots.multiplexedLimit = 6;
+  slots.adapt(TransferOutcome{TransferError::NONE, false});
+  EXPECT_EQ(1u, slots.limit);
+  slots.adapt(TransferOutcome{TransferError::NONE, true});
+  EXPECT_EQ(6u, slots.limit);
+  EXPECT_EQ(6u, slots.maxLimit);
+  slots.adapt(TransferOutcome{TransferError::TIMEOUT, true});
+  EXPECT_EQ(3u, slots.limit);
+
+  HostSlots fixed;
+  fixed.adapt(TransferOutcome{TransferError::NONE, true});
+  EXPECT_EQ(1u, fixed.limit);
+}
@@ -0,0 +1,56 @@
+#include "Metrics.h"
+#include "MetricsEndpoint.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <boost/asio.hpp>
+#include <string>
+#include <thread>
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+struct MetricsEndpointFixture : public ::testing::Test {
+  MetricsEndpointFixture()
+      : Test{}, ioContext{}, workGuard{boost::asio::make_work_guard(ioContext)}, endpoint{ioContext, 0}, ioThread{} {
+    ioThread = std::thread{[this]() { ioContext.run(); }};
+  }
+  ~MetricsEndpointFixture() {
+    ioContext.stop();
+    ioThread.join();
+  }
+
+  std::string get(const std::string& request) {
+    boost::asio::io_context clientContext;
+    tcp::socket             socket{clientContext};
+    socket.connect(tcp::endpoint{boost::asio::ip::address_v4::loopback(), endpoint.port()});
+    boost::asio::write(socket, boost::asio::buffer(request));
+    std::string               response;
+    boost::system::error_code error;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(response), error);
+    EXPECT_EQ(boost::asio::error::eof, error);
+    return response;
+  }
+
+  boost::asio::io_context                                                    ioContext;
+  boost::asio::executor_work_guard<boost::asio::io_context::executor_type> workGuard;
+  MetricsEndpoint                                                            endpoint;
+  std::thread                                                                ioThread;
+};
+
+} // namespace
+
+TEST_F(MetricsEndpointFixture, servesMetrics) {
+  getCounter("endpoint_test_total", "Test counter.").add(7);
+  const std::string response = get("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_THAT(response, testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_THAT(response, testing::HasSubstr("\r\n\r\n# HELP "));
+  EXPECT_THAT(response, testing::HasSubstr("\nendpoint_test_total 7\n"));
+}
+
+TEST_F(MetricsEndpointFixture, unknownTarget) {
+  EXPECT_THAT(get("GET / HTTP/1.1\r\n\r\n"), testing::StartsWith("HTTP/1.1 404 Not Found\r\n"));
+  EXPECT_THAT(get("POST /metrics HTTP/1.1\r\n\r\n"), testing::StartsWith("HTTP/1.1 405 Method Not Allowed\r\n"));
+}
@@ -0,0 +1,131 @@
+#include "DownloadResult.h"
+#include "crawler/RecordReplay.h"
+#include "testFilename.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+/**
+ * Answers each download after 50ms, the content is the url and the downloads of failing.com fail.
+ */
+class FakeDownloader : public Downloader {
+public:
+  ~FakeDownloader() {
+    for(std::future<void>& download: m_downloads) {
+      download.get();
+    }
+  }
+
+private:
+  void doDownload(DownloadElem&& elem) override {
+    m_downloads.push_back(std::async(std::launch::async, [elem = std::move(elem)]() {
+      std::this_thread::sleep_for(50ms);
+      DownloadResult result;
+      result.url                  = elem.url;
+      result.success              = std::string::npos == std::get<0>(elem.url).find("failing.com");
+      result.content              = result.success ? std::get<0>(elem.url) : std::string{};
+      result.errorMessage         = result.success ? std::string{} : "fake error";
+      result.mediaType            = MediaType{"text", "html", "utf-8"};
+      result.downloadSpeedByteSec = 1000.;
+      elem.callback(std::move(result));
+    }));
+  }
+
+  std::vector<std::future<void>> m_downloads;
+};
+
+struct RecordReplayFixture : public ::testing::Test {
+  RecordReplayFixture() : Test{}, filename{testFilename("RecordReplayTest", ".rec")} {}
+  ~RecordReplayFixture() { std::remove(filename.c_str()); }
+
+  void record(const std::vector<std::string>& urls) {
+    FakeDownloader      fake;
+    RecordingDownloader recorder{&fake, filename};
+    for(size_t url = 0; url < urls.size(); ++url) {
+      recorder.download(DownloadElem{Url{urls[url], static_cast<int>(url)}, [](DownloadResult&&) {}});
+    }
+  }
+
+  /**
+   * Replays the urls in order, waiting for each result.
+   */
+  std::vector<DownloadResult> replay(ReplayDownloader& replayer, const std::vector<std::string>& urls) {
+    std::vector<DownloadResult> results;
+    for(size_t url = 0; url < urls.size(); ++url) {
+      std::promise<DownloadResult> result;
+      replayer.download(DownloadElem{Url{urls[url], static_cast<int>(url) + 100},
+                                     [&result](DownloadResult&& dwResult) { result.set_value(std::move(dwResult)); }});
+      results.push_back(result.get_future().get());
+    }
+    return results;
+  }
+
+  std::string filename;
+};
+
+} // namespace
+
+TEST_F(RecordReplayFixture, replaysRecordedResults) {
+  record({"http://a.com/", "http://failing.com/"});
+  ReplayDownloader replayer{filename, ReplaySpeed::MAXIMUM};
+  EXPECT_EQ(2u, replayer.nrRemainingRecords());
+
+  const std::vector<DownloadResult> results = replay(replayer, {"http://failing.com/", "http://a.com/"});
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(Url("http://failing.com/", 100), results[0].url);
+  EXPECT_FALSE(results[0].success);
+  EXPECT_EQ("fake error", results[0].errorMessage);
+  EXPECT_EQ(Url("http://a.com/", 101), results[1].url);
+  EXPECT_TRUE(results[1].success);
+  EXPECT_EQ("http://a.com/", results[1].content);
+  EXPECT_EQ("html", results[1].mediaType.subtype);
+  EXPECT_EQ("utf-8", results[1].mediaType.charset);
+  EXPECT_EQ(1000., results[1].downloadSpeedByteSec);
+  EXPECT_EQ(0u, replayer.nrRemainingRecords());
+}
+
+TEST_F(RecordReplayFixture, unrecordedUrlsFail) {
+  record({"http://a.com/"});
+  ReplayDownloader replayer{filename, ReplaySpeed::MAXIMUM};
+
+  const std::vector<DownloadResult> results = replay(replayer, {"http://b.com/", "http://a.com/", "http://a.com/"});
+  ASSERT_EQ(3u, results.size());
+  EXPECT_FALSE(results[0].success);
+  EXPECT_TRUE(results[1].success);
+  EXPECT_FALSE(results[2].success);
+}
+
+TEST_F(RecordReplayFixture, recordedSpeedKeepsTheDownloadTime) {
+  record({"http://a.com/"});
+  ReplayDownloader replayer{filename, ReplaySpeed::RECORDED};
+
+  const auto start = std::chrono::steady_clock::now();
+  replay(replayer, {"http://a.com/"});
+  EXPECT_LE(50ms, std::chrono::steady_clock::now() - start);
+}
+
+TEST_F(RecordReplayFixture, invalidFile) {
+  EXPECT_THROW(ReplayDownloader(filename, ReplaySpeed::MAXIMUM), std::runtime_error);
+  std::ofstream{filename} << "not a recording";
+  EXPECT_THROW(ReplayDownloader(filename, ReplaySpeed::MAXIMUM), std::runtime_error);
+}
+
+TEST_F(RecordReplayFixture, truncatedRecord) {
+  record({"http://a.com/"});
+  ReplayDownloader{filename, ReplaySpeed::MAXIMUM};
+  // the file ends inside the duration of a second record
+  std::ofstream{filename, std::ios::binary | std::ios::app} << "123";
+  EXPECT_THROW(ReplayDownloader(filename, ReplaySpeed::MAXIMUM), std::runtime_error);
+}
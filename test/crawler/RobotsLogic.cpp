@@ -13,111 +13,107 @@ struct DownloadFinishedMock {
 
 struct DwFinishedCallback {
   DownloadFinishedMock* dwFinishedMock;
-  void                  operator()(DownloadQueues::DownloadQueueIt it) { dwFinishedMock->downloadFinishedProxy(it); }
+  void                  operator()(DownloadQueues::DownloadQueueIt it, const TransferOutcome&) {
+    dwFinishedMock->downloadFinishedProxy(it);
+  }
 };
 
 struct RobotsLogicFixture : public ::testing::Test {
-  RobotsLogicFixture() : Test{}, queues{}, dwFinishedMock{}, dwFinishedCallback{&dwFinishedMock} {
+  RobotsLogicFixture()
+      : Test{}, queues{}, robotsLogic{&queues}, dwFinishedMock{}, dwFinishedCallback{&dwFinishedMock} {
     EXPECT_CALL(dwFinishedMock, downloadFinishedProxy(_)).Times(0);
   }
 
+  void populate(std::vector<DownloadElem>&& urlsToCrawl) {
+    robotsLogic.populateDownloadQueues(makeUrlBatch(std::move(urlsToCrawl)), dwFinishedCallback);
+  }
+
   DownloadQueues       queues;
+  RobotsLogic          robotsLogic;
   DownloadFinishedMock dwFinishedMock;
   DwFinishedCallback   dwFinishedCallback;
 };
 
 TEST_F(RobotsLogicFixture, buildQueues) {
-  populateDownloadQueuesWithRobots(&queues,
-                                   std::vector<DownloadElem>{
-                                       {{"http://url.com", 1}, [](DownloadResult&&) {}},
-                                   },
-                                   dwFinishedCallback);
+  populate(std::vector<DownloadElem>{
+      {{"http://url.com", 1}, [](DownloadResult&&) {}},
+  });
   ASSERT_EQ(queues.size(), 1);
   auto downloadQueueIt = std::begin(queues);
   ASSERT_EQ(queues.size(downloadQueueIt), 1);
-  EXPECT_EQ(std::get<0>(queues.popDownload(downloadQueueIt).url), "http://url.com/robots.txt");
+  EXPECT_EQ(std::get<0>(robotsLogic.popDownload(downloadQueueIt).url), "http://url.com/robots.txt");
 }
 
 TEST_F(RobotsLogicFixture, noRobotsForBadUris) {
-  populateDownloadQueuesWithRobots(&queues,
-                                   std::vector<DownloadElem>{{{"http://url.com dsadas", 1}, [](auto) {}},
-                                                             {{"ftp://url.com dsadas", 2}, [](auto) {}},
-                                                             {{"ftp://url.com", 3}, [](auto) {}},
-                                                             {{"http://url.com#23", 4}, [](auto) {}}},
-                                   dwFinishedCallback);
+  populate(std::vector<DownloadElem>{{{"http://url.com dsadas", 1}, [](auto) {}},
+                                     {{"ftp://url.com dsadas", 2}, [](auto) {}},
+                                     {{"ftp://url.com", 3}, [](auto) {}},
+                                     {{"http://url.com#23", 4}, [](auto) {}}});
 
   ASSERT_EQ(queues.size(), 0);
 }
 
 TEST_F(RobotsLogicFixture, onlyOneRobotPerProtocolAndHost) {
-  populateDownloadQueuesWithRobots(&queues,
-                                   std::vector<DownloadElem>{{{"http://url.com/dsjaklj", 1}, [](auto) {}},
-                                                             {{"http://url.com/dsjaklj?q=34", 1}, [](auto) {}},
-                                                             {{"http://url.com/q=34", 1}, [](auto) {}}},
-                                   dwFinishedCallback);
+  populate(std::vector<DownloadElem>{{{"http://url.com/dsjaklj", 1}, [](auto) {}},
+                                     {{"http://url.com/dsjaklj?q=34", 1}, [](auto) {}},
+                                     {{"http://url.com/q=34", 1}, [](auto) {}}});
 
   ASSERT_EQ(queues.size(), 1);
   auto downloadQueueIt = std::begin(queues);
   ASSERT_EQ(queues.size(downloadQueueIt), 1);
-  EXPECT_EQ(std::get<0>(queues.popDownload(downloadQueueIt).url), "http://url.com/robots.txt");
+  EXPECT_EQ(std::get<0>(robotsLogic.popDownload(downloadQueueIt).url), "http://url.com/robots.txt");
 }
 
 TEST_F(RobotsLogicFixture, oneDownloadQueuePerHost) {
-  populateDownloadQueuesWithRobots(&queues,
-                                   std::vector<DownloadElem>{
-                                       {{"http://url1.com/dsjaklj", 1}, [](auto) {}},
-                                       {{"http://url1.com/dsjaklj?q=34", 2}, [](auto) {}},
-                                       {{"https://url1.com/q=34", 3}, [](auto) {}},
-                                   },
-                                   dwFinishedCallback);
+  populate(std::vector<DownloadElem>{
+      {{"http://url1.com/dsjaklj", 1}, [](auto) {}},
+      {{"http://url1.com/dsjaklj?q=34", 2}, [](auto) {}},
+      {{"https://url1.com/q=34", 3}, [](auto) {}},
+  });
 
   ASSERT_EQ(1, queues.size());
   auto downloadQueueIt = queues.begin();
   ASSERT_EQ(2, queues.size(downloadQueueIt));
-  std::vector<std::string> urls{std::get<0>(queues.popDownload(downloadQueueIt).url),
-                                std::get<0>(queues.popDownload(downloadQueueIt).url)};
+  std::vector<std::string> urls{std::get<0>(robotsLogic.popDownload(downloadQueueIt).url),
+                                std::get<0>(robotsLogic.popDownload(downloadQueueIt).url)};
 
   EXPECT_THAT(urls, testing::UnorderedElementsAre("http://url1.com/robots.txt", "https://url1.com/robots.txt"));
 }
 
 TEST_F(RobotsLogicFixture, separateQueueForEachHost) {
-  populateDownloadQueuesWithRobots(&queues,
-                                   std::vector<DownloadElem>{
-                                       {{"http://url1.com/dsjaklj", 1}, [](auto) {}},
-                                       {{"http://url1.com/dsjaklj?q=34", 2}, [](auto) {}},
-                                       {{"https://url2.com/q=34", 3}, [](auto) {}},
-                                   },
-                                   dwFinishedCallback);
+  populate(std::vector<DownloadElem>{
+      {{"http://url1.com/dsjaklj", 1}, [](auto) {}},
+      {{"http://url1.com/dsjaklj?q=34", 2}, [](auto) {}},
+      {{"https://url2.com/q=34", 3}, [](auto) {}},
+  });
 
   ASSERT_EQ(2, queues.size());
   std::vector<std::string> urls;
   for(auto downloadQueueIt = std::begin(queues); downloadQueueIt != std::end(queues); ++downloadQueueIt) {
     ASSERT_EQ(1, queues.size(downloadQueueIt));
-    urls.push_back(std::get<0>(queues.popDownload(downloadQueueIt).url));
+    urls.push_back(std::get<0>(robotsLogic.popDownload(downloadQueueIt).url));
   }
 
   EXPECT_THAT(urls, testing::UnorderedElementsAre("http://url1.com/robots.txt", "https://url2.com/robots.txt"));
 }
 
 TEST_F(RobotsLogicFixture, oneRobotForEachProtocolAndHost) {
-  populateDownloadQueuesWithRobots(&queues,
-                                   std::vector<DownloadElem>{{{"http://url1.com/dsjaklj", 1}, [](auto) {}},
-                                                             {{"http://url1.com/dsjaklj?q=34", 2}, [](auto) {}},
-                                                             {{"https://url1.com/q=34", 3}, [](auto) {}},
-                                                             {{"http://url2.com/dsjaklj", 4}, [](auto) {}},
-                                                             {{"http://url2.com/dsjaklj?q=34", 5}, [](auto) {}},
-                                                             {{"https://url2.com/q=34", 6}, [](auto) {}}},
-                                   dwFinishedCallback);
+  populate(std::vector<DownloadElem>{{{"http://url1.com/dsjaklj", 1}, [](auto) {}},
+                                     {{"http://url1.com/dsjaklj?q=34", 2}, [](auto) {}},
+                                     {{"https://url1.com/q=34", 3}, [](auto) {}},
+                                     {{"http://url2.com/dsjaklj", 4}, [](auto) {}},
+                                     {{"http://url2.com/dsjaklj?q=34", 5}, [](auto) {}},
+                                     {{"https://url2.com/q=34", 6}, [](auto) {}}});
 
   ASSERT_EQ(2, queues.size());
   auto downloadQueueIt1 = queues.begin();
   auto downloadQueueIt2 = ++queues.begin();
   ASSERT_EQ(2, queues.size(downloadQueueIt1));
   ASSERT_EQ(2, queues.size(downloadQueueIt2));
-  std::vector<std::string> urls{std::get<0>(queues.popDownload(downloadQueueIt1).url),
-                                std::get<0>(queues.popDownload(downloadQueueIt1).url),
-                                std::get<0>(queues.popDownload(downloadQueueIt2).url),
-                                std::get<0>(queues.popDownload(downloadQueueIt2).url)};
+  std::vector<std::string> urls{std::get<0>(robotsLogic.popDownload(downloadQueueIt1).url),
+                                std::get<0>(robotsLogic.popDownload(downloadQueueIt1).url),
+                                std::get<0>(robotsLogic.popDownload(downloadQueueIt2).url),
+                                std::get<0>(robotsLogic.popDownload(downloadQueueIt2).url)};
 
   EXPECT_THAT(urls,
               testing::UnorderedElementsAre("http://url1.com/robots.txt",
@@ -136,38 +132,140 @@ struct RobotsLogicWithDownloadCallback : public RobotsLogicFixture {
 };
 
 TEST_F(RobotsLogicWithDownloadCallback, urlDownloadFinishedCalledByCallback) {
-  populateDownloadQueuesWithRobots(
-      &queues,
-      std::vector<DownloadElem>{
-          {{"http://url.com", 1}, [this](DownloadResult&& result) { downloadCallback.cb(result); }},
-      },
-      dwFinishedCallback);
+  populate(std::vector<DownloadElem>{
+      {{"http://url.com", 1}, [this](DownloadResult&& result) { downloadCallback.cb(result); }},
+  });
   ASSERT_EQ(queues.size(), 1);
   auto downloadQueueIt = std::begin(queues);
   ASSERT_EQ(queues.size(downloadQueueIt), 1);
-  DownloadElem download = queues.popDownload(downloadQueueIt);
+  DownloadElem download = robotsLogic.popDownload(downloadQueueIt);
   EXPECT_CALL(dwFinishedMock, downloadFinishedProxy(downloadQueueIt));
   EXPECT_CALL(downloadCallback, cb(_)).Times(0);
   download.callback(DownloadResult{});
 }
 
 TEST_F(RobotsLogicWithDownloadCallback, urlDownloadAfterFinishedRobots) {
-  populateDownloadQueuesWithRobots(
-      &queues,
-      std::vector<DownloadElem>{
-          {{"http://url.com", 1}, [this](DownloadResult&& result) { downloadCallback.cb(result); }},
-      },
-      dwFinishedCallback);
+  populate(std::vector<DownloadElem>{
+      {{"http://url.com", 1}, [this](DownloadResult&& result) { downloadCallback.cb(result); }},
+  });
   ASSERT_EQ(queues.size(), 1);
   auto downloadQueueIt = std::begin(queues);
   ASSERT_EQ(queues.size(downloadQueueIt), 1);
-  DownloadElem download = queues.popDownload(downloadQueueIt);
+  DownloadElem download = robotsLogic.popDownload(downloadQueueIt);
   EXPECT_CALL(dwFinishedMock, downloadFinishedProxy(downloadQueueIt));
   download.callback(DownloadResult{});
   ASSERT_EQ(queues.size(downloadQueueIt), 1);
-  DownloadElem urlDownload = queues.popDownload(downloadQueueIt);
+  DownloadElem urlDownload = robotsLogic.popDownload(downloadQueueIt);
   EXPECT_EQ(std::get<0>(urlDownload.url), "http://url.com");
   EXPECT_CALL(downloadCallback, cb(_));
   EXPECT_CALL(dwFinishedMock, downloadFinishedProxy(downloadQueueIt));
   urlDownload.callback(DownloadResult{});
 }
+
+TEST_F(RobotsLogicFixture, duplicatesByCanonicalUrlAreDropped) {
+  populate(std::vector<DownloadElem>{{{"http://url.com/a/b", 1}, [](auto) {}},
+                                     {{"HTTP://URL.com/a/./b", 2}, [](auto) {}},
+                                     {{"http://url.com/a/c/../b", 3}, [](auto) {}},
+                                     {{"http://url.com/a/c", 4}, [](auto) {}}});
+
+  ASSERT_EQ(1, queues.size());
+  auto downloadQueueIt = queues.begin();
+  EXPECT_EQ("url.com", downloadQueueIt->first);
+  ASSERT_EQ(1, queues.size(downloadQueueIt));
+  DownloadElem robotsDownload = robotsLogic.popDownload(downloadQueueIt);
+  EXPECT_EQ(std::get<0>(robotsDownload.url), "http://url.com/robots.txt");
+  EXPECT_CALL(dwFinishedMock, downloadFinishedProxy(downloadQueueIt));
+  robotsDownload.callback(DownloadResult{});
+
+  ASSERT_EQ(2, queues.size(downloadQueueIt));
+  std::vector<std::string> urls{std::get<0>(robotsLogic.popDownload(downloadQueueIt).url),
+                                std::get<0>(robotsLogic.popDownload(downloadQueueIt).url)};
+  EXPECT_THAT(urls, testing::UnorderedElementsAre("http://url.com/a/b", "http://url.com/a/c"));
+}
+
+TEST_F(RobotsLogicFixture, droppedUrlsAreFinished) {
+  std::vector<DownloadResult> results;
+  UrlBatch batch{[&results](DownloadResult&& result) { results.push_back(std::move(result)); }};
+  batch.add("http://url.com/a/b", 1);
+  batch.add("HTTP://URL.com/a/./b", 2);
+  batch.add("http://url.com/a/b", 3);
+  batch.add("ftp://url.com", 4);
+  // the first of the duplicates is not a clean url
+  batch.add("http://url.com/c/./d", 5);
+  batch.add("http://url.com/c/d", 6);
+  robotsLogic.populateDownloadQueues(std::move(batch), dwFinishedCallback);
+  EXPECT_EQ(2, robotsLogic.nrQueuedUrls());
+
+  ASSERT_EQ(4, results.size());
+  EXPECT_EQ(Url("HTTP://URL.com/a/./b", 2), results[0].url);
+  EXPECT_EQ("duplicate url", results[0].errorMessage);
+  EXPECT_EQ(Url("http://url.com/a/b", 3), results[1].url);
+  EXPECT_EQ("duplicate url", results[1].errorMessage);
+  EXPECT_EQ(Url("ftp://url.com", 4), results[2].url);
+  EXPECT_EQ("invalid url", results[2].errorMessage);
+  EXPECT_EQ(Url("http://url.com/c/d", 6), results[3].url);
+  EXPECT_EQ("duplicate url", results[3].errorMessage);
+  for(const DownloadResult& result: results) {
+    EXPECT_FALSE(result.success);
+    EXPECT_EQ(TransferError::OTHER, result.transferError);
+  }
+}
+
+TEST_F(RobotsLogicFixture, batchSinkReceivesResultsByUrlIndex) {
+  std::vector<Url> results;
+  UrlBatch         batch{[&results](DownloadResult&& result) { results.push_back(result.url); }};
+  batch.add("http://url.com/a", 7);
+  batch.add("http://url.com/b", 9);
+  robotsLogic.populateDownloadQueues(std::move(batch), dwFinishedCallback);
+  EXPECT_EQ(2, robotsLogic.nrQueuedUrls());
+
+  ASSERT_EQ(1, queues.size());
+  auto downloadQueueIt = queues.begin();
+  EXPECT_CALL(dwFinishedMock, downloadFinishedProxy(downloadQueueIt)).Times(3);
+  DownloadElem robotsDownload = robotsLogic.popDownload(downloadQueueIt);
+  robotsDownload.callback(DownloadResult{robotsDownload.url});
+  EXPECT_TRUE(results.empty());
+  while(!queues.empty(downloadQueueIt)) {
+    DownloadElem download = robotsLogic.popDownload(downloadQueueIt);
+    download.callback(DownloadResult{download.url});
+  }
+  EXPECT_THAT(results, testing::UnorderedElementsAre(Url{"http://url.com/a", 7}, Url{"http://url.com/b", 9}));
+}
+
+TEST_F(RobotsLogicFixture, queuedUrlsAreCompact) {
+  constexpr int nrUrls  = 200000;
+  constexpr int nrHosts = 1000;
+  UrlBatch      batch;
+  size_t        urlsLength = 0;
+  for(int index = 0; index < nrUrls; ++index) {
+    const std::string url
+        = "http://host" + std::to_string(index % nrHosts) + ".com/path/page" + std::to_string(index) + ".html";
+    urlsLength += url.size();
+    batch.add(url, index);
+  }
+  robotsLogic.populateDownloadQueues(std::move(batch), dwFinishedCallback);
+  ASSERT_EQ(nrUrls, robotsLogic.nrQueuedUrls());
+  ASSERT_EQ(nrHosts, queues.size());
+
+  const size_t bytesPerUrl = robotsLogic.memoryUsage() / nrUrls;
+  EXPECT_LT(bytesPerUrl, urlsLength / nrUrls + 3 * sizeof(UrlHandle)) << "bytes per url: " << bytesPerUrl;
+}
+
+TEST(RobotsLogic, hostsSharingAPolitenessKey) {
+  DownloadQueues queues;
+  RobotsLogic    robotsLogic{&queues,
+                          [](const std::string_view host) { return std::string{host.substr(host.find('.') + 1)}; }};
+  robotsLogic.populateDownloadQueues(makeUrlBatch({{{"http://a.blog.com/1", 1}, [](auto) {}},
+                                                   {{"http://b.blog.com/2", 2}, [](auto) {}},
+                                                   {{"http://a.shop.com/3", 3}, [](auto) {}}}),
+                                     [](DownloadQueues::DownloadQueueIt, const TransferOutcome&) {});
+
+  ASSERT_EQ(2u, queues.size());
+  auto blogQueue = std::begin(queues);
+  ASSERT_EQ("blog.com", blogQueue->first);
+  ASSERT_EQ(2u, queues.size(blogQueue));
+  // the robots.txt files stay per host
+  std::vector<std::string> urls{std::get<0>(robotsLogic.popDownload(blogQueue).url),
+                                std::get<0>(robotsLogic.popDownload(blogQueue).url)};
+  EXPECT_THAT(urls, testing::UnorderedElementsAre("http://a.blog.com/robots.txt", "http://b.blog.com/robots.txt"));
+}
@@ -0,0 +1,253 @@
+#include "DownloadResult.h"
+#include "crawler/SimulatedDownloader.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct SimulatedCrawl {
+  size_t nrBatches;
+  size_t nrResults;
+  size_t nrFailedResults;
+  size_t nrCircuitOpenResults;
+};
+
+SimulatedCrawl
+simulateCrawl(SimulatedDownloader& simulator,
+              const size_t         nrHosts,
+              const size_t         urlsPerHost,
+              const size_t         maxActiveQueues,
+              std::chrono::seconds politenessDelay,
+              const AdaptiveConcurrencyOptions* adaptiveConcurrency = nullptr,
+              const HostConcurrency*            hostConcurrency     = nullptr,
+              const std::chrono::milliseconds   prewarmWindow       = std::chrono::milliseconds{0},
+              const CircuitBreakerOptions&      circuitBreaker      = CircuitBreakerOptions{},
+              const size_t                      nrBatches           = 1) {
+  SimulatedCrawl result{0, 0, 0, 0};
+  const auto     dispatcher = [&result, nrHosts, urlsPerHost]() {
+    ++result.nrBatches;
+    UrlBatch batch{[&result](DownloadResult&& dwResult) {
+      ++result.nrResults;
+      result.nrFailedResults += dwResult.success ? 0 : 1;
+      result.nrCircuitOpenResults += TransferError::CIRCUIT_OPEN == dwResult.transferError ? 1 : 0;
+    }};
+    for(size_t url = 0; url < urlsPerHost; ++url) {
+      for(size_t host = 0; host < nrHosts; ++host) {
+        batch.add("http://host" + std::to_string(host) + ".com/" + std::to_string(url), static_cast<int>(url));
+      }
+    }
+    return batch;
+  };
+  Crawler crawler{[&result, nrBatches]() { return result.nrBatches < nrBatches; },
+                  dispatcher,
+                  &simulator,
+                  maxActiveQueues,
+                  politenessDelay,
+                  &simulator};
+  if(nullptr != adaptiveConcurrency) {
+    crawler.adaptConcurrency(*adaptiveConcurrency);
+  }
+  if(nullptr != hostConcurrency) {
+    crawler.setHostConcurrency(*hostConcurrency);
+  }
+  crawler.setPrewarmWindow(prewarmWindow);
+  crawler.setCircuitBreaker(circuitBreaker);
+  crawler.crawl();
+  return result;
+}
+
+} // namespace
+
+TEST(SimulatedDownloader, politeCrawlOnVirtualTime) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  SimulatedDownloader simulator{profile, 2s};
+
+  const SimulatedCrawl crawl = simulateCrawl(simulator, 1000, 10, 100, 2s);
+  EXPECT_EQ(10000u, crawl.nrResults);
+  EXPECT_EQ(0u, crawl.nrFailedResults);
+
+  const SimulationStats stats = simulator.stats();
+  EXPECT_EQ(11000u, stats.nrDownloads); // with the robots.txt downloads
+  EXPECT_EQ(0u, stats.nrPolitenessViolations);
+  EXPECT_EQ(100u, stats.maxActiveDownloads);
+  // each host waits 2 seconds between its 11 downloads
+  EXPECT_GT(stats.virtualDuration, 20s);
+  EXPECT_GT(stats.slotUtilisation(100), .5);
+  EXPECT_LE(stats.slotUtilisation(100), 1.);
+}
+
+TEST(SimulatedDownloader, detectsPolitenessViolations) {
+  SimulatedDownloader simulator{SimulationProfile{}, 2s};
+  simulateCrawl(simulator, 10, 3, 10, 0s);
+  EXPECT_GT(simulator.stats().nrPolitenessViolations, 0u);
+}
+
+TEST(SimulatedDownloader, deadHosts) {
+  SimulationProfile profile;
+  profile.deadHostRate = 1;
+  SimulatedDownloader simulator{profile, 0s};
+
+  const SimulatedCrawl crawl = simulateCrawl(simulator, 10, 3, 10, 0s);
+  EXPECT_EQ(30u, crawl.nrResults);
+  EXPECT_EQ(30u, crawl.nrFailedResults);
+  EXPECT_EQ(40u, simulator.stats().nrFailedDownloads);
+}
+
+TEST(SimulatedDownloader, advanceWithoutDownloads) {
+  SimulatedDownloader simulator{SimulationProfile{}, 0s};
+  const SteadyTime    start = simulator.now();
+  simulator.advance(start + 1h);
+  EXPECT_EQ(start + 1h, simulator.now());
+  EXPECT_THROW(simulator.advance(SteadyTime::max()), std::logic_error);
+}
+
+TEST(SimulatedDownloader, downloadsAboveCapacityTimeOut) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  profile.capacity     = 50;
+  profile.timeout      = 5s;
+  SimulatedDownloader simulator{profile, 0s};
+
+  const SimulatedCrawl crawl = simulateCrawl(simulator, 1000, 2, 100, 0s);
+  EXPECT_GT(crawl.nrFailedResults, 500u);
+  EXPECT_EQ(100u, simulator.stats().maxActiveDownloads);
+}
+
+TEST(SimulatedDownloader, adaptiveConcurrencyFindsTheCapacity) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  profile.capacity     = 50;
+  profile.timeout      = 5s;
+  SimulatedDownloader simulator{profile, 0s};
+
+  AdaptiveConcurrencyOptions adaptive;
+  adaptive.maxActiveDownloads = 500;
+  const SimulatedCrawl crawl  = simulateCrawl(simulator, 5000, 4, 10, 0s, &adaptive);
+  EXPECT_EQ(20000u, crawl.nrResults);
+  EXPECT_LT(crawl.nrFailedResults, 1000u);
+  const SimulationStats stats = simulator.stats();
+  EXPECT_GT(stats.meanActiveDownloads, 30.);
+  EXPECT_LT(stats.maxActiveDownloads, 150u);
+}
+
+TEST(SimulatedDownloader, hostSlotsCrawlFaster) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  SimulatedDownloader oneSlot{profile, 2s};
+  simulateCrawl(oneSlot, 10, 40, 100, 2s);
+
+  profile.hostSlots = 4;
+  SimulatedDownloader fourSlots{profile, 2s};
+  HostConcurrency     hostConcurrency;
+  hostConcurrency.defaultSlots = 4;
+  const SimulatedCrawl crawl   = simulateCrawl(fourSlots, 10, 40, 100, 2s, nullptr, &hostConcurrency);
+  EXPECT_EQ(400u, crawl.nrResults);
+
+  const SimulationStats stats = fourSlots.stats();
+  EXPECT_EQ(0u, stats.nrPolitenessViolations);
+  EXPECT_GT(stats.maxActiveDownloads, 10u);
+  EXPECT_LE(stats.maxActiveDownloads, 40u);
+  EXPECT_LT(stats.virtualDuration * 2, oneSlot.stats().virtualDuration);
+}
+
+TEST(SimulatedDownloader, hostSlotsOfAPolitenessKey) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  profile.hostSlots    = 3;
+  SimulatedDownloader simulator{profile, 2s};
+  HostConcurrency     hostConcurrency;
+  hostConcurrency.slots["host0.com"] = 3;
+  const SimulatedCrawl crawl         = simulateCrawl(simulator, 2, 20, 100, 2s, nullptr, &hostConcurrency);
+  EXPECT_EQ(40u, crawl.nrResults);
+
+  const SimulationStats stats = simulator.stats();
+  EXPECT_EQ(0u, stats.nrPolitenessViolations);
+  EXPECT_EQ(4u, stats.maxActiveDownloads); // 3 of host0.com and 1 of host1.com
+}
+
+TEST(SimulatedDownloader, multiplexedHostsGetMoreSlots) {
+  SimulationProfile profile;
+  profile.deadHostRate        = 0;
+  profile.errorRate           = 0;
+  profile.multiplexedHostRate = 1;
+  profile.hostSlots           = 4;
+  SimulatedDownloader oneSlot{profile, 2s};
+  simulateCrawl(oneSlot, 10, 40, 100, 2s);
+
+  SimulatedDownloader multiplexed{profile, 2s};
+  HostConcurrency     hostConcurrency;
+  hostConcurrency.multiplexedSlots = 4;
+  const SimulatedCrawl crawl       = simulateCrawl(multiplexed, 10, 40, 100, 2s, nullptr, &hostConcurrency);
+  EXPECT_EQ(400u, crawl.nrResults);
+
+  const SimulationStats stats = multiplexed.stats();
+  EXPECT_EQ(0u, stats.nrPolitenessViolations);
+  EXPECT_GT(stats.maxActiveDownloads, 10u);
+  EXPECT_LT(stats.virtualDuration * 2, oneSlot.stats().virtualDuration);
+}
+
+TEST(SimulatedDownloader, prewarmsBeforeThePolitenessDelayEnds) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  SimulatedDownloader simulator{profile, 2s};
+  const SimulatedCrawl crawl = simulateCrawl(simulator, 100, 5, 1000, 2s, nullptr, nullptr, 200ms);
+  EXPECT_EQ(500u, crawl.nrResults);
+
+  const SimulationStats stats = simulator.stats();
+  EXPECT_EQ(0u, stats.nrPolitenessViolations);
+  // every url waits the delay after the robots.txt or the previous url of its host
+  EXPECT_EQ(500u, stats.nrPrewarms);
+  EXPECT_EQ(500u, stats.nrPrewarmedDownloads);
+}
+
+TEST(SimulatedDownloader, noPrewarmsWithoutWindow) {
+  SimulatedDownloader simulator{SimulationProfile{}, 2s};
+  simulateCrawl(simulator, 10, 5, 100, 2s);
+  EXPECT_EQ(0u, simulator.stats().nrPrewarms);
+}
+
+TEST(SimulatedDownloader, circuitBreakerStopsDownloadingFromDeadHosts) {
+  SimulationProfile profile;
+  profile.deadHostRate = 1;
+  SimulatedDownloader   simulator{profile, 0s};
+  CircuitBreakerOptions circuitBreaker;
+  circuitBreaker.maxConsecutiveFailures = 2;
+  circuitBreaker.cooldown               = 60s;
+
+  const SimulatedCrawl crawl = simulateCrawl(simulator, 10, 10, 10, 0s, nullptr, nullptr, 0ms, circuitBreaker, 2);
+  EXPECT_EQ(200u, crawl.nrResults);
+  EXPECT_EQ(200u, crawl.nrFailedResults);
+  // per host the robots.txt and the first url open the circuit, the second url probes the host and trips it,
+  // the following batch starts before the cooldown passed
+  EXPECT_EQ(180u, crawl.nrCircuitOpenResults);
+  const SimulationStats stats = simulator.stats();
+  EXPECT_EQ(30u, stats.nrFailedDownloads);
+  EXPECT_GE(stats.virtualDuration, 60s);
+}
+
+TEST(SimulatedDownloader, circuitBreakerKeepsHealthyHosts) {
+  SimulationProfile profile;
+  profile.deadHostRate = 0;
+  profile.errorRate    = 0;
+  SimulatedDownloader   simulator{profile, 2s};
+  CircuitBreakerOptions circuitBreaker;
+  circuitBreaker.maxConsecutiveFailures = 1;
+
+  const SimulatedCrawl crawl = simulateCrawl(simulator, 100, 5, 100, 2s, nullptr, nullptr, 0ms, circuitBreaker);
+  EXPECT_EQ(500u, crawl.nrResults);
+  EXPECT_EQ(0u, crawl.nrFailedResults);
+  EXPECT_EQ(0u, simulator.stats().nrPolitenessViolations);
+}
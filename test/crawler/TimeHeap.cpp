@@ -11,18 +11,22 @@ struct TimeHeapFixture : public ::testing::Test {
       , url1_2{"http://url1.com/23.htm", 1}
       , url2_1{"http://url2.com", 2}
       , url2_2{"http://url2.com/23.htm", 3}
+      , arena{}
       , dwList2x2Urls{}
-      , dwQueueItUrl1{dwList2x2Urls.getQueueByHost("url1.com")}
-      , dwQueueItUrl2{dwList2x2Urls.getQueueByHost("url2.com")} {
-    dwList2x2Urls.addDownload(dwQueueItUrl1, {url1_1});
-    dwList2x2Urls.addDownload(dwQueueItUrl1, {url1_2});
-    dwList2x2Urls.addDownload(dwQueueItUrl2, {url2_1});
-    dwList2x2Urls.addDownload(dwQueueItUrl2, {url2_2});
+      , dwQueueItUrl1{dwList2x2Urls.getQueue("url1.com")}
+      , dwQueueItUrl2{dwList2x2Urls.getQueue("url2.com")} {
+    for(const Url& url: {url1_1, url1_2}) {
+      dwList2x2Urls.addDownload(dwQueueItUrl1, arena.add(std::get<0>(url), std::get<1>(url)));
+    }
+    for(const Url& url: {url2_1, url2_2}) {
+      dwList2x2Urls.addDownload(dwQueueItUrl2, arena.add(std::get<0>(url), std::get<1>(url)));
+    }
   }
   Url                             url1_1;
   Url                             url1_2;
   Url                             url2_1;
   Url                             url2_2;
+  UrlArena                        arena;
   DownloadQueues                  dwList2x2Urls;
   DownloadQueues::DownloadQueueIt dwQueueItUrl1;
   DownloadQueues::DownloadQueueIt dwQueueItUrl2;
@@ -32,8 +36,12 @@ namespace {
 
 struct QueuePopper {
   DownloadQueues* downloadQueues;
+  const UrlArena* arena;
   auto            operator()(DownloadQueues::DownloadQueueIt dwQueue) {
-    return [=]() { return downloadQueues->popDownload(dwQueue); };
+    return [downloadQueues = downloadQueues, arena = arena, dwQueue]() {
+      const UrlHandle url = downloadQueues->popDownload(dwQueue).url;
+      return DownloadElem{Url{std::string{arena->url(url)}, url.urlIndex}};
+    };
   }
 };
 
@@ -41,20 +49,20 @@ struct QueuePopper {
 
 TEST(TimeHeap, initializeEmpty) {
   DownloadQueues emptyQueue;
-  TimeHeap       timeHeap{emptyQueue, 0, QueuePopper{&emptyQueue}};
+  TimeHeap       timeHeap{emptyQueue, 0, QueuePopper{&emptyQueue, nullptr}};
   EXPECT_TRUE(timeHeap.empty());
   EXPECT_THROW(timeHeap.topTime(), std::logic_error);
   EXPECT_THROW(timeHeap.pop(), std::logic_error);
 }
 
 TEST_F(TimeHeapFixture, initialize) {
-  TimeHeap timeHeap{dwList2x2Urls, 2, QueuePopper{&dwList2x2Urls}};
+  TimeHeap timeHeap{dwList2x2Urls, 2, QueuePopper{&dwList2x2Urls, &arena}};
   EXPECT_GT(std::chrono::steady_clock::now(), timeHeap.topTime());
   EXPECT_FALSE(timeHeap.empty());
 }
 
 TEST_F(TimeHeapFixture, popOnly) {
-  TimeHeap         timeHeap{dwList2x2Urls, 2, QueuePopper{&dwList2x2Urls}};
+  TimeHeap         timeHeap{dwList2x2Urls, 2, QueuePopper{&dwList2x2Urls, &arena}};
   std::vector<Url> poped;
   for(int i = 0; i < 2; ++i) {
     poped.push_back(timeHeap.pop().url);
@@ -67,19 +75,19 @@ TEST_F(TimeHeapFixture, popOnly) {
 
 TEST_F(TimeHeapFixture, pushAndPop) {
   DownloadQueues emptyQueue;
-  TimeHeap       timeHeap{emptyQueue, 2, QueuePopper{&emptyQueue}};
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl1));
+  TimeHeap       timeHeap{emptyQueue, 2, QueuePopper{&emptyQueue, &arena}};
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl1));
   EXPECT_EQ(timeHeap.pop().url, url1_2);
   EXPECT_TRUE(timeHeap.empty());
 }
 
 TEST_F(TimeHeapFixture, multiplePushAndPop) {
   DownloadQueues emptyQueue;
-  TimeHeap       timeHeap{emptyQueue, 2, QueuePopper{&emptyQueue}};
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl1));
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl2));
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl1));
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl2));
+  TimeHeap       timeHeap{emptyQueue, 2, QueuePopper{&emptyQueue, &arena}};
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl1));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl2));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl1));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl2));
   EXPECT_EQ(timeHeap.pop().url, url1_2);
   EXPECT_EQ(timeHeap.pop().url, url2_2);
   EXPECT_EQ(timeHeap.pop().url, url1_1);
@@ -89,13 +97,13 @@ TEST_F(TimeHeapFixture, multiplePushAndPop) {
 
 TEST_F(TimeHeapFixture, multipleInterleavingPushAndPop) {
   DownloadQueues emptyQueue;
-  TimeHeap       timeHeap{emptyQueue, 2, QueuePopper{&emptyQueue}};
+  TimeHeap       timeHeap{emptyQueue, 2, QueuePopper{&emptyQueue, &arena}};
 
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl1));
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl1));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl1));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl1));
   EXPECT_EQ(timeHeap.pop().url, url1_2);
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl2));
-  timeHeap.push(QueuePopper{&emptyQueue}(dwQueueItUrl2));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl2));
+  timeHeap.push(QueuePopper{&emptyQueue, &arena}(dwQueueItUrl2));
   EXPECT_EQ(timeHeap.pop().url, url1_1);
   EXPECT_EQ(timeHeap.pop().url, url2_2);
   EXPECT_EQ(timeHeap.pop().url, url2_1);
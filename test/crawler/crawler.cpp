@@ -28,6 +28,7 @@ using ::testing::Field;
 using ::testing::InSequence;
 using ::testing::Return;
 using ::testing::Test;
+using ::testing::UnorderedElementsAre;
 
 namespace {
 
@@ -90,6 +91,8 @@ private:
     m_downloads.emplace_back(std::move(callbackResult));
   }
 
+  void doPrefetchHost(std::string_view url) override { prefetchedUrls.emplace_back(url); }
+
 public:
   void checkHostTimeouts(std::chrono::seconds expectedDelay) { m_expectedDelay = expectedDelay; }
 
@@ -112,7 +115,8 @@ public:
   }
 
   ~DownloaderMock() { finishDownloads(); }
-  size_t maxNrDownloads;
+  size_t                   maxNrDownloads;
+  std::vector<std::string> prefetchedUrls;
 
 private:
   using SteadyTime = std::chrono::time_point<std::chrono::steady_clock>;
@@ -329,6 +333,17 @@ TEST_P(CrawlerOnceFixture, testMaxActiveQueues) {
   crawlAndWaitForDownloadsToFinish();
 }
 
+TEST_P(CrawlerOnceFixture, prefetchesTheHostOfEachQueue) {
+  EXPECT_CALL(dispatcherMock, doGetUrls())
+      .WillOnce(Return(std::vector<DownloadElem>{sampleHost1Url2.enableDownload(),
+                                                 sampleHost1Url3.enableDownload(),
+                                                 sampleHost2Url1.enableDownload()}));
+  EXPECT_CALL(downloaderMock, doDownloadProxy(_)).Times(5);
+
+  crawlAndWaitForDownloadsToFinish();
+  EXPECT_THAT(downloaderMock.prefetchedUrls, UnorderedElementsAre(sampleUrl1RobotsTxt, sampleUrl2RobotsTxt));
+}
+
 struct CrawlerWithTimeoutFixture : public CrawlerOnceFixture {
   CrawlerWithTimeoutFixture() : CrawlerOnceFixture{std::chrono::seconds{2}} {}
 };
@@ -0,0 +1,21 @@
+#ifndef TEST_TESTUTILS_TESTFILENAME_H_R8MWQ3ZT
+#define TEST_TESTUTILS_TESTFILENAME_H_R8MWQ3ZT
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+/**
+ * @returns a file in the temporary directory named after the running test, ctest runs the tests in parallel processes
+ */
+inline std::string
+testFilename(const std::string_view prefix, const std::string_view extension) {
+  const ::testing::TestInfo* const test = ::testing::UnitTest::GetInstance()->current_test_info();
+  std::string                      result{::testing::TempDir()};
+  result.append(prefix).append(1, '_').append(test->name()).append(1, '_').append(std::to_string(getpid()));
+  return result.append(extension);
+}
+
+#endif /* end of include guard: TEST_TESTUTILS_TESTFILENAME_H_R8MWQ3ZT */
@@ -0,0 +1,72 @@
+#include "DnsCache.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+DnsCacheLimits
+limits(const size_t maxEntries) {
+  DnsCacheLimits result;
+  result.maxEntries  = maxEntries;
+  result.ttl         = 300s;
+  result.negativeTtl = 30s;
+  return result;
+}
+
+} // namespace
+
+TEST(DnsCache, findsTheAnswerUntilItExpires) {
+  const SteadyTime start;
+  DnsCache         cache{limits(10)};
+  EXPECT_EQ(nullptr, cache.find("a.com", start));
+  cache.insert("a.com", {"10.0.0.1", "10.0.0.2"}, start);
+  const DnsAnswer* const answer = cache.find("a.com", start + 299s);
+  ASSERT_NE(nullptr, answer);
+  EXPECT_THAT(answer->addresses, ::testing::ElementsAre("10.0.0.1", "10.0.0.2"));
+  EXPECT_EQ(nullptr, cache.find("a.com", start + 300s));
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(DnsCache, failuresExpireEarlier) {
+  const SteadyTime start;
+  DnsCache         cache{limits(10)};
+  cache.insert("unknown.com", {}, start);
+  const DnsAnswer* const answer = cache.find("unknown.com", start + 29s);
+  ASSERT_NE(nullptr, answer);
+  EXPECT_TRUE(answer->addresses.empty());
+  EXPECT_EQ(nullptr, cache.find("unknown.com", start + 30s));
+}
+
+TEST(DnsCache, evictsTheLeastRecentlyUsed) {
+  const SteadyTime start;
+  DnsCache         cache{limits(2)};
+  cache.insert("a.com", {"10.0.0.1"}, start);
+  cache.insert("b.com", {"10.0.0.2"}, start);
+  EXPECT_NE(nullptr, cache.find("a.com", start));
+  cache.insert("c.com", {"10.0.0.3"}, start);
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_NE(nullptr, cache.find("a.com", start));
+  EXPECT_EQ(nullptr, cache.find("b.com", start));
+  EXPECT_NE(nullptr, cache.find("c.com", start));
+}
+
+TEST(DnsCache, insertReplacesTheAnswer) {
+  const SteadyTime start;
+  DnsCache         cache{limits(2)};
+  cache.insert("a.com", {}, start);
+  cache.insert("a.com", {"10.0.0.1"}, start + 10s);
+  EXPECT_EQ(1u, cache.size());
+  const DnsAnswer* const answer = cache.find("a.com", start + 100s);
+  ASSERT_NE(nullptr, answer);
+  EXPECT_THAT(answer->addresses, ::testing::ElementsAre("10.0.0.1"));
+}
+
+TEST(DnsCache, curlResolveEntries) {
+  EXPECT_THAT(curlResolveEntries("a.com", "443", DnsAnswer{{"10.0.0.1", "2001:db8::1"}, SteadyTime{}}),
+              ::testing::ElementsAre("-a.com:443", "a.com:443:10.0.0.1,[2001:db8::1]"));
+}
@@ -0,0 +1,63 @@
+#include "HeaderHandler.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @returns false if the handler aborted the download on one of the lines
+ */
+bool
+handleHeader(HeaderHandler& handler, const std::vector<std::string>& lines) {
+  for(std::string line: lines) {
+    if(line.size() != handler(line.data(), line.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct HeaderHandlerFixture : public ::testing::Test {
+  HeaderHandlerFixture()
+      : Test{}, errors{}, handler{[](const MediaType& mediaType) { return "html" == mediaType.subtype; }, &errors} {}
+
+  std::ostringstream errors;
+  HeaderHandler      handler;
+};
+
+} // namespace
+
+TEST_F(HeaderHandlerFixture, statusLinesOfAllHttpVersions) {
+  for(const char* const statusLine: {"HTTP/1.0 200 OK\r\n", "HTTP/1.1 200 OK\r\n", "HTTP/2 200 \r\n", "HTTP/3 200\r\n"}) {
+    handler.reuse();
+    EXPECT_TRUE(handleHeader(handler, {statusLine, "Content-Type: text/html; charset=UTF-8\r\n", "\r\n"}))
+        << statusLine << errors.str();
+    EXPECT_EQ("text", handler.getMediaType().type) << statusLine;
+    EXPECT_EQ("UTF-8", handler.getMediaType().charset) << statusLine;
+  }
+}
+
+TEST_F(HeaderHandlerFixture, http2LowercaseFieldNames) {
+  EXPECT_TRUE(handleHeader(handler, {"HTTP/2 200 \r\n", "content-type: text/html\r\n", "\r\n"}));
+  EXPECT_EQ("html", handler.getMediaType().subtype);
+}
+
+TEST_F(HeaderHandlerFixture, abortsUnsuccessfulResponses) {
+  EXPECT_FALSE(handleHeader(handler, {"HTTP/2 404 \r\n"}));
+  handler.reuse();
+  EXPECT_FALSE(handleHeader(handler, {"HTTP/1.1 500 Internal Server Error\r\n"}));
+  handler.reuse();
+  EXPECT_FALSE(handleHeader(handler, {"HTTP/2 200 \r\n", "content-type: image/png\r\n"}));
+}
+
+TEST_F(HeaderHandlerFixture, abortsUnknownStatusLines) {
+  for(const char* const statusLine: {"HTTP/4 200 OK\r\n", "HTTP/2 2000\r\n", "ICY 200 OK\r\n"}) {
+    handler.reuse();
+    EXPECT_FALSE(handleHeader(handler, {statusLine})) << statusLine;
+  }
+}
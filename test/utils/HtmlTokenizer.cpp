@@ -0,0 +1,148 @@
+#include "HtmlTokenizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+namespace {
+
+/**
+ * @returns the reported tags as "name attribute=value ..." strings
+ */
+std::vector<std::string>
+tokenize(HtmlTokenizer& tokenizer, const std::string& html, const size_t chunkSize) {
+  std::vector<std::string> result;
+  for(size_t size = std::min(chunkSize, html.size());; size = std::min(size + chunkSize, html.size())) {
+    // a copy, the buffer may move between the calls
+    const std::string received = html.substr(0, size);
+    tokenizer.feed(received, [&result](const HtmlTag& tag) {
+      std::string text = std::to_string(static_cast<int>(tag.name));
+      for(const HtmlAttribute& attribute: tag.attributes) {
+        text += ' ' + std::string{attribute.name} + '=' + std::string{attribute.value};
+      }
+      result.push_back(text);
+    });
+    if(size == html.size()) {
+      return result;
+    }
+  }
+}
+
+std::vector<std::string>
+tokenize(const std::string& html, const SimdLevel simdLevel = SimdLevel::SCALAR) {
+  HtmlTokenizer tokenizer{simdLevel};
+  return tokenize(tokenizer, html, html.size());
+}
+
+std::string
+tag(const HtmlTagName name, const std::string& attributes = "") {
+  return std::to_string(static_cast<int>(name)) + attributes;
+}
+
+/**
+ * A page with all kinds of tags, comments and scripts at random positions.
+ */
+std::string
+generatePage(const uint32_t seed) {
+  static const std::vector<std::string> PIECES{
+      "<p>text</p>",
+      "<a href=\"/page\">link</a>",
+      "<A HREF='/UPPER'>",
+      "<img src=x.png alt=\"1 < 2\">",
+      "<link rel=stylesheet href=s.css>",
+      "<meta name=robots content=\"index\">",
+      "<base href=\"http://a.com/\">",
+      "<!-- <a href=\"/hidden\"> -->",
+      "<script>if(a<b){document.write('<a href=\"/js\">')}</script>",
+      "<style>a[href=\"/css\"]{}</style>",
+      "<!DOCTYPE html>",
+      "<section><span>s</span></section>",
+      "<iframe src=\"/frame\"></iframe>",
+      "<area shape=rect href=/area>",
+      "\n    ",
+      "plain text with a < sign",
+  };
+  std::mt19937 random{seed};
+  std::string  result;
+  for(size_t piece = 0; piece < 500; ++piece) {
+    result += PIECES[random() % PIECES.size()];
+  }
+  return result;
+}
+
+std::vector<SimdLevel>
+supportedSimdLevels() {
+  std::vector<SimdLevel> result{SimdLevel::SCALAR};
+  if(SimdLevel::SCALAR != bestSimdLevel()) {
+    result.push_back(SimdLevel::SSE2);
+  }
+  if(SimdLevel::AVX2 == bestSimdLevel()) {
+    result.push_back(SimdLevel::AVX2);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(HtmlTokenizer, reportedTags) {
+  EXPECT_THAT(tokenize("<html><A Href=\"/a\" class=x>a</a><div><img src='i.png' alt></div><link rel=icon href=/f>"),
+              ElementsAre(tag(HtmlTagName::A, " Href=/a class=x"),
+                          tag(HtmlTagName::IMG, " src=i.png alt="),
+                          tag(HtmlTagName::LINK, " rel=icon href=/f")));
+  EXPECT_THAT(tokenize("<meta charset=utf-8 /><base href=/><script src=s.js></script><style></style>"),
+              ElementsAre(tag(HtmlTagName::META, " charset=utf-8"),
+                          tag(HtmlTagName::BASE, " href=/"),
+                          tag(HtmlTagName::SCRIPT, " src=s.js"),
+                          tag(HtmlTagName::STYLE)));
+  EXPECT_THAT(tokenize("<abbr><span><b><small><address><frame src=f><iframe src=i>"),
+              ElementsAre(tag(HtmlTagName::FRAME, " src=f"), tag(HtmlTagName::IFRAME, " src=i")));
+}
+
+TEST(HtmlTokenizer, skippedContent) {
+  EXPECT_THAT(tokenize("<!-- <a href=1> --><script> '<a href=2>' </Script><style><a href=3></STYLE><a href=4>"),
+              ElementsAre(tag(HtmlTagName::SCRIPT), tag(HtmlTagName::STYLE), tag(HtmlTagName::A, " href=4")));
+  EXPECT_THAT(tokenize("<!DOCTYPE html><!a><a href=1>"), ElementsAre(tag(HtmlTagName::A, " href=1")));
+}
+
+TEST(HtmlTokenizer, unclosedTagsEndTheScan) {
+  EXPECT_THAT(tokenize("<a href=1><a href='2>"), ElementsAre(tag(HtmlTagName::A, " href=1")));
+  EXPECT_THAT(tokenize("<a href=1><script>"), ElementsAre(tag(HtmlTagName::A, " href=1"), tag(HtmlTagName::SCRIPT)));
+  EXPECT_THAT(tokenize("<!-- <a href=1>"), IsEmpty());
+  EXPECT_THAT(tokenize("<a"), IsEmpty());
+  EXPECT_THAT(tokenize("<"), IsEmpty());
+  EXPECT_THAT(tokenize(""), IsEmpty());
+}
+
+TEST(HtmlTokenizer, incrementalScanMatchesTheWholePage) {
+  const std::string              page     = generatePage(1);
+  const std::vector<std::string> expected = tokenize(page);
+  ASSERT_LT(100u, expected.size());
+  for(const size_t chunkSize: {1, 2, 3, 7, 16, 31, 64, 1000}) {
+    for(const SimdLevel simdLevel: supportedSimdLevels()) {
+      HtmlTokenizer tokenizer{simdLevel};
+      EXPECT_EQ(expected, tokenize(tokenizer, page, chunkSize)) << "chunkSize: " << chunkSize;
+    }
+  }
+}
+
+TEST(HtmlTokenizer, simdLevelsMatchScalar) {
+  for(uint32_t seed = 0; seed < 20; ++seed) {
+    const std::string page = generatePage(seed);
+    for(const SimdLevel simdLevel: supportedSimdLevels()) {
+      EXPECT_EQ(tokenize(page), tokenize(page, simdLevel)) << "seed: " << seed;
+    }
+  }
+}
+
+TEST(HtmlTokenizer, reset) {
+  HtmlTokenizer tokenizer;
+  tokenize(tokenizer, "<script>", 8);
+  tokenizer.reset();
+  EXPECT_THAT(tokenize(tokenizer, "<a href=1>", 10), ElementsAre(tag(HtmlTagName::A, " href=1")));
+}
@@ -0,0 +1,96 @@
+#include "Logger.h"
+#include "testFilename.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+LOG_INIT(LoggerTest);
+
+namespace {
+
+struct LoggerFixture : public ::testing::Test {
+  LoggerFixture() : Test{}, filename{testFilename("LoggerTest", ".log")} { setLoggingOutput(filename); }
+  ~LoggerFixture() {
+    setLoggingOutput("");
+    std::remove(filename.c_str());
+  }
+
+  std::vector<std::string> readLines() {
+    flushLogging();
+    std::ifstream            input{filename};
+    std::vector<std::string> lines;
+    for(std::string line; std::getline(input, line);) {
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  std::string filename;
+};
+
+int
+countFormatting(int& o_count) {
+  return ++o_count;
+}
+
+} // namespace
+
+TEST_F(LoggerFixture, messagesAreWrittenToOutput) {
+  LOG_INFO("info " << 1);
+  LOG_ERROR("error " << std::hex << 255);
+  LOG_INFO(255);
+  EXPECT_THAT(readLines(),
+              testing::ElementsAre("[INFO] LoggerTest: info 1",
+                                   "[ERROR] LoggerTest: error ff",
+                                   "[INFO] LoggerTest: 255"));
+}
+
+TEST_F(LoggerFixture, disabledDebugMessagesAreNotFormatted) {
+  int nrFormatted = 0;
+  LOG_DEBUG(countFormatting(nrFormatted));
+  EXPECT_EQ(0, nrFormatted);
+#ifndef NDEBUG
+  enableDebugLogging("LoggerTest");
+  LOG_DEBUG(countFormatting(nrFormatted));
+  enableDebugLogging("LoggerTest", false);
+  EXPECT_EQ(1, nrFormatted);
+  EXPECT_EQ("[DEBUG] LoggerTest: 1", readLines().back());
+#endif
+}
+
+TEST_F(LoggerFixture, longMessagesAreTruncated) {
+  LOG_INFO(std::string(1 << 20, 'a'));
+  const auto lines = readLines();
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_LT(lines.back().size(), 1u << 20);
+  EXPECT_THAT(lines.back(), testing::EndsWith("[truncated]"));
+}
+
+TEST_F(LoggerFixture, messagesFromAllThreadsAreWrittenOrCounted) {
+  constexpr int            NR_THREADS  = 4;
+  constexpr int            NR_MESSAGES = 100000;
+  const size_t             nrDropped   = getNrDroppedLogMessages();
+  std::vector<std::thread> threads;
+  for(int thread = 0; thread < NR_THREADS; ++thread) {
+    threads.emplace_back([thread]() {
+      for(int message = 0; message < NR_MESSAGES; ++message) {
+        LOG_INFO("thread " << thread << " message " << message);
+      }
+    });
+  }
+  for(auto& thread: threads) {
+    thread.join();
+  }
+
+  size_t nrMessages = 0;
+  for(const auto& line: readLines()) {
+    nrMessages += line.find(": thread ") != std::string::npos ? 1 : 0;
+  }
+  EXPECT_EQ(static_cast<size_t>(NR_THREADS * NR_MESSAGES), nrMessages + getNrDroppedLogMessages() - nrDropped);
+}
@@ -0,0 +1,74 @@
+#include "Metrics.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(Metrics, counterFromManyThreads) {
+  Counter&                 counter = getCounter("test_counter_total", "Test counter.");
+  std::vector<std::thread> threads;
+  for(int thread = 0; thread < 8; ++thread) {
+    threads.emplace_back([&counter]() {
+      for(int increment = 0; increment < 10000; ++increment) {
+        counter.add();
+      }
+    });
+  }
+  for(auto& thread: threads) {
+    thread.join();
+  }
+  EXPECT_EQ(80000u, counter.value());
+}
+
+TEST(Metrics, registeredOnce) {
+  Counter& counter = getCounter("test_labeled_total", "Test counter.", {{"result", "ok"}});
+  EXPECT_EQ(&counter, &getCounter("test_labeled_total", "Test counter.", {{"result", "ok"}}));
+  EXPECT_NE(&counter, &getCounter("test_labeled_total", "Test counter.", {{"result", "failed"}}));
+  EXPECT_THROW(getGauge("test_labeled_total", "Test gauge."), std::logic_error);
+}
+
+TEST(Metrics, histogramBuckets) {
+  for(uint64_t value = 0; value < 100000; value = value * 3 / 2 + 1) {
+    const size_t bucket = Histogram::bucketIndex(value);
+    EXPECT_LE(value, Histogram::bucketUpperBound(bucket));
+    if(bucket > 0) {
+      EXPECT_GT(value, Histogram::bucketUpperBound(bucket - 1));
+    }
+    // 8 sub buckets per power of two
+    EXPECT_LE(Histogram::bucketUpperBound(bucket) - value, value / 8);
+  }
+  EXPECT_EQ(Histogram::NR_BUCKETS - 1, Histogram::bucketIndex(Histogram::MAX_VALUE));
+  EXPECT_EQ(Histogram::NR_BUCKETS - 1, Histogram::bucketIndex(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(Metrics, histogramQuantiles) {
+  Histogram& histogram = getHistogram("test_latency_seconds", "Test histogram.", 1e-6);
+  EXPECT_EQ(0u, histogram.quantile(0.5));
+  for(uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(1000u, histogram.count());
+  EXPECT_EQ(500500u, histogram.sum());
+  EXPECT_NEAR(500, histogram.quantile(0.5), 500 / 8);
+  EXPECT_NEAR(990, histogram.quantile(0.99), 990 / 8);
+  EXPECT_EQ(1u, histogram.quantile(0));
+}
+
+TEST(Metrics, prometheusFormat) {
+  getGauge("test_queue_depth", "Test \"gauge\".", {{"host", "a\"b"}}).set(-3);
+  getHistogram("test_size_bytes", "Test sizes.", 1.).record(3);
+
+  std::ostringstream out;
+  writeMetrics(out);
+  const std::string text = out.str();
+  EXPECT_THAT(text, testing::HasSubstr("# TYPE test_queue_depth gauge\ntest_queue_depth{host=\"a\\\"b\"} -3\n"));
+  EXPECT_THAT(text, testing::HasSubstr("# TYPE test_size_bytes histogram\n"));
+  EXPECT_THAT(text, testing::HasSubstr("test_size_bytes_bucket{le=\"1\"} 0\n"));
+  EXPECT_THAT(text, testing::HasSubstr("test_size_bytes_bucket{le=\"3\"} 1\n"));
+  EXPECT_THAT(text, testing::HasSubstr("test_size_bytes_bucket{le=\"+Inf\"} 1\n"));
+  EXPECT_THAT(text, testing::HasSubstr("test_size_bytes_sum 3\ntest_size_bytes_count 1\n"));
+}
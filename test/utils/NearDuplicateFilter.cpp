@@ -0,0 +1,94 @@
+#include "DownloadResult.h"
+#include "NearDuplicateFilter.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+namespace {
+
+std::string
+page(const std::string& header, const unsigned topic) {
+  std::string result = "<html><body><h1>" + header + "</h1><p>";
+  for(unsigned word = 0; word < 1000; ++word) {
+    result += "w" + std::to_string((word * word + topic * 7919) % 1009) + " ";
+  }
+  return result + "</p></body></html>";
+}
+
+DownloadResult
+download(const std::string& url, const int urlIndex, const std::string& content, const bool success = true) {
+  DownloadResult result;
+  result.url     = Url{url, urlIndex};
+  result.content = content;
+  result.success = success;
+  return result;
+}
+
+/**
+ * Filters the downloads, the filter is destroyed before returning thus all the pages are processed.
+ */
+struct FilteredPages {
+  FilteredPages(const NearDuplicateOptions& options, std::vector<DownloadResult>&& downloads) {
+    NearDuplicateFilter filter{options, [this](DownloadResult&& result, const NearDuplicateTag& tag) {
+                                 std::lock_guard<std::mutex> lock{mutex};
+                                 urls.push_back(std::get<0>(result.url));
+                                 tags.push_back(tag);
+                               }};
+    for(DownloadResult& result: downloads) {
+      filter.process(std::move(result));
+    }
+  }
+
+  std::mutex                    mutex;
+  std::vector<std::string>      urls;
+  std::vector<NearDuplicateTag> tags;
+};
+
+} // namespace
+
+TEST(NearDuplicateFilter, skipsNearDuplicates) {
+  std::vector<DownloadResult> downloads;
+  downloads.push_back(download("http://a.com/", 0, page("Monday 10:00", 1)));
+  downloads.push_back(download("http://a.com/?today", 1, page("Tuesday 11:30", 1)));
+  downloads.push_back(download("http://b.com/", 2, page("Monday 10:00", 2)));
+  downloads.push_back(download("http://c.com/", 3, "", false));
+  downloads.push_back(download("http://d.com/", 4, "<img src=a.png>"));
+  downloads.push_back(download("http://e.com/", 5, "<img src=b.png>"));
+
+  NearDuplicateOptions options;
+  options.nrThreads = 4;
+  FilteredPages pages{options, std::move(downloads)};
+  ASSERT_EQ(5u, pages.urls.size());
+  EXPECT_EQ(1, std::count(begin(pages.urls), end(pages.urls), "http://a.com/")
+                   + std::count(begin(pages.urls), end(pages.urls), "http://a.com/?today"));
+  EXPECT_EQ(1, std::count(begin(pages.urls), end(pages.urls), "http://b.com/"));
+  for(const NearDuplicateTag& tag: pages.tags) {
+    EXPECT_FALSE(tag.nearDuplicate);
+  }
+}
+
+TEST(NearDuplicateFilter, tagsNearDuplicates) {
+  std::vector<DownloadResult> downloads;
+  downloads.push_back(download("http://a.com/", 7, page("Monday 10:00", 1)));
+  downloads.push_back(download("http://a.com/?today", 8, page("Tuesday 11:30", 1)));
+  downloads.push_back(download("http://a.com/", 9, page("Monday 10:00", 3)));
+
+  NearDuplicateOptions options;
+  options.action    = NearDuplicateAction::TAG;
+  options.nrThreads = 1;
+  FilteredPages pages{options, std::move(downloads)};
+  ASSERT_EQ(3u, pages.tags.size());
+  EXPECT_FALSE(pages.tags[0].nearDuplicate);
+  EXPECT_NE(0u, pages.tags[0].simHash);
+  EXPECT_TRUE(pages.tags[1].nearDuplicate);
+  EXPECT_EQ(7, pages.tags[1].originalUrlIndex);
+  EXPECT_FALSE(pages.tags[2].nearDuplicate);
+}
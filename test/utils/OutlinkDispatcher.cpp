@@ -0,0 +1,144 @@
+#include "DownloadResult.h"
+#include "OutlinkDispatcher.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+namespace {
+
+/**
+ * Crawls the pages of a fake web without a crawler.
+ */
+struct FakeWeb {
+  std::map<std::string, std::string> pages;
+  std::atomic<size_t>                nrResults{0};
+  ContentScannerFactory              scannerFactory{}; // the html pages are scanned like by the downloader
+
+  std::function<void(DownloadResult&&)> sink() {
+    return [this](DownloadResult&&) { ++nrResults; };
+  }
+
+  /**
+   * @returns the urls of each batch
+   */
+  std::vector<std::vector<std::string>> crawl(OutlinkDispatcher& dispatcher) {
+    std::vector<std::vector<std::string>> result;
+    while(dispatcher.hasUrls()) {
+      UrlBatch batch = dispatcher.nextBatch();
+      result.emplace_back();
+      for(const UrlHandle& handle: batch.urls) {
+        const std::string url{batch.arena.url(handle)};
+        result.back().push_back(url);
+        DownloadResult page;
+        page.url     = Url{url, handle.urlIndex};
+        page.success = pages.count(url);
+        page.content = page.success ? pages[url] : std::string{};
+        if(page.success && scannerFactory) {
+          page.scanner = scannerFactory(MediaType{"text", "html", ""});
+          page.scanner->scan(page.content);
+        }
+        batch.onFinished(std::move(page));
+      }
+    }
+    return result;
+  }
+};
+
+} // namespace
+
+TEST(OutlinkDispatcher, followsLinksUpToMaxDepth) {
+  FakeWeb web;
+  web.pages["http://a.com/"]  = R"(<a href="/1">1</a><a href="2">2</a><a href="http://a.com/1#top">1</a>)";
+  web.pages["http://a.com/1"] = R"(<a href="sub/3?x=1&amp;y=2">3</a><a href="/">home</a>)";
+  web.pages["http://a.com/2"] = R"html(<a href="mailto:me@a.com">mail</a><a href="javascript:void(0)">js</a>)html";
+
+  web.pages["http://a.com/sub/3?x=1&y=2"] = R"(<a href="/4">4</a>)";
+
+  OutlinkOptions options;
+  options.maxDepth = 2;
+  OutlinkDispatcher dispatcher{{"HTTP://A.com"}, options, web.sink()};
+  const auto        batches = web.crawl(dispatcher);
+  ASSERT_EQ(3u, batches.size());
+  EXPECT_THAT(batches[0], ElementsAre("http://a.com/"));
+  EXPECT_THAT(batches[1], UnorderedElementsAre("http://a.com/1", "http://a.com/2"));
+  EXPECT_THAT(batches[2], ElementsAre("http://a.com/sub/3?x=1&y=2"));
+  EXPECT_EQ(4u, web.nrResults);
+  EXPECT_EQ(4u, dispatcher.nrDispatchedUrls());
+}
+
+TEST(OutlinkDispatcher, followsTheLinksOfScannedPages) {
+  FakeWeb web;
+  web.pages["http://a.com/"]      = R"(<base href="/sub/"><a href="1">1</a>)";
+  web.pages["http://a.com/sub/1"] = R"(<meta name="robots" content="nofollow"><a href="/2">2</a>)";
+
+  OutlinkOptions options;
+  options.maxDepth = 2;
+  OutlinkDispatcher dispatcher{{"http://a.com/"}, options, web.sink()};
+  web.scannerFactory = dispatcher.scannerFactory();
+  EXPECT_EQ(nullptr, web.scannerFactory(MediaType{"image", "png", ""}));
+  const auto batches = web.crawl(dispatcher);
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_THAT(batches[1], ElementsAre("http://a.com/sub/1"));
+  EXPECT_EQ(2u, web.nrResults);
+}
+
+TEST(OutlinkDispatcher, sameHostScope) {
+  FakeWeb web;
+  web.pages["http://www.a.com/"] = R"(<a href="http://a.com/">a</a><a href="http://b.www.a.com/">b</a>)"
+                                   R"(<a href="https://www.a.com/s">s</a>)";
+  OutlinkDispatcher dispatcher{{"http://www.a.com/"}, OutlinkOptions{}, web.sink()};
+  const auto        batches = web.crawl(dispatcher);
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_THAT(batches[1], ElementsAre("https://www.a.com/s"));
+}
+
+TEST(OutlinkDispatcher, sameDomainScope) {
+  FakeWeb web;
+  web.pages["http://www.a.com/"] = R"(<a href="http://a.com/">a</a><a href="http://b.a.com/">b</a>)"
+                                   R"(<a href="http://ba.com/">c</a><a href="http://a.com.b.com/">d</a>)";
+  OutlinkOptions options;
+  options.scope = CrawlScope::SAME_DOMAIN;
+  OutlinkDispatcher dispatcher{{"http://www.a.com/"}, options, web.sink()};
+  const auto        batches = web.crawl(dispatcher);
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_THAT(batches[1], UnorderedElementsAre("http://a.com/", "http://b.a.com/"));
+}
+
+TEST(OutlinkDispatcher, allowListScope) {
+  FakeWeb web;
+  web.pages["http://a.com/"] = R"(<a href="http://b.com/">b</a><a href="http://x.c.com/">c</a><a href="/a">a</a>)";
+  OutlinkOptions options;
+  options.scope        = CrawlScope::ALLOW_LIST;
+  options.allowedHosts = {"B.com", "c.com"};
+  OutlinkDispatcher dispatcher{{"http://a.com/"}, options, web.sink()};
+  const auto        batches = web.crawl(dispatcher);
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_THAT(batches[1], UnorderedElementsAre("http://b.com/", "http://x.c.com/"));
+}
+
+TEST(OutlinkDispatcher, maxUrlsAndInvalidSeeds) {
+  FakeWeb web;
+  web.pages["http://a.com/"] = R"(<a href="/1">1</a><a href="/2">2</a><a href="/3">3</a>)";
+  OutlinkOptions options;
+  options.maxUrls = 3;
+  OutlinkDispatcher dispatcher{{"not an url", "http://a.com/", "http://a.com"}, options, web.sink()};
+  const auto        batches = web.crawl(dispatcher);
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_THAT(batches[0], ElementsAre("http://a.com/"));
+  EXPECT_EQ(2u, batches[1].size());
+}
+
+TEST(OutlinkDispatcher, noSeeds) {
+  FakeWeb           web;
+  OutlinkDispatcher dispatcher{{}, OutlinkOptions{}, web.sink()};
+  EXPECT_THAT(web.crawl(dispatcher), IsEmpty());
+}
@@ -0,0 +1,95 @@
+#include "SegmentFiles.h"
+#include "testFilename.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct SegmentWriterFixture : public ::testing::Test {
+  SegmentWriterFixture() : Test{}, filename{testFilename("SegmentWriterTest", ".seg")} {
+    std::remove(filename.c_str());
+  }
+  ~SegmentWriterFixture() { std::remove(filename.c_str()); }
+
+  std::string readFile() const {
+    std::ifstream input{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+  }
+
+  bool exists() const { return std::ifstream{filename}.good(); }
+
+  std::string filename;
+};
+
+StreamingOptions
+streamingOptions() {
+  StreamingOptions result;
+  result.directory = ::testing::TempDir();
+  result.streamed  = [](const MediaType& mediaType) { return "pdf" == mediaType.subtype; };
+  return result;
+}
+
+} // namespace
+
+TEST_F(SegmentWriterFixture, writesWholeBlocks) {
+  SegmentWriter writer{1};
+  ASSERT_TRUE(writer.open(filename));
+  const std::string content(SegmentWriter::BLOCK_SIZE * 2 + 100, 'x');
+  EXPECT_TRUE(writer.append(std::string_view{content}.substr(0, 100)));
+  EXPECT_EQ(0u, writer.written());
+  EXPECT_EQ(100u, writer.buffered());
+  EXPECT_TRUE(writer.append(std::string_view{content}.substr(100)));
+  EXPECT_EQ(SegmentWriter::BLOCK_SIZE * 2, writer.written());
+  EXPECT_EQ(100u, writer.buffered());
+
+  EXPECT_TRUE(writer.finish());
+  EXPECT_FALSE(writer.isOpen());
+  EXPECT_EQ(filename, writer.path());
+  EXPECT_EQ(content, readFile());
+}
+
+TEST_F(SegmentWriterFixture, discardRemovesTheFile) {
+  {
+    SegmentWriter writer{SegmentWriter::BLOCK_SIZE};
+    ASSERT_TRUE(writer.open(filename));
+    EXPECT_TRUE(writer.append("content"));
+    writer.discard();
+    EXPECT_FALSE(exists());
+    ASSERT_TRUE(writer.open(filename));
+    EXPECT_EQ(0u, writer.buffered());
+    EXPECT_TRUE(writer.append("content"));
+  }
+  // the writer of an unfinished transfer removes its file
+  EXPECT_FALSE(exists());
+}
+
+TEST_F(SegmentWriterFixture, doesNotReplaceFiles) {
+  std::ofstream{filename} << "kept";
+  SegmentWriter writer{SegmentWriter::BLOCK_SIZE};
+  EXPECT_FALSE(writer.open(filename));
+  EXPECT_THAT(writer.error(), ::testing::HasSubstr("open of the segment file"));
+  EXPECT_EQ("kept", readFile());
+}
+
+TEST(SegmentFiles, pathsAreUnique) {
+  SegmentFiles      files{streamingOptions()};
+  const std::string first = files.nextPath();
+  EXPECT_EQ(0u, first.find(::testing::TempDir()));
+  EXPECT_NE(first, files.nextPath());
+  EXPECT_TRUE(files.streamed(MediaType{"application", "pdf", ""}));
+  EXPECT_FALSE(files.streamed(MediaType{"text", "html", ""}));
+}
+
+TEST(SegmentFiles, invalidOptions) {
+  StreamingOptions options  = streamingOptions();
+  options.maxStreamedLength = options.memoryThreshold;
+  EXPECT_THROW(SegmentFiles{options}, std::invalid_argument);
+  EXPECT_THROW(SegmentFiles{StreamingOptions{}}, std::invalid_argument);
+}
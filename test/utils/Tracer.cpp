@@ -0,0 +1,111 @@
+#include "Tracer.h"
+#include "testFilename.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct TracerFixture : public ::testing::Test {
+  TracerFixture() : Test{}, filename{testFilename("TracerTest", ".fxt")} {}
+  ~TracerFixture() {
+    stopTracing();
+    std::remove(filename.c_str());
+  }
+
+  std::vector<uint64_t> readWords() {
+    stopTracing();
+    std::ifstream     input{filename, std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+    EXPECT_EQ(0u, content.size() % 8);
+    std::vector<uint64_t> result(content.size() / 8);
+    content.copy(reinterpret_cast<char*>(result.data()), result.size() * 8);
+    return result;
+  }
+
+  std::string filename;
+};
+
+struct Record {
+  uint64_t type;
+  uint64_t nrWords;
+};
+
+/**
+ * @returns the records of the trace, which must cover the trace exactly
+ */
+std::vector<Record>
+readRecords(const std::vector<uint64_t>& words) {
+  std::vector<Record> result;
+  for(size_t pos = 1; pos < words.size();) {
+    const Record record{words[pos] & 0xf, (words[pos] >> 4) & 0xfff};
+    EXPECT_NE(0u, record.nrWords);
+    if(0 == record.nrWords) {
+      break;
+    }
+    result.push_back(record);
+    pos += record.nrWords;
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_F(TracerFixture, disabledByDefault) { EXPECT_FALSE(sampleTrace()); }
+
+TEST_F(TracerFixture, sampling) {
+  startTracing(filename, 3);
+  std::vector<bool> sampled;
+  for(int transfer = 0; transfer < 6; ++transfer) {
+    sampled.push_back(sampleTrace());
+  }
+  EXPECT_THAT(sampled, testing::ElementsAre(true, false, false, true, false, false));
+  stopTracing();
+  EXPECT_FALSE(sampleTrace());
+}
+
+TEST_F(TracerFixture, transferSpans) {
+  startTracing(filename, 1);
+  const SteadyTime    start = std::chrono::steady_clock::now();
+  const TransferTimes times{start, start + 1ms, start + 3ms, start + 4ms, start + 5ms};
+  // a new TLS connection
+  const CurlTimes curlTimes{1000us, 2000us, 3000us, 4000us, 5000us};
+  traceTransfer("http://example.com/", times, curlTimes, start + 11ms, start + 12ms);
+  traceSpan("actionQueue", start, start + 1ms);
+
+  const std::vector<uint64_t> words = readWords();
+  ASSERT_FALSE(words.empty());
+  EXPECT_EQ(0x0016547846040010u, words[0]);
+  size_t nrEvents = 0;
+  for(const Record& record: readRecords(words)) {
+    nrEvents += 4 == record.type ? 1 : 0;
+  }
+  // download, queued, politeness, slotWait, dispatch, dns, connect, tls, ttfb, body, callback and actionQueue
+  EXPECT_EQ(12u, nrEvents);
+
+  const std::string content(reinterpret_cast<const char*>(words.data()), words.size() * 8);
+  EXPECT_THAT(content, testing::HasSubstr("http://example.com/"));
+  EXPECT_THAT(content, testing::HasSubstr("politeness"));
+}
+
+TEST_F(TracerFixture, missingTimesAreNotTraced) {
+  startTracing(filename, 1);
+  const SteadyTime start = std::chrono::steady_clock::now();
+  // only the download and the callback spans are known
+  traceTransfer("http://example.com/", TransferTimes{}, CurlTimes{}, start, start + 1ms);
+
+  size_t nrEvents = 0;
+  for(const Record& record: readRecords(readWords())) {
+    nrEvents += 4 == record.type ? 1 : 0;
+  }
+  EXPECT_EQ(2u, nrEvents);
+}
@@ -0,0 +1,109 @@
+#include "TransferTimeouts.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+TimeoutOptions
+adaptiveOptions() {
+  TimeoutOptions result;
+  result.connect       = 15s;
+  result.transfer      = 60s;
+  result.adaptive      = true;
+  result.latencyFactor = 4;
+  result.minConnect    = 1s;
+  result.minTransfer   = 10s;
+  return result;
+}
+
+} // namespace
+
+TEST(TransferTimeouts, configuredDeadlinesWithoutAdaptation) {
+  TimeoutOptions options = adaptiveOptions();
+  options.adaptive       = false;
+  TransferTimeouts timeouts{options};
+  for(int transfer = 0; transfer < 10; ++transfer) {
+    timeouts.record("http://a.com/page", 500ms, 5s);
+  }
+  const TransferDeadlines deadlines = timeouts.deadlines("http://a.com/page");
+  EXPECT_EQ(15s, deadlines.connect);
+  EXPECT_EQ(60s, deadlines.transfer);
+  EXPECT_EQ(0u, timeouts.nrOrigins());
+}
+
+TEST(TransferTimeouts, adaptsAfterEnoughTransfers) {
+  TransferTimeouts timeouts{adaptiveOptions()};
+  for(int transfer = 0; transfer < 3; ++transfer) {
+    timeouts.record("http://a.com/" + std::to_string(transfer), 500ms, 5s);
+  }
+  EXPECT_EQ(60s, timeouts.deadlines("http://a.com/next").transfer);
+  timeouts.record("http://a.com/3", 500ms, 5s);
+  const TransferDeadlines deadlines = timeouts.deadlines("http://a.com/next");
+  EXPECT_EQ(2s, deadlines.connect);
+  EXPECT_EQ(20s, deadlines.transfer);
+  // other origins keep the configured deadlines
+  EXPECT_EQ(60s, timeouts.deadlines("https://a.com/next").transfer);
+}
+
+TEST(TransferTimeouts, originsAreCanonical) {
+  TransferTimeouts timeouts{adaptiveOptions()};
+  timeouts.record("HTTP://A.com/0", 500ms, 5s);
+  timeouts.record("http://a.com:80/1", 500ms, 5s);
+  timeouts.record("http://user@a.com./2", 500ms, 5s);
+  timeouts.record("http://a.com/3", 500ms, 5s);
+  EXPECT_EQ(1u, timeouts.nrOrigins());
+  EXPECT_EQ(20s, timeouts.deadlines("http://A.COM/next").transfer);
+  EXPECT_EQ(60s, timeouts.deadlines("http://a.com:8080/next").transfer);
+}
+
+TEST(TransferTimeouts, deadlinesStayWithinTheLimits) {
+  TransferTimeouts timeouts{adaptiveOptions()};
+  for(int transfer = 0; transfer < 4; ++transfer) {
+    timeouts.record("http://fast.com/", 1ms, 100ms);
+    timeouts.record("http://slow.com/", 10s, 50s);
+  }
+  EXPECT_EQ(1s, timeouts.deadlines("http://fast.com/").connect);
+  EXPECT_EQ(10s, timeouts.deadlines("http://fast.com/").transfer);
+  EXPECT_EQ(15s, timeouts.deadlines("http://slow.com/").connect);
+  EXPECT_EQ(60s, timeouts.deadlines("http://slow.com/").transfer);
+}
+
+TEST(TransferTimeouts, percentileIgnoresAnOutlier) {
+  TransferTimeouts timeouts{adaptiveOptions()};
+  for(int transfer = 0; transfer < 15; ++transfer) {
+    timeouts.record("http://a.com/", 0ms, 3s);
+  }
+  timeouts.record("http://a.com/", 0ms, 40s);
+  EXPECT_EQ(12s, timeouts.deadlines("http://a.com/").transfer);
+  // reused connections do not count for the connect deadline
+  EXPECT_EQ(15s, timeouts.deadlines("http://a.com/").connect);
+}
+
+TEST(TransferTimeouts, forgetsTheOriginsWhenFull) {
+  TimeoutOptions options = adaptiveOptions();
+  options.maxOrigins     = 2;
+  TransferTimeouts timeouts{options};
+  timeouts.record("http://a.com/", 1ms, 1s);
+  timeouts.record("http://b.com/", 1ms, 1s);
+  timeouts.record("http://a.com/", 1ms, 1s);
+  EXPECT_EQ(2u, timeouts.nrOrigins());
+  timeouts.record("http://c.com/", 1ms, 1s);
+  EXPECT_EQ(1u, timeouts.nrOrigins());
+}
+
+TEST(TransferTimeouts, rejectsInvalidOptions) {
+  TimeoutOptions options = adaptiveOptions();
+  options.connect        = 0s;
+  EXPECT_THROW(TransferTimeouts{options}, std::invalid_argument);
+  options               = adaptiveOptions();
+  options.latencyFactor = .5;
+  EXPECT_THROW(TransferTimeouts{options}, std::invalid_argument);
+  options             = adaptiveOptions();
+  options.prewarmIdle = 0ms;
+  EXPECT_THROW(TransferTimeouts{options}, std::invalid_argument);
+}
@@ -0,0 +1,54 @@
+#include "UrlArena.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+TEST(UrlArena, addAndRead) {
+  UrlArena        arena;
+  const UrlHandle handle = arena.add("http://url.com/a/b", 3, 5, 14);
+  EXPECT_EQ(arena.url(handle), "http://url.com/a/b");
+  EXPECT_EQ(arena.path(handle), "/a/b");
+  EXPECT_EQ(handle.urlIndex, 3);
+  EXPECT_EQ(handle.hostId, 5);
+}
+
+TEST(UrlArena, urlsDoNotSpanChunks) {
+  UrlArena                 arena;
+  std::vector<UrlHandle>   handles;
+  std::vector<std::string> urls;
+  for(int index = 0; arena.memoryUsage() < 3 * UrlArena::CHUNK_SIZE; ++index) {
+    urls.push_back("http://url.com/" + std::string(index % 1000, 'a'));
+    handles.push_back(arena.add(urls.back(), index));
+  }
+  for(size_t index = 0; index < handles.size(); ++index) {
+    ASSERT_EQ(arena.url(handles[index]), urls[index]);
+    ASSERT_EQ(handles[index].offset / UrlArena::CHUNK_SIZE,
+              (handles[index].offset + handles[index].length - 1) / UrlArena::CHUNK_SIZE);
+  }
+}
+
+TEST(UrlArena, viewsStayValid) {
+  UrlArena               arena;
+  const std::string_view first = arena.url(arena.add("http://url.com/", 0));
+  for(int index = 0; index < 100000; ++index) {
+    arena.add("http://url.com/" + std::to_string(index), index);
+  }
+  EXPECT_EQ(first, "http://url.com/");
+}
+
+TEST(UrlArena, invalidUrls) {
+  UrlArena arena;
+  EXPECT_THROW(arena.add(std::string(UrlArena::MAX_URL_LENGTH + 1, 'a'), 0), std::length_error);
+  EXPECT_THROW(arena.add("http://url.com/", 0, 0, 16), std::logic_error);
+  EXPECT_TRUE(arena.empty());
+}
+
+TEST(UrlArena, smallBatchesStaySmall) {
+  UrlArena arena;
+  arena.add("http://url.com/", 0);
+  arena.add("", 1);
+  EXPECT_EQ(arena.memoryUsage(), UrlArena::MIN_CHUNK_SIZE);
+}
@@ -0,0 +1,119 @@
+#include "DownloadResult.h"
+#include "UrlFileDispatcher.h"
+#include "UrlFileReader.h"
+#include "testFilename.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct UrlFileFixture : public ::testing::Test {
+  UrlFileFixture() : Test{}, filename{testFilename("UrlFileReaderTest", ".txt")} {}
+  ~UrlFileFixture() { std::remove(filename.c_str()); }
+
+  void write(const std::string& content) { std::ofstream{filename, std::ios::binary} << content; }
+
+  std::vector<std::string> readAll(size_t maxUrls, size_t chunkSize) {
+    UrlFileReader                 reader{filename, maxUrls};
+    std::vector<std::string_view> urls;
+    while(!reader.finished()) {
+      const size_t nrUrls = reader.next(chunkSize, urls);
+      EXPECT_TRUE(nrUrls == chunkSize || reader.finished());
+    }
+    return std::vector<std::string>(urls.begin(), urls.end());
+  }
+
+  std::string filename;
+};
+
+} // namespace
+
+TEST_F(UrlFileFixture, readLines) {
+  write("http://url1.com/\nhttp://url2.com/a\r\n\nhttp://url3.com/b");
+  EXPECT_THAT(readAll(10, 10), testing::ElementsAre("http://url1.com/", "http://url2.com/a", "http://url3.com/b"));
+  EXPECT_THAT(readAll(10, 1), testing::ElementsAre("http://url1.com/", "http://url2.com/a", "http://url3.com/b"));
+}
+
+TEST_F(UrlFileFixture, maxUrls) {
+  write("http://url1.com/\nhttp://url2.com/\nhttp://url3.com/\n");
+  EXPECT_THAT(readAll(2, 10), testing::ElementsAre("http://url1.com/", "http://url2.com/"));
+}
+
+TEST_F(UrlFileFixture, emptyFile) {
+  write("");
+  EXPECT_TRUE(readAll(10, 10).empty());
+}
+
+TEST_F(UrlFileFixture, longLines) {
+  const std::string longUrl = "http://url.com/" + std::string(100, 'a');
+  std::string       content;
+  for(int i = 0; i < 1000; ++i) {
+    content += longUrl.substr(0, 15 + i % 100) + "\n";
+  }
+  write(content);
+  const std::vector<std::string> urls = readAll(2000, 7);
+  ASSERT_EQ(1000, urls.size());
+  for(int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(longUrl.substr(0, 15 + i % 100), urls[i]);
+  }
+}
+
+TEST_F(UrlFileFixture, missingFile) {
+  EXPECT_THROW(UrlFileReader(filename + ".missing", 10), std::runtime_error);
+}
+
+TEST_F(UrlFileFixture, readLineNumbers) {
+  write("http://url1.com/\n\r\n\nhttp://url2.com/\n");
+  UrlFileReader                 reader{filename, 10};
+  std::vector<std::string_view> urls;
+  std::vector<size_t>           lines;
+  reader.next(10, urls, &lines);
+  EXPECT_THAT(urls, testing::ElementsAre("http://url1.com/", "http://url2.com/"));
+  EXPECT_THAT(lines, testing::ElementsAre(0, 3));
+}
+
+TEST_F(UrlFileFixture, dispatchBatches) {
+  write("http://url1.com/\nhttp://url2.com/\nhttp://url3.com/\n");
+  UrlFileDispatcher dispatcher{filename, 10, 2, [](DownloadResult&&) {}, 5};
+  ASSERT_TRUE(dispatcher.hasUrls());
+  UrlBatch first = dispatcher.nextBatch();
+  ASSERT_EQ(2, first.size());
+  EXPECT_EQ("http://url2.com/", first.arena.url(first.urls[1]));
+  EXPECT_EQ(6, first.urls[1].urlIndex);
+  ASSERT_TRUE(dispatcher.hasUrls());
+  UrlBatch second = dispatcher.nextBatch();
+  ASSERT_EQ(1, second.size());
+  EXPECT_EQ(7, second.urls[0].urlIndex);
+  EXPECT_FALSE(dispatcher.hasUrls());
+}
+
+TEST_F(UrlFileFixture, dispatchCountsEmptyLines) {
+  write("http://url1.com/\n\nhttp://url2.com/\n");
+  UrlFileDispatcher dispatcher{filename, 10, 10, [](DownloadResult&&) {}, 1};
+  UrlBatch          batch = dispatcher.nextBatch();
+  ASSERT_EQ(2, batch.size());
+  EXPECT_EQ(1, batch.urls[0].urlIndex);
+  EXPECT_EQ(3, batch.urls[1].urlIndex);
+}
+
+TEST_F(UrlFileFixture, dispatchFailsTooLongUrls) {
+  const std::string tooLong = "http://url.com/" + std::string(64 * 1024, 'a');
+  write("http://url1.com/\n" + tooLong + "\nhttp://url2.com/\n");
+  std::vector<DownloadResult> failed;
+  UrlFileDispatcher           dispatcher{
+      filename, 10, 10, [&failed](DownloadResult&& result) { failed.push_back(std::move(result)); }, 0};
+  UrlBatch batch = dispatcher.nextBatch();
+  ASSERT_EQ(2, batch.size());
+  EXPECT_EQ("http://url2.com/", batch.arena.url(batch.urls[1]));
+  EXPECT_EQ(2, batch.urls[1].urlIndex);
+  ASSERT_EQ(1, failed.size());
+  EXPECT_FALSE(failed[0].success);
+  EXPECT_EQ(tooLong, std::get<0>(failed[0].url));
+  EXPECT_EQ(1, std::get<1>(failed[0].url));
+}
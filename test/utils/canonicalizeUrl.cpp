@@ -0,0 +1,101 @@
+#include "uriUtils/uriUtils.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace {
+
+std::string
+canonicalize(const std::string& url, bool sortQueryParameters = false) {
+  std::string  buffer(url.size() + 1, '\0');
+  const size_t length = canonicalizeUrl(url, &buffer[0], buffer.size(), nullptr, sortQueryParameters);
+  buffer.resize(length);
+  return buffer;
+}
+
+} // namespace
+
+TEST(canonicalizeUrl, alreadyCanonical) {
+  EXPECT_EQ(canonicalize("http://url.com/a/b?q=1"), "http://url.com/a/b?q=1");
+}
+
+TEST(canonicalizeUrl, lowercaseSchemeAndHost) {
+  EXPECT_EQ(canonicalize("HTTP://Url.COM/Path"), "http://url.com/Path");
+}
+
+TEST(canonicalizeUrl, emptyPath) {
+  EXPECT_EQ(canonicalize("http://url.com"), "http://url.com/");
+  EXPECT_EQ(canonicalize("http://url.com?q"), "http://url.com/?q");
+}
+
+TEST(canonicalizeUrl, ports) {
+  EXPECT_EQ(canonicalize("http://url.com:80/"), "http://url.com/");
+  EXPECT_EQ(canonicalize("https://url.com:443/"), "https://url.com/");
+  EXPECT_EQ(canonicalize("http://url.com:/"), "http://url.com/");
+  EXPECT_EQ(canonicalize("https://url.com:80/"), "https://url.com:80/");
+  EXPECT_EQ(canonicalize("http://url.com:8080/"), "http://url.com:8080/");
+  EXPECT_EQ(canonicalize("http://url.com:0080/"), "http://url.com/");
+  EXPECT_EQ(canonicalize("http://url.com:8a/"), "");
+}
+
+TEST(canonicalizeUrl, trailingHostDot) {
+  EXPECT_EQ(canonicalize("http://url.com./a"), "http://url.com/a");
+  EXPECT_EQ(canonicalize("http://url.com.:8080/a"), "http://url.com:8080/a");
+}
+
+TEST(canonicalizeUrl, dotSegments) {
+  EXPECT_EQ(canonicalize("http://url.com/a/./b"), "http://url.com/a/b");
+  EXPECT_EQ(canonicalize("http://url.com/a/b/../c"), "http://url.com/a/c");
+  EXPECT_EQ(canonicalize("http://url.com/a/b/.."), "http://url.com/a/");
+  EXPECT_EQ(canonicalize("http://url.com/a/."), "http://url.com/a/");
+  EXPECT_EQ(canonicalize("http://url.com/../../a"), "http://url.com/a");
+  EXPECT_EQ(canonicalize("http://url.com/a/%2E%2e/b"), "http://url.com/b");
+  EXPECT_EQ(canonicalize("http://url.com/a/..b/c"), "http://url.com/a/..b/c");
+}
+
+TEST(canonicalizeUrl, percentEncoding) {
+  EXPECT_EQ(canonicalize("http://url.com/%7euser%2fa%2F"), "http://url.com/~user%2Fa%2F");
+  EXPECT_EQ(canonicalize("http://url.com/%41?q=%3d%62"), "http://url.com/A?q=%3Db");
+  EXPECT_EQ(canonicalize("http://url.com/100%"), "http://url.com/100%");
+}
+
+TEST(canonicalizeUrl, fragmentRemoved) {
+  EXPECT_EQ(canonicalize("http://url.com/a#frag"), "http://url.com/a");
+  EXPECT_EQ(canonicalize("http://url.com/a?q=1#frag"), "http://url.com/a?q=1");
+}
+
+TEST(canonicalizeUrl, sortQueryParameters) {
+  EXPECT_EQ(canonicalize("http://url.com/?b=2&a=1&c", true), "http://url.com/?a=1&b=2&c");
+  EXPECT_EQ(canonicalize("http://url.com/?b=2&a=1&c", false), "http://url.com/?b=2&a=1&c");
+}
+
+TEST(canonicalizeUrl, invalid) {
+  EXPECT_EQ(canonicalize(""), "");
+  EXPECT_EQ(canonicalize("url.com"), "");
+  EXPECT_EQ(canonicalize("http:url.com"), "");
+  EXPECT_EQ(canonicalize("http:///a"), "");
+  EXPECT_EQ(canonicalize("http://url.com dsadas"), "");
+  EXPECT_EQ(canonicalize("http://url.com/a b"), "");
+}
+
+TEST(canonicalizeUrl, parts) {
+  const std::string url{"HTTPS://www.Url.com:8443/a/../b?x=1#f"};
+  std::string       buffer(url.size() + 1, '\0');
+  UrlParts          parts;
+  const size_t      length = canonicalizeUrl(url, &buffer[0], buffer.size(), &parts);
+  ASSERT_NE(0, length);
+  EXPECT_EQ(std::string(buffer.data(), length), "https://www.url.com:8443/b?x=1");
+  EXPECT_EQ(parts.scheme, "https");
+  EXPECT_EQ(parts.host, "www.url.com");
+  EXPECT_EQ(parts.port, "8443");
+  EXPECT_EQ(parts.path, "/b");
+  EXPECT_EQ(parts.query, "x=1");
+}
+
+TEST(canonicalizeUrl, bufferTooSmall) {
+  const std::string url{"http://url.com"};
+  std::string       buffer(url.size(), '\0');
+  EXPECT_EQ(0, canonicalizeUrl(url, &buffer[0], buffer.size()));
+}
@@ -0,0 +1,77 @@
+#include "extractLinks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+namespace {
+
+HtmlLinks
+extract(const std::string& html) {
+  HtmlLinks result;
+  extractLinks(html, result);
+  return result;
+}
+
+} // namespace
+
+TEST(extractLinks, hrefAndSrc) {
+  const HtmlLinks links = extract(R"(<html><body><a href="/a">A</a><img src='b.png'><A HREF=c.html>C</A></body></html>)");
+  EXPECT_THAT(links.links, ElementsAre("/a", "b.png", "c.html"));
+  EXPECT_TRUE(links.base.empty());
+}
+
+TEST(extractLinks, otherAttributesAreIgnored) {
+  const HtmlLinks links = extract(R"(<a class="x" data-href="no" href = "yes" title='<a href="no">'>)");
+  EXPECT_THAT(links.links, ElementsAre("yes"));
+}
+
+TEST(extractLinks, base) {
+  const HtmlLinks links = extract(R"(<head><base href="http://b.com/"><base href="http://c.com/"></head><a href="d">)");
+  EXPECT_EQ("http://b.com/", links.base);
+  EXPECT_THAT(links.links, ElementsAre("http://c.com/", "d"));
+}
+
+TEST(extractLinks, commentsScriptsAndStylesAreSkipped) {
+  const HtmlLinks links = extract(R"(<!-- <a href="no1"> --><script src="s.js">var a = '<a href="no2">';</SCRIPT>)"
+                                  R"(<style>a[href="no3"] {}</style><a href="yes">)");
+  EXPECT_THAT(links.links, ElementsAre("s.js", "yes"));
+}
+
+TEST(extractLinks, malformedHtml) {
+  EXPECT_THAT(extract("<a href").links, IsEmpty());
+  EXPECT_THAT(extract("<a href=\"unterminated").links, IsEmpty());
+  EXPECT_THAT(extract("1 < 2 <a href=x> <").links, ElementsAre("x"));
+  EXPECT_THAT(extract("<a <b href=x>").links, ElementsAre("x"));
+  EXPECT_THAT(extract("<script>no end <a href=x>").links, IsEmpty());
+  EXPECT_THAT(extract("<!-- no end <a href=x>").links, IsEmpty());
+}
+
+TEST(extractLinks, metaRobotsNofollow) {
+  EXPECT_FALSE(extract(R"(<meta name="description" content="nofollow"><a href="x">)").nofollow);
+  EXPECT_TRUE(extract(R"(<META NAME="Robots" CONTENT="noindex, NoFollow"><a href="x">)").nofollow);
+}
+
+TEST(LinkScanner, scansWhileReceived) {
+  const std::string html = R"(<base href="http://b.com/"><!-- <a href="no"> --><a href="/a">A</a><img src='b.png'>)"
+                           R"(<script>'<a href="no">'</script><meta name="robots" content="nofollow"><a href=c>)";
+  for(const size_t chunkSize: {1u, 3u, 7u, 64u}) {
+    LinkScanner scanner;
+    std::string received;
+    for(size_t pos = 0; pos < html.size(); pos += chunkSize) {
+      // the received bytes are moved like the content of a growing download
+      std::string grown = received + html.substr(pos, chunkSize);
+      received.swap(grown);
+      scanner.scan(received);
+    }
+    HtmlLinks links;
+    scanner.appendLinks(received, links);
+    EXPECT_EQ("http://b.com/", links.base) << chunkSize;
+    EXPECT_THAT(links.links, ElementsAre("/a", "b.png", "c")) << chunkSize;
+    EXPECT_TRUE(links.nofollow) << chunkSize;
+  }
+}
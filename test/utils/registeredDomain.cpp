@@ -0,0 +1,31 @@
+#include "uriUtils/uriUtils.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+TEST(registeredDomain, topLevelSuffixes) {
+  EXPECT_EQ("example.com", registeredDomain("example.com"));
+  EXPECT_EQ("example.com", registeredDomain("www.example.com"));
+  EXPECT_EQ("blogspot.com", registeredDomain("a.b.blogspot.com"));
+  EXPECT_EQ("example.de", registeredDomain("shop.example.de"));
+}
+
+TEST(registeredDomain, multiLabelSuffixes) {
+  EXPECT_EQ("example.co.uk", registeredDomain("www.a.example.co.uk"));
+  EXPECT_EQ("example.co.uk", registeredDomain("example.co.uk"));
+  EXPECT_EQ("example.com.au", registeredDomain("news.example.com.au"));
+  // not in the embedded subset
+  EXPECT_EQ("example.xx", registeredDomain("a.example.xx"));
+}
+
+TEST(registeredDomain, hostsWithoutRegisteredDomain) {
+  EXPECT_EQ("co.uk", registeredDomain("co.uk"));
+  EXPECT_EQ("localhost", registeredDomain("localhost"));
+  EXPECT_EQ("", registeredDomain(""));
+  EXPECT_EQ(".com", registeredDomain(".com"));
+}
+
+TEST(registeredDomain, ipAddresses) {
+  EXPECT_EQ("192.168.1.10", registeredDomain("192.168.1.10"));
+  EXPECT_EQ("[2001:db8::1]", registeredDomain("[2001:db8::1]"));
+}
@@ -0,0 +1,64 @@
+#include "uriUtils/uriUtils.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace {
+
+std::string
+resolve(const std::string& base, const std::string& reference) {
+  std::string result{"unchanged"};
+  resolveUrl(base, reference, result);
+  return result;
+}
+
+std::string
+resolveCanonical(const std::string& base, const std::string& reference) {
+  const std::string url = resolve(base, reference);
+  std::string       buffer(url.size() + 1, '\0');
+  buffer.resize(canonicalizeUrl(url, &buffer[0], buffer.size()));
+  return buffer;
+}
+
+} // namespace
+
+TEST(resolveUrl, absoluteReference) {
+  EXPECT_EQ(resolve("http://a.com/b/c", "https://d.com/e"), "https://d.com/e");
+  EXPECT_EQ(resolve("http://a.com/b/c", "mailto:me@a.com"), "mailto:me@a.com");
+  EXPECT_EQ(resolve("http://a.com/b/c", "  http://d.com/\n"), "http://d.com/");
+}
+
+TEST(resolveUrl, networkPathReference) {
+  EXPECT_EQ(resolve("https://a.com/b/c", "//d.com/e"), "https://d.com/e");
+}
+
+TEST(resolveUrl, absolutePathReference) {
+  EXPECT_EQ(resolve("http://a.com/b/c?q#f", "/d/e"), "http://a.com/d/e");
+  EXPECT_EQ(resolve("http://a.com:8080", "/d"), "http://a.com:8080/d");
+}
+
+TEST(resolveUrl, relativePathReference) {
+  EXPECT_EQ(resolve("http://a.com/b/c?q", "d"), "http://a.com/b/d");
+  EXPECT_EQ(resolve("http://a.com/b/", "d?x"), "http://a.com/b/d?x");
+  EXPECT_EQ(resolve("http://a.com", "d"), "http://a.com/d");
+  EXPECT_EQ(resolve("http://a.com?q", "d"), "http://a.com/d");
+}
+
+TEST(resolveUrl, queryAndFragmentReference) {
+  EXPECT_EQ(resolve("http://a.com/b/c?q#f", "?x"), "http://a.com/b/c?x");
+  EXPECT_EQ(resolve("http://a.com/b/c?q#f", "#g"), "http://a.com/b/c?q#g");
+  EXPECT_EQ(resolve("http://a.com/b/c?q#f", ""), "http://a.com/b/c?q");
+}
+
+TEST(resolveUrl, dotSegmentsAreRemovedByCanonicalization) {
+  EXPECT_EQ(resolveCanonical("http://a.com/b/c/d", "../e"), "http://a.com/b/e");
+  EXPECT_EQ(resolveCanonical("http://a.com/b/c/d", "./e#f"), "http://a.com/b/c/e");
+  EXPECT_EQ(resolveCanonical("http://a.com/b", "../../e"), "http://a.com/e");
+}
+
+TEST(resolveUrl, invalidBase) {
+  EXPECT_EQ(resolve("a.com/b", "c"), "unchanged");
+  EXPECT_EQ(resolve("", "c"), "unchanged");
+}
@@ -0,0 +1,102 @@
+#include "simHash.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @returns a page of nrWords random words with a fixed seed
+ */
+std::string
+article(const size_t nrWords, const unsigned seed) {
+  static const std::vector<std::string> words{"crawler", "page",    "link",  "host", "robots", "queue", "batch",
+                                              "the",     "of",      "and",   "a",    "fast",   "slow",  "download",
+                                              "server",  "content", "index", "web",  "search", "text",  "html"};
+  std::mt19937                          random{seed};
+  std::uniform_int_distribution<size_t> word{0, words.size() - 1};
+  std::string                           result = "<html><body><p>";
+  for(size_t index = 0; index < nrWords; ++index) {
+    result += words[word(random)] + (0 == index % 12 ? "</p>\n<p>" : " ");
+  }
+  return result + "</p></body></html>";
+}
+
+} // namespace
+
+TEST(simHash, markupIsIgnored) {
+  EXPECT_EQ(simHash("hello big WORLD, again", 2),
+            simHash(R"(<p class="x">Hello <b>big</b> world <!-- no --> again</p><script>var x = "<p>no</p>";</script>)"
+                    "<STYLE>p { color: red; }</style>",
+                    2));
+  EXPECT_EQ(simHash("a b", 2), simHash("a < b", 2));
+}
+
+TEST(simHash, pagesWithoutText) {
+  EXPECT_EQ(0u, simHash("", 4));
+  EXPECT_EQ(0u, simHash("<html><script>var a;</script><img src=a.png> <!-- c --></html>", 4));
+  EXPECT_NE(0u, simHash("<p>short</p>", 4));
+}
+
+TEST(simHash, nearDuplicatePages) {
+  const std::string page = article(2000, 1);
+  std::string       updated{page};
+  updated.insert(updated.find("<body>") + 6, "<p>Updated 2024-01-02 10:22</p>");
+  updated.insert(updated.find("</body>"), "<div class=ad>Buy a crawler now</div>");
+
+  EXPECT_LE(hammingDistance(simHash(page, 4), simHash(updated, 4)), 3u);
+  EXPECT_GT(hammingDistance(simHash(page, 4), simHash(article(2000, 2), 4)), 10u);
+}
+
+TEST(simHashIndex, findsHashesWithinMaxDistance) {
+  const uint64_t hash = 0x0123456789abcdefull;
+  SimHashIndex   index;
+  index.insert(hash, 7);
+  EXPECT_EQ(1u, index.size());
+
+  uint32_t id = 0;
+  EXPECT_TRUE(index.findNear(hash, id));
+  EXPECT_EQ(7u, id);
+  // the flipped bits are in different bands
+  EXPECT_TRUE(index.findNear(hash ^ 0x0000000100010001ull, id));
+  EXPECT_TRUE(index.findNear(hash ^ 0x8000800080000000ull, id));
+  EXPECT_FALSE(index.findNear(hash ^ 0x0001000100010001ull, id));
+  EXPECT_FALSE(index.findNear(~hash, id));
+}
+
+TEST(simHashIndex, matchesBruteForce) {
+  for(const unsigned maxDistance: {0u, 3u, 6u}) {
+    std::mt19937_64       random{maxDistance};
+    SimHashIndex          index{maxDistance};
+    std::vector<uint64_t> hashes;
+    for(uint32_t id = 0; id < 2000; ++id) {
+      hashes.push_back(random());
+      index.insert(hashes.back(), id);
+    }
+    for(size_t query = 0; query < 2000; ++query) {
+      uint64_t hash = hashes[random() % hashes.size()];
+      for(unsigned flip = random() % (maxDistance + 3); flip > 0; --flip) {
+        hash ^= uint64_t{1} << (random() % 64);
+      }
+      bool expected = false;
+      for(const uint64_t stored: hashes) {
+        expected = expected || hammingDistance(hash, stored) <= maxDistance;
+      }
+      uint32_t id = 0;
+      ASSERT_EQ(expected, index.findNear(hash, id)) << "maxDistance: " << maxDistance << " hash: " << hash;
+      if(expected) {
+        EXPECT_LE(hammingDistance(hash, hashes[id]), maxDistance);
+      }
+    }
+  }
+}
+
+TEST(simHashIndex, invalidMaxDistance) {
+  EXPECT_NO_THROW(SimHashIndex{SimHashIndex::MAX_DISTANCE});
+  EXPECT_THROW(SimHashIndex{SimHashIndex::MAX_DISTANCE + 1}, std::invalid_argument);
+}
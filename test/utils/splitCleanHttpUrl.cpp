@@ -0,0 +1,75 @@
+#include "uriUtils/uriUtils.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace {
+
+bool
+isClean(const std::string& url) {
+  UrlParts parts;
+  return splitCleanHttpUrl(url, parts);
+}
+
+} // namespace
+
+TEST(splitCleanHttpUrl, components) {
+  const std::string url{"https://www.url.com/a/b.html?q=1&r=2"};
+  UrlParts          parts;
+  ASSERT_TRUE(splitCleanHttpUrl(url, parts));
+  EXPECT_EQ(parts.scheme, "https");
+  EXPECT_EQ(parts.host, "www.url.com");
+  EXPECT_EQ(parts.port, "");
+  EXPECT_EQ(parts.path, "/a/b.html");
+  EXPECT_EQ(parts.query, "q=1&r=2");
+}
+
+TEST(splitCleanHttpUrl, acceptsCanonicalUrls) {
+  EXPECT_TRUE(isClean("http://url.com/"));
+  EXPECT_TRUE(isClean("http://sub-domain.url2.com/a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p/q.html"));
+  EXPECT_TRUE(isClean("http://url.com/a.b/c?d=e.f"));
+}
+
+TEST(splitCleanHttpUrl, leavesOtherUrlsToTheParser) {
+  EXPECT_FALSE(isClean("ftp://url.com/"));
+  EXPECT_FALSE(isClean("HTTP://url.com/"));
+  EXPECT_FALSE(isClean("http://Url.com/"));
+  EXPECT_FALSE(isClean("http://url.com"));
+  EXPECT_FALSE(isClean("http://url.com./"));
+  EXPECT_FALSE(isClean("http://url.com:80/"));
+  EXPECT_FALSE(isClean("http://user@url.com/"));
+  EXPECT_FALSE(isClean("http://127.0.0.1/"));
+  EXPECT_FALSE(isClean("http:///"));
+  EXPECT_FALSE(isClean("http://url.com/a%20b"));
+  EXPECT_FALSE(isClean("http://url.com/a#fragment"));
+  EXPECT_FALSE(isClean("http://url.com/a b"));
+}
+
+TEST(splitCleanHttpUrl, dotSegments) {
+  EXPECT_FALSE(isClean("http://url.com/./a"));
+  EXPECT_FALSE(isClean("http://url.com/a/../b"));
+  // a dot segment right after and right before a 16 byte block boundary
+  EXPECT_FALSE(isClean("http://url.com/aaaaaaaaaaaaaaa/./b"));
+  EXPECT_FALSE(isClean("http://url.com/aaaaaaaaaaaaaa/./b"));
+  EXPECT_TRUE(isClean("http://url.com/aaaaaaaaaaaaaaa/a.b"));
+}
+
+TEST(splitCleanHttpUrl, forbiddenCharactersInLongPaths) {
+  EXPECT_TRUE(isClean("http://url.com/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"));
+  EXPECT_FALSE(isClean("http://url.com/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\x80"
+                       "aaaaaaaaaaaaa"));
+  EXPECT_FALSE(isClean("http://url.com/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa{aaaaaaaaaaaaa"));
+  EXPECT_FALSE(isClean("http://url.com/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\x7f"
+                       "aaaaaaaaaaaaa"));
+}
+
+TEST(splitCleanHttpUrl, agreesWithCanonicalizeUrl) {
+  for(const std::string url: {"http://url.com/a/b?c=d", "https://a-b.c.org/x.y/z/?q=%", "http://url.com/a/b/"}) {
+    std::string buffer(url.size() + 1, '\0');
+    if(isClean(url)) {
+      EXPECT_EQ(url, buffer.substr(0, canonicalizeUrl(url, &buffer[0], buffer.size()))) << url;
+    }
+  }
+}